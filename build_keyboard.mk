@@ -121,12 +121,26 @@ SRC += $(KEYBOARD_C) \
     $(QUANTUM_DIR)/quantum.c \
     $(QUANTUM_DIR)/keymap_common.c \
     $(QUANTUM_DIR)/keycode_config.c \
-    $(QUANTUM_DIR)/process_keycode/process_leader.c
+    $(QUANTUM_DIR)/process_keycode/process_leader.c \
+    $(QUANTUM_DIR)/process_keycode/leader_dictionary.c
 
 ifneq ($(SUBPROJECT),)
     SRC += $(SUBPROJECT_C)
 endif
 
+ifeq ($(strip $(SPLIT_KEYBOARD)), yes)
+    OPT_DEFS += -DSPLIT_KEYBOARD
+    SPLIT_DIR := $(QUANTUM_DIR)/split_common
+    SRC += $(SPLIT_DIR)/matrix.c \
+        $(SPLIT_DIR)/split_util.c \
+        $(SPLIT_DIR)/split_transport.c \
+        $(SPLIT_DIR)/serial_protocol.c \
+        $(SPLIT_DIR)/serial.c \
+        $(SPLIT_DIR)/i2c.c \
+        $(SPLIT_DIR)/split_uart.c
+    CUSTOM_MATRIX = yes
+endif
+
 ifndef CUSTOM_MATRIX
     SRC += $(QUANTUM_DIR)/matrix.c
 endif
@@ -145,9 +159,16 @@ ifeq ($(strip $(AUDIO_ENABLE)), yes)
     OPT_DEFS += -DAUDIO_ENABLE
     MUSIC_ENABLE := 1
     SRC += $(QUANTUM_DIR)/process_keycode/process_audio.c
-    SRC += $(QUANTUM_DIR)/audio/audio.c
-    SRC += $(QUANTUM_DIR)/audio/voices.c
-    SRC += $(QUANTUM_DIR)/audio/luts.c
+    SRC += $(QUANTUM_DIR)/audio/audio_song.c
+    ifeq ($(PLATFORM),CHIBIOS)
+        SRC += $(QUANTUM_DIR)/audio/audio_chibios.c
+        SRC += $(QUANTUM_DIR)/audio/audio_mixer.c
+    else
+        SRC += $(QUANTUM_DIR)/audio/audio.c
+        SRC += $(QUANTUM_DIR)/audio/audio_engine.c
+        SRC += $(QUANTUM_DIR)/audio/voices.c
+        SRC += $(QUANTUM_DIR)/audio/luts.c
+    endif
 endif
 
 ifeq ($(strip $(MIDI_ENABLE)), yes)
@@ -165,6 +186,13 @@ ifeq ($(strip $(COMBO_ENABLE)), yes)
     SRC += $(QUANTUM_DIR)/process_keycode/process_combo.c
 endif
 
+ifeq ($(strip $(STENO_ENABLE)), yes)
+    OPT_DEFS += -DSTENO_ENABLE
+    VIRTSER_ENABLE := yes
+    SRC += $(QUANTUM_DIR)/process_keycode/process_steno.c \
+    $(QUANTUM_DIR)/process_keycode/steno_packet.c
+endif
+
 ifeq ($(strip $(VIRTSER_ENABLE)), yes)
     OPT_DEFS += -DVIRTSER_ENABLE
 endif
@@ -174,10 +202,17 @@ ifeq ($(strip $(FAUXCLICKY_ENABLE)), yes)
     SRC += $(QUANTUM_DIR)/fauxclicky.c
 endif
 
+ifeq ($(strip $(CHORDING_ENABLE)), yes)
+    OPT_DEFS += -DCHORDING_ENABLE
+    SRC += $(QUANTUM_DIR)/process_keycode/process_chording.c \
+    $(QUANTUM_DIR)/process_keycode/chord_dictionary.c
+endif
+
 ifeq ($(strip $(UCIS_ENABLE)), yes)
     OPT_DEFS += -DUCIS_ENABLE
     UNICODE_COMMON = yes
-    SRC += $(QUANTUM_DIR)/process_keycode/process_ucis.c
+    SRC += $(QUANTUM_DIR)/process_keycode/process_ucis.c \
+    $(QUANTUM_DIR)/process_keycode/ucis_index.c
 endif
 
 ifeq ($(strip $(UNICODEMAP_ENABLE)), yes)
@@ -198,12 +233,24 @@ endif
 
 ifeq ($(strip $(RGBLIGHT_ENABLE)), yes)
     OPT_DEFS += -DRGBLIGHT_ENABLE
-    SRC += $(QUANTUM_DIR)/light_ws2812.c
+    WS2812_DRIVER ?= bitbang
+    ifeq ($(strip $(WS2812_DRIVER)), bitbang)
+        SRC += $(QUANTUM_DIR)/light_ws2812.c
+    else
+        SRC += $(QUANTUM_DIR)/ws2812/ws2812_encode.c
+        SRC += $(QUANTUM_DIR)/ws2812/ws2812_$(strip $(WS2812_DRIVER)).c
+    endif
     SRC += $(QUANTUM_DIR)/rgblight.c
+    SRC += $(QUANTUM_DIR)/color/color.c
     CIE1931_CURVE = yes
     LED_BREATHING_TABLE = yes
 endif
 
+ifeq ($(strip $(RGB_REACTIVE_ENABLE)), yes)
+    OPT_DEFS += -DRGB_REACTIVE_ENABLE
+    SRC += $(QUANTUM_DIR)/rgb_reactive/rgb_reactive.c
+endif
+
 ifeq ($(strip $(TAP_DANCE_ENABLE)), yes)
     OPT_DEFS += -DTAP_DANCE_ENABLE
     SRC += $(QUANTUM_DIR)/process_keycode/process_tap_dance.c
@@ -261,6 +308,9 @@ ifneq ($(SUBPROJECT),)
 endif
 VPATH += $(KEYBOARD_PATH)
 VPATH += $(COMMON_VPATH)
+ifeq ($(strip $(SPLIT_KEYBOARD)), yes)
+    VPATH += $(QUANTUM_PATH)/split_common
+endif
 
 include $(TMK_PATH)/protocol.mk
 
@@ -301,6 +351,9 @@ all: build sizeafter
 build: elf hex
 #build: elf hex eep lss sym
 #build: lib
+ifeq ($(strip $(TRACE_ENABLE)), yes)
+build: trace
+endif
 
 
 include $(TMK_PATH)/rules.mk
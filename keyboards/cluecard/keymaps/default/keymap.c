@@ -15,15 +15,15 @@ const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
 
 #ifdef AUDIO_ENABLE
 
-float tone_startup[][2] = SONG(STARTUP_SOUND);
-float tone_qwerty[][2] = SONG(QWERTY_SOUND);
-float tone_dvorak[][2] = SONG(DVORAK_SOUND);
-float tone_colemak[][2] = SONG(COLEMAK_SOUND);
-float tone_plover[][2] = SONG(PLOVER_SOUND);
-float tone_plover_gb[][2] = SONG(PLOVER_GOODBYE_SOUND);
-float music_scale[][2] = SONG(MUSIC_SCALE_SOUND);
-
-float tone_goodbye[][2] = SONG(GOODBYE_SOUND);
+const uint8_t tone_startup[] PROGMEM = SONG_BYTES(STARTUP_SOUND);
+const uint8_t tone_qwerty[] PROGMEM = SONG_BYTES(QWERTY_SOUND);
+const uint8_t tone_dvorak[] PROGMEM = SONG_BYTES(DVORAK_SOUND);
+const uint8_t tone_colemak[] PROGMEM = SONG_BYTES(COLEMAK_SOUND);
+const uint8_t tone_plover[] PROGMEM = SONG_BYTES(PLOVER_SOUND);
+const uint8_t tone_plover_gb[] PROGMEM = SONG_BYTES(PLOVER_GOODBYE_SOUND);
+const uint8_t music_scale[] PROGMEM = SONG_BYTES(MUSIC_SCALE_SOUND);
+
+const uint8_t tone_goodbye[] PROGMEM = SONG_BYTES(GOODBYE_SOUND);
 #endif
 
 const uint16_t PROGMEM fn_actions[] = {
@@ -36,13 +36,13 @@ void action_function(keyrecord_t *record, uint8_t id, uint8_t opt) {
 	if (record->event.pressed) {
 		switch (id) {
 			case 0:
-				PLAY_NOTE_ARRAY(tone_startup, false, 0);
+				PLAY_SONG(tone_startup, false, 0);
 				break;
 			case 1:
-				PLAY_NOTE_ARRAY(music_scale, false, 0);
+				PLAY_SONG(music_scale, false, 0);
 				break;
 			case 2:
-				PLAY_NOTE_ARRAY(tone_goodbye, false, 0);
+				PLAY_SONG(tone_goodbye, false, 0);
 				break;
 		}
 	}
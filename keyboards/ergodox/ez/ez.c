@@ -61,6 +61,13 @@ uint8_t init_mcp23018(void) {
         _delay_ms(1000);
     }
 
+    // let the register pointer toggle between the A and B registers, the
+    // matrix scan relies on it to read GPIOB right after writing GPIOA
+    mcp23018_status = i2c_start(I2C_ADDR_WRITE);    if (mcp23018_status) goto out;
+    mcp23018_status = i2c_write(IOCON);             if (mcp23018_status) goto out;
+    mcp23018_status = i2c_write(IOCON_SEQOP);       if (mcp23018_status) goto out;
+    i2c_stop();
+
     // set pin direction
     // - unused  : input  : 1
     // - input   : input  : 1
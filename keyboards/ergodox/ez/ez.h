@@ -16,6 +16,8 @@
 #define I2C_ADDR_READ   ( (I2C_ADDR<<1) | I2C_READ  )
 #define IODIRA          0x00            // i/o direction register
 #define IODIRB          0x01
+#define IOCON           0x0A            // configuration register
+#define IOCON_SEQOP     (1<<5)          // pointer toggles between A and B instead of incrementing
 #define GPPUA           0x0C            // GPIO pull-up resistor register
 #define GPPUB           0x0D
 #define GPIOA           0x12            // general purpose i/o port register (write modifies OLAT)
@@ -35,6 +35,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "matrix.h"
 #include "ez.h"
 #include "i2cmaster.h"
+#include "twi_async.h"
 #ifdef DEBUG_MATRIX_SCAN_RATE
 #include  "timer.h"
 #endif
@@ -44,10 +45,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
  * scan loops which should be made to get stable debounced results.
  *
  * On Ergodox matrix scan rate is relatively low, because of slow I2C.
- * Now it's only 317 scans/second, or about 3.15 msec/scan.
+ * With blocking I2C calls it was only 317 scans/second, or about 3.15
+ * msec/scan. The left half is now read in the background while the right
+ * half is scanned, so a scan takes about as long as the I2C transfers of
+ * the left half (see DEBUG_MATRIX_SCAN_RATE for the actual number).
  * According to Cherry specs, debouncing time is 5 msec.
- *
- * And so, there is no sense to have DEBOUNCE higher than 2.
  */
 
 #ifndef DEBOUNCE
@@ -66,8 +68,25 @@ static matrix_row_t read_cols(uint8_t row);
 static void init_cols(void);
 static void unselect_rows(void);
 static void select_row(uint8_t row);
+static bool left_scan_start(void);
+static bool left_scan_finish(void);
+
+/*
+ * The left half is scanned by one queued transaction per row: read the
+ * columns of the row selected by the previous transaction, then select the
+ * next row. init_mcp23018() sets IOCON.SEQOP, which makes the register
+ * pointer toggle between GPIOA and GPIOB, so after writing GPIOA it's left
+ * on GPIOB and the read needs no register address of its own.
+ *
+ * The columns are latched when the MCP23018 acknowledges its read address,
+ * a start condition and nine clocks after the row was selected, which
+ * takes the place of the wait_us(30) of the right half.
+ */
+#define LEFT_ROWS 7
 
-static uint8_t mcp23018_reset_loop;
+static twi_transaction_t left_scan[LEFT_ROWS + 1];
+static uint8_t left_select[LEFT_ROWS + 1][2];
+static uint8_t left_cols[LEFT_ROWS];
 
 #ifdef DEBUG_MATRIX_SCAN_RATE
 uint32_t matrix_timer;
@@ -107,7 +126,7 @@ void matrix_init(void)
 {
     // initialize row and col
 
-    mcp23018_status = init_mcp23018();
+    twi_connect(init_mcp23018);
 
 
     unselect_rows();
@@ -131,7 +150,7 @@ void matrix_init(void)
 }
 
 void matrix_power_up(void) {
-    mcp23018_status = init_mcp23018();
+    twi_connect(init_mcp23018);
 
     unselect_rows();
     init_cols();
@@ -171,20 +190,21 @@ void debounce_report(matrix_row_t change, uint8_t row) {
   }
 }
 
+static void store_row(uint8_t row, matrix_row_t cols)
+{
+    matrix_row_t mask = debounce_mask(row);
+    cols = (cols & mask) | (matrix[row] & ~mask);
+    debounce_report(cols ^ matrix[row], row);
+    matrix[row] = cols;
+}
+
 uint8_t matrix_scan(void)
 {
     if (mcp23018_status) { // if there was an error
-        if (++mcp23018_reset_loop == 0) {
-            // since mcp23018_reset_loop is 8 bit - we'll try to reset once in 255 matrix scans
-            // this will be approx bit more frequent than once per second
-            print("trying to reset mcp23018\n");
-            mcp23018_status = init_mcp23018();
-            if (mcp23018_status) {
-                print("left side not responding\n");
-            } else {
-                print("left side attached\n");
-                ergodox_blink_all_leds();
-            }
+        // tried again by the engine once every TWI_RECONNECT_INTERVAL
+        if (twi_reconnect(init_mcp23018)) {
+            print("left side attached\n");
+            ergodox_blink_all_leds();
         }
     }
 
@@ -202,17 +222,23 @@ uint8_t matrix_scan(void)
     }
 #endif
 
-    for (uint8_t i = 0; i < MATRIX_ROWS; i++) {
+    bool left_running = !mcp23018_status && left_scan_start();
+
+    for (uint8_t i = LEFT_ROWS; i < MATRIX_ROWS; i++) {
         select_row(i);
         wait_us(30);  // without this wait read unstable value.
-        matrix_row_t mask = debounce_mask(i);
-        matrix_row_t cols = (read_cols(i) & mask) | (matrix[i] & ~mask);
-        debounce_report(cols ^ matrix[i], i);
-        matrix[i] = cols;
-
+        store_row(i, read_cols(i));
         unselect_rows();
     }
 
+    if (!mcp23018_status && !(left_running && left_scan_finish())) {
+        print("left side not responding\n");
+        mcp23018_status = 1;
+    }
+    for (uint8_t i = 0; i < LEFT_ROWS; i++) {
+        store_row(i, mcp23018_status ? 0 : left_cols[i]);
+    }
+
     matrix_scan_quantum();
 
     return 1;
@@ -275,32 +301,59 @@ static void  init_cols(void)
     PORTF |=  (1<<7 | 1<<6 | 1<<5 | 1<<4 | 1<<1 | 1<<0);
 }
 
-static matrix_row_t read_cols(uint8_t row)
+// Queues the scan of the left half, returns false if the engine refused it
+static bool left_scan_start(void)
 {
-    if (row < 7) {
-        if (mcp23018_status) { // if there was an error
-            return 0;
-        } else {
-            uint8_t data = 0;
-            mcp23018_status = i2c_start(I2C_ADDR_WRITE);    if (mcp23018_status) goto out;
-            mcp23018_status = i2c_write(GPIOB);             if (mcp23018_status) goto out;
-            mcp23018_status = i2c_start(I2C_ADDR_READ);     if (mcp23018_status) goto out;
-            data = i2c_readNak();
-            data = ~data;
-        out:
-            i2c_stop();
-            return data;
+    for (uint8_t i = 0; i <= LEFT_ROWS; i++) {
+        twi_transaction_t* t = &left_scan[i];
+        t->address = I2C_ADDR;
+        t->segments = 0;
+        if (i > 0) {
+            // columns of the previous row, the pointer is still on GPIOB
+            t->segment[t->segments++] = (twi_segment_t){
+                .read = true, .length = 1, .data = &left_cols[i - 1] };
         }
-    } else {
-        // read from teensy
-        return
-            (PINF&(1<<0) ? 0 : (1<<0)) |
-            (PINF&(1<<1) ? 0 : (1<<1)) |
-            (PINF&(1<<4) ? 0 : (1<<2)) |
-            (PINF&(1<<5) ? 0 : (1<<3)) |
-            (PINF&(1<<6) ? 0 : (1<<4)) |
-            (PINF&(1<<7) ? 0 : (1<<5)) ;
+        // set active row low  : 0
+        // set other rows hi-Z : 1
+        // and all of them hi-Z once the last row has been read
+        left_select[i][0] = GPIOA;
+        left_select[i][1] = i < LEFT_ROWS ? 0xFF & ~(1<<i) : 0xFF;
+        t->segment[t->segments++] = (twi_segment_t){
+            .read = false, .length = 2, .data = left_select[i] };
+        if (!twi_queue(t)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Waits for the left half, returns false if the MCP23018 stopped answering
+static bool left_scan_finish(void)
+{
+    if (!twi_wait()) {
+        return false;
     }
+    for (uint8_t i = 0; i <= LEFT_ROWS; i++) {
+        if (left_scan[i].status != TWI_DONE) {
+            return false;
+        }
+    }
+    for (uint8_t i = 0; i < LEFT_ROWS; i++) {
+        left_cols[i] = ~left_cols[i];
+    }
+    return true;
+}
+
+static matrix_row_t read_cols(uint8_t row)
+{
+    // read from teensy
+    return
+        (PINF&(1<<0) ? 0 : (1<<0)) |
+        (PINF&(1<<1) ? 0 : (1<<1)) |
+        (PINF&(1<<4) ? 0 : (1<<2)) |
+        (PINF&(1<<5) ? 0 : (1<<3)) |
+        (PINF&(1<<6) ? 0 : (1<<4)) |
+        (PINF&(1<<7) ? 0 : (1<<5)) ;
 }
 
 /* Row pin configuration
@@ -315,19 +368,8 @@ static matrix_row_t read_cols(uint8_t row)
  */
 static void unselect_rows(void)
 {
-    // unselect on mcp23018
-    if (mcp23018_status) { // if there was an error
-        // do nothing
-    } else {
-        // set all rows hi-Z : 1
-        mcp23018_status = i2c_start(I2C_ADDR_WRITE);    if (mcp23018_status) goto out;
-        mcp23018_status = i2c_write(GPIOA);             if (mcp23018_status) goto out;
-        mcp23018_status = i2c_write( 0xFF
-                              & ~(0<<7)
-                          );                            if (mcp23018_status) goto out;
-    out:
-        i2c_stop();
-    }
+    // the mcp23018 rows are unselected by the last transaction of
+    // left_scan_start()
 
     // unselect on teensy
     // Hi-Z(DDR:0, PORT:0) to unselect
@@ -341,54 +383,39 @@ static void unselect_rows(void)
 
 static void select_row(uint8_t row)
 {
-    if (row < 7) {
-        // select on mcp23018
-        if (mcp23018_status) { // if there was an error
-            // do nothing
-        } else {
-            // set active row low  : 0
-            // set other rows hi-Z : 1
-            mcp23018_status = i2c_start(I2C_ADDR_WRITE);        if (mcp23018_status) goto out;
-            mcp23018_status = i2c_write(GPIOA);                 if (mcp23018_status) goto out;
-            mcp23018_status = i2c_write( 0xFF & ~(1<<row)
-                                  & ~(0<<7)
-                              );                                if (mcp23018_status) goto out;
-        out:
-            i2c_stop();
-        }
-    } else {
-        // select on teensy
-        // Output low(DDR:1, PORT:0) to select
-        switch (row) {
-            case 7:
-                DDRB  |= (1<<0);
-                PORTB &= ~(1<<0);
-                break;
-            case 8:
-                DDRB  |= (1<<1);
-                PORTB &= ~(1<<1);
-                break;
-            case 9:
-                DDRB  |= (1<<2);
-                PORTB &= ~(1<<2);
-                break;
-            case 10:
-                DDRB  |= (1<<3);
-                PORTB &= ~(1<<3);
-                break;
-            case 11:
-                DDRD  |= (1<<2);
-                PORTD &= ~(1<<3);
-                break;
-            case 12:
-                DDRD  |= (1<<3);
-                PORTD &= ~(1<<3);
-                break;
-            case 13:
-                DDRC  |= (1<<6);
-                PORTC &= ~(1<<6);
-                break;
-        }
+    // the mcp23018 rows are selected by left_scan_start()
+
+    // select on teensy
+    // Output low(DDR:1, PORT:0) to select
+    switch (row) {
+        case 7:
+            DDRB  |= (1<<0);
+            PORTB &= ~(1<<0);
+            break;
+        case 8:
+            DDRB  |= (1<<1);
+            PORTB &= ~(1<<1);
+            break;
+        case 9:
+            DDRB  |= (1<<2);
+            PORTB &= ~(1<<2);
+            break;
+        case 10:
+            DDRB  |= (1<<3);
+            PORTB &= ~(1<<3);
+            break;
+        case 11:
+            DDRD  |= (1<<2);
+            PORTD &= ~(1<<3);
+            break;
+        case 12:
+            DDRD  |= (1<<3);
+            PORTD &= ~(1<<3);
+            break;
+        case 13:
+            DDRC  |= (1<<6);
+            PORTC &= ~(1<<6);
+            break;
     }
 }
 
@@ -16,6 +16,7 @@
 
 # # project specific files
 SRC = twimaster.c \
+	  twi_async.c \
 	  matrix.c
 
 # MCU name
@@ -0,0 +1,169 @@
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <util/twi.h>
+#include <util/delay.h>
+#include "timer.h"
+#include "twi_async.h"
+
+#define TWCR_NEXT ((1<<TWINT) | (1<<TWEN) | (1<<TWIE))
+#define TWCR_STOP ((1<<TWINT) | (1<<TWEN) | (1<<TWSTO))
+
+static twi_transaction_t* volatile queue[TWI_QUEUE_SIZE];
+static volatile uint8_t queue_head;
+static volatile uint8_t queue_count;
+static volatile bool online;
+static uint16_t reconnect_timer;
+
+// Position inside the running transaction, owned by the interrupt
+static uint8_t segment;
+static uint8_t position;
+
+static void fail_all(void) {
+    if (queue_count) {
+        TWCR = TWCR_STOP;
+    }
+    while (queue_count) {
+        queue[queue_head]->status = TWI_ERROR;
+        queue_head = (queue_head + 1) % TWI_QUEUE_SIZE;
+        queue_count--;
+    }
+    online = false;
+}
+
+// A stop is done within a couple of bit times, unless something holds the
+// bus down. Then the TWI is reset, which lets go of both lines, and the bus
+// goes offline. Runs with interrupts enabled.
+static bool wait_stop(void) {
+    for (uint16_t us = 0; TWCR & (1<<TWSTO); us++) {
+        if (us >= TWI_STOP_TIMEOUT) {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                fail_all();
+                TWCR = 0;
+            }
+            return false;
+        }
+        _delay_us(1);
+    }
+    return true;
+}
+
+static void next_transaction(void) {
+    queue[queue_head]->status = TWI_DONE;
+    queue_head = (queue_head + 1) % TWI_QUEUE_SIZE;
+    queue_count--;
+    segment = 0;
+    if (queue_count) {
+        // stop, followed right away by the start of the next one
+        TWCR = TWCR_NEXT | (1<<TWSTO) | (1<<TWSTA);
+    } else {
+        TWCR = TWCR_STOP;
+    }
+}
+
+ISR(TWI_vect) {
+    twi_transaction_t* t = queue[queue_head];
+    twi_segment_t* s = &t->segment[segment];
+
+    switch (TW_STATUS) {
+        case TW_START:
+        case TW_REP_START:
+            position = 0;
+            TWDR = (t->address << 1) | (s->read ? TW_READ : TW_WRITE);
+            TWCR = TWCR_NEXT;
+            return;
+        case TW_MT_SLA_ACK:
+        case TW_MT_DATA_ACK:
+            if (position < s->length) {
+                TWDR = s->data[position++];
+                TWCR = TWCR_NEXT;
+                return;
+            }
+            break;
+        case TW_MR_DATA_ACK:
+            s->data[position++] = TWDR;
+            // fall through
+        case TW_MR_SLA_ACK:
+            // acknowledge everything but the last byte
+            TWCR = TWCR_NEXT | (position + 1 < s->length ? (1<<TWEA) : 0);
+            return;
+        case TW_MR_DATA_NACK:
+            s->data[position++] = TWDR;
+            break;
+        default:
+            // not acknowledged, arbitration lost or bus error
+            fail_all();
+            return;
+    }
+
+    if (++segment < t->segments) {
+        TWCR = TWCR_NEXT | (1<<TWSTA);
+    } else {
+        next_transaction();
+    }
+}
+
+bool twi_queue(twi_transaction_t* t) {
+    for (;;) {
+        // the stop ending the previous transaction may still be on the wire
+        if (!queue_count && !wait_stop()) {
+            return false;
+        }
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            if (!online || queue_count >= TWI_QUEUE_SIZE) {
+                return false;
+            }
+            // unless the queue ran out and sent its stop in the meantime
+            if (queue_count || !(TWCR & (1<<TWSTO))) {
+                t->status = TWI_PENDING;
+                queue[(queue_head + queue_count) % TWI_QUEUE_SIZE] = t;
+                if (queue_count++ == 0) {
+                    segment = 0;
+                    TWCR = TWCR_NEXT | (1<<TWSTA);
+                }
+                return true;
+            }
+        }
+    }
+}
+
+bool twi_busy(void) {
+    return queue_count != 0;
+}
+
+bool twi_wait(void) {
+    uint16_t start = timer_read();
+    while (queue_count) {
+        if (timer_elapsed(start) > TWI_TIMEOUT) {
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                fail_all();
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+bool twi_online(void) {
+    return online;
+}
+
+bool twi_connect(uint8_t (*init)(void)) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        fail_all();
+    }
+    if (!wait_stop()) {
+        reconnect_timer = timer_read();
+        return false;
+    }
+    online = init() == 0;
+    reconnect_timer = timer_read();
+    return online;
+}
+
+bool twi_reconnect(uint8_t (*init)(void)) {
+    if (timer_elapsed(reconnect_timer) < TWI_RECONNECT_INTERVAL) {
+        return false;
+    }
+    return twi_connect(init);
+}
@@ -0,0 +1,79 @@
+#ifndef TWI_ASYNC_H
+#define TWI_ASYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Interrupt driven TWI master
+ *
+ * Transactions are queued by the caller and run back to back from the TWI
+ * interrupt, so the bus keeps moving while the main loop does something
+ * else. A transaction addresses one device with up to two segments, each
+ * one a write or a read, joined by a repeated start.
+ *
+ * The blocking functions of i2cmaster.h still work whenever the queue is
+ * empty, they are the fallback used to set devices up.
+ */
+
+#ifndef TWI_QUEUE_SIZE
+#define TWI_QUEUE_SIZE 8
+#endif
+
+// ms to wait for the queue to drain before giving up on the bus
+#ifndef TWI_TIMEOUT
+#define TWI_TIMEOUT 10
+#endif
+
+// ms between attempts to bring back a device that stopped answering
+#ifndef TWI_RECONNECT_INTERVAL
+#define TWI_RECONNECT_INTERVAL 1000
+#endif
+
+// us to wait for a stop to get onto the bus before resetting the TWI
+#ifndef TWI_STOP_TIMEOUT
+#define TWI_STOP_TIMEOUT 500
+#endif
+
+#define TWI_SEGMENTS 2
+
+// Transaction status
+#define TWI_PENDING 0
+#define TWI_DONE 1
+#define TWI_ERROR 2
+
+typedef struct {
+    bool read;
+    uint8_t length;
+    uint8_t* data;
+} twi_segment_t;
+
+typedef struct {
+    uint8_t address;  // 7 bit, without the R/W bit
+    uint8_t segments;
+    twi_segment_t segment[TWI_SEGMENTS];
+    volatile uint8_t status;
+} twi_transaction_t;
+
+// Queues a transaction, the caller keeps it alive until its status is no
+// longer TWI_PENDING. Returns false if the queue is full, the bus is
+// offline, or the last stop never got onto the bus, which resets the TWI
+// and takes the bus offline.
+bool twi_queue(twi_transaction_t* t);
+bool twi_busy(void);
+// Waits until every queued transaction has finished. Returns false and
+// takes the bus offline if that takes longer than TWI_TIMEOUT.
+bool twi_wait(void);
+
+// Any failed transaction takes the bus offline and fails everything else
+// in the queue until the device has been set up again
+bool twi_online(void);
+// Sets the device up with init, which uses the blocking functions and
+// returns 0 on success. The bus is online if that worked; it stays offline
+// without calling init if the bus is held down.
+bool twi_connect(uint8_t (*init)(void));
+// Calls twi_connect at most once every TWI_RECONNECT_INTERVAL, for
+// devices that stopped answering. Returns true when the device came back.
+bool twi_reconnect(uint8_t (*init)(void));
+
+#endif
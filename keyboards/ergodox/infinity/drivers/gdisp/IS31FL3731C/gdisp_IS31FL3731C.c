@@ -113,6 +113,10 @@ typedef struct{
     uint8_t write_buffer[IS31_FRAME_SIZE];
     uint8_t frame_buffer[GDISP_SCREEN_HEIGHT * GDISP_SCREEN_WIDTH];
     uint8_t page;
+    // PWM registers changed since each of the two display pages was last
+    // written. Empty when first > last.
+    uint8_t dirty_first[2];
+    uint8_t dirty_last[2];
 }__attribute__((__packed__)) PrivData;
 
 // Some common routines and macros
@@ -143,6 +147,19 @@ static GFXINLINE void write_ram(GDisplay *g, uint8_t page, uint16_t offset, uint
     write_data(g, (uint8_t*)PRIV(g), length + 1);
 }
 
+// Writes count PWM registers starting at first from the write buffer
+static GFXINLINE void write_pwm(GDisplay *g, uint8_t page, uint8_t first, uint8_t count) {
+    // The register address has to go out in the same transfer, right in
+    // front of the data, so borrow the byte before it. For the first
+    // register that's write_buffer_offset.
+    uint8_t* tx = &PRIV(g)->write_buffer[first] - 1;
+    uint8_t saved = *tx;
+    *tx = IS31_PWM_REG + first;
+    write_page(g, page);
+    write_data(g, tx, count + 1);
+    *tx = saved;
+}
+
 LLDSPEC bool_t gdisp_lld_init(GDisplay *g) {
 	// The private area is the display surface.
 	g->priv = gfxAlloc(sizeof(PrivData));
@@ -172,6 +189,14 @@ LLDSPEC bool_t gdisp_lld_init(GDisplay *g) {
         gfxSleepMilliseconds(1);
     }
 
+    // the PWM values are kept ready in the write buffer from now on, and
+    // everything is zero on both pages
+    __builtin_memset(PRIV(g)->write_buffer, 0, IS31_FRAME_SIZE);
+    for (uint8_t i=0; i<2; i++) {
+        PRIV(g)->dirty_first[i] = IS31_PWM_SIZE - 1;
+        PRIV(g)->dirty_last[i] = 0;
+    }
+
     // software shutdown disable (i.e. turn stuff on)
     write_register(g, IS31_FUNCTIONREG, IS31_REG_SHUTDOWN, IS31_REG_SHUTDOWN_ON);
     gfxSleepMilliseconds(10);
@@ -197,19 +222,17 @@ LLDSPEC bool_t gdisp_lld_init(GDisplay *g) {
 
 		PRIV(g)->page++;
 		PRIV(g)->page %= 2;
-		// TODO: some smarter algorithm for this
-		// We should run only one physical page at a time
-		// This way we don't need to send so much data, and
-		// we could use slightly less memory
-		uint8_t* src = PRIV(g)->frame_buffer;
-		for (int y=0;y<GDISP_SCREEN_HEIGHT;y++) {
-		    for (int x=0;x<GDISP_SCREEN_WIDTH;x++) {
-		        PRIV(g)->write_buffer[get_led_address(g, x, y)]=CIE1931_CURVE[*src];
-		        ++src;
-		    }
+		// Only the registers that changed since this page was last shown
+		// are sent, the other page still has everything else
+		uint8_t page = PRIV(g)->page;
+		uint8_t first = PRIV(g)->dirty_first[page];
+		uint8_t last = PRIV(g)->dirty_last[page];
+		if (first <= last) {
+		    write_pwm(g, page, first, last - first + 1);
+		    gfxSleepMilliseconds(1);
 		}
-        write_ram(g, PRIV(g)->page, IS31_PWM_REG, IS31_PWM_SIZE);
-        gfxSleepMilliseconds(1);
+		PRIV(g)->dirty_first[page] = IS31_PWM_SIZE - 1;
+		PRIV(g)->dirty_last[page] = 0;
         write_register(g, IS31_FUNCTIONREG, IS31_REG_PICTDISP, PRIV(g)->page);
 
 		g->flags &= ~GDISP_FLG_NEEDFLUSH;
@@ -231,7 +254,18 @@ LLDSPEC bool_t gdisp_lld_init(GDisplay *g) {
 			y = g->p.y;
 			break;
 		}
-		PRIV(g)->frame_buffer[y * GDISP_SCREEN_WIDTH + x] = gdispColor2Native(g->p.color);
+		uint8_t value = gdispColor2Native(g->p.color);
+		if (PRIV(g)->frame_buffer[y * GDISP_SCREEN_WIDTH + x] == value)
+			return;
+		PRIV(g)->frame_buffer[y * GDISP_SCREEN_WIDTH + x] = value;
+		uint8_t address = get_led_address(g, x, y);
+		PRIV(g)->write_buffer[address] = CIE1931_CURVE[value];
+		for (uint8_t i=0; i<2; i++) {
+			if (address < PRIV(g)->dirty_first[i])
+				PRIV(g)->dirty_first[i] = address;
+			if (address > PRIV(g)->dirty_last[i])
+				PRIV(g)->dirty_last[i] = address;
+		}
 		g->flags |= GDISP_FLG_NEEDFLUSH;
 	}
 #endif
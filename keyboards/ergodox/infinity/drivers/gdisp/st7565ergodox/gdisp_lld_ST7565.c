@@ -56,11 +56,17 @@
 /* Driver local functions.                                                   */
 /*===========================================================================*/
 
+#define GDISP_PAGES (GDISP_SCREEN_HEIGHT / 8)
+
 typedef struct{
     bool_t buffer2;
     uint8_t data_pos;
     uint8_t data[16];
     uint8_t ram[GDISP_SCREEN_HEIGHT * GDISP_SCREEN_WIDTH / 8];
+    // Columns changed since each of the two display buffers was last
+    // written, per page. Empty when first > last.
+    uint8_t dirty_first[2][GDISP_PAGES];
+    uint8_t dirty_last[2][GDISP_PAGES];
 }PrivData;
 
 // Some common routines and macros
@@ -86,6 +92,31 @@ static GFXINLINE void flush_cmd(GDisplay* g) {
 #define xyaddr(x, y)		((x) + ((y)>>3)*GDISP_SCREEN_WIDTH)
 #define xybit(y)			(1<<((y)&7))
 
+static void clear_dirty(GDisplay* g, unsigned buffer) {
+    for (unsigned p = 0; p < GDISP_PAGES; p++) {
+        PRIV(g)->dirty_first[buffer][p] = GDISP_SCREEN_WIDTH - 1;
+        PRIV(g)->dirty_last[buffer][p] = 0;
+    }
+}
+
+// Sets or clears a pixel in the display memory, only changed bytes are
+// sent by the next flush
+static void set_pixel(GDisplay* g, coord_t x, coord_t y, bool_t on) {
+    uint8_t* dst = &RAM(g)[xyaddr(x, y)];
+    uint8_t value = on ? (*dst | xybit(y)) : (*dst & ~xybit(y));
+    if (value == *dst)
+        return;
+    *dst = value;
+    unsigned p = y >> 3;
+    for (unsigned b = 0; b < 2; b++) {
+        if (x < PRIV(g)->dirty_first[b][p])
+            PRIV(g)->dirty_first[b][p] = x;
+        if (x > PRIV(g)->dirty_last[b][p])
+            PRIV(g)->dirty_last[b][p] = x;
+    }
+    g->flags |= GDISP_FLG_NEEDFLUSH;
+}
+
 /*===========================================================================*/
 /* Driver exported functions.                                                */
 /*===========================================================================*/
@@ -102,6 +133,14 @@ LLDSPEC bool_t gdisp_lld_init(GDisplay *g) {
     g->priv = gfxAlloc(sizeof(PrivData));
     PRIV(g)->buffer2 = false;
     PRIV(g)->data_pos = 0;
+    // Nothing is known about the display memory yet, so the first flush
+    // of each buffer writes all of it
+    for (unsigned b = 0; b < 2; b++) {
+        for (unsigned p = 0; p < GDISP_PAGES; p++) {
+            PRIV(g)->dirty_first[b][p] = 0;
+            PRIV(g)->dirty_last[b][p] = GDISP_SCREEN_WIDTH - 1;
+        }
+    }
 
     // Initialise the board interface
     init_board(g);
@@ -158,17 +197,23 @@ LLDSPEC void gdisp_lld_flush(GDisplay *g) {
 
     acquire_bus(g);
     enter_cmd_mode(g);
+    unsigned buffer = (PRIV(g)->buffer2 ? 1 : 0);
     unsigned dstOffset = (PRIV(g)->buffer2 ? 4 : 0);
-    for (p = 0; p < 4; p++) {
+    for (p = 0; p < GDISP_PAGES; p++) {
+        unsigned first = PRIV(g)->dirty_first[buffer][p];
+        unsigned last = PRIV(g)->dirty_last[buffer][p];
+        if (first > last)
+            continue;
         write_cmd(g, ST7565_PAGE | (p + dstOffset));
-        write_cmd(g, ST7565_COLUMN_MSB | 0);
-        write_cmd(g, ST7565_COLUMN_LSB | 0);
+        write_cmd(g, ST7565_COLUMN_MSB | (first >> 4));
+        write_cmd(g, ST7565_COLUMN_LSB | (first & 0xF));
         write_cmd(g, ST7565_RMW);
         flush_cmd(g);
         enter_data_mode(g);
-        write_data(g, RAM(g) + (p*GDISP_SCREEN_WIDTH), GDISP_SCREEN_WIDTH);
+        write_data(g, RAM(g) + (p*GDISP_SCREEN_WIDTH) + first, last - first + 1);
         enter_cmd_mode(g);
     }
+    clear_dirty(g, buffer);
     unsigned line = (PRIV(g)->buffer2 ? 32 : 0);
     write_cmd(g, ST7565_START_LINE | line);
     flush_cmd(g);
@@ -202,11 +247,7 @@ LLDSPEC void gdisp_lld_draw_pixel(GDisplay *g) {
         y = g->p.x;
         break;
     }
-    if (gdispColor2Native(g->p.color) != Black)
-        RAM(g)[xyaddr(x, y)] |= xybit(y);
-    else
-        RAM(g)[xyaddr(x, y)] &= ~xybit(y);
-    g->flags |= GDISP_FLG_NEEDFLUSH;
+    set_pixel(g, x, y, gdispColor2Native(g->p.color) != Black);
 }
 #endif
 
@@ -250,18 +291,11 @@ LLDSPEC void gdisp_lld_blit_area(GDisplay *g) {
             uint8_t src = buffer[srcbit / 8];
             uint8_t bit = 7-(srcbit % 8);
             uint8_t bitset = (src >> bit) & 1;
-            uint8_t* dst = &(RAM(g)[xyaddr(dstx, dsty)]);
-            if (bitset) {
-                *dst |= xybit(dsty);
-            }
-            else {
-                *dst &= ~xybit(dsty);
-            }
+            set_pixel(g, dstx, dsty, bitset);
 			dstx++;
             srcbit++;
         }
     }
-    g->flags |= GDISP_FLG_NEEDFLUSH;
 }
 
 #if GDISP_NEED_CONTROL && GDISP_HARDWARE_CONTROL
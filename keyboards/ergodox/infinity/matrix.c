@@ -134,6 +134,11 @@ uint8_t matrix_scan(void)
     return 1;
 }
 
+bool matrix_is_debouncing(void)
+{
+    return debouncing;
+}
+
 bool matrix_is_on(uint8_t row, uint8_t col)
 {
     return (matrix[row] & (1<<col));
@@ -83,6 +83,7 @@ static keyframe_animation_t one_led_color = {
 };
 
 bool swap_led_target_color(keyframe_animation_t* animation, visualizer_state_t* state) {
+    visualizer_invalidate_nothing(state);
     uint32_t temp = next_led_target_color;
     next_led_target_color = state->target_lcd_color;
     state->target_lcd_color = temp;
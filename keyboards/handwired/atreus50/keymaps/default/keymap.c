@@ -131,20 +131,20 @@ const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
 };
 
 #ifdef AUDIO_ENABLE
-float tone_startup[][2] = {
-  {NOTE_B5, 20},
-  {NOTE_B6, 8},
-  {NOTE_DS6, 20},
-  {NOTE_B6, 8}
+const uint8_t tone_startup[] PROGMEM = {
+  SONG_DURATION(20), SONG_NOTE(5, 11),
+  SONG_DURATION(8),  SONG_NOTE(6, 11),
+  SONG_DURATION(20), SONG_NOTE(6, 3),
+  SONG_DURATION(8),  SONG_NOTE(6, 11)
 };
 
-float tone_qwerty[][2]     = SONG(QWERTY_SOUND);
-float tone_dvorak[][2]     = SONG(DVORAK_SOUND);
-float tone_colemak[][2]    = SONG(COLEMAK_SOUND);
+const uint8_t tone_qwerty[] PROGMEM     = SONG_BYTES(QWERTY_SOUND);
+const uint8_t tone_dvorak[] PROGMEM     = SONG_BYTES(DVORAK_SOUND);
+const uint8_t tone_colemak[] PROGMEM    = SONG_BYTES(COLEMAK_SOUND);
 
-float tone_goodbye[][2] = SONG(GOODBYE_SOUND);
+const uint8_t tone_goodbye[] PROGMEM = SONG_BYTES(GOODBYE_SOUND);
 
-float music_scale[][2]     = SONG(MUSIC_SCALE_SOUND);
+const uint8_t music_scale[] PROGMEM     = SONG_BYTES(MUSIC_SCALE_SOUND);
 #endif
 
 void persistent_default_layer_set(uint16_t default_layer) {
@@ -157,7 +157,7 @@ bool process_record_user(uint16_t keycode, keyrecord_t *record) {
         case QWERTY:
           if (record->event.pressed) {
             #ifdef AUDIO_ENABLE
-              PLAY_NOTE_ARRAY(tone_qwerty, false, 0);
+              PLAY_SONG(tone_qwerty, false, 0);
             #endif
             persistent_default_layer_set(1UL<<_QWERTY);
           }
@@ -166,7 +166,7 @@ bool process_record_user(uint16_t keycode, keyrecord_t *record) {
         case COLEMAK:
           if (record->event.pressed) {
             #ifdef AUDIO_ENABLE
-              PLAY_NOTE_ARRAY(tone_colemak, false, 0);
+              PLAY_SONG(tone_colemak, false, 0);
             #endif
             persistent_default_layer_set(1UL<<_COLEMAK);
           }
@@ -175,7 +175,7 @@ bool process_record_user(uint16_t keycode, keyrecord_t *record) {
         case DVORAK:
           if (record->event.pressed) {
             #ifdef AUDIO_ENABLE
-              PLAY_NOTE_ARRAY(tone_dvorak, false, 0);
+              PLAY_SONG(tone_dvorak, false, 0);
             #endif
             persistent_default_layer_set(1UL<<_DVORAK);
           }
@@ -227,12 +227,12 @@ void matrix_init_user(void) {
 void startup_user()
 {
     _delay_ms(20); // gets rid of tick
-    PLAY_NOTE_ARRAY(tone_startup, false, 0);
+    PLAY_SONG(tone_startup, false, 0);
 }
 
 void shutdown_user()
 {
-    PLAY_NOTE_ARRAY(tone_goodbye, false, 0);
+    PLAY_SONG(tone_goodbye, false, 0);
     _delay_ms(150);
     stop_all_notes();
 }
@@ -244,7 +244,7 @@ void music_on_user(void)
 
 void music_scale_user(void)
 {
-    PLAY_NOTE_ARRAY(music_scale, false, 0);
+    PLAY_SONG(music_scale, false, 0);
 }
 
 #endif
@@ -63,4 +63,5 @@ CONSOLE_ENABLE ?= yes	# Console for debug
 COMMAND_ENABLE ?= yes    # Commands for debug and configuration
 SLEEP_LED_ENABLE ?= yes  # Breathing sleep LED during USB suspend
 NKRO_ENABLE ?= yes	    # USB Nkey Rollover
+#IDLE_SCAN_ENABLE ?= yes # Rest between scans while idle
 CUSTOM_MATRIX ?= yes # Custom matrix file
\ No newline at end of file
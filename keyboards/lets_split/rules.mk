@@ -1,8 +1,6 @@
-SRC += matrix.c \
-	   i2c.c \
-	   split_util.c \
-	   serial.c \
-	   ssd1306.c
+SRC += ssd1306.c
+
+SPLIT_KEYBOARD = yes
 
 # MCU name
 #MCU = at90usb1287
@@ -70,10 +68,10 @@ BLUETOOTH_ENABLE ?= no       # Enable Bluetooth with the Adafruit EZ-Key HID
 RGBLIGHT_ENABLE ?= no       # Enable WS2812 RGB underlight.  Do not enable this with audio at the same time.
 SUBPROJECT_rev1 ?= yes
 USE_I2C ?= yes
+# Do not enable BACKLIGHT_ENABLE with the serial link, it uses timer1 for the bit clock
 # Do not enable SLEEP_LED_ENABLE. it uses the same timer as BACKLIGHT_ENABLE
 SLEEP_LED_ENABLE ?= no    # Breathing sleep LED during USB suspend
 
-CUSTOM_MATRIX = yes
 
 avrdude: build
 	ls /dev/tty* > /tmp/1; \
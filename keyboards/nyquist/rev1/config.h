@@ -39,6 +39,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #define CATERINA_BOOTLOADER
 
+/* i2c SCL clock frequency of the split link */
+#define SCL_CLOCK 100000L
+
 /* COL2ROW or ROW2COL */
 #define DIODE_DIRECTION COL2ROW
 
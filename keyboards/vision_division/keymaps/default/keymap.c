@@ -279,23 +279,23 @@ KEYMAP(LAYER_ADJUST, \
 
 #ifdef AUDIO_ENABLE
 
-float tone_my_startup[][2] = SONG(ODE_TO_JOY);
-float tone_my_goodbye[][2] = SONG(ROCK_A_BYE_BABY);
+const uint8_t tone_my_startup[] PROGMEM = SONG_BYTES(ODE_TO_JOY);
+const uint8_t tone_my_goodbye[] PROGMEM = SONG_BYTES(ROCK_A_BYE_BABY);
 
-float tone_qwerty[][2]     = SONG(QWERTY_SOUND);
-float tone_dvorak[][2]     = SONG(DVORAK_SOUND);
-float tone_colemak[][2]    = SONG(COLEMAK_SOUND);
+const uint8_t tone_qwerty[] PROGMEM     = SONG_BYTES(QWERTY_SOUND);
+const uint8_t tone_dvorak[] PROGMEM     = SONG_BYTES(DVORAK_SOUND);
+const uint8_t tone_colemak[] PROGMEM    = SONG_BYTES(COLEMAK_SOUND);
 
-float tone_audio_on[][2]   = SONG(CLOSE_ENCOUNTERS_5_NOTE);
-float tone_music_on[][2]   = SONG(DOE_A_DEER);
-float music_scale[][2]     = SONG(MUSIC_SCALE_SOUND);
+const uint8_t tone_audio_on[] PROGMEM   = SONG_BYTES(CLOSE_ENCOUNTERS_5_NOTE);
+const uint8_t tone_music_on[] PROGMEM   = SONG_BYTES(DOE_A_DEER);
+const uint8_t music_scale[] PROGMEM     = SONG_BYTES(MUSIC_SCALE_SOUND);
 
-float tone_caps_on[][2]    = SONG(CAPS_LOCK_ON_SOUND);
-float tone_caps_off[][2]   = SONG(CAPS_LOCK_OFF_SOUND);
-float tone_numlk_on[][2]   = SONG(NUM_LOCK_ON_SOUND);
-float tone_numlk_off[][2]  = SONG(NUM_LOCK_OFF_SOUND);
-float tone_scroll_on[][2]  = SONG(SCROLL_LOCK_ON_SOUND);
-float tone_scroll_off[][2] = SONG(SCROLL_LOCK_OFF_SOUND);
+const uint8_t tone_caps_on[] PROGMEM    = SONG_BYTES(CAPS_LOCK_ON_SOUND);
+const uint8_t tone_caps_off[] PROGMEM   = SONG_BYTES(CAPS_LOCK_OFF_SOUND);
+const uint8_t tone_numlk_on[] PROGMEM   = SONG_BYTES(NUM_LOCK_ON_SOUND);
+const uint8_t tone_numlk_off[] PROGMEM  = SONG_BYTES(NUM_LOCK_OFF_SOUND);
+const uint8_t tone_scroll_on[] PROGMEM  = SONG_BYTES(SCROLL_LOCK_ON_SOUND);
+const uint8_t tone_scroll_off[] PROGMEM = SONG_BYTES(SCROLL_LOCK_OFF_SOUND);
 
 #endif /* AUDIO_ENABLE */
 
@@ -559,32 +559,32 @@ void led_set_user(uint8_t usb_led)
     if ((usb_led & (1<<USB_LED_CAPS_LOCK)) && !(old_usb_led & (1<<USB_LED_CAPS_LOCK)))
     {
       // If CAPS LK LED is turning on...
-      PLAY_NOTE_ARRAY(tone_caps_on,  false, LEGATO);
+      PLAY_SONG(tone_caps_on,  false, LEGATO);
     }
     else if (!(usb_led & (1<<USB_LED_CAPS_LOCK)) && (old_usb_led & (1<<USB_LED_CAPS_LOCK)))
     {
       // If CAPS LK LED is turning off...
-      PLAY_NOTE_ARRAY(tone_caps_off, false, LEGATO);
+      PLAY_SONG(tone_caps_off, false, LEGATO);
     }
     else if ((usb_led & (1<<USB_LED_NUM_LOCK)) && !(old_usb_led & (1<<USB_LED_NUM_LOCK)))
     {
       // If NUM LK LED is turning on...
-      PLAY_NOTE_ARRAY(tone_numlk_on,  false, LEGATO);
+      PLAY_SONG(tone_numlk_on,  false, LEGATO);
     }
     else if (!(usb_led & (1<<USB_LED_NUM_LOCK)) && (old_usb_led & (1<<USB_LED_NUM_LOCK)))
     {
       // If NUM LED is turning off...
-      PLAY_NOTE_ARRAY(tone_numlk_off, false, LEGATO);
+      PLAY_SONG(tone_numlk_off, false, LEGATO);
     }
     else if ((usb_led & (1<<USB_LED_SCROLL_LOCK)) && !(old_usb_led & (1<<USB_LED_SCROLL_LOCK)))
     {
       // If SCROLL LK LED is turning on...
-      PLAY_NOTE_ARRAY(tone_scroll_on,  false, LEGATO);
+      PLAY_SONG(tone_scroll_on,  false, LEGATO);
     }
     else if (!(usb_led & (1<<USB_LED_SCROLL_LOCK)) && (old_usb_led & (1<<USB_LED_SCROLL_LOCK)))
     {
       // If SCROLL LED is turning off...
-      PLAY_NOTE_ARRAY(tone_scroll_off, false, LEGATO);
+      PLAY_SONG(tone_scroll_off, false, LEGATO);
     }
   }
 
@@ -594,29 +594,29 @@ void led_set_user(uint8_t usb_led)
 void startup_user()
 {
   _delay_ms(10); // gets rid of tick
-  // PLAY_NOTE_ARRAY(tone_my_startup, false, STACCATO);
+  // PLAY_SONG(tone_my_startup, false, STACCATO);
 }
 
 void shutdown_user()
 {
-  // PLAY_NOTE_ARRAY(tone_my_goodbye, false, STACCATO);
+  // PLAY_SONG(tone_my_goodbye, false, STACCATO);
   _delay_ms(2000);
   stop_all_notes();
 }
 
 void audio_on_user(void)
 {
-  PLAY_NOTE_ARRAY(tone_audio_on, false, STACCATO);
+  PLAY_SONG(tone_audio_on, false, STACCATO);
 }
 
 void music_on_user(void)
 {
-  PLAY_NOTE_ARRAY(tone_music_on, false, STACCATO);
+  PLAY_SONG(tone_music_on, false, STACCATO);
 }
 
 void music_scale_user(void)
 {
-  PLAY_NOTE_ARRAY(music_scale, false, STACCATO);
+  PLAY_SONG(music_scale, false, STACCATO);
 }
 
 #endif /* AUDIO_ENABLE */
\ No newline at end of file
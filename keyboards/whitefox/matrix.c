@@ -6,6 +6,9 @@
 #include "wait.h"
 #include "print.h"
 #include "matrix.h"
+#ifdef IDLE_SCAN_ENABLE
+#include "idle_scan.h"
+#endif
 
 
 /*
@@ -22,6 +25,24 @@ static matrix_row_t matrix_debouncing[MATRIX_ROWS];
 static bool debouncing = false;
 static uint16_t debouncing_time = 0;
 
+#ifdef IDLE_SCAN_ENABLE
+#define ROWS_B      ((1UL << 2) | (1UL << 3) | (1UL << 18) | (1UL << 19))
+#define ROWS_C      ((1UL << 0) | (1UL << 8) | (1UL << 9) | (1UL << 10) | (1UL << 11))
+#define COLS_C      ((1UL << 1) | (1UL << 2))
+#define COLS_D      ((1UL << 0) | (1UL << 1) | (1UL << 4) | (1UL << 5) | (1UL << 6) | (1UL << 7))
+#define IRQC_OFF        0x0
+#define IRQC_LOGIC_ONE  0xC
+#define WAKE_IRQ_PRIORITY 2
+#endif
+
+static inline matrix_row_t read_cols(void)
+{
+    // { PTD0, PTD1, PTD4, PTD5, PTD6, PTD7, PTC1, PTC2 }
+    return ((palReadPort(GPIOC) & 0x06UL) << 5) |
+           ((palReadPort(GPIOD) & 0xF0UL) >> 2) |
+            (palReadPort(GPIOD) & 0x03UL);
+}
+
 
 void matrix_init(void)
 {
@@ -49,6 +70,11 @@ void matrix_init(void)
 
     memset(matrix, 0, MATRIX_ROWS);
     memset(matrix_debouncing, 0, MATRIX_ROWS);
+
+#ifdef IDLE_SCAN_ENABLE
+    nvicEnableVector(PORTC_IRQn, WAKE_IRQ_PRIORITY);
+    nvicEnableVector(PORTD_IRQn, WAKE_IRQ_PRIORITY);
+#endif
 }
 
 uint8_t matrix_scan(void)
@@ -71,10 +97,7 @@ uint8_t matrix_scan(void)
 
         wait_us(20); // need wait to settle pin state
 
-        // read col data: { PTD0, PTD1, PTD4, PTD5, PTD6, PTD7, PTC1, PTC2 }
-        data = ((palReadPort(GPIOC) & 0x06UL) << 5) |
-               ((palReadPort(GPIOD) & 0xF0UL) >> 2) |
-                (palReadPort(GPIOD) & 0x03UL);
+        data = read_cols();
 
         // un-strobe row
         switch (row) {
@@ -105,6 +128,11 @@ uint8_t matrix_scan(void)
     return 1;
 }
 
+bool matrix_is_debouncing(void)
+{
+    return debouncing;
+}
+
 bool matrix_is_on(uint8_t row, uint8_t col)
 {
     return (matrix[row] & (1<<col));
@@ -130,3 +158,71 @@ void matrix_print(void)
         xprintf("\n");
     }
 }
+
+#ifdef IDLE_SCAN_ENABLE
+/*
+ * Wake on a key press: with every row strobed a key pulls its column high,
+ * and the column pins interrupt on a high level. The interrupt turns
+ * itself off, as the level stays while the key is held.
+ */
+static void set_col_irqs(uint32_t irqc)
+{
+    for (uint8_t pin = 0; pin < 32; pin++) {
+        if (COLS_C & (1UL << pin)) {
+            PORTC->PCR[pin] = (PORTC->PCR[pin] & ~PORTx_PCRn_IRQC_MASK) |
+                              PORTx_PCRn_IRQC(irqc) | PORTx_PCRn_ISF;
+        }
+        if (COLS_D & (1UL << pin)) {
+            PORTD->PCR[pin] = (PORTD->PCR[pin] & ~PORTx_PCRn_IRQC_MASK) |
+                              PORTx_PCRn_IRQC(irqc) | PORTx_PCRn_ISF;
+        }
+    }
+}
+
+static void wake_from_isr(void)
+{
+    osalSysLockFromISR();
+    set_col_irqs(IRQC_OFF);
+    idle_scan_wake_i();
+    osalSysUnlockFromISR();
+}
+
+OSAL_IRQ_HANDLER(KINETIS_PORTC_IRQ_VECTOR) {
+    OSAL_IRQ_PROLOGUE();
+    wake_from_isr();
+    OSAL_IRQ_EPILOGUE();
+}
+
+OSAL_IRQ_HANDLER(KINETIS_PORTD_IRQ_VECTOR) {
+    OSAL_IRQ_PROLOGUE();
+    wake_from_isr();
+    OSAL_IRQ_EPILOGUE();
+}
+
+bool matrix_wake_enable(void)
+{
+    palSetPort(GPIOB, ROWS_B);
+    palSetPort(GPIOC, ROWS_C);
+    wait_us(20); // need wait to settle pin state
+
+    if (read_cols()) {
+        // already down: scan it instead
+        palClearPort(GPIOB, ROWS_B);
+        palClearPort(GPIOC, ROWS_C);
+        return false;
+    }
+    osalSysLock();
+    set_col_irqs(IRQC_LOGIC_ONE);
+    osalSysUnlock();
+    return true;
+}
+
+void matrix_wake_disable(void)
+{
+    osalSysLock();
+    set_col_irqs(IRQC_OFF);
+    osalSysUnlock();
+    palClearPort(GPIOB, ROWS_B);
+    palClearPort(GPIOC, ROWS_C);
+}
+#endif
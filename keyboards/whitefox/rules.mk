@@ -65,4 +65,5 @@ EXTRAKEY_ENABLE ?= yes	# Audio control and System control
 COMMAND_ENABLE ?= yes    # Commands for debug and configuration
 #SLEEP_LED_ENABLE ?= yes  # Breathing sleep LED during USB suspend
 NKRO_ENABLE ?= yes	    # USB Nkey Rollover
+#IDLE_SCAN_ENABLE ?= yes # Rest between scans while idle, wake on a key press
 CUSTOM_MATRIX ?= yes # Custom matrix file
@@ -48,6 +48,7 @@ MSG_EEPROM = Creating load file for EEPROM:
 MSG_BIN = Creating binary load file for Flash:
 MSG_EXTENDED_LISTING = Creating Extended Listing:
 MSG_SYMBOL_TABLE = Creating Symbol Table:
+MSG_TRACE_TABLE = Creating trace format table:
 MSG_LINKING = Linking:
 MSG_COMPILING = Compiling:
 MSG_COMPILING_CPP = Compiling:
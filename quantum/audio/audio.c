@@ -21,12 +21,11 @@
 #include <avr/io.h>
 #include "print.h"
 #include "audio.h"
+#include "audio_engine.h"
 #include "keymap.h"
 
 #include "eeconfig.h"
 
-#define CPU_PRESCALER 8
-
 // -----------------------------------------------------------------------------
 // Timer Abstractions
 // -----------------------------------------------------------------------------
@@ -48,52 +47,19 @@
 // -----------------------------------------------------------------------------
 
 
-int voices = 0;
-int voice_place = 0;
-float frequency = 0;
-int volume = 0;
-long position = 0;
-
-float frequencies[8] = {0, 0, 0, 0, 0, 0, 0, 0};
-int volumes[8] = {0, 0, 0, 0, 0, 0, 0, 0};
-bool sliding = false;
-
-float place = 0;
-
-uint8_t * sample;
-uint16_t sample_length = 0;
-
-bool     playing_notes = false;
-bool     playing_note = false;
-float    note_frequency = 0;
-float    note_length = 0;
-uint8_t  note_tempo = TEMPO_DEFAULT;
-float    note_timbre = TIMBRE_DEFAULT;
-uint16_t note_position = 0;
-float (* notes_pointer)[][2];
-uint16_t notes_count;
-bool     notes_repeat;
-float    notes_rest;
-bool     note_resting = false;
-
-uint8_t current_note = 0;
-uint8_t rest_counter = 0;
-
+// Settings, handed to the engine whenever they change
 #ifdef VIBRATO_ENABLE
-float vibrato_counter = 0;
 float vibrato_strength = .5;
 float vibrato_rate = 0.125;
 #endif
 
 float polyphony_rate = 0;
+uint8_t note_tempo = TEMPO_DEFAULT;
 
 static bool audio_initialized = false;
 
 audio_config_t audio_config;
 
-uint16_t envelope_index = 0;
-bool glissando = true;
-
 void audio_init()
 {
 
@@ -126,21 +92,10 @@ void stop_all_notes()
     if (!audio_initialized) {
         audio_init();
     }
-    voices = 0;
-
     DISABLE_AUDIO_COUNTER_3_ISR;
     DISABLE_AUDIO_COUNTER_3_OUTPUT;
 
-    playing_notes = false;
-    playing_note = false;
-    frequency = 0;
-    volume = 0;
-
-    for (uint8_t i = 0; i < 8; i++)
-    {
-        frequencies[i] = 0;
-        volumes[i] = 0;
-    }
+    audio_engine_stop();
 }
 
 void stop_note(float freq)
@@ -151,176 +106,32 @@ void stop_note(float freq)
         if (!audio_initialized) {
             audio_init();
         }
-        for (int i = 7; i >= 0; i--) {
-            if (frequencies[i] == freq) {
-                frequencies[i] = 0;
-                volumes[i] = 0;
-                for (int j = i; (j < 7); j++) {
-                    frequencies[j] = frequencies[j+1];
-                    frequencies[j+1] = 0;
-                    volumes[j] = volumes[j+1];
-                    volumes[j+1] = 0;
-                }
-                break;
-            }
-        }
-        voices--;
-        if (voices < 0)
-            voices = 0;
-        if (voice_place >= voices) {
-            voice_place = 0;
-        }
-        if (voices == 0) {
-            DISABLE_AUDIO_COUNTER_3_ISR;
+        DISABLE_AUDIO_COUNTER_3_ISR;
+        audio_engine_remove_voice(freq);
+        if (playing_note) {
+            ENABLE_AUDIO_COUNTER_3_ISR;
+        } else {
             DISABLE_AUDIO_COUNTER_3_OUTPUT;
-            frequency = 0;
-            volume = 0;
-            playing_note = false;
         }
     }
 }
 
-#ifdef VIBRATO_ENABLE
-
-float mod(float a, int b)
-{
-    float r = fmod(a, b);
-    return r < 0 ? r + b : r;
-}
-
-float vibrato(float average_freq) {
-    #ifdef VIBRATO_STRENGTH_ENABLE
-        float vibrated_freq = average_freq * pow(vibrato_lut[(int)vibrato_counter], vibrato_strength);
-    #else
-        float vibrated_freq = average_freq * vibrato_lut[(int)vibrato_counter];
-    #endif
-    vibrato_counter = mod((vibrato_counter + vibrato_rate * (1.0 + 440.0/average_freq)), VIBRATO_LUT_LENGTH);
-    return vibrated_freq;
-}
-
-#endif
-
 ISR(TIMER3_COMPA_vect)
 {
-    float freq;
+    audio_timer_t timer = { TIMER_3_PERIOD, TIMER_3_DUTY_CYCLE };
 
-    if (playing_note) {
-        if (voices > 0) {
-            if (polyphony_rate > 0) {
-                if (voices > 1) {
-                    voice_place %= voices;
-                    if (place++ > (frequencies[voice_place] / polyphony_rate / CPU_PRESCALER)) {
-                        voice_place = (voice_place + 1) % voices;
-                        place = 0.0;
-                    }
-                }
-
-                #ifdef VIBRATO_ENABLE
-                    if (vibrato_strength > 0) {
-                        freq = vibrato(frequencies[voice_place]);
-                    } else {
-                        freq = frequencies[voice_place];
-                    }
-                #else
-                    freq = frequencies[voice_place];
-                #endif
-            } else {
-                if (glissando) {
-                    if (frequency != 0 && frequency < frequencies[voices - 1] && frequency < frequencies[voices - 1] * pow(2, -440/frequencies[voices - 1]/12/2)) {
-                        frequency = frequency * pow(2, 440/frequency/12/2);
-                    } else if (frequency != 0 && frequency > frequencies[voices - 1] && frequency > frequencies[voices - 1] * pow(2, 440/frequencies[voices - 1]/12/2)) {
-                        frequency = frequency * pow(2, -440/frequency/12/2);
-                    } else {
-                        frequency = frequencies[voices - 1];
-                    }
-                } else {
-                    frequency = frequencies[voices - 1];
-                }
-
-                #ifdef VIBRATO_ENABLE
-                    if (vibrato_strength > 0) {
-                        freq = vibrato(frequency);
-                    } else {
-                        freq = frequency;
-                    }
-                #else
-                    freq = frequency;
-                #endif
-            }
-
-            if (envelope_index < 65535) {
-                envelope_index++;
-            }
-
-            freq = voice_envelope(freq);
-
-            if (freq < 30.517578125) {
-                freq = 30.52;
-            }
-
-            TIMER_3_PERIOD = (uint16_t)(((float)F_CPU) / (freq * CPU_PRESCALER));
-            TIMER_3_DUTY_CYCLE = (uint16_t)((((float)F_CPU) / (freq * CPU_PRESCALER)) * note_timbre);
-        }
+    if (!audio_engine_tick(&timer)) {
+        DISABLE_AUDIO_COUNTER_3_ISR;
+        DISABLE_AUDIO_COUNTER_3_OUTPUT;
+        return;
     }
 
-    if (playing_notes) {
-        if (note_frequency > 0) {
-            #ifdef VIBRATO_ENABLE
-                if (vibrato_strength > 0) {
-                    freq = vibrato(note_frequency);
-                } else {
-                    freq = note_frequency;
-                }
-            #else
-                    freq = note_frequency;
-            #endif
-
-            if (envelope_index < 65535) {
-                envelope_index++;
-            }
-            freq = voice_envelope(freq);
-
-            TIMER_3_PERIOD = (uint16_t)(((float)F_CPU) / (freq * CPU_PRESCALER));
-            TIMER_3_DUTY_CYCLE = (uint16_t)((((float)F_CPU) / (freq * CPU_PRESCALER)) * note_timbre);
-        } else {
-            TIMER_3_PERIOD = 0;
-            TIMER_3_DUTY_CYCLE = 0;
-        }
-
-        note_position++;
-        bool end_of_note = false;
-        if (TIMER_3_PERIOD > 0) {
-            end_of_note = (note_position >= (note_length / TIMER_3_PERIOD * 0xFFFF));
-        } else {
-            end_of_note = (note_position >= (note_length * 0x7FF));
-        }
-
-        if (end_of_note) {
-            current_note++;
-            if (current_note >= notes_count) {
-                if (notes_repeat) {
-                    current_note = 0;
-                } else {
-                    DISABLE_AUDIO_COUNTER_3_ISR;
-                    DISABLE_AUDIO_COUNTER_3_OUTPUT;
-                    playing_notes = false;
-                    return;
-                }
-            }
-            if (!note_resting && (notes_rest > 0)) {
-                note_resting = true;
-                note_frequency = 0;
-                note_length = notes_rest;
-                current_note--;
-            } else {
-                note_resting = false;
-                envelope_index = 0;
-                note_frequency = (*notes_pointer)[current_note][0];
-                note_length = ((*notes_pointer)[current_note][1] / 4) * (((float)note_tempo) / 100);
-            }
-
-            note_position = 0;
-        }
+    TIMER_3_PERIOD = timer.period;
+    TIMER_3_DUTY_CYCLE = timer.duty;
+    if (timer.duty) {
+        ENABLE_AUDIO_COUNTER_3_OUTPUT;
+    } else {
+        DISABLE_AUDIO_COUNTER_3_OUTPUT;
     }
 
     if (!audio_config.enable) {
@@ -337,22 +148,14 @@ void play_note(float freq, int vol) {
         audio_init();
     }
 
-    if (audio_config.enable && voices < 8) {
+    if (audio_config.enable && audio_engine_voices() < AUDIO_MAX_VOICES) {
         DISABLE_AUDIO_COUNTER_3_ISR;
 
         // Cancel notes if notes are playing
         if (playing_notes)
             stop_all_notes();
 
-        playing_note = true;
-
-        envelope_index = 0;
-
-        if (freq > 0) {
-            frequencies[voices] = freq;
-            volumes[voices] = vol;
-            voices++;
-        }
+        audio_engine_add_voice(freq);
 
         ENABLE_AUDIO_COUNTER_3_ISR;
         ENABLE_AUDIO_COUNTER_3_OUTPUT;
@@ -375,25 +178,31 @@ void play_notes(float (*np)[][2], uint16_t n_count, bool n_repeat, float n_rest)
         if (playing_note)
             stop_all_notes();
 
-        playing_notes = true;
+        audio_engine_play_notes(np, n_count, n_repeat, n_rest);
 
-        notes_pointer = np;
-        notes_count = n_count;
-        notes_repeat = n_repeat;
-        notes_rest = n_rest;
+        ENABLE_AUDIO_COUNTER_3_ISR;
+        ENABLE_AUDIO_COUNTER_3_OUTPUT;
+    }
 
-        place = 0;
-        current_note = 0;
+}
 
-        note_frequency = (*notes_pointer)[current_note][0];
-        note_length = ((*notes_pointer)[current_note][1] / 4) * (((float)note_tempo) / 100);
-        note_position = 0;
+void play_song(const uint8_t* song, uint16_t size, bool n_repeat, float n_rest)
+{
+    if (!audio_initialized) {
+        audio_init();
+    }
 
+    if (audio_config.enable) {
+        DISABLE_AUDIO_COUNTER_3_ISR;
+
+        if (playing_note)
+            stop_all_notes();
+
+        audio_engine_play_song(song, size, n_repeat, n_rest);
 
         ENABLE_AUDIO_COUNTER_3_ISR;
         ENABLE_AUDIO_COUNTER_3_OUTPUT;
     }
-
 }
 
 bool is_playing_notes(void) {
@@ -428,28 +237,30 @@ void audio_off(void) {
 
 void set_vibrato_rate(float rate) {
     vibrato_rate = rate;
+    audio_engine_set_vibrato_rate(vibrato_rate);
 }
 
 void increase_vibrato_rate(float change) {
-    vibrato_rate *= change;
+    set_vibrato_rate(vibrato_rate * change);
 }
 
 void decrease_vibrato_rate(float change) {
-    vibrato_rate /= change;
+    set_vibrato_rate(vibrato_rate / change);
 }
 
 #ifdef VIBRATO_STRENGTH_ENABLE
 
 void set_vibrato_strength(float strength) {
     vibrato_strength = strength;
+    audio_engine_set_vibrato_strength(vibrato_strength);
 }
 
 void increase_vibrato_strength(float change) {
-    vibrato_strength *= change;
+    set_vibrato_strength(vibrato_strength * change);
 }
 
 void decrease_vibrato_strength(float change) {
-    vibrato_strength /= change;
+    set_vibrato_strength(vibrato_strength / change);
 }
 
 #endif  /* VIBRATO_STRENGTH_ENABLE */
@@ -460,44 +271,46 @@ void decrease_vibrato_strength(float change) {
 
 void set_polyphony_rate(float rate) {
     polyphony_rate = rate;
+    audio_engine_set_polyphony_rate(polyphony_rate);
 }
 
 void enable_polyphony() {
-    polyphony_rate = 5;
+    set_polyphony_rate(5);
 }
 
 void disable_polyphony() {
-    polyphony_rate = 0;
+    set_polyphony_rate(0);
 }
 
 void increase_polyphony_rate(float change) {
-    polyphony_rate *= change;
+    set_polyphony_rate(polyphony_rate * change);
 }
 
 void decrease_polyphony_rate(float change) {
-    polyphony_rate /= change;
+    set_polyphony_rate(polyphony_rate / change);
 }
 
 // Timbre function
 
 void set_timbre(float timbre) {
-    note_timbre = timbre;
+    audio_engine_set_timbre(timbre);
 }
 
 // Tempo functions
 
 void set_tempo(uint8_t tempo) {
     note_tempo = tempo;
+    audio_engine_set_tempo(note_tempo);
 }
 
 void decrease_tempo(uint8_t tempo_change) {
-    note_tempo += tempo_change;
+    set_tempo(note_tempo + tempo_change);
 }
 
 void increase_tempo(uint8_t tempo_change) {
     if (note_tempo - tempo_change < 10) {
-        note_tempo = 10;
+        set_tempo(10);
     } else {
-        note_tempo -= tempo_change;
+        set_tempo(note_tempo - tempo_change);
     }
 }
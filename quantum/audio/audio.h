@@ -18,10 +18,14 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#if defined(__AVR__)
 #include <avr/io.h>
 #include <util/delay.h>
+#endif
 #include "musical_notes.h"
 #include "song_list.h"
+#include "song_bytes.h"
+#include "audio_song.h"
 #include "voices.h"
 #include "quantum.h"
 
@@ -30,7 +34,7 @@
 
 // #define VIBRATO_ENABLE
 
-// Enable vibrato strength/amplitude - slows down ISR too much
+// Enable vibrato strength/amplitude - costs a multiply per interrupt
 // #define VIBRATO_STRENGTH_ENABLE
 
 typedef union {
@@ -87,6 +91,8 @@ void play_note(float freq, int vol);
 void stop_note(float freq);
 void stop_all_notes(void);
 void play_notes(float (*np)[][2], uint16_t n_count, bool n_repeat, float n_rest);
+// Plays a compressed song from PROGMEM, see audio_song.h
+void play_song(const uint8_t* song, uint16_t size, bool n_repeat, float n_rest);
 
 #define SCALE (int8_t []){ 0 + (12*0), 2 + (12*0), 4 + (12*0), 5 + (12*0), 7 + (12*0), 9 + (12*0), 11 + (12*0), \
                            0 + (12*1), 2 + (12*1), 4 + (12*1), 5 + (12*1), 7 + (12*1), 9 + (12*1), 11 + (12*1), \
@@ -99,6 +105,7 @@ void play_notes(float (*np)[][2], uint16_t n_count, bool n_repeat, float n_rest)
 // The global float array for the song must be used here.
 #define NOTE_ARRAY_SIZE(x) ((int16_t)(sizeof(x) / (sizeof(x[0]))))
 #define PLAY_NOTE_ARRAY(note_array, note_repeat, note_rest_style) play_notes(&note_array, NOTE_ARRAY_SIZE((note_array)), (note_repeat), (note_rest_style));
+#define PLAY_SONG(song, song_repeat, song_rest_style) play_song((song), sizeof(song), (song_repeat), (song_rest_style));
 
 
 bool is_playing_notes(void);
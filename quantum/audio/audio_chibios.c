@@ -0,0 +1,396 @@
+/* Copyright 2016 Jack Humbert
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Audio for ChibiOS boards with a DAC, through the mixer of audio_mixer.h
+ *
+ * The PDB triggers a DMA transfer from a circular buffer of samples to the
+ * DAC at AUDIO_SAMPLE_RATE. The DMA interrupts at the half and at the end
+ * of the buffer, and the half that was just played gets rendered again
+ * while the other one is going out. Output is on the DAC0 pin.
+ *
+ * Only the K20 parts with a DAC (MK20DX256: Whitefox, Infinity ErgoDox,
+ * Teensy 3.1/3.2) are supported so far.
+ */
+
+#include "ch.h"
+#include "hal.h"
+#include "print.h"
+#include "audio.h"
+#include "audio_mixer.h"
+#include "eeconfig.h"
+
+// Samples in the circular buffer, each half lasts 5.8ms at 22050Hz
+#ifndef AUDIO_BUFFER_SIZE
+#define AUDIO_BUFFER_SIZE 256
+#endif
+
+#ifndef AUDIO_DMA_IRQ_PRIORITY
+#define AUDIO_DMA_IRQ_PRIORITY 12
+#endif
+
+#if defined(K20x)
+
+// Not all of these are in the ChibiOS headers, so the registers are
+// addressed directly
+#define AUDIO_SIM_SCGC2 (*(volatile uint32_t*)0x4004802C)
+#define AUDIO_SIM_SCGC6 (*(volatile uint32_t*)0x4004803C)
+#define AUDIO_SIM_SCGC7 (*(volatile uint32_t*)0x40048040)
+#define AUDIO_SIM_SCGC2_DAC0 (1 << 12)
+#define AUDIO_SIM_SCGC6_PDB (1 << 22)
+#define AUDIO_SIM_SCGC6_DMAMUX (1 << 1)
+#define AUDIO_SIM_SCGC7_DMA (1 << 1)
+
+#define AUDIO_DAC0_DAT0 (*(volatile uint16_t*)0x400CC000)
+#define AUDIO_DAC0_C0 (*(volatile uint8_t*)0x400CC021)
+#define AUDIO_DAC_C0_DACEN 0x80
+#define AUDIO_DAC_C0_DACRFS 0x40
+
+#define AUDIO_PDB0_SC (*(volatile uint32_t*)0x40036000)
+#define AUDIO_PDB0_MOD (*(volatile uint32_t*)0x40036004)
+#define AUDIO_PDB0_IDLY (*(volatile uint32_t*)0x4003600C)
+#define AUDIO_PDB_SC_LDOK (1 << 0)
+#define AUDIO_PDB_SC_CONT (1 << 1)
+#define AUDIO_PDB_SC_PDBEN (1 << 7)
+#define AUDIO_PDB_SC_TRGSEL_SOFTWARE (15 << 8)
+#define AUDIO_PDB_SC_DMAEN (1 << 15)
+#define AUDIO_PDB_SC_SWTRIG (1 << 16)
+
+#define AUDIO_DMAMUX0_CHCFG(n) (*(volatile uint8_t*)(0x40021000 + (n)))
+#define AUDIO_DMAMUX_ENBL 0x80
+#define AUDIO_DMAMUX_SOURCE_PDB 48
+
+#define AUDIO_DMA_CERQ (*(volatile uint8_t*)0x4000801A)
+#define AUDIO_DMA_SERQ (*(volatile uint8_t*)0x4000801B)
+#define AUDIO_DMA_CINT (*(volatile uint8_t*)0x4000801F)
+
+typedef struct {
+    volatile uint32_t SADDR;
+    volatile int16_t SOFF;
+    volatile uint16_t ATTR;
+    volatile uint32_t NBYTES;
+    volatile int32_t SLAST;
+    volatile uint32_t DADDR;
+    volatile int16_t DOFF;
+    volatile uint16_t CITER;
+    volatile int32_t DLASTSGA;
+    volatile uint16_t CSR;
+    volatile uint16_t BITER;
+} audio_dma_tcd_t;
+
+#define AUDIO_DMA_TCD(n) ((audio_dma_tcd_t*)(0x40009000 + (n) * 32))
+#define AUDIO_DMA_ATTR_16BIT ((1 << 8) | 1)
+#define AUDIO_DMA_CSR_INTMAJOR (1 << 1)
+#define AUDIO_DMA_CSR_INTHALF (1 << 2)
+
+// Channel 0, whose interrupt is the first one of the vector table
+#define AUDIO_DMA_CHANNEL 0
+#define AUDIO_DMA_IRQ 0
+#define AUDIO_DMA_IRQ_VECTOR Vector40
+
+#else
+#error "audio: no DAC backend for this MCU"
+#endif
+
+static audio_sample_t buffer[AUDIO_BUFFER_SIZE];
+// Halves of the buffer that hold nothing but silence
+static uint8_t silent_halves;
+
+static bool audio_initialized = false;
+
+audio_config_t audio_config;
+
+#ifdef VIBRATO_ENABLE
+float vibrato_strength = .5;
+float vibrato_rate = 0.125;
+#endif
+float polyphony_rate = 0;
+uint8_t note_tempo = TEMPO_DEFAULT;
+
+OSAL_IRQ_HANDLER(AUDIO_DMA_IRQ_VECTOR) {
+    OSAL_IRQ_PROLOGUE();
+
+    AUDIO_DMA_CINT = AUDIO_DMA_CHANNEL;
+    // the DMA is past the half that is about to be refilled
+    audio_sample_t* half = buffer;
+    if (AUDIO_DMA_TCD(AUDIO_DMA_CHANNEL)->SADDR < (uint32_t)&buffer[AUDIO_BUFFER_SIZE / 2]) {
+        half = &buffer[AUDIO_BUFFER_SIZE / 2];
+    }
+
+    // nothing to mix once both halves went quiet
+    if (silent_halves < 2) {
+        if (audio_mixer_render(half, AUDIO_BUFFER_SIZE / 2)) {
+            silent_halves = 0;
+        } else {
+            silent_halves++;
+        }
+    }
+
+    OSAL_IRQ_EPILOGUE();
+}
+
+void audio_init(void)
+{
+    if (!eeconfig_is_enabled())
+    {
+        eeconfig_init();
+    }
+    audio_config.raw = eeconfig_read_audio();
+
+    audio_mixer_init();
+    for (uint16_t i = 0; i < AUDIO_BUFFER_SIZE; i++) {
+        buffer[i] = AUDIO_MIXER_CENTER;
+    }
+    silent_halves = 2;
+
+    AUDIO_SIM_SCGC2 |= AUDIO_SIM_SCGC2_DAC0;
+    AUDIO_SIM_SCGC6 |= AUDIO_SIM_SCGC6_PDB | AUDIO_SIM_SCGC6_DMAMUX;
+    AUDIO_SIM_SCGC7 |= AUDIO_SIM_SCGC7_DMA;
+
+    // VDDA as the reference
+    AUDIO_DAC0_C0 = AUDIO_DAC_C0_DACEN | AUDIO_DAC_C0_DACRFS;
+    AUDIO_DAC0_DAT0 = AUDIO_MIXER_CENTER;
+
+    audio_dma_tcd_t* tcd = AUDIO_DMA_TCD(AUDIO_DMA_CHANNEL);
+    tcd->SADDR = (uint32_t)buffer;
+    tcd->SOFF = sizeof(audio_sample_t);
+    tcd->ATTR = AUDIO_DMA_ATTR_16BIT;
+    tcd->NBYTES = sizeof(audio_sample_t);
+    tcd->SLAST = -(int32_t)sizeof(buffer);
+    tcd->DADDR = (uint32_t)&AUDIO_DAC0_DAT0;
+    tcd->DOFF = 0;
+    tcd->CITER = AUDIO_BUFFER_SIZE;
+    tcd->DLASTSGA = 0;
+    tcd->BITER = AUDIO_BUFFER_SIZE;
+    tcd->CSR = AUDIO_DMA_CSR_INTHALF | AUDIO_DMA_CSR_INTMAJOR;
+
+    AUDIO_DMAMUX0_CHCFG(AUDIO_DMA_CHANNEL) = 0;
+    AUDIO_DMAMUX0_CHCFG(AUDIO_DMA_CHANNEL) = AUDIO_DMAMUX_ENBL | AUDIO_DMAMUX_SOURCE_PDB;
+    AUDIO_DMA_SERQ = AUDIO_DMA_CHANNEL;
+    nvicEnableVector(AUDIO_DMA_IRQ, AUDIO_DMA_IRQ_PRIORITY);
+
+    // one DMA request per sample, forever
+    AUDIO_PDB0_IDLY = 1;
+    AUDIO_PDB0_MOD = KINETIS_BUSCLK_FREQUENCY / AUDIO_SAMPLE_RATE - 1;
+    AUDIO_PDB0_SC = AUDIO_PDB_SC_TRGSEL_SOFTWARE | AUDIO_PDB_SC_PDBEN | AUDIO_PDB_SC_CONT |
+        AUDIO_PDB_SC_DMAEN | AUDIO_PDB_SC_LDOK;
+    AUDIO_PDB0_SC |= AUDIO_PDB_SC_SWTRIG;
+
+    audio_initialized = true;
+}
+
+void stop_all_notes(void)
+{
+    dprintf("audio stop all notes");
+
+    if (!audio_initialized) {
+        audio_init();
+    }
+    chSysLock();
+    audio_mixer_all_off();
+    chSysUnlock();
+}
+
+void stop_note(float freq)
+{
+    dprintf("audio stop note freq=%d", (int)freq);
+
+    if (!audio_initialized) {
+        audio_init();
+    }
+    chSysLock();
+    audio_mixer_note_off(freq);
+    chSysUnlock();
+}
+
+void play_note(float freq, int vol) {
+
+    dprintf("audio play note freq=%d vol=%d", (int)freq, vol);
+
+    if (!audio_initialized) {
+        audio_init();
+    }
+
+    if (audio_config.enable && freq > 0) {
+        chSysLock();
+        // Cancel notes if notes are playing
+        if (audio_mixer_song_playing()) {
+            audio_mixer_all_off();
+        }
+        audio_mixer_note_on(freq);
+        silent_halves = 0;
+        chSysUnlock();
+    }
+}
+
+void play_notes(float (*np)[][2], uint16_t n_count, bool n_repeat, float n_rest)
+{
+    if (!audio_initialized) {
+        audio_init();
+    }
+
+    if (audio_config.enable) {
+        chSysLock();
+        // Cancel held notes, the song has the speaker to itself
+        audio_mixer_all_off();
+        audio_mixer_play_song(np, n_count, n_repeat, n_rest);
+        silent_halves = 0;
+        chSysUnlock();
+    }
+}
+
+void play_song(const uint8_t* song, uint16_t size, bool n_repeat, float n_rest)
+{
+    if (!audio_initialized) {
+        audio_init();
+    }
+
+    if (audio_config.enable) {
+        chSysLock();
+        audio_mixer_all_off();
+        audio_mixer_play_compressed_song(song, size, n_repeat, n_rest);
+        silent_halves = 0;
+        chSysUnlock();
+    }
+}
+
+bool is_playing_notes(void) {
+    return audio_mixer_song_playing();
+}
+
+bool is_audio_on(void) {
+    return (audio_config.enable != 0);
+}
+
+void audio_toggle(void) {
+    audio_config.enable ^= 1;
+    eeconfig_update_audio(audio_config.raw);
+    if (audio_config.enable)
+        audio_on_user();
+    else
+        stop_all_notes();
+}
+
+void audio_on(void) {
+    audio_config.enable = 1;
+    eeconfig_update_audio(audio_config.raw);
+    audio_on_user();
+}
+
+void audio_off(void) {
+    audio_config.enable = 0;
+    eeconfig_update_audio(audio_config.raw);
+    stop_all_notes();
+}
+
+#ifdef VIBRATO_ENABLE
+
+// The mixer has no vibrato, the settings are only kept
+
+void set_vibrato_rate(float rate) {
+    vibrato_rate = rate;
+}
+
+void increase_vibrato_rate(float change) {
+    vibrato_rate *= change;
+}
+
+void decrease_vibrato_rate(float change) {
+    vibrato_rate /= change;
+}
+
+#ifdef VIBRATO_STRENGTH_ENABLE
+
+void set_vibrato_strength(float strength) {
+    vibrato_strength = strength;
+}
+
+void increase_vibrato_strength(float change) {
+    vibrato_strength *= change;
+}
+
+void decrease_vibrato_strength(float change) {
+    vibrato_strength /= change;
+}
+
+#endif  /* VIBRATO_STRENGTH_ENABLE */
+
+#endif /* VIBRATO_ENABLE */
+
+// Polyphony functions, held notes always sound together here
+
+void set_polyphony_rate(float rate) {
+    polyphony_rate = rate;
+}
+
+void enable_polyphony() {
+    polyphony_rate = 5;
+}
+
+void disable_polyphony() {
+    polyphony_rate = 0;
+}
+
+void increase_polyphony_rate(float change) {
+    polyphony_rate *= change;
+}
+
+void decrease_polyphony_rate(float change) {
+    polyphony_rate /= change;
+}
+
+// Timbre function
+
+void set_timbre(float timbre) {
+    chSysLock();
+    audio_mixer_set_timbre(timbre);
+    chSysUnlock();
+}
+
+// Tempo functions
+
+void set_tempo(uint8_t tempo) {
+    note_tempo = tempo;
+    audio_mixer_set_tempo(note_tempo);
+}
+
+void decrease_tempo(uint8_t tempo_change) {
+    set_tempo(note_tempo + tempo_change);
+}
+
+void increase_tempo(uint8_t tempo_change) {
+    if (note_tempo - tempo_change < 10) {
+        set_tempo(10);
+    } else {
+        set_tempo(note_tempo - tempo_change);
+    }
+}
+
+// Voices, the mixer only plays square waves
+
+voice_type voice = default_voice;
+
+void set_voice(voice_type v) {
+    voice = v;
+}
+
+void voice_iterate() {
+    voice = (voice + 1) % number_of_voices;
+}
+
+void voice_deiterate() {
+    voice = (voice - 1 + number_of_voices) % number_of_voices;
+}
@@ -0,0 +1,359 @@
+/* Copyright 2016 Jack Humbert
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "audio_engine.h"
+#include "musical_notes.h"
+#include "voices.h"
+#include "luts.h"
+#include "audio_song.h"
+
+bool playing_note = false;
+bool playing_notes = false;
+
+uint16_t envelope_index = 0;
+uint16_t envelope_time = 0;
+uint8_t  note_timbre = TIMBRE8(TIMBRE_DEFAULT);
+bool     glissando = true;
+uint32_t polyphony_ticks = 0;
+
+static uint32_t envelope_ticks;
+
+// Held notes, the frequency is only kept to find them again
+static float    voice_frequencies[AUDIO_MAX_VOICES];
+static uint16_t voice_periods[AUDIO_MAX_VOICES];
+static uint8_t  voices;
+static uint8_t  voice_place;
+static uint32_t place_ticks;
+
+// Current period of a held note, slides towards the last voice
+static uint16_t period;
+
+#ifdef VIBRATO_ENABLE
+// The cycle used to advance by rate * (1 + 440 / f) steps of the
+// VIBRATO_LUT_LENGTH entry table per interrupt. vibrato_step is rate in
+// 1/65536 of the cycle, and 440 / f is worked out from the period in
+// 1/65536 as period * VIBRATO_RATIO >> 8.
+#define VIBRATO_STEP(rate) ((rate) * 65536.0 / VIBRATO_LUT_LENGTH)
+#define VIBRATO_RATIO ((uint32_t)(440.0 * 16777216.0 / AUDIO_TIMER_HZ + 0.5))
+static uint16_t vibrato_step = VIBRATO_STEP(0.125);
+static uint16_t vibrato_strength = 128;  // 1/256
+static uint16_t vibrato_phase;
+static uint16_t vibrato_increment;
+#endif
+
+// Song, either floats or compressed
+static float  (*notes_pointer)[][2];
+static uint16_t notes_count;
+static audio_song_t song;
+static bool     song_compressed;
+static bool     notes_repeat;
+static uint32_t notes_rest;       // timer ticks
+static uint16_t current_note;
+static bool     note_resting;
+static uint8_t  note_tempo = TEMPO_DEFAULT;
+static uint16_t note_period;       // 0 while resting
+static uint32_t note_remaining;    // timer ticks
+
+uint16_t audio_period(float frequency) {
+    if (frequency < (float)AUDIO_TIMER_HZ / 0xFFFF) {
+        return 0xFFFF;
+    }
+    return (uint16_t)((float)AUDIO_TIMER_HZ / frequency);
+}
+
+static uint16_t shift_period(uint16_t p, int16_t offset) {
+    int32_t shifted = p + (((int32_t)p * offset) >> VIBRATO_PERIOD_LUT_SCALE);
+    return shifted > 0xFFFF ? 0xFFFF : shifted;
+}
+
+uint16_t audio_vibrato(uint16_t p, uint16_t phase) {
+    int8_t offset = pgm_read_byte(&vibrato_period_lut[phase >> VIBRATO_PERIOD_LUT_SHIFT]);
+    return shift_period(p, offset);
+}
+
+uint16_t audio_noise(void) {
+    static uint16_t state = 1;
+    state ^= state << 7;
+    state ^= state >> 9;
+    state ^= state << 8;
+    return state;
+}
+
+static void start_note(uint16_t note_period) {
+    envelope_index = 0;
+    envelope_time = 0;
+    envelope_ticks = 0;
+#ifdef VIBRATO_ENABLE
+    uint32_t ratio = ((uint32_t)note_period * VIBRATO_RATIO) >> 8;
+    // 440 / f up to 16, below 27Hz the vibrato doesn't speed up any more
+    if (ratio > 0xFFFFFUL) {
+        ratio = 0xFFFFFUL;
+    }
+    uint32_t increment = vibrato_step + (((uint32_t)vibrato_step * (ratio >> 4)) >> 12);
+    vibrato_increment = increment < 0xFFFF ? increment : 0xFFFF;
+#else
+    (void)note_period;
+#endif
+}
+
+bool audio_engine_add_voice(float frequency) {
+    if (voices >= AUDIO_MAX_VOICES) {
+        return false;
+    }
+    playing_note = true;
+    uint16_t voice_period = audio_period(frequency);
+    start_note(voice_period);
+    if (frequency > 0) {
+        voice_frequencies[voices] = frequency;
+        voice_periods[voices] = voice_period;
+        voices++;
+    }
+    return true;
+}
+
+bool audio_engine_remove_voice(float frequency) {
+    if (!playing_note) {
+        return false;
+    }
+    for (int8_t i = voices - 1; i >= 0; i--) {
+        if (voice_frequencies[i] == frequency) {
+            for (uint8_t j = i; j < voices - 1; j++) {
+                voice_frequencies[j] = voice_frequencies[j + 1];
+                voice_periods[j] = voice_periods[j + 1];
+            }
+            break;
+        }
+    }
+    if (voices > 0) {
+        voices--;
+    }
+    if (voice_place >= voices) {
+        voice_place = 0;
+    }
+    if (voices == 0) {
+        period = 0;
+        playing_note = false;
+    }
+    return true;
+}
+
+uint8_t audio_engine_voices(void) {
+    return voices;
+}
+
+void audio_engine_stop(void) {
+    voices = 0;
+    voice_place = 0;
+    period = 0;
+    playing_note = false;
+    playing_notes = false;
+}
+
+static uint16_t song_period(uint8_t note) {
+    uint32_t frequency = audio_song_frequency(note) >> 8;
+    if (frequency == 0) {
+        return 0;
+    }
+    uint32_t p = ((uint32_t)AUDIO_TIMER_HZ << 8) / frequency;
+    return p < 0xFFFF ? p : 0xFFFF;
+}
+
+static void rewind_song(void) {
+    current_note = 0;
+    if (song_compressed) {
+        audio_song_start(&song, song.data, song.size);
+    }
+}
+
+static bool song_done(void) {
+    return song_compressed ? audio_song_done(&song) : current_note >= notes_count;
+}
+
+// Reads the next note of the song, returns false at the end
+static bool read_note(void) {
+    if (song_compressed) {
+        if (!audio_song_next(&song)) {
+            return false;
+        }
+        note_period = song_period(song.note);
+        note_remaining = (uint32_t)song.duration * note_tempo * 0xFFFF / 400;
+    } else {
+        if (current_note >= notes_count) {
+            return false;
+        }
+        float frequency = (*notes_pointer)[current_note][0];
+        float length = ((*notes_pointer)[current_note][1] / 4) * (((float)note_tempo) / 100);
+        note_period = frequency > 0 ? audio_period(frequency) : 0;
+        note_remaining = length * 0xFFFF;
+        current_note++;
+    }
+    start_note(note_period);
+    return true;
+}
+
+static void start_song(bool n_repeat, float n_rest) {
+    notes_repeat = n_repeat;
+    notes_rest = n_rest * 0xFFFF;
+    place_ticks = 0;
+    note_resting = false;
+    rewind_song();
+    playing_notes = read_note();
+}
+
+void audio_engine_play_notes(float (*np)[][2], uint16_t n_count, bool n_repeat, float n_rest) {
+    notes_pointer = np;
+    notes_count = n_count;
+    song_compressed = false;
+    start_song(n_repeat, n_rest);
+}
+
+void audio_engine_play_song(const uint8_t* data, uint16_t size, bool n_repeat, float n_rest) {
+    song.data = data;
+    song.size = size;
+    song_compressed = true;
+    start_song(n_repeat, n_rest);
+}
+
+void audio_engine_set_tempo(uint8_t tempo) {
+    note_tempo = tempo;
+}
+
+void audio_engine_set_polyphony_rate(float rate) {
+    // a voice used to last f / rate / AUDIO_CPU_PRESCALER interrupts of
+    // 1 / f each, which doesn't depend on the note
+    polyphony_ticks = rate > 0 ? (uint32_t)(AUDIO_TIMER_HZ / AUDIO_CPU_PRESCALER / rate) : 0;
+}
+
+void audio_engine_set_timbre(float timbre) {
+    note_timbre = TIMBRE8(timbre);
+}
+
+#ifdef VIBRATO_ENABLE
+
+void audio_engine_set_vibrato_rate(float rate) {
+    float step = VIBRATO_STEP(rate);
+    vibrato_step = step < 0xFFFF ? (uint16_t)step : 0xFFFF;
+}
+
+void audio_engine_set_vibrato_strength(float strength) {
+    vibrato_strength = strength * 256;
+}
+
+#endif
+
+static uint16_t vibrato(uint16_t p) {
+#ifdef VIBRATO_ENABLE
+    if (vibrato_strength > 0) {
+        uint16_t phase = vibrato_phase;
+        vibrato_phase += vibrato_increment;
+#ifdef VIBRATO_STRENGTH_ENABLE
+        int8_t offset = pgm_read_byte(&vibrato_period_lut[phase >> VIBRATO_PERIOD_LUT_SHIFT]);
+        return shift_period(p, ((int32_t)offset * vibrato_strength) >> 8);
+#else
+        return audio_vibrato(p, phase);
+#endif
+    }
+#endif
+    return p;
+}
+
+// Moves the period a step towards target, the step grows with the period
+// so the slide takes the same time per octave at any pitch
+static void glide(uint16_t target) {
+    uint16_t step = ((uint32_t)period * period) >> AUDIO_GLISSANDO_SHIFT;
+    if (step == 0) {
+        step = 1;
+    }
+    if (period < target) {
+        period = target - period > step ? period + step : target;
+    } else {
+        period = period - target > step ? period - step : target;
+    }
+}
+
+static void play_period(uint16_t p, audio_timer_t* timer) {
+    p = vibrato(p);
+
+    if (envelope_index < 0xFFFF) {
+        envelope_index++;
+    }
+    envelope_ticks += p;
+    while (envelope_ticks >= AUDIO_ENVELOPE_STEP) {
+        envelope_ticks -= AUDIO_ENVELOPE_STEP;
+        if (envelope_time < 0xFFFF) {
+            envelope_time++;
+        }
+    }
+
+    p = voice_envelope(p);
+    timer->period = p;
+    timer->duty = ((uint32_t)p * note_timbre) >> 8;
+}
+
+bool audio_engine_tick(audio_timer_t* timer) {
+    if (playing_note && voices > 0) {
+        if (polyphony_ticks > 0) {
+            if (voices > 1) {
+                if (voice_place >= voices) {
+                    voice_place = 0;
+                }
+                place_ticks += timer->period;
+                if (place_ticks > polyphony_ticks) {
+                    voice_place = voice_place + 1 < voices ? voice_place + 1 : 0;
+                    place_ticks = 0;
+                }
+            }
+            period = voice_periods[voice_place];
+        } else if (glissando && period != 0) {
+            glide(voice_periods[voices - 1]);
+        } else {
+            period = voice_periods[voices - 1];
+        }
+        play_period(period, timer);
+    }
+
+    if (playing_notes) {
+        if (note_period > 0) {
+            play_period(note_period, timer);
+        } else {
+            timer->period = AUDIO_REST_PERIOD;
+            timer->duty = 0;
+        }
+
+        if (note_remaining > timer->period) {
+            note_remaining -= timer->period;
+            return true;
+        }
+
+        if (!note_resting && notes_rest > 0 && (notes_repeat || !song_done())) {
+            // the rest between two notes isn't scaled by the tempo
+            note_resting = true;
+            note_period = 0;
+            note_remaining = notes_rest;
+        } else {
+            note_resting = false;
+            if (!read_note()) {
+                if (notes_repeat) {
+                    rewind_song();
+                }
+                if (!notes_repeat || !read_note()) {
+                    playing_notes = false;
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,107 @@
+/* Copyright 2016 Jack Humbert
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef AUDIO_ENGINE_H
+#define AUDIO_ENGINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Integer audio engine behind the timer interrupt
+ *
+ * The timer runs at F_CPU / AUDIO_CPU_PRESCALER and the interrupt fires once
+ * per period of the note being played. Everything that needs floating point
+ * (converting a frequency to a period, note lengths, rates) happens once per
+ * note; audio_engine_tick only adds, shifts and reads tables, so it stays
+ * short enough not to get in the way of USB and the matrix scan.
+ *
+ * A float song still reads its next note from the interrupt, so that one
+ * conversion runs there. Songs from play_song() and the vibrato need no
+ * floats in the interrupt at all.
+ */
+
+#define AUDIO_CPU_PRESCALER 8
+#define AUDIO_TIMER_HZ (F_CPU / AUDIO_CPU_PRESCALER)
+
+// Timer period of a constant frequency, folded at compile time
+#define AUDIO_PERIOD(freq) ((uint16_t)(AUDIO_TIMER_HZ / (freq)))
+
+// Period the timer keeps running at while a rest is playing
+#define AUDIO_REST_PERIOD AUDIO_PERIOD(1000)
+
+// Duty cycle as a fraction of 256, from one of the TIMBRE_ constants
+#define TIMBRE8(t) ((t) >= 1 ? 255 : (uint8_t)((t) * 256))
+
+// Timer ticks per envelope step, the envelopes in voices.c are written for
+// 880 steps per second
+#define AUDIO_ENVELOPE_STEP (AUDIO_TIMER_HZ / 880)
+
+// Glissando moves the period by period^2 >> AUDIO_GLISSANDO_SHIFT every
+// interrupt, which slides about 18 octaves per second at any pitch
+#ifndef AUDIO_GLISSANDO_SHIFT
+#   if F_CPU > 12000000
+#       define AUDIO_GLISSANDO_SHIFT 17
+#   else
+#       define AUDIO_GLISSANDO_SHIFT 16
+#   endif
+#endif
+
+#define AUDIO_MAX_VOICES 8
+
+typedef struct {
+    uint16_t period;
+    uint16_t duty;
+} audio_timer_t;
+
+extern bool playing_note;
+extern bool playing_notes;
+
+// Voice state, shared with the envelopes in voices.c
+extern uint16_t envelope_index;  // interrupts since the note started
+extern uint16_t envelope_time;   // AUDIO_ENVELOPE_STEPs since the note started
+extern uint8_t  note_timbre;     // TIMBRE8
+extern bool     glissando;
+extern uint32_t polyphony_ticks; // ticks per voice when polyphonic, 0 for off
+
+uint16_t audio_period(float frequency);
+// Shifts a period along the vibrato cycle, phase wraps around at 0x10000
+uint16_t audio_vibrato(uint16_t period, uint16_t phase);
+// 16 bit pseudo random numbers for the percussion voices
+uint16_t audio_noise(void);
+
+// Held notes, matched by frequency. Return false if nothing changed.
+bool audio_engine_add_voice(float frequency);
+bool audio_engine_remove_voice(float frequency);
+uint8_t audio_engine_voices(void);
+void audio_engine_stop(void);
+
+void audio_engine_play_notes(float (*np)[][2], uint16_t n_count, bool n_repeat, float n_rest);
+// Plays a compressed song from PROGMEM, see audio_song.h
+void audio_engine_play_song(const uint8_t* data, uint16_t size, bool n_repeat, float n_rest);
+
+void audio_engine_set_tempo(uint8_t tempo);
+void audio_engine_set_polyphony_rate(float rate);
+void audio_engine_set_timbre(float timbre);
+#ifdef VIBRATO_ENABLE
+void audio_engine_set_vibrato_rate(float rate);
+void audio_engine_set_vibrato_strength(float strength);
+#endif
+
+// Runs one timer period. Fills in the next period and duty cycle, a duty
+// cycle of 0 means silence. Returns false once a song has finished.
+bool audio_engine_tick(audio_timer_t* timer);
+
+#endif
@@ -0,0 +1,261 @@
+/* Copyright 2016 Jack Humbert
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stddef.h>
+#include "audio_mixer.h"
+#include "musical_notes.h"
+#include "audio_song.h"
+
+#define VOICE_OFF 0
+#define VOICE_ON 1
+#define VOICE_RELEASED 2
+
+#define RAMP_STEP (AUDIO_MIXER_AMPLITUDE / AUDIO_MIXER_RAMP)
+
+typedef struct {
+    float frequency;  // only kept to find the voice again
+    uint32_t phase;
+    uint32_t increment;
+    uint16_t level;
+    uint8_t state;
+} voice_t;
+
+// The held notes, followed by the one the song plays on
+static voice_t voices[AUDIO_MIXER_VOICES + 1];
+#define SONG_VOICE (&voices[AUDIO_MIXER_VOICES])
+
+// The square wave is high while the phase is below this
+static uint32_t duty = (uint32_t)(TIMBRE_DEFAULT * 0x100) << 24;
+
+static float  (*notes_pointer)[][2];
+static uint16_t notes_count;
+static audio_song_t song;
+static bool     song_compressed;
+static bool     notes_repeat;
+static uint32_t notes_rest;       // samples
+static uint16_t current_note;
+static bool     note_resting;
+static bool     song_playing;
+static uint32_t song_remaining;   // samples
+static uint8_t  note_tempo = TEMPO_DEFAULT;
+
+// A length takes length * 0xFFFF ticks of the AVR timer
+#define SONG_SAMPLES(length) \
+    ((uint32_t)((length) * (0xFFFF * (float)AUDIO_SAMPLE_RATE / AUDIO_MIXER_SONG_TICK_HZ)))
+
+static void start_voice(voice_t* voice, float frequency, uint32_t increment) {
+    voice->frequency = frequency;
+    // the phase is kept, so a voice can change pitch without a click
+    voice->increment = increment;
+    voice->state = VOICE_ON;
+}
+
+static uint32_t increment(float frequency) {
+    return frequency * (4294967296.0 / AUDIO_SAMPLE_RATE);
+}
+
+void audio_mixer_init(void) {
+    for (uint8_t i = 0; i <= AUDIO_MIXER_VOICES; i++) {
+        voices[i].state = VOICE_OFF;
+        voices[i].level = 0;
+    }
+    song_playing = false;
+}
+
+bool audio_mixer_note_on(float frequency) {
+    voice_t* voice = NULL;
+    for (uint8_t i = 0; i < AUDIO_MIXER_VOICES; i++) {
+        if (voices[i].state == VOICE_OFF) {
+            voice = &voices[i];
+            voice->level = 0;
+            break;
+        }
+        // take a note that is on its way out if there's nothing better
+        if (voices[i].state == VOICE_RELEASED && !voice) {
+            voice = &voices[i];
+        }
+    }
+    if (!voice) {
+        return false;
+    }
+    start_voice(voice, frequency, increment(frequency));
+    return true;
+}
+
+void audio_mixer_note_off(float frequency) {
+    for (uint8_t i = 0; i < AUDIO_MIXER_VOICES; i++) {
+        if (voices[i].state == VOICE_ON && voices[i].frequency == frequency) {
+            voices[i].state = VOICE_RELEASED;
+            return;
+        }
+    }
+}
+
+void audio_mixer_all_off(void) {
+    for (uint8_t i = 0; i <= AUDIO_MIXER_VOICES; i++) {
+        if (voices[i].state == VOICE_ON) {
+            voices[i].state = VOICE_RELEASED;
+        }
+    }
+    song_playing = false;
+}
+
+uint8_t audio_mixer_active_voices(void) {
+    uint8_t active = 0;
+    for (uint8_t i = 0; i <= AUDIO_MIXER_VOICES; i++) {
+        if (voices[i].state != VOICE_OFF) {
+            active++;
+        }
+    }
+    return active;
+}
+
+static void release_song_voice(void) {
+    if (SONG_VOICE->state == VOICE_ON) {
+        SONG_VOICE->state = VOICE_RELEASED;
+    }
+}
+
+static void rewind_song(void) {
+    current_note = 0;
+    if (song_compressed) {
+        audio_song_start(&song, song.data, song.size);
+    }
+}
+
+static bool song_done(void) {
+    return song_compressed ? audio_song_done(&song) : current_note >= notes_count;
+}
+
+// Reads the next note of the song, returns false at the end
+static bool read_note(void) {
+    float    length;
+    uint32_t note_increment;
+    if (song_compressed) {
+        if (!audio_song_next(&song)) {
+            return false;
+        }
+        length = song.duration / 4.0f;
+        note_increment = ((uint64_t)audio_song_frequency(song.note) << 16) / AUDIO_SAMPLE_RATE;
+    } else {
+        if (current_note >= notes_count) {
+            return false;
+        }
+        float frequency = (*notes_pointer)[current_note][0];
+        length = (*notes_pointer)[current_note][1] / 4;
+        note_increment = frequency > 0 ? increment(frequency) : 0;
+        current_note++;
+    }
+    song_remaining = SONG_SAMPLES(length * (((float)note_tempo) / 100));
+    if (note_increment > 0) {
+        // the song voice is never looked up by frequency
+        start_voice(SONG_VOICE, 0, note_increment);
+    } else {
+        release_song_voice();
+    }
+    return true;
+}
+
+static void start_song(bool n_repeat, float n_rest) {
+    notes_repeat = n_repeat;
+    notes_rest = SONG_SAMPLES(n_rest);
+    note_resting = false;
+    rewind_song();
+    song_playing = read_note();
+}
+
+void audio_mixer_play_song(float (*np)[][2], uint16_t n_count, bool n_repeat, float n_rest) {
+    notes_pointer = np;
+    notes_count = n_count;
+    song_compressed = false;
+    start_song(n_repeat, n_rest);
+}
+
+void audio_mixer_play_compressed_song(const uint8_t* data, uint16_t size, bool n_repeat, float n_rest) {
+    song.data = data;
+    song.size = size;
+    song_compressed = true;
+    start_song(n_repeat, n_rest);
+}
+
+bool audio_mixer_song_playing(void) {
+    return song_playing;
+}
+
+void audio_mixer_set_timbre(float timbre) {
+    duty = timbre >= 1 ? 0xFFFFFFFF : (uint32_t)(timbre * 4294967296.0);
+}
+
+void audio_mixer_set_tempo(uint8_t tempo) {
+    note_tempo = tempo;
+}
+
+static void next_note(void) {
+    if (!note_resting && notes_rest > 0 && (notes_repeat || !song_done())) {
+        note_resting = true;
+        song_remaining = notes_rest;
+        release_song_voice();
+        return;
+    }
+    note_resting = false;
+    if (!read_note()) {
+        if (notes_repeat) {
+            rewind_song();
+        }
+        if (!notes_repeat || !read_note()) {
+            song_playing = false;
+            release_song_voice();
+        }
+    }
+}
+
+bool audio_mixer_render(audio_sample_t* buffer, uint16_t count) {
+    bool audible = false;
+    for (uint16_t n = 0; n < count; n++) {
+        if (song_playing) {
+            if (song_remaining > 0) {
+                song_remaining--;
+            } else {
+                next_note();
+            }
+        }
+
+        int32_t sum = 0;
+        for (uint8_t i = 0; i <= AUDIO_MIXER_VOICES; i++) {
+            voice_t* voice = &voices[i];
+            if (voice->state == VOICE_OFF) {
+                continue;
+            }
+            if (voice->state == VOICE_ON) {
+                if (voice->level < AUDIO_MIXER_AMPLITUDE) {
+                    voice->level += RAMP_STEP;
+                }
+            } else if (voice->level > RAMP_STEP) {
+                voice->level -= RAMP_STEP;
+            } else {
+                voice->level = 0;
+                voice->state = VOICE_OFF;
+                continue;
+            }
+            sum += voice->phase < duty ? voice->level : -(int32_t)voice->level;
+            voice->phase += voice->increment;
+            audible = true;
+        }
+
+        sum += AUDIO_MIXER_CENTER;
+        buffer[n] = sum < 0 ? 0 : sum > AUDIO_MIXER_MAX ? AUDIO_MIXER_MAX : sum;
+    }
+    return audible;
+}
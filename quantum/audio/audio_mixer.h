@@ -0,0 +1,83 @@
+/* Copyright 2016 Jack Humbert
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef AUDIO_MIXER_H
+#define AUDIO_MIXER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Software mixer for boards with a DAC
+ *
+ * Every held note gets a voice of its own: a square wave with a phase
+ * accumulator, ramped in and out so notes start and stop without clicks.
+ * The voices are summed into 12 bit samples centered on
+ * AUDIO_MIXER_CENTER, so chords really sound together instead of taking
+ * turns. The work per sample is bounded by AUDIO_MIXER_VOICES.
+ *
+ * Songs play on a voice of their own, with lengths in the units of the
+ * AVR timer so they last as long as they do there.
+ */
+
+#ifndef AUDIO_SAMPLE_RATE
+#define AUDIO_SAMPLE_RATE 22050
+#endif
+
+#ifndef AUDIO_MIXER_VOICES
+#define AUDIO_MIXER_VOICES 8
+#endif
+
+// Amplitude of a single voice, four voices together reach full scale and
+// more than that is clipped
+#ifndef AUDIO_MIXER_AMPLITUDE
+#define AUDIO_MIXER_AMPLITUDE 512
+#endif
+
+// Samples a voice takes to ramp in or out, 3ms
+#ifndef AUDIO_MIXER_RAMP
+#define AUDIO_MIXER_RAMP 64
+#endif
+
+#define AUDIO_MIXER_CENTER 2048
+#define AUDIO_MIXER_MAX 4095
+
+// Songs are timed in ticks of the AVR audio timer
+#define AUDIO_MIXER_SONG_TICK_HZ 2000000
+
+typedef uint16_t audio_sample_t;
+
+void audio_mixer_init(void);
+
+// Starts a voice at frequency, returns false when all of them are in use
+bool audio_mixer_note_on(float frequency);
+// Releases the voice playing frequency
+void audio_mixer_note_off(float frequency);
+// Releases every voice and stops the song
+void audio_mixer_all_off(void);
+uint8_t audio_mixer_active_voices(void);
+
+void audio_mixer_play_song(float (*np)[][2], uint16_t n_count, bool n_repeat, float n_rest);
+// A compressed song, see audio_song.h
+void audio_mixer_play_compressed_song(const uint8_t* data, uint16_t size, bool n_repeat, float n_rest);
+bool audio_mixer_song_playing(void);
+
+void audio_mixer_set_timbre(float timbre);
+void audio_mixer_set_tempo(uint8_t tempo);
+
+// Renders count samples, returns false if they are all silence
+bool audio_mixer_render(audio_sample_t* buffer, uint16_t count);
+
+#endif
@@ -0,0 +1,138 @@
+/* Copyright 2016 Jack Humbert
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <math.h>
+#include "audio_song.h"
+#include "musical_notes.h"
+#include "progmem.h"
+
+#define OCTAVE_8(note) ((uint32_t)((note) * 65536.0))
+
+// The top octave, the others are shifted down from it
+static const uint32_t octave_8[12] PROGMEM = {
+    OCTAVE_8(NOTE_C8), OCTAVE_8(NOTE_CS8), OCTAVE_8(NOTE_D8), OCTAVE_8(NOTE_DS8),
+    OCTAVE_8(NOTE_E8), OCTAVE_8(NOTE_F8), OCTAVE_8(NOTE_FS8), OCTAVE_8(NOTE_G8),
+    OCTAVE_8(NOTE_GS8), OCTAVE_8(NOTE_A8), OCTAVE_8(NOTE_AS8), OCTAVE_8(NOTE_B8),
+};
+
+void audio_song_start(audio_song_t* song, const uint8_t* data, uint16_t size) {
+    song->data = data;
+    song->size = size;
+    song->position = 0;
+    song->repeats = 0;
+    song->note = SONG_REST;
+    song->duration = 16;
+}
+
+bool audio_song_next(audio_song_t* song) {
+    if (song->repeats > 0) {
+        song->repeats--;
+        return true;
+    }
+    while (song->position < song->size) {
+        uint8_t byte = pgm_read_byte(&song->data[song->position++]);
+        if (byte < 0x80) {
+            song->note = byte;
+            return true;
+        }
+        if (byte < 0xC0) {
+            song->duration = ((byte & 0x3F) + 1) * 2;
+        } else if (byte < SONG_LONG_DURATION) {
+            song->repeats = byte & 0x3F;
+            return true;
+        } else if (byte == SONG_LONG_DURATION && song->position < song->size) {
+            song->duration = pgm_read_byte(&song->data[song->position++]);
+        }
+    }
+    return false;
+}
+
+bool audio_song_done(const audio_song_t* song) {
+    return song->repeats == 0 && song->position >= song->size;
+}
+
+uint32_t audio_song_frequency(uint8_t note) {
+    if (note == SONG_REST || note > SONG_NOTE_MAX) {
+        return 0;
+    }
+    uint8_t octave = (note - 1) / 12;
+    uint8_t shift = 8 - octave;
+    uint32_t frequency = pgm_read_dword(&octave_8[(note - 1) % 12]);
+    return shift ? (frequency + (1UL << (shift - 1))) >> shift : frequency;
+}
+
+uint8_t audio_song_note(float frequency) {
+    if (frequency <= 0) {
+        return SONG_REST;
+    }
+    float semitones = 12 * log2f(frequency / (float)(NOTE_C8 / 256));
+    if (semitones < -0.5f || semitones > SONG_NOTE_MAX - 0.5f) {
+        return 0xFF;
+    }
+    uint8_t note = 1 + (uint8_t)(semitones + 0.5f);
+    float error = audio_song_frequency(note) / 65536.0f - frequency;
+    if (fabsf(error) > frequency * 0.003f) {
+        return 0xFF;
+    }
+    return note;
+}
+
+uint16_t audio_song_encode(const float (*notes)[2], uint16_t count, uint8_t* out, uint16_t size) {
+    uint16_t written = 0;
+    uint16_t repeat_at = 0xFFFF;
+    uint8_t  last_note = 0xFF;
+    uint8_t  duration = 16;
+
+    for (uint16_t i = 0; i < count; i++) {
+        uint8_t note = audio_song_note(notes[i][0]);
+        float   length = notes[i][1];
+        if (note == 0xFF || length < 1 || length > 255 || length != (uint8_t)length) {
+            return 0;
+        }
+
+        if (note == last_note && length == duration) {
+            if (repeat_at != 0xFFFF && out[repeat_at] != SONG_REPEAT(SONG_REPEAT_MAX)) {
+                out[repeat_at]++;
+                continue;
+            }
+            if (written >= size) {
+                return 0;
+            }
+            repeat_at = written;
+            out[written++] = SONG_REPEAT(1);
+            continue;
+        }
+
+        if (length != duration) {
+            duration = length;
+            if (written + 3 > size) {
+                return 0;
+            }
+            if (duration % 2 == 0 && duration <= SONG_DURATION_MAX) {
+                out[written++] = SONG_DURATION(duration);
+            } else {
+                out[written++] = SONG_LONG_DURATION;
+                out[written++] = duration;
+            }
+        }
+        if (written >= size) {
+            return 0;
+        }
+        out[written++] = note;
+        last_note = note;
+        repeat_at = 0xFFFF;
+    }
+    return written;
+}
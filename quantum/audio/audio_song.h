@@ -0,0 +1,74 @@
+/* Copyright 2016 Jack Humbert
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef AUDIO_SONG_H
+#define AUDIO_SONG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Compressed songs
+ *
+ * A song is a byte string in PROGMEM, read one note at a time while it
+ * plays. A note is a single byte, the duration carries over from the one
+ * before it:
+ *
+ *   0x00-0x7F  note, SONG_REST or a semitone counted from C0 (C0 is 1)
+ *   0x80-0xBF  sets the duration to an even length from 2 to 128
+ *   0xC0-0xEF  plays the last note again, 1 to 48 times
+ *   0xF0 n     sets the duration to any length n
+ *
+ * Lengths are in the units of the float songs, 16 is a quarter note. A
+ * note takes one byte instead of eight, two when its duration changes.
+ * audio_song_encode() converts the float songs.
+ */
+
+#define SONG_REST 0
+#define SONG_NOTE(octave, semitone) (1 + 12 * (octave) + (semitone))
+#define SONG_NOTE_MAX SONG_NOTE(8, 11)
+#define SONG_DURATION(length) (0x80 | ((length) / 2 - 1))
+#define SONG_REPEAT(times) (0xC0 | ((times) - 1))
+#define SONG_LONG_DURATION 0xF0
+
+#define SONG_DURATION_MAX 128
+#define SONG_REPEAT_MAX 48
+
+typedef struct {
+    const uint8_t* data;
+    uint16_t size;
+    uint16_t position;
+    uint8_t  repeats;
+    // the note just read
+    uint8_t  note;
+    uint8_t  duration;
+} audio_song_t;
+
+void audio_song_start(audio_song_t* song, const uint8_t* data, uint16_t size);
+// Reads the next note, returns false at the end of the song
+bool audio_song_next(audio_song_t* song);
+bool audio_song_done(const audio_song_t* song);
+
+// Frequency of a note in 1/65536 Hz, 0 for a rest
+uint32_t audio_song_frequency(uint8_t note);
+
+// The note closest to frequency, 0xFF if none is within a few cents
+uint8_t audio_song_note(float frequency);
+
+// Converts a float song, returns the bytes written or 0 if it didn't fit
+// or has notes or lengths the format can't hold
+uint16_t audio_song_encode(const float (*notes)[2], uint16_t count, uint8_t* out, uint16_t size);
+
+#endif
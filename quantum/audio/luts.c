@@ -14,9 +14,6 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <avr/io.h>
-#include <avr/interrupt.h>
-#include <avr/pgmspace.h>
 #include "luts.h"
 
 const float vibrato_lut[VIBRATO_LUT_LENGTH] =
@@ -43,6 +40,14 @@ const float vibrato_lut[VIBRATO_LUT_LENGTH] =
 	1.0000000000000,
 };
 
+const int8_t vibrato_period_lut[VIBRATO_PERIOD_LUT_LENGTH] PROGMEM =
+{
+	   0,  -23,  -45,  -66,  -83,  -98, -109, -116,
+	-118, -116, -109,  -98,  -83,  -66,  -45,  -23,
+	   0,   23,   45,   66,   84,   99,  110,  116,
+	 119,  116,  110,   99,   84,   66,   45,   23,
+};
+
 const uint16_t frequency_lut[FREQUENCY_LUT_LENGTH] =
 {
 	0x8E0B,
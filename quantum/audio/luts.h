@@ -14,9 +14,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <avr/io.h>
-#include <avr/interrupt.h>
-#include <avr/pgmspace.h>
+#include <stdint.h>
+#include "progmem.h"
 
 #ifndef LUTS_H
 #define LUTS_H
@@ -25,7 +24,14 @@
 
 #define FREQUENCY_LUT_LENGTH 349
 
+// One cycle of vibrato as period offsets in units of 1/16384, +-1/8 of a
+// semitone, indexed by the top 5 bits of a 16 bit phase
+#define VIBRATO_PERIOD_LUT_LENGTH 32
+#define VIBRATO_PERIOD_LUT_SHIFT 11
+#define VIBRATO_PERIOD_LUT_SCALE 14
+
 extern const float vibrato_lut[VIBRATO_LUT_LENGTH];
 extern const uint16_t frequency_lut[FREQUENCY_LUT_LENGTH];
+extern const int8_t vibrato_period_lut[VIBRATO_PERIOD_LUT_LENGTH] PROGMEM;
 
 #endif /* LUTS_H */
@@ -0,0 +1,88 @@
+/* Generated by the audio_song test from song_list.h, don't edit */
+#ifndef SONG_BYTES_H
+#define SONG_BYTES_H
+
+// const uint8_t tone_startup[] PROGMEM = SONG_BYTES(STARTUP_SOUND);
+#define SONG_BYTES(name) { name##_BYTES }
+
+#define STARTUP_SOUND_BYTES \
+    0x85, 0x59, 0x83, 0x56, 0x4D, 0x52, 0x89, 0x56
+
+#define GOODBYE_SOUND_BYTES \
+    0x83, 0x59, 0x52, 0x85, 0x4D
+
+#define QWERTY_SOUND_BYTES \
+    0x83, 0x51, 0x52, 0x81, 0x00, 0x87, 0x59
+
+#define COLEMAK_SOUND_BYTES \
+    0x83, 0x51, 0x52, 0x81, 0x00, 0x85, 0x59, 0x81, 0x00, 0x85, 0x5D
+
+#define DVORAK_SOUND_BYTES \
+    0x83, 0x51, 0x52, 0x81, 0x00, 0x83, 0x59, 0x81, 0x00, 0x83, 0x5B, 0x81, \
+    0x00, 0x83, 0x59
+
+#define PLOVER_SOUND_BYTES \
+    0x83, 0x51, 0x52, 0x81, 0x00, 0x85, 0x59, 0x81, 0x00, 0x85, 0x5E
+
+#define PLOVER_GOODBYE_SOUND_BYTES \
+    0x83, 0x51, 0x52, 0x81, 0x00, 0x85, 0x5E, 0x81, 0x00, 0x85, 0x59
+
+#define MUSIC_SCALE_SOUND_BYTES \
+    0x83, 0x46, 0x48, 0x4A, 0x4B, 0x4D, 0x4F, 0x51, 0x52
+
+#define CAPS_LOCK_ON_SOUND_BYTES \
+    0x83, 0x2E, 0x30
+
+#define CAPS_LOCK_OFF_SOUND_BYTES \
+    0x83, 0x30, 0x2E
+
+#define SCROLL_LOCK_ON_SOUND_BYTES \
+    0x83, 0x33, 0x35
+
+#define SCROLL_LOCK_OFF_SOUND_BYTES \
+    0x83, 0x35, 0x33
+
+#define NUM_LOCK_ON_SOUND_BYTES \
+    0x83, 0x3F, 0x41
+
+#define NUM_LOCK_OFF_SOUND_BYTES \
+    0x83, 0x41, 0x3F
+
+#define UNICODE_WINDOWS_BYTES \
+    0x83, 0x48, 0x81, 0x4D
+
+#define UNICODE_LINUX_BYTES \
+    0x83, 0x4D, 0x81, 0x48
+
+#define COIN_SOUND_BYTES \
+    0x83, 0x46, 0x97, 0x4D
+
+#define ONE_UP_SOUND_BYTES \
+    0x4D, 0x50, 0x59, 0x55, 0x57, 0x5C
+
+#define SONIC_RING_BYTES \
+    0x83, 0x4D, 0x50, 0x97, 0x55
+
+#define ZELDA_PUZZLE_BYTES \
+    0x44, 0x43, 0x40, 0x3A, 0x39, 0x41, 0x45, 0x97, 0x49
+
+#define ODE_TO_JOY_BYTES \
+    0x35, 0xC0, 0x36, 0x38, 0xC0, 0x36, 0x35, 0x33, 0x31, 0xC0, 0x33, 0x35, \
+    0x8B, 0x35, 0x83, 0x33, 0x8F, 0x33
+
+#define ROCK_A_BYE_BABY_BYTES \
+    0x8B, 0x3C, 0x83, 0x33, 0x87, 0x48, 0x8F, 0x46, 0x87, 0x44, 0x8B, 0x3C, \
+    0x83, 0x3F, 0x87, 0x44, 0x8F, 0x43
+
+#define CLOSE_ENCOUNTERS_5_NOTE_BYTES \
+    0x3F, 0x41, 0x3D, 0x31, 0x38
+
+#define DOE_A_DEER_BYTES \
+    0x8B, 0x31, 0x83, 0x33, 0x8B, 0x35, 0x83, 0x31, 0x87, 0x35, 0x31, 0x35
+
+#define IN_LIKE_FLINT_BYTES \
+    0x83, 0x3B, 0xC0, 0x8B, 0x3C, 0x83, 0x3B, 0x3C, 0x8B, 0x32, 0x83, 0x3C, \
+    0x32, 0x8B, 0x34, 0x83, 0x32, 0x3C, 0x8B, 0x3B, 0x83, 0x3B, 0xC0, 0x8B, \
+    0x3C
+
+#endif
@@ -0,0 +1,353 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+extern "C" {
+#include "audio/audio_engine.h"
+#include "audio/musical_notes.h"
+#include "audio/voices.h"
+#include "audio/luts.h"
+#include "audio/audio_song.h"
+}
+
+#define TIMER_HZ ((double)AUDIO_TIMER_HZ)
+
+// Float operations, each one a library call on an AVR
+struct SoftFloatCalls {
+    unsigned add, mul, div, compare, convert, pow, fmod;
+};
+static SoftFloatCalls soft_float_calls;
+
+// A float that counts what is done with it
+struct CountedFloat {
+    CountedFloat(double value = 0) : v(value) {}
+    float v;
+};
+
+static CountedFloat operator+(CountedFloat a, CountedFloat b) { soft_float_calls.add++; return a.v + b.v; }
+static CountedFloat operator*(CountedFloat a, CountedFloat b) { soft_float_calls.mul++; return a.v * b.v; }
+static CountedFloat operator/(CountedFloat a, CountedFloat b) { soft_float_calls.div++; return a.v / b.v; }
+static bool operator<(CountedFloat a, CountedFloat b) { soft_float_calls.compare++; return a.v < b.v; }
+static bool operator>(CountedFloat a, CountedFloat b) { soft_float_calls.compare++; return a.v > b.v; }
+static bool operator!=(CountedFloat a, CountedFloat b) { soft_float_calls.compare++; return a.v != b.v; }
+static CountedFloat pow(CountedFloat a, CountedFloat b) { soft_float_calls.pow++; return std::pow(a.v, b.v); }
+static CountedFloat fmod(CountedFloat a, CountedFloat b) { soft_float_calls.fmod++; return std::fmod(a.v, b.v); }
+static int to_int(CountedFloat a) { soft_float_calls.convert++; return a.v; }
+static int to_int(float a) { return a; }
+
+// The floating point interrupt audio.c used before, for a held note with
+// glissando and vibrato on the default voice
+template <typename T>
+class FloatIsr {
+public:
+    FloatIsr() : frequency(0), target(0), vibrato_counter(0), vibrato_rate(0.125),
+                 note_timbre(TIMBRE_DEFAULT), envelope_index(0), period(0), duty(0) {}
+
+    void tick() {
+        if (frequency != 0 && frequency < target && frequency < target * pow(2, -440/target/12/2)) {
+            frequency = frequency * pow(2, 440/frequency/12/2);
+        } else if (frequency != 0 && frequency > target && frequency > target * pow(2, 440/target/12/2)) {
+            frequency = frequency * pow(2, -440/frequency/12/2);
+        } else {
+            frequency = target;
+        }
+        T freq = frequency * vibrato_lut[to_int(vibrato_counter)];
+        T counter = fmod(vibrato_counter + vibrato_rate * (1.0 + 440.0/frequency), VIBRATO_LUT_LENGTH);
+        vibrato_counter = counter < 0 ? counter + VIBRATO_LUT_LENGTH : counter;
+
+        if (envelope_index < 65535) {
+            envelope_index++;
+        }
+        note_timbre = TIMBRE_50;
+        if (freq < 30.517578125) {
+            freq = 30.52;
+        }
+        period = to_int(((float)F_CPU) / (freq * AUDIO_CPU_PRESCALER));
+        duty = to_int((((float)F_CPU) / (freq * AUDIO_CPU_PRESCALER)) * note_timbre);
+    }
+
+    T frequency;
+    T target;
+    T vibrato_counter;
+    T vibrato_rate;
+    T note_timbre;
+    uint16_t envelope_index;
+    uint16_t period;
+    uint16_t duty;
+};
+
+class AudioEngine : public testing::Test {
+public:
+    AudioEngine() : elapsed(0) {
+        audio_engine_stop();
+        audio_engine_set_tempo(TEMPO_DEFAULT);
+        set_voice(default_voice);
+        timer.period = 0;
+        timer.duty = 0;
+    }
+
+    bool tick() {
+        bool running = audio_engine_tick(&timer);
+        elapsed += timer.period;
+        return running;
+    }
+
+    // Runs the engine for a time in seconds
+    void run(double seconds) {
+        while (elapsed < seconds * TIMER_HZ) {
+            tick();
+        }
+    }
+
+    audio_timer_t timer;
+    uint64_t elapsed;
+};
+
+TEST_F(AudioEngine, periods) {
+    EXPECT_EQ(audio_period(440), 4545);
+    EXPECT_EQ(audio_period(NOTE_C4), (uint16_t)(TIMER_HZ / NOTE_C4));
+    EXPECT_EQ(audio_period(20), 0xFFFF);
+    EXPECT_EQ(AUDIO_PERIOD(440), 4545);
+}
+
+TEST_F(AudioEngine, held_note_stays_within_the_vibrato) {
+    audio_engine_add_voice(440);
+    uint16_t lowest = 0xFFFF, highest = 0;
+    for (int i = 0; i < 2000; i++) {
+        tick();
+        lowest = std::min(lowest, timer.period);
+        highest = std::max(highest, timer.period);
+        EXPECT_EQ(timer.duty, timer.period / 2);
+    }
+    // an eighth of a semitone either way
+    EXPECT_LT(lowest, 4545);
+    EXPECT_GT(highest, 4545);
+    EXPECT_GE(lowest, 4545 * 0.992);
+    EXPECT_LE(highest, 4545 * 1.008);
+}
+
+TEST_F(AudioEngine, envelope_counts_time) {
+    for (float frequency : {110.0f, 440.0f, 1760.0f}) {
+        audio_engine_stop();
+        audio_engine_add_voice(frequency);
+        elapsed = 0;
+        run(0.5);
+        // run stops up to one period late
+        EXPECT_NEAR(envelope_time, 440, 1 + audio_period(frequency) / AUDIO_ENVELOPE_STEP) << frequency;
+    }
+}
+
+TEST_F(AudioEngine, glissando_matches_the_float_version) {
+    FloatIsr<float> reference;
+    reference.frequency = 220;
+    reference.target = 220;
+    reference.tick();
+    reference.target = 440;
+    double reference_time = 0;
+    while (reference.frequency != reference.target) {
+        reference.tick();
+        reference_time += reference.period / TIMER_HZ;
+    }
+
+    audio_engine_add_voice(220);
+    tick();
+    audio_engine_add_voice(440);
+    elapsed = 0;
+    while (timer.period > 4545 * 1.008) {
+        tick();
+    }
+    double time = elapsed / TIMER_HZ;
+    printf("octave glide: %.1f ms before, %.1f ms now\n", reference_time * 1000, time * 1000);
+    EXPECT_NEAR(time, reference_time, reference_time * 0.25);
+}
+
+TEST_F(AudioEngine, released_voices_fall_back) {
+    audio_engine_add_voice(440);
+    audio_engine_add_voice(880);
+    run(0.2);
+    EXPECT_NEAR(timer.period, 2272, 2272 * 0.008);
+    audio_engine_remove_voice(880);
+    run(0.4);
+    EXPECT_NEAR(timer.period, 4545, 4545 * 0.008);
+    audio_engine_remove_voice(440);
+    EXPECT_FALSE(playing_note);
+    EXPECT_EQ(audio_engine_voices(), 0);
+}
+
+TEST_F(AudioEngine, song_plays_for_its_length) {
+    float song[][2] = {
+        { NOTE_A4, 16 },
+        { NOTE_REST, 8 },
+        { NOTE_A5, 8 },
+    };
+    audio_engine_play_notes(&song, 3, false, 0);
+    uint16_t silent = 0;
+    while (tick()) {
+        if (timer.duty == 0) {
+            silent++;
+        }
+    }
+    EXPECT_FALSE(playing_notes);
+    // lengths are in 1/4 of 0xFFFF timer ticks
+    double expected = (16 + 8 + 8) / 4.0 * 0xFFFF;
+    EXPECT_NEAR(elapsed, expected, 3 * 4545);
+    EXPECT_GT(silent, 0);
+}
+
+TEST_F(AudioEngine, song_rests_and_repeats) {
+    float song[][2] = {
+        { NOTE_A4, 8 },
+        { NOTE_A5, 8 },
+    };
+    audio_engine_play_notes(&song, 2, true, 1);
+    run(4 * (2 * 0xFFFF + 2 * 0.25 * 0xFFFF) / TIMER_HZ);
+    EXPECT_TRUE(playing_notes);
+    audio_engine_stop();
+    EXPECT_FALSE(tick() && playing_notes);
+}
+
+TEST_F(AudioEngine, compressed_song_plays_like_the_floats) {
+    float song[][2] = {
+        { NOTE_A4, 16 },
+        { NOTE_REST, 8 },
+        { NOTE_CS5, 8 },
+        { NOTE_CS5, 8 },
+        { NOTE_E5, 6 },
+    };
+    uint8_t compressed[16];
+    uint16_t size = audio_song_encode(song, 5, compressed, sizeof(compressed));
+    ASSERT_GT(size, 0);
+
+    // the period heard in the middle of every note and rest
+    auto middles = [&]() {
+        std::vector<std::pair<uint64_t, uint16_t>> ticks;
+        elapsed = 0;
+        while (tick()) {
+            ticks.push_back({ elapsed, timer.duty ? timer.period : 0 });
+        }
+        std::vector<uint16_t> heard;
+        double start = 0;
+        for (int i = 0; i < 5; i++) {
+            for (double length : { song[i][1] / 4.0 * 0xFFFF, STACCATO * 0xFFFF }) {
+                double middle = start + length / 2;
+                start += length;
+                for (auto& t : ticks) {
+                    if (t.first >= middle) {
+                        heard.push_back(t.second);
+                        break;
+                    }
+                }
+            }
+        }
+        return heard;
+    };
+
+    audio_engine_play_notes(&song, 5, false, STACCATO);
+    std::vector<uint16_t> float_periods = middles();
+    uint64_t float_elapsed = elapsed;
+    audio_engine_play_song(compressed, size, false, STACCATO);
+    std::vector<uint16_t> periods = middles();
+
+    EXPECT_NEAR(elapsed, float_elapsed, 5 * 4545);
+    ASSERT_EQ(periods.size(), float_periods.size());
+    for (size_t i = 0; i < periods.size(); i++) {
+        // both within the vibrato
+        EXPECT_NEAR(periods[i], float_periods[i], float_periods[i] * 0.017) << i;
+    }
+    EXPECT_EQ(float_periods[2], 0);
+}
+
+TEST_F(AudioEngine, tempo_scales_notes) {
+    float song[][2] = {
+        { NOTE_A4, 8 },
+    };
+    audio_engine_set_tempo(200);
+    audio_engine_play_notes(&song, 1, false, 0);
+    while (tick());
+    EXPECT_NEAR(elapsed, 4 * 0xFFFF, 4545);
+}
+
+TEST_F(AudioEngine, fader_voice_fades_out) {
+    set_voice(butts_fader);
+    audio_engine_add_voice(440);
+    run(0.01);
+    EXPECT_NEAR(timer.period, 4 * 4545, 4 * 4545 * 0.008);
+    run(0.05);
+    EXPECT_GT(timer.duty, 0);
+    run(0.3);
+    EXPECT_EQ(timer.duty, 0);
+}
+
+TEST_F(AudioEngine, drums_stay_in_their_range) {
+    set_voice(drums);
+    audio_engine_add_voice(NOTE_C3);
+    for (int i = 0; i < 200; i++) {
+        tick();
+        EXPECT_GE(timer.period, AUDIO_PERIOD(100) * 0.99);
+        EXPECT_LE(timer.period, AUDIO_PERIOD(60) * 1.01);
+    }
+}
+
+template <typename F>
+static double time_ticks(F tick, unsigned ticks) {
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < ticks; i++) {
+        tick();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / ticks;
+}
+
+// The interrupt used to make a handful of float library calls every time,
+// that's what costs on an AVR. The host timings only show the part that
+// doesn't go away with an FPU.
+TEST_F(AudioEngine, benchmark) {
+    const unsigned ticks = 200000;
+    volatile uint16_t sink = 0;
+
+    // alternating between two notes every 1024 interrupts, so there is
+    // always some glissando going on
+    FloatIsr<CountedFloat> counted;
+    counted.frequency = 220;
+    for (unsigned count = 0; count < ticks; count++) {
+        counted.target = (count & 0x400) ? 440 : 220;
+        counted.tick();
+    }
+    SoftFloatCalls& c = soft_float_calls;
+    printf("float calls per interrupt before: %.2f add, %.2f mul, %.2f div, %.2f compare, "
+           "%.2f convert, %.2f pow, %.2f fmod; none now\n",
+           (double)c.add / ticks, (double)c.mul / ticks, (double)c.div / ticks,
+           (double)c.compare / ticks, (double)c.convert / ticks,
+           (double)c.pow / ticks, (double)c.fmod / ticks);
+    EXPECT_GE(c.div, 3 * ticks);
+    EXPECT_EQ(c.fmod, ticks);
+
+    unsigned count = 0;
+    FloatIsr<float> reference;
+    reference.frequency = 220;
+    double float_time = time_ticks([&]() {
+        reference.target = (++count & 0x400) ? 440 : 220;
+        reference.tick();
+        sink = reference.duty;
+    }, ticks);
+
+    count = 0;
+    audio_engine_add_voice(220);
+    bool high = false;
+    double integer_time = time_ticks([&]() {
+        if (((++count & 0x400) != 0) != high) {
+            high = !high;
+            if (high) {
+                audio_engine_add_voice(440);
+            } else {
+                audio_engine_remove_voice(440);
+            }
+        }
+        tick();
+        sink = timer.duty;
+    }, ticks);
+    (void)sink;
+
+    printf("host interrupt: %6.1f ns before, %6.1f ns now\n", float_time, integer_time);
+}
@@ -0,0 +1,220 @@
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+extern "C" {
+#include "audio/audio_mixer.h"
+#include "audio/musical_notes.h"
+#include "audio/audio_song.h"
+}
+
+// Renders the mixer natively and keeps everything it produced, for
+// checking and for listening to as a WAV file
+class AudioMixer : public testing::Test {
+public:
+    AudioMixer() {
+        audio_mixer_init();
+        audio_mixer_set_timbre(TIMBRE_50);
+        audio_mixer_set_tempo(TEMPO_DEFAULT);
+    }
+
+    bool render(double seconds) {
+        std::vector<audio_sample_t> block(seconds * AUDIO_SAMPLE_RATE);
+        bool audible = audio_mixer_render(block.data(), block.size());
+        samples.insert(samples.end(), block.begin(), block.end());
+        return audible;
+    }
+
+    // 16 bit mono PCM
+    void write_wav(const char* name) {
+        std::string path = std::string(".build/audio_mixer_") + name + ".wav";
+        FILE* file = fopen(path.c_str(), "wb");
+        ASSERT_NE(file, nullptr);
+        uint32_t data_size = samples.size() * 2;
+        auto u32 = [&](uint32_t v) { fwrite(&v, 4, 1, file); };
+        auto u16 = [&](uint16_t v) { fwrite(&v, 2, 1, file); };
+        fwrite("RIFF", 4, 1, file);
+        u32(36 + data_size);
+        fwrite("WAVEfmt ", 8, 1, file);
+        u32(16);
+        u16(1);
+        u16(1);
+        u32(AUDIO_SAMPLE_RATE);
+        u32(AUDIO_SAMPLE_RATE * 2);
+        u16(2);
+        u16(16);
+        fwrite("data", 4, 1, file);
+        u32(data_size);
+        for (audio_sample_t sample : samples) {
+            u16((int16_t)((sample - AUDIO_MIXER_CENTER) * 8));
+        }
+        fclose(file);
+    }
+
+    // Goertzel, the power of one frequency in the samples from start on
+    double power(double frequency, size_t start = 0) {
+        double coefficient = 2 * cos(2 * M_PI * frequency / AUDIO_SAMPLE_RATE);
+        double s1 = 0, s2 = 0;
+        for (size_t i = start; i < samples.size(); i++) {
+            double s = (samples[i] - AUDIO_MIXER_CENTER) + coefficient * s1 - s2;
+            s2 = s1;
+            s1 = s;
+        }
+        return s1 * s1 + s2 * s2 - coefficient * s1 * s2;
+    }
+
+    std::vector<audio_sample_t> samples;
+};
+
+TEST_F(AudioMixer, silent_when_idle) {
+    EXPECT_FALSE(render(0.01));
+    for (audio_sample_t sample : samples) {
+        EXPECT_EQ(sample, AUDIO_MIXER_CENTER);
+    }
+}
+
+TEST_F(AudioMixer, chord_plays_every_note) {
+    EXPECT_TRUE(audio_mixer_note_on(NOTE_C4));
+    EXPECT_TRUE(audio_mixer_note_on(NOTE_E4));
+    EXPECT_TRUE(audio_mixer_note_on(NOTE_G4));
+    EXPECT_TRUE(render(0.5));
+    write_wav("chord");
+
+    double off_key = std::max(power(NOTE_A4), power(NOTE_D4));
+    EXPECT_GT(power(NOTE_C4), 20 * off_key);
+    EXPECT_GT(power(NOTE_E4), 20 * off_key);
+    EXPECT_GT(power(NOTE_G4), 20 * off_key);
+}
+
+TEST_F(AudioMixer, release_fades_out) {
+    audio_mixer_note_on(NOTE_A4);
+    render(0.05);
+    audio_mixer_note_off(NOTE_A4);
+    size_t released = samples.size();
+    render(0.01);
+    EXPECT_EQ(audio_mixer_active_voices(), 0);
+
+    // the level comes down over AUDIO_MIXER_RAMP samples, not at once
+    int first = 0, last = 0;
+    for (size_t i = released; i < released + 8; i++) {
+        first = std::max(first, abs(samples[i] - AUDIO_MIXER_CENTER));
+    }
+    for (size_t i = released + AUDIO_MIXER_RAMP - 8; i < released + AUDIO_MIXER_RAMP; i++) {
+        last = std::max(last, abs(samples[i] - AUDIO_MIXER_CENTER));
+    }
+    EXPECT_GT(first, AUDIO_MIXER_AMPLITUDE * 3 / 4);
+    EXPECT_LT(last, AUDIO_MIXER_AMPLITUDE / 4);
+    for (size_t i = released + AUDIO_MIXER_RAMP; i < samples.size(); i++) {
+        EXPECT_EQ(samples[i], AUDIO_MIXER_CENTER);
+    }
+    EXPECT_FALSE(render(0.01));
+}
+
+TEST_F(AudioMixer, voices_are_limited_and_clipped) {
+    for (int i = 0; i < AUDIO_MIXER_VOICES; i++) {
+        EXPECT_TRUE(audio_mixer_note_on(NOTE_A3 * (i + 1)));
+    }
+    EXPECT_FALSE(audio_mixer_note_on(NOTE_A2));
+    render(0.05);
+    // whenever most of them are high together the sum clips rather than
+    // wraps around
+    EXPECT_EQ(*std::max_element(samples.begin(), samples.end()), AUDIO_MIXER_MAX);
+    for (audio_sample_t sample : samples) {
+        EXPECT_LE(sample, AUDIO_MIXER_MAX);
+    }
+
+    // a released voice can be taken over
+    audio_mixer_note_off(NOTE_A3);
+    EXPECT_TRUE(audio_mixer_note_on(NOTE_A2));
+}
+
+TEST_F(AudioMixer, song_plays_for_its_length) {
+    float song[][2] = {
+        { NOTE_C5, 16 },
+        { NOTE_REST, 8 },
+        { NOTE_E5, 8 },
+        { NOTE_G5, 16 },
+    };
+    audio_mixer_play_song(&song, 4, false, 0);
+    while (audio_mixer_song_playing()) {
+        render(0.001);
+    }
+    render(0.01);
+    write_wav("song");
+
+    // the same time the AVR timer takes, 1/4 of 0xFFFF ticks of 2MHz per
+    // length unit
+    double expected = (16 + 8 + 8 + 16) / 4.0 * 0xFFFF / AUDIO_MIXER_SONG_TICK_HZ;
+    size_t last = samples.size();
+    while (last > 0 && samples[last - 1] == AUDIO_MIXER_CENTER) {
+        last--;
+    }
+    EXPECT_NEAR((double)last / AUDIO_SAMPLE_RATE, expected, 0.005);
+    EXPECT_GT(power(NOTE_E5), 20 * power(NOTE_D5));
+}
+
+TEST_F(AudioMixer, compressed_song_sounds_the_same) {
+    float song[][2] = {
+        { NOTE_C5, 16 },
+        { NOTE_REST, 8 },
+        { NOTE_E5, 8 },
+        { NOTE_G5, 16 },
+    };
+    audio_mixer_play_song(&song, 4, false, 0);
+    while (audio_mixer_song_playing()) {
+        render(0.001);
+    }
+    std::vector<audio_sample_t> float_samples;
+    float_samples.swap(samples);
+
+    uint8_t compressed[8];
+    uint16_t size = audio_song_encode(song, 4, compressed, sizeof(compressed));
+    audio_mixer_play_compressed_song(compressed, size, false, 0);
+    while (audio_mixer_song_playing()) {
+        render(0.001);
+    }
+    ASSERT_EQ(samples.size(), float_samples.size());
+    std::vector<audio_sample_t> compressed_samples;
+    compressed_samples.swap(samples);
+    for (float note : { NOTE_C5, NOTE_E5, NOTE_G5 }) {
+        samples = float_samples;
+        double expected = power(note);
+        samples = compressed_samples;
+        EXPECT_NEAR(power(note), expected, expected * 0.1) << note;
+    }
+    EXPECT_GT(power(NOTE_E5), 20 * power(NOTE_D5));
+}
+
+TEST_F(AudioMixer, repeated_song_keeps_going) {
+    float song[][2] = {
+        { NOTE_C5, 4 },
+        { NOTE_E5, 4 },
+    };
+    audio_mixer_play_song(&song, 2, true, 1);
+    render(1);
+    EXPECT_TRUE(audio_mixer_song_playing());
+    audio_mixer_all_off();
+    EXPECT_FALSE(audio_mixer_song_playing());
+    render(0.01);
+    EXPECT_EQ(audio_mixer_active_voices(), 0);
+}
+
+// Cost of mixing every voice, which bounds the time the DMA interrupt takes
+TEST_F(AudioMixer, benchmark) {
+    for (int i = 0; i < AUDIO_MIXER_VOICES; i++) {
+        audio_mixer_note_on(NOTE_C4 * (i + 1));
+    }
+    std::vector<audio_sample_t> block(128);
+    const unsigned blocks = 2000;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < blocks; i++) {
+        audio_mixer_render(block.data(), block.size());
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / (blocks * block.size());
+    printf("%d voices: %.1f ns per sample, %.2f%% of real time on this host\n",
+           AUDIO_MIXER_VOICES, ns, ns * AUDIO_SAMPLE_RATE / 1e7);
+}
@@ -0,0 +1,211 @@
+#include "gtest/gtest.h"
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+extern "C" {
+#include "audio/audio_song.h"
+#include "audio/musical_notes.h"
+#include "audio/song_list.h"
+#include "audio/song_bytes.h"
+}
+
+struct FloatSong {
+    const char* name;
+    std::vector<std::array<float, 2>> notes;
+};
+
+#define NOTE_ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
+#define FLOAT_SONG(name) \
+    { #name, [] { float notes[][2] = SONG(name); \
+                  return std::vector<std::array<float, 2>>((std::array<float, 2>*)notes, \
+                      (std::array<float, 2>*)notes + NOTE_ARRAY_SIZE(notes)); }() }
+
+// Everything in song_list.h
+static const std::vector<FloatSong> song_list = {
+    FLOAT_SONG(STARTUP_SOUND),
+    FLOAT_SONG(GOODBYE_SOUND),
+    FLOAT_SONG(QWERTY_SOUND),
+    FLOAT_SONG(COLEMAK_SOUND),
+    FLOAT_SONG(DVORAK_SOUND),
+    FLOAT_SONG(PLOVER_SOUND),
+    FLOAT_SONG(PLOVER_GOODBYE_SOUND),
+    FLOAT_SONG(MUSIC_SCALE_SOUND),
+    FLOAT_SONG(CAPS_LOCK_ON_SOUND),
+    FLOAT_SONG(CAPS_LOCK_OFF_SOUND),
+    FLOAT_SONG(SCROLL_LOCK_ON_SOUND),
+    FLOAT_SONG(SCROLL_LOCK_OFF_SOUND),
+    FLOAT_SONG(NUM_LOCK_ON_SOUND),
+    FLOAT_SONG(NUM_LOCK_OFF_SOUND),
+    FLOAT_SONG(UNICODE_WINDOWS),
+    FLOAT_SONG(UNICODE_LINUX),
+    FLOAT_SONG(COIN_SOUND),
+    FLOAT_SONG(ONE_UP_SOUND),
+    FLOAT_SONG(SONIC_RING),
+    FLOAT_SONG(ZELDA_PUZZLE),
+    FLOAT_SONG(ODE_TO_JOY),
+    FLOAT_SONG(ROCK_A_BYE_BABY),
+    FLOAT_SONG(CLOSE_ENCOUNTERS_5_NOTE),
+    FLOAT_SONG(DOE_A_DEER),
+    FLOAT_SONG(IN_LIKE_FLINT),
+};
+
+static std::vector<uint8_t> encode(const std::vector<std::array<float, 2>>& notes) {
+    std::vector<uint8_t> out(notes.size() * 3 + 1);
+    uint16_t size = audio_song_encode((const float(*)[2])notes.data(), notes.size(), out.data(), out.size());
+    out.resize(size);
+    return out;
+}
+
+static std::vector<std::array<float, 2>> decode(const std::vector<uint8_t>& data) {
+    std::vector<std::array<float, 2>> notes;
+    audio_song_t song;
+    audio_song_start(&song, data.data(), data.size());
+    while (audio_song_next(&song)) {
+        notes.push_back({ audio_song_frequency(song.note) / 65536.0f, (float)song.duration });
+    }
+    return notes;
+}
+
+TEST(AudioSong, every_note_maps_back) {
+    for (uint8_t note = 1; note <= SONG_NOTE_MAX; note++) {
+        EXPECT_EQ(audio_song_note(audio_song_frequency(note) / 65536.0f), note);
+    }
+    EXPECT_EQ(audio_song_note(NOTE_REST), SONG_REST);
+    EXPECT_EQ(audio_song_note(NOTE_A4), SONG_NOTE(4, 9));
+    EXPECT_EQ(audio_song_note(NOTE_C2), SONG_NOTE(2, 0));
+    EXPECT_EQ(audio_song_note(NOTE_B8), SONG_NOTE_MAX);
+    EXPECT_NEAR(audio_song_frequency(SONG_NOTE(4, 9)) / 65536.0, 440, 0.01);
+    // between two notes
+    EXPECT_EQ(audio_song_note(452), 0xFF);
+    EXPECT_EQ(audio_song_note(10000), 0xFF);
+}
+
+TEST(AudioSong, song_list_round_trips) {
+    for (const FloatSong& song : song_list) {
+        std::vector<uint8_t> data = encode(song.notes);
+        ASSERT_GT(data.size(), 0u) << song.name;
+        std::vector<std::array<float, 2>> notes = decode(data);
+        ASSERT_EQ(notes.size(), song.notes.size()) << song.name;
+        for (size_t i = 0; i < notes.size(); i++) {
+            EXPECT_NEAR(notes[i][0], song.notes[i][0], song.notes[i][0] * 0.001) << song.name << " " << i;
+            EXPECT_EQ(notes[i][1], song.notes[i][1]) << song.name << " " << i;
+        }
+    }
+}
+
+TEST(AudioSong, repeats_and_lengths) {
+    std::vector<std::array<float, 2>> notes = {
+        { NOTE_E4, 16 }, { NOTE_E4, 16 }, { NOTE_E4, 16 }, { NOTE_F4, 16 },
+        { NOTE_G4, 7 }, { NOTE_REST, 200 }, { NOTE_G4, 128 },
+    };
+    for (int i = 0; i < 60; i++) {
+        notes.push_back({ NOTE_C5, 128 });
+    }
+    std::vector<uint8_t> data = encode(notes);
+    std::vector<uint8_t> expected = {
+        SONG_NOTE(4, 4), SONG_REPEAT(2), SONG_NOTE(4, 5),
+        SONG_LONG_DURATION, 7, SONG_NOTE(4, 7),
+        SONG_LONG_DURATION, 200, SONG_REST,
+        SONG_DURATION(128), SONG_NOTE(4, 7),
+        SONG_NOTE(5, 0), SONG_REPEAT(SONG_REPEAT_MAX), SONG_REPEAT(11),
+    };
+    EXPECT_EQ(data, expected);
+    EXPECT_EQ(decode(data).size(), notes.size());
+}
+
+TEST(AudioSong, refuses_what_it_cant_hold) {
+    std::vector<std::array<float, 2>> off_key = { { 452, 16 } };
+    EXPECT_TRUE(encode(off_key).empty());
+    std::vector<std::array<float, 2>> fraction = { { NOTE_A4, 0.5 } };
+    EXPECT_TRUE(encode(fraction).empty());
+    std::vector<std::array<float, 2>> too_long = { { NOTE_A4, 256 } };
+    EXPECT_TRUE(encode(too_long).empty());
+
+    std::vector<std::array<float, 2>> notes = { { NOTE_A4, 8 }, { NOTE_B4, 8 } };
+    uint8_t out[3];
+    EXPECT_EQ(audio_song_encode((const float(*)[2])notes.data(), 2, out, 2), 0);
+    EXPECT_EQ(audio_song_encode((const float(*)[2])notes.data(), 2, out, 3), 3);
+}
+
+TEST(AudioSong, done_after_the_last_note) {
+    const uint8_t data[] = { SONG_NOTE(4, 9), SONG_REPEAT(2) };
+    audio_song_t song;
+    audio_song_start(&song, data, sizeof(data));
+    int notes = 0;
+    while (!audio_song_done(&song)) {
+        EXPECT_TRUE(audio_song_next(&song));
+        notes++;
+    }
+    EXPECT_EQ(notes, 3);
+    EXPECT_FALSE(audio_song_next(&song));
+}
+
+// Converts the whole song list and reports what it saves. The converted
+// songs are committed as quantum/audio/song_bytes.h, which has to match;
+// after a change to song_list.h, copy .build/song_bytes.h over it.
+TEST(AudioSong, converter) {
+    std::string header =
+        "/* Generated by the audio_song test from song_list.h, don't edit */\n"
+        "#ifndef SONG_BYTES_H\n"
+        "#define SONG_BYTES_H\n"
+        "\n"
+        "// const uint8_t tone_startup[] PROGMEM = SONG_BYTES(STARTUP_SOUND);\n"
+        "#define SONG_BYTES(name) { name##_BYTES }\n";
+
+    size_t float_bytes = 0, song_bytes = 0;
+    for (const FloatSong& song : song_list) {
+        std::vector<uint8_t> data = encode(song.notes);
+        float_bytes += song.notes.size() * sizeof(float[2]);
+        song_bytes += data.size();
+
+        header += "\n#define " + std::string(song.name) + "_BYTES";
+        for (size_t i = 0; i < data.size(); i++) {
+            char byte[8];
+            snprintf(byte, sizeof(byte), "0x%02X", data[i]);
+            header += i % 12 ? ", " : (i ? ", \\\n    " : " \\\n    ");
+            header += byte;
+        }
+        header += "\n";
+    }
+    header += "\n#endif\n";
+
+    std::string committed;
+    FILE* file = fopen("quantum/audio/song_bytes.h", "r");
+    ASSERT_NE(file, nullptr);
+    char buffer[256];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        committed.append(buffer, read);
+    }
+    fclose(file);
+    if (committed != header) {
+        file = fopen(".build/song_bytes.h", "w");
+        ASSERT_NE(file, nullptr);
+        fputs(header.c_str(), file);
+        fclose(file);
+    }
+    EXPECT_EQ(committed, header) << "song_bytes.h is out of date, see .build/song_bytes.h";
+
+    // the octave table comes with the decoder
+    size_t table_bytes = 12 * sizeof(uint32_t);
+    printf("song_list.h: %zu bytes as floats, %zu compressed + %zu for the note table, %.0f%% saved\n",
+           float_bytes, song_bytes, table_bytes,
+           100.0 * (1 - (double)(song_bytes + table_bytes) / float_bytes));
+    EXPECT_LT(song_bytes * 4, float_bytes);
+}
+
+// The committed songs play the same notes as the float ones
+TEST(AudioSong, song_bytes_match) {
+    const uint8_t startup[] = SONG_BYTES(STARTUP_SOUND);
+    const uint8_t scale[] = SONG_BYTES(MUSIC_SCALE_SOUND);
+    float startup_notes[][2] = SONG(STARTUP_SOUND);
+    float scale_notes[][2] = SONG(MUSIC_SCALE_SOUND);
+    EXPECT_EQ(std::vector<uint8_t>(startup, startup + sizeof(startup)),
+              encode(std::vector<std::array<float, 2>>((std::array<float, 2>*)startup_notes,
+                  (std::array<float, 2>*)startup_notes + NOTE_ARRAY_SIZE(startup_notes))));
+    EXPECT_EQ(std::vector<uint8_t>(scale, scale + sizeof(scale)),
+              encode(std::vector<std::array<float, 2>>((std::array<float, 2>*)scale_notes,
+                  (std::array<float, 2>*)scale_notes + NOTE_ARRAY_SIZE(scale_notes))));
+}
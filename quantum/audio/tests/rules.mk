@@ -0,0 +1,16 @@
+audio_engine_DEFS := -DF_CPU=16000000 -DAUDIO_VOICES -DVIBRATO_ENABLE
+audio_engine_SRC :=\
+	$(QUANTUM_PATH)/audio/tests/audio_engine_tests.cpp \
+	$(QUANTUM_PATH)/audio/audio_engine.c \
+	$(QUANTUM_PATH)/audio/audio_song.c \
+	$(QUANTUM_PATH)/audio/voices.c \
+	$(QUANTUM_PATH)/audio/luts.c
+
+audio_mixer_SRC :=\
+	$(QUANTUM_PATH)/audio/tests/audio_mixer_tests.cpp \
+	$(QUANTUM_PATH)/audio/audio_mixer.c \
+	$(QUANTUM_PATH)/audio/audio_song.c
+
+audio_song_SRC :=\
+	$(QUANTUM_PATH)/audio/tests/audio_song_tests.cpp \
+	$(QUANTUM_PATH)/audio/audio_song.c
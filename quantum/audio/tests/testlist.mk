@@ -0,0 +1,4 @@
+TEST_LIST +=\
+	audio_engine\
+	audio_mixer\
+	audio_song
@@ -14,14 +14,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "voices.h"
-#include "audio.h"
-#include "stdlib.h"
-
-// these are imported from audio.c
-extern uint16_t envelope_index;
-extern float note_timbre;
-extern float polyphony_rate;
-extern bool glissando;
+#include "audio_engine.h"
+#include "musical_notes.h"
 
 voice_type voice = default_voice;
 
@@ -37,45 +31,59 @@ void voice_deiterate() {
     voice = (voice - 1 + number_of_voices) % number_of_voices;
 }
 
-float voice_envelope(float frequency) {
-    // envelope_index ranges from 0 to 0xFFFF, which is preserved at 880.0 Hz
-    __attribute__ ((unused))
-    uint16_t compensated_index = (uint16_t)((float)envelope_index * (880.0 / frequency));
+#ifdef AUDIO_VOICES
+
+// A period shift octaves down, as far as the timer goes
+static uint16_t octaves_down(uint16_t period, uint8_t shift) {
+    return period > (0xFFFF >> shift) ? 0xFFFF : period << shift;
+}
+
+// A random period between two frequencies
+#define RANDOM_PERIOD(low, high) \
+    (AUDIO_PERIOD(high) + (((uint32_t)audio_noise() * (AUDIO_PERIOD(low) - AUDIO_PERIOD(high))) >> 16))
+
+// Fades a 50% duty cycle out over length steps
+#define FADE(remaining, length) ((remaining) * (TIMBRE8(TIMBRE_50) / (length)))
+
+#endif
+
+uint16_t voice_envelope(uint16_t period) {
+    // envelope_time counts 1/880 s, whatever the note
 
     switch (voice) {
         case default_voice:
             glissando = true;
-            note_timbre = TIMBRE_50;
-            polyphony_rate = 0;
+            note_timbre = TIMBRE8(TIMBRE_50);
+            polyphony_ticks = 0;
 	        break;
 
     #ifdef AUDIO_VOICES
 
         case something:
             glissando = false;
-            polyphony_rate = 0;
-            switch (compensated_index) {
+            polyphony_ticks = 0;
+            switch (envelope_time) {
                 case 0 ... 9:
-                    note_timbre = TIMBRE_12;
+                    note_timbre = TIMBRE8(TIMBRE_12);
                     break;
 
                 case 10 ... 19:
-                    note_timbre = TIMBRE_25;
+                    note_timbre = TIMBRE8(TIMBRE_25);
                     break;
 
                 case 20 ... 200:
-                    note_timbre = .125 + .125;
+                    note_timbre = TIMBRE8(.125 + .125);
                     break;
 
                 default:
-                    note_timbre = .125;
+                    note_timbre = TIMBRE8(.125);
                     break;
             }
             break;
 
         case drums:
             glissando = false;
-            polyphony_rate = 0;
+            polyphony_ticks = 0;
                 // switch (compensated_index) {
                 //     case 0 ... 10:
                 //         note_timbre = 0.5;
@@ -89,67 +97,67 @@ float voice_envelope(float frequency) {
                 // }
                 // frequency = (rand() % (int)(frequency * 1.2 - frequency)) + (frequency * 0.8);
 
-            if (frequency < 80.0) {
+            if (period > AUDIO_PERIOD(80)) {
 
-            } else if (frequency < 160.0) {
+            } else if (period > AUDIO_PERIOD(160)) {
 
                 // Bass drum: 60 - 100 Hz
-                frequency = (rand() % (int)(40)) + 60;
+                period = RANDOM_PERIOD(60, 100);
                 switch (envelope_index) {
                     case 0 ... 10:
-                        note_timbre = 0.5;
+                        note_timbre = TIMBRE8(TIMBRE_50);
                         break;
                     case 11 ... 20:
-                        note_timbre = 0.5 * (21 - envelope_index) / 10;
+                        note_timbre = FADE(21 - envelope_index, 10);
                         break;
                     default:
                         note_timbre = 0;
                         break;
                 }
 
-            } else if (frequency < 320.0) {
+            } else if (period > AUDIO_PERIOD(320)) {
 
 
                 // Snare drum: 1 - 2 KHz
-                frequency = (rand() % (int)(1000)) + 1000;
+                period = RANDOM_PERIOD(1000, 2000);
                 switch (envelope_index) {
                     case 0 ... 5:
-                        note_timbre = 0.5;
+                        note_timbre = TIMBRE8(TIMBRE_50);
                         break;
                     case 6 ... 20:
-                        note_timbre = 0.5 * (21 - envelope_index) / 15;
+                        note_timbre = FADE(21 - envelope_index, 15);
                         break;
                     default:
                         note_timbre = 0;
                         break;
                 }
 
-            } else if (frequency < 640.0) {
+            } else if (period > AUDIO_PERIOD(640)) {
 
                 // Closed Hi-hat: 3 - 5 KHz
-                frequency = (rand() % (int)(2000)) + 3000;
+                period = RANDOM_PERIOD(3000, 5000);
                 switch (envelope_index) {
                     case 0 ... 15:
-                        note_timbre = 0.5;
+                        note_timbre = TIMBRE8(TIMBRE_50);
                         break;
                     case 16 ... 20:
-                        note_timbre = 0.5 * (21 - envelope_index) / 5;
+                        note_timbre = FADE(21 - envelope_index, 5);
                         break;
                     default:
                         note_timbre = 0;
                         break;
                 }
 
-            } else if (frequency < 1280.0) {
+            } else if (period > AUDIO_PERIOD(1280)) {
 
                 // Open Hi-hat: 3 - 5 KHz
-                frequency = (rand() % (int)(2000)) + 3000;
+                period = RANDOM_PERIOD(3000, 5000);
                 switch (envelope_index) {
                     case 0 ... 35:
-                        note_timbre = 0.5;
+                        note_timbre = TIMBRE8(TIMBRE_50);
                         break;
                     case 36 ... 50:
-                        note_timbre = 0.5 * (51 - envelope_index) / 15;
+                        note_timbre = FADE(51 - envelope_index, 15);
                         break;
                     default:
                         note_timbre = 0;
@@ -160,20 +168,21 @@ float voice_envelope(float frequency) {
             break;
         case butts_fader:
             glissando = true;
-            polyphony_rate = 0;
-            switch (compensated_index) {
+            polyphony_ticks = 0;
+            switch (envelope_time) {
                 case 0 ... 9:
-                    frequency = frequency / 4;
-                    note_timbre = TIMBRE_12;
+                    period = octaves_down(period, 2);
+                    note_timbre = TIMBRE8(TIMBRE_12);
 	                break;
 
                 case 10 ... 19:
-                    frequency = frequency / 2;
-                    note_timbre = TIMBRE_12;
+                    period = octaves_down(period, 1);
+                    note_timbre = TIMBRE8(TIMBRE_12);
 	                break;
 
                 case 20 ... 200:
-                    note_timbre = .125 - pow(((float)compensated_index - 20) / (200 - 20), 2)*.125;
+                    // .125 - ((t - 20) / 180)^2 * .125, 180^2 / 32 is close to 1024
+                    note_timbre = TIMBRE8(TIMBRE_12) - (((uint16_t)(envelope_time - 20) * (envelope_time - 20)) >> 10);
 	                break;
 
                 default:
@@ -183,7 +192,7 @@ float voice_envelope(float frequency) {
     	    break;
 
         // case octave_crunch:
-        //     polyphony_rate = 0;
+        //     polyphony_ticks = 0;
         //     switch (compensated_index) {
         //         case 0 ... 9:
         //         case 20 ... 24:
@@ -206,46 +215,49 @@ float voice_envelope(float frequency) {
 	       //  break;
 
         case duty_osc:
-            // This slows the loop down a substantial amount, so higher notes may freeze
             glissando = true;
-            polyphony_rate = 0;
-            switch (compensated_index) {
+            polyphony_ticks = 0;
+            switch (envelope_time) {
                 default:
-                    #define OCS_SPEED 10
+                    // one cycle every 300 steps, 65536 / 300
+                    #define OCS_SPEED 218
                     #define OCS_AMP   .25
-                    // sine wave is slow
-                    // note_timbre = (sin((float)compensated_index/10000*OCS_SPEED) * OCS_AMP / 2) + .5;
-                    // triangle wave is a bit faster
-                    note_timbre = (float)abs((compensated_index*OCS_SPEED % 3000) - 1500) * ( OCS_AMP / 1500 ) + (1 - OCS_AMP) / 2;
+                    // triangle wave between .375 and .625
+                    {
+                        uint8_t phase = (uint16_t)(envelope_time * OCS_SPEED) >> 8;
+                        uint8_t triangle = phase < 128 ? 127 - phase : phase - 128;
+                        note_timbre = TIMBRE8((1 - OCS_AMP) / 2) + (triangle >> 1);
+                    }
                 	break;
             }
 	        break;
 
         case duty_octave_down:
             glissando = true;
-            polyphony_rate = 0;
-            note_timbre = (envelope_index % 2) * .125 + .375 * 2;
-            if ((envelope_index % 4) == 0)
-                note_timbre = 0.5;
-            if ((envelope_index % 8) == 0)
+            polyphony_ticks = 0;
+            note_timbre = (envelope_index & 1) ? TIMBRE8(.875) : TIMBRE8(.75);
+            if ((envelope_index & 3) == 0)
+                note_timbre = TIMBRE8(TIMBRE_50);
+            if ((envelope_index & 7) == 0)
                 note_timbre = 0;
             break;
         case delayed_vibrato:
             glissando = true;
-            polyphony_rate = 0;
-            note_timbre = TIMBRE_50;
+            polyphony_ticks = 0;
+            note_timbre = TIMBRE8(TIMBRE_50);
             #define VOICE_VIBRATO_DELAY 150
-            #define VOICE_VIBRATO_SPEED 50
-            switch (compensated_index) {
+            // one cycle every 400 steps, 65536 / 400
+            #define VOICE_VIBRATO_SPEED 164
+            switch (envelope_time) {
                 case 0 ... VOICE_VIBRATO_DELAY:
                     break;
                 default:
-                    frequency = frequency * vibrato_lut[(int)fmod((((float)compensated_index - (VOICE_VIBRATO_DELAY + 1))/1000*VOICE_VIBRATO_SPEED), VIBRATO_LUT_LENGTH)];
+                    period = audio_vibrato(period, (envelope_time - (VOICE_VIBRATO_DELAY + 1)) * VOICE_VIBRATO_SPEED);
                     break;
             }
             break;
         // case delayed_vibrato_octave:
-        //     polyphony_rate = 0;
+        //     polyphony_ticks = 0;
         //     if ((envelope_index % 2) == 1) {
         //         note_timbre = 0.55;
         //     } else {
@@ -292,5 +304,5 @@ float voice_envelope(float frequency) {
    			break;
     }
 
-    return frequency;
+    return period;
 }
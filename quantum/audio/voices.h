@@ -15,14 +15,13 @@
  */
 #include <stdint.h>
 #include <stdbool.h>
-#include <avr/io.h>
-#include <util/delay.h>
-#include "luts.h"
 
 #ifndef VOICES_H
 #define VOICES_H
 
-float voice_envelope(float frequency);
+// Applies the selected voice to the timer period of the note playing,
+// called from the audio interrupt
+uint16_t voice_envelope(uint16_t period);
 
 typedef enum {
     default_voice,
@@ -0,0 +1,59 @@
+#include "color.h"
+
+uint8_t blend8(uint8_t from, uint8_t to, uint8_t alpha) {
+    // weights out of 256 instead of 255, so there's no division
+    uint16_t weight = alpha + (alpha >> 7);
+    return (to * weight + from * (256 - weight)) >> 8;
+}
+
+rgb_t hsv_to_rgb(uint8_t hue, uint8_t sat, uint8_t val) {
+    rgb_t rgb;
+
+    if (sat == 0) {
+        rgb.r = val;
+        rgb.g = val;
+        rgb.b = val;
+        return rgb;
+    }
+
+    // hue * 6 puts the sector in the high byte and the position within it
+    // in the low byte
+    uint16_t h = hue * 6;
+    uint8_t position = h & 0xFF;
+    uint8_t base = ((255 - sat) * val) >> 8;
+    uint8_t color = ((val - base) * position) >> 8;
+
+    switch (h >> 8) {
+        case 0:
+            rgb.r = val;
+            rgb.g = base + color;
+            rgb.b = base;
+            break;
+        case 1:
+            rgb.r = val - color;
+            rgb.g = val;
+            rgb.b = base;
+            break;
+        case 2:
+            rgb.r = base;
+            rgb.g = val;
+            rgb.b = base + color;
+            break;
+        case 3:
+            rgb.r = base;
+            rgb.g = val - color;
+            rgb.b = val;
+            break;
+        case 4:
+            rgb.r = base + color;
+            rgb.g = base;
+            rgb.b = val;
+            break;
+        default:
+            rgb.r = val;
+            rgb.g = base;
+            rgb.b = val - color;
+            break;
+    }
+    return rgb;
+}
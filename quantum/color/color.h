@@ -0,0 +1,28 @@
+#ifndef COLOR_H
+#define COLOR_H
+
+#include <stdint.h>
+
+/*
+ * Fixed point HSV to RGB conversion
+ *
+ * Hues go around the color wheel in 256 steps, so they wrap around by
+ * themselves in 8 bit arithmetic, and the six sectors of the wheel are
+ * found with a multiplication instead of divisions. The result is linear,
+ * the brightness curve of the LEDs is up to the caller.
+ */
+
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} rgb_t;
+
+// Converts a hue in degrees (0-359) to the 256 step wheel
+#define HUE_360_TO_8(hue) ((uint8_t)(((uint16_t)(hue) * 182) >> 8))
+
+rgb_t hsv_to_rgb(uint8_t hue, uint8_t sat, uint8_t val);
+// Mixes to into from, alpha 0 keeps from and 255 gives to
+uint8_t blend8(uint8_t from, uint8_t to, uint8_t alpha);
+
+#endif
@@ -0,0 +1,125 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+extern "C" {
+#include "color/color.h"
+}
+
+// The conversion rgblight used before, with hues in degrees
+static rgb_t hsv_to_rgb_degrees(uint16_t hue, uint8_t sat, uint8_t val) {
+    uint8_t r = 0, g = 0, b = 0, base, color;
+    if (sat == 0) {
+        r = val;
+        g = val;
+        b = val;
+    } else {
+        base = ((255 - sat) * val) >> 8;
+        color = (val - base) * (hue % 60) / 60;
+        switch (hue / 60) {
+            case 0: r = val; g = base + color; b = base; break;
+            case 1: r = val - color; g = val; b = base; break;
+            case 2: r = base; g = val; b = base + color; break;
+            case 3: r = base; g = val - color; b = val; break;
+            case 4: r = base + color; g = base; b = val; break;
+            case 5: r = val; g = base; b = val - color; break;
+        }
+    }
+    return rgb_t{r, g, b};
+}
+
+TEST(ColorHsv, primaries) {
+    rgb_t red = hsv_to_rgb(0, 255, 255);
+    EXPECT_EQ(red.r, 255);
+    EXPECT_EQ(red.g, 0);
+    EXPECT_EQ(red.b, 0);
+    rgb_t green = hsv_to_rgb(HUE_360_TO_8(120), 255, 255);
+    EXPECT_EQ(green.g, 255);
+    EXPECT_LE(green.r, 4);
+    EXPECT_LE(green.b, 4);
+    rgb_t blue = hsv_to_rgb(HUE_360_TO_8(240), 255, 255);
+    EXPECT_EQ(blue.b, 255);
+    EXPECT_LE(blue.r, 4);
+    EXPECT_LE(blue.g, 4);
+}
+
+TEST(ColorHsv, no_saturation_is_gray) {
+    for (int hue = 0; hue < 256; hue += 17) {
+        rgb_t rgb = hsv_to_rgb(hue, 0, 100);
+        EXPECT_EQ(rgb.r, 100);
+        EXPECT_EQ(rgb.g, 100);
+        EXPECT_EQ(rgb.b, 100);
+    }
+}
+
+TEST(ColorHsv, blend_ends) {
+    EXPECT_EQ(blend8(10, 200, 0), 10);
+    EXPECT_EQ(blend8(10, 200, 255), 200);
+    EXPECT_EQ(blend8(0, 200, 128), 100);
+}
+
+TEST(ColorHsv, degree_conversion_stays_on_the_wheel) {
+    EXPECT_EQ(HUE_360_TO_8(0), 0);
+    EXPECT_EQ(HUE_360_TO_8(180), 127);
+    EXPECT_EQ(HUE_360_TO_8(359), 255);
+}
+
+TEST(ColorHsv, matches_the_degree_based_conversion) {
+    for (uint16_t hue = 0; hue < 360; hue++) {
+        for (int sat = 0; sat < 256; sat += 51) {
+            for (int val = 0; val < 256; val += 51) {
+                rgb_t expected = hsv_to_rgb_degrees(hue, sat, val);
+                rgb_t actual = hsv_to_rgb(HUE_360_TO_8(hue), sat, val);
+                // the 256 step wheel is a bit coarser than degrees, one step
+                // is worth up to 7 counts at full saturation
+                EXPECT_LE(abs(expected.r - actual.r), 7) << hue << " " << sat << " " << val;
+                EXPECT_LE(abs(expected.g - actual.g), 7) << hue << " " << sat << " " << val;
+                EXPECT_LE(abs(expected.b - actual.b), 7) << hue << " " << sat << " " << val;
+            }
+        }
+    }
+}
+
+// Renders rainbow swirl frames the old way, with a division and a modulo
+// per LED, and the new way, with a fixed point hue step, and prints the
+// time per frame of both
+static double swirl_old(std::vector<rgb_t>& leds, unsigned frames) {
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned frame = 0; frame < frames; frame++) {
+        uint16_t current_hue = frame % 360;
+        for (unsigned i = 0; i < leds.size(); i++) {
+            volatile unsigned count = leds.size();
+            uint16_t hue = (360 / count * i + current_hue) % 360;
+            leds[i] = hsv_to_rgb_degrees(hue, 255, 255);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / frames;
+}
+
+static double swirl_new(std::vector<rgb_t>& leds, unsigned frames) {
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned frame = 0; frame < frames; frame++) {
+        uint8_t current_hue = HUE_360_TO_8(frame % 360);
+        volatile unsigned count = leds.size();
+        uint16_t step = 65536 / count;
+        uint16_t offset = 0;
+        for (unsigned i = 0; i < leds.size(); i++) {
+            leds[i] = hsv_to_rgb(current_hue + (offset >> 8), 255, 255);
+            offset += step;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / frames;
+}
+
+TEST(ColorHsv, benchmark) {
+    const unsigned frames = 2000;
+    for (unsigned count : {16, 64, 256}) {
+        std::vector<rgb_t> leds(count);
+        double old_time = swirl_old(leds, frames);
+        double new_time = swirl_new(leds, frames);
+        printf("%3u LEDs: %7.3f us/frame before, %7.3f us/frame now\n", count, old_time, new_time);
+    }
+}
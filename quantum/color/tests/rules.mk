@@ -0,0 +1,3 @@
+color_hsv_SRC :=\
+	$(QUANTUM_PATH)/color/tests/color_tests.cpp \
+	$(QUANTUM_PATH)/color/color.c
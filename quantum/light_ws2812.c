@@ -274,7 +274,16 @@ void inline ws2812_sendarray_mask(uint8_t *data,uint16_t datlen,uint8_t maskhi)
   sreg_prev=SREG;
   cli();
 
+  uint8_t chunk = WS2812_CHUNK_SIZE;
   while (datlen--) {
+    if (chunk-- == 0) {
+      // let any pending interrupt in while the line is low, it's only
+      // serviced after the instruction following the SREG write
+      SREG=sreg_prev;
+      asm volatile("nop");
+      cli();
+      chunk = WS2812_CHUNK_SIZE - 1;
+    }
     curbyte=(*data++);
 
     asm volatile(
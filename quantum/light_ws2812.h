@@ -23,8 +23,11 @@
 #ifndef LIGHT_WS2812_H_
 #define LIGHT_WS2812_H_
 
+#include <stdint.h>
+#ifdef __AVR__
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#endif
 //#include "ws2812_config.h"
 //#include "i2cmaster.h"
 
@@ -60,6 +63,17 @@ struct cRGBW { uint8_t g; uint8_t r; uint8_t b; uint8_t w;};
  *         - Wait 50�s to reset the LEDs
  */
 
+/*
+ * The driver is selected with WS2812_DRIVER in rules.mk:
+ *
+ *   bitbang (default)  this file, any pin on AVR
+ *   usart              USART1 in SPI mode on AVR, RGB_DI_PIN has to be D3
+ *   chibios            SPI with DMA on ChibiOS
+ *
+ * All of them implement ws2812_setleds and ws2812_setleds_rgbw, the other
+ * functions are only available with bitbang.
+ */
+
 void ws2812_setleds     (LED_TYPE *ledarray, uint16_t number_of_leds);
 void ws2812_setleds_pin (LED_TYPE *ledarray, uint16_t number_of_leds,uint8_t pinmask);
 void ws2812_setleds_rgbw(LED_TYPE *ledarray, uint16_t number_of_leds);
@@ -69,8 +83,17 @@ void ws2812_setleds_rgbw(LED_TYPE *ledarray, uint16_t number_of_leds);
  *
  * The functions take a byte-array and send to the data output as WS2812 bitstream.
  * The length is the number of bytes to send - three per LED.
+ *
+ * Interrupts are only disabled for WS2812_CHUNK_SIZE bytes at a time. The
+ * LEDs only latch after the line has been low for at least 50us (280us on
+ * newer parts), so the short gaps left for interrupt handlers in between
+ * don't disturb the transfer.
  */
 
+#ifndef WS2812_CHUNK_SIZE
+#define WS2812_CHUNK_SIZE 3
+#endif
+
 void ws2812_sendarray     (uint8_t *array,uint16_t length);
 void ws2812_sendarray_mask(uint8_t *array,uint16_t length, uint8_t pinmask);
 
@@ -0,0 +1,103 @@
+/* Copyright 2016 Jack Humbert
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "chord_dictionary.h"
+
+static bool dictionary_sorted = false;
+static bool dictionary_ready = false;
+
+static uint32_t entry_keys(uint16_t entry) {
+  return pgm_read_dword(&chord_dictionary[entry].keys);
+}
+
+void chord_dictionary_init(void) {
+  dictionary_sorted = true;
+  for (uint16_t i = 1; i < CHORDING_DICTIONARY_SIZE; i++) {
+    if (entry_keys(i - 1) > entry_keys(i)) {
+      dictionary_sorted = false;
+      break;
+    }
+  }
+  dictionary_ready = true;
+}
+
+bool chord_dictionary_sorted(void) {
+  return dictionary_sorted;
+}
+
+uint16_t chord_lookup(uint32_t keys) {
+  if (!dictionary_ready) {
+    chord_dictionary_init();
+  }
+  if (dictionary_sorted) {
+    // the first entry that isn't below keys
+    uint16_t first = 0, last = CHORDING_DICTIONARY_SIZE;
+    while (first < last) {
+      uint16_t middle = first + (last - first) / 2;
+      if (entry_keys(middle) < keys) {
+        first = middle + 1;
+      } else {
+        last = middle;
+      }
+    }
+    if (first < CHORDING_DICTIONARY_SIZE && entry_keys(first) == keys) {
+      return first;
+    }
+    return CHORD_NOT_FOUND;
+  }
+  for (uint16_t i = 0; i < CHORDING_DICTIONARY_SIZE; i++) {
+    if (entry_keys(i) == keys) {
+      return i;
+    }
+  }
+  return CHORD_NOT_FOUND;
+}
+
+uint16_t chord_action(uint16_t index) {
+  return pgm_read_word(&chord_dictionary[index].action);
+}
+
+uint32_t chord_press(chord_state_t *state, uint8_t key, uint16_t now) {
+  if (state->chord == 0) {
+    // keys still held from the last chord are part of the next one
+    state->chord = state->pressed;
+    state->timer = now;
+  }
+  state->pressed |= CHORD_BIT(key);
+  state->chord |= CHORD_BIT(key);
+  return 0;
+}
+
+uint32_t chord_release(chord_state_t *state, uint8_t key) {
+  uint32_t chord = 0;
+
+  if (state->chord & CHORD_BIT(key)) {
+    chord = state->chord;
+    state->chord = 0;
+  }
+  state->pressed &= ~CHORD_BIT(key);
+  return chord;
+}
+
+uint32_t chord_timeout(chord_state_t *state, uint16_t now) {
+  uint32_t chord = 0;
+
+  if (CHORDING_WINDOW > 0 && state->chord && (uint16_t)(now - state->timer) >= CHORDING_WINDOW) {
+    chord = state->chord;
+    state->chord = 0;
+  }
+  return chord;
+}
@@ -0,0 +1,81 @@
+/* Copyright 2016 Jack Humbert
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CHORD_DICTIONARY_H
+#define CHORD_DICTIONARY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "progmem.h"
+
+/*
+ * Chords as a bitset of chord keys, looked up in a sorted table
+ *
+ * Chord keys are CH(0) to CH(31) in the keymap, and a chord is the set of
+ * them pressed together, one bit per key:
+ *
+ *   const chord_t PROGMEM chord_dictionary[] = {
+ *     CHORD(CHORD_BIT(0) | CHORD_BIT(1), KC_A),
+ *   };
+ *
+ * with CHORDING_DICTIONARY_SIZE set to the number of entries in config.h.
+ * Sorted by keys, a chord is found with a binary search on the whole set
+ * at once; a table that isn't sorted is compared entry by entry.
+ *
+ * The chord is the keys pressed since the last one was sent, and any
+ * still held from it when a new key goes down. It's sent when the first
+ * of its keys is released, or once CHORDING_WINDOW ms have passed since
+ * the first was pressed, if that's set.
+ */
+
+#define CHORD_BIT(n) ((uint32_t)1 << (n))
+#define CHORD(k, act) {.keys = (k), .action = (act)}
+
+typedef struct {
+    uint32_t keys;
+    uint16_t action;
+} chord_t;
+
+#ifndef CHORDING_DICTIONARY_SIZE
+#define CHORDING_DICTIONARY_SIZE 0
+#endif
+
+// 0 sends chords on the first release only
+#ifndef CHORDING_WINDOW
+#define CHORDING_WINDOW 0
+#endif
+
+#define CHORD_NOT_FOUND 0xFFFF
+
+extern const chord_t chord_dictionary[] PROGMEM;
+
+typedef struct {
+    uint32_t pressed;  // chord keys down
+    uint32_t chord;    // keys of the chord being typed, 0 between chords
+    uint16_t timer;    // when its first key went down
+} chord_state_t;
+
+void chord_dictionary_init(void);
+bool chord_dictionary_sorted(void);
+// The index of the entry for keys, CHORD_NOT_FOUND if there isn't one
+uint16_t chord_lookup(uint32_t keys);
+uint16_t chord_action(uint16_t index);
+
+// Each returns the chord to send, or 0
+uint32_t chord_press(chord_state_t *state, uint8_t key, uint16_t now);
+uint32_t chord_release(chord_state_t *state, uint8_t key);
+uint32_t chord_timeout(chord_state_t *state, uint16_t now);
+
+#endif
@@ -0,0 +1,125 @@
+/* Copyright 2016 Jack Humbert
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "leader_dictionary.h"
+
+#if LEADER_DICTIONARY_SIZE > 0
+
+// The dictionary, in the order of its sequences
+static leader_index_t sorted[LEADER_DICTIONARY_SIZE];
+static bool sorted_ready = false;
+
+static const uint16_t *entry_keys(leader_index_t entry) {
+  const uint16_t *keys;
+  memcpy_P(&keys, &leader_dictionary[entry].keys, sizeof(keys));
+  return keys;
+}
+
+static uint16_t key_at(leader_index_t entry, uint8_t position) {
+  return pgm_read_word(&entry_keys(entry)[position]);
+}
+
+static int8_t compare(leader_index_t a, leader_index_t b) {
+  const uint16_t *keys_a = entry_keys(a);
+  const uint16_t *keys_b = entry_keys(b);
+  for (uint8_t i = 0; ; i++) {
+    uint16_t key_a = pgm_read_word(&keys_a[i]);
+    uint16_t key_b = pgm_read_word(&keys_b[i]);
+    if (key_a != key_b) {
+      return key_a < key_b ? -1 : 1;
+    }
+    if (key_a == LEADER_END) {
+      return 0;
+    }
+  }
+}
+
+void leader_dictionary_init(void) {
+  // insertion sort, which keeps the first of two equal sequences first
+  for (leader_index_t i = 0; i < LEADER_DICTIONARY_SIZE; i++) {
+    leader_index_t j = i;
+    while (j > 0 && compare(sorted[j - 1], i) > 0) {
+      sorted[j] = sorted[j - 1];
+      j--;
+    }
+    sorted[j] = i;
+  }
+  sorted_ready = true;
+}
+
+void leader_match_start(leader_match_t *match) {
+  if (!sorted_ready) {
+    leader_dictionary_init();
+  }
+  match->first = 0;
+  match->last = LEADER_DICTIONARY_SIZE;
+  match->length = 0;
+}
+
+// The first entry in [first, last) whose key at position is past keycode,
+// or isn't below it if inclusive is false
+static leader_index_t search(leader_index_t first, leader_index_t last, uint8_t position, uint16_t keycode, bool inclusive) {
+  while (first < last) {
+    leader_index_t middle = first + (last - first) / 2;
+    uint16_t key = key_at(sorted[middle], position);
+    if (key < keycode || (inclusive && key == keycode)) {
+      first = middle + 1;
+    } else {
+      last = middle;
+    }
+  }
+  return first;
+}
+
+uint8_t leader_match_key(leader_match_t *match, uint16_t keycode) {
+  if (keycode == LEADER_END || match->length == 0xFF) {
+    match->last = match->first;
+  }
+  if (match->first >= match->last) {
+    return LEADER_NO_MATCH;
+  }
+
+  // everything in the range shares the keys so far, so it's sorted by the
+  // key that comes next
+  uint8_t position = match->length++;
+  match->first = search(match->first, match->last, position, keycode, false);
+  match->last = search(match->first, match->last, position, keycode, true);
+  if (match->first >= match->last) {
+    return LEADER_NO_MATCH;
+  }
+
+  // a sequence that ends here sorts first, LEADER_END being 0
+  if (key_at(sorted[match->first], match->length) != LEADER_END) {
+    return LEADER_PARTIAL;
+  }
+  return match->last - match->first == 1 ? LEADER_MATCH : LEADER_PENDING;
+}
+
+uint16_t leader_match_action(const leader_match_t *match) {
+  return pgm_read_word(&leader_dictionary[sorted[match->first]].action);
+}
+
+uint16_t leader_match_timeout(const leader_match_t *match, uint16_t timeout) {
+  if (match->first < match->last && key_at(sorted[match->first], match->length) == LEADER_END) {
+    uint16_t own = pgm_read_word(&leader_dictionary[sorted[match->first]].timeout);
+    if (own) {
+      return own;
+    }
+  }
+  return timeout;
+}
+
+#endif
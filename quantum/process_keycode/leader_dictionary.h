@@ -0,0 +1,90 @@
+/* Copyright 2016 Jack Humbert
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LEADER_DICTIONARY_H
+#define LEADER_DICTIONARY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "progmem.h"
+
+/*
+ * Leader sequences as a table instead of a chain of SEQ_*_KEYS ifs
+ *
+ *   const uint16_t PROGMEM leader_git_status[] = {KC_G, KC_S, LEADER_END};
+ *
+ *   const leader_sequence_t PROGMEM leader_dictionary[] = {
+ *     LEADER_SEQ(leader_git_status, GIT_STATUS),
+ *   };
+ *
+ * with LEADER_DICTIONARY_SIZE set to the number of entries in config.h.
+ * Sequences can be any length. The table doesn't need to be in any order;
+ * an index sorted by sequence is built in RAM (a byte per entry) the first
+ * time the leader key is used.
+ *
+ * Every key narrows the range of sorted entries that start with what was
+ * typed so far, with a binary search, so the work per key grows with the
+ * log of the dictionary size rather than with the dictionary. A sequence
+ * fires as soon as no longer sequence starts with it. If one does, it
+ * fires when its timeout runs out without another key.
+ */
+
+#define LEADER_END 0
+
+typedef struct {
+    const uint16_t *keys;
+    uint16_t action;
+    uint16_t timeout;  // to wait for a longer sequence, 0 for LEADER_TIMEOUT
+} leader_sequence_t;
+
+#define LEADER_SEQ(seq, act)                  {.keys = &(seq)[0], .action = (act)}
+#define LEADER_SEQ_TIMEOUT(seq, act, time)    {.keys = &(seq)[0], .action = (act), .timeout = (time)}
+
+#ifndef LEADER_DICTIONARY_SIZE
+#define LEADER_DICTIONARY_SIZE 0
+#endif
+
+#if LEADER_DICTIONARY_SIZE > 255
+typedef uint16_t leader_index_t;
+#else
+typedef uint8_t leader_index_t;
+#endif
+
+extern const leader_sequence_t leader_dictionary[] PROGMEM;
+
+enum leader_match_result {
+    LEADER_NO_MATCH,  // nothing starts with the keys typed
+    LEADER_PARTIAL,   // keep going, nothing matches yet
+    LEADER_PENDING,   // matches, but a longer sequence might follow
+    LEADER_MATCH,     // matches and nothing longer does
+};
+
+typedef struct {
+    leader_index_t first;
+    leader_index_t last;   // one past
+    uint8_t        length;
+} leader_match_t;
+
+void leader_dictionary_init(void);
+void leader_match_start(leader_match_t *match);
+uint8_t leader_match_key(leader_match_t *match, uint16_t keycode);
+// The action of the sequence typed, after LEADER_PENDING or LEADER_MATCH
+uint16_t leader_match_action(const leader_match_t *match);
+// How long to wait for the next key, the sequence's own timeout if it has
+// one and a longer sequence might follow
+uint16_t leader_match_timeout(const leader_match_t *match, uint16_t timeout);
+
+#endif
@@ -16,61 +16,44 @@
 
 #include "process_chording.h"
 
-bool keys_chord(uint8_t keys[]) {
-  uint8_t keys_size = sizeof(keys)/sizeof(keys[0]);
-  bool pass = true;
-  uint8_t in = 0;
-  for (uint8_t i = 0; i < chord_key_count; i++) {
-    bool found = false;
-    for (uint8_t j = 0; j < keys_size; j++) {
-      if (chord_keys[i] == (keys[j] & 0xFF)) {
-        in++; // detects key in chord
-        found = true;
-        break;
-      }
-    }
-    if (found)
-      continue;
-    if (chord_keys[i] != 0)  {
-      pass = false; // makes sure rest are blank
-    }
+static chord_state_t chord_state;
+
+__attribute__((weak))
+void chording_event(uint16_t action) {
+  register_code16(action);
+  unregister_code16(action);
+}
+
+__attribute__((weak))
+void chording_unmatched(uint32_t keys) {}
+
+static void send_chord(uint32_t keys) {
+  if (!keys)
+    return;
+
+  uint16_t index = chord_lookup(keys);
+  if (index != CHORD_NOT_FOUND) {
+    chording_event(chord_action(index));
+  } else {
+    chording_unmatched(keys);
   }
-  return (pass && (in == keys_size));
 }
 
 bool process_chording(uint16_t keycode, keyrecord_t *record) {
-  if (keycode >= QK_CHORDING && keycode <= QK_CHORDING_MAX) {
-    if (record->event.pressed) {
-      if (!chording) {
-        chording = true;
-        for (uint8_t i = 0; i < CHORDING_MAX; i++)
-          chord_keys[i] = 0;
-        chord_key_count = 0;
-        chord_key_down = 0;
-      }
-      chord_keys[chord_key_count] = (keycode & 0xFF);
-      chord_key_count++;
-      chord_key_down++;
-      return false;
-    } else {
-      if (chording) {
-        chord_key_down--;
-        if (chord_key_down == 0) {
-          chording = false;
-          // Chord Dictionary
-          if (keys_chord((uint8_t[]){KC_ENTER, KC_SPACE})) {
-            register_code(KC_A);
-            unregister_code(KC_A);
-            return false;
-          }
-          for (uint8_t i = 0; i < chord_key_count; i++) {
-            register_code(chord_keys[i]);
-            unregister_code(chord_keys[i]);
-            return false;
-          }
-        }
-      }
-    }
+  if (keycode < QK_CHORDING || keycode >= CH(32))
+    return true;
+
+  uint8_t key = keycode - QK_CHORDING;
+  if (record->event.pressed) {
+    send_chord(chord_press(&chord_state, key, timer_read()));
+  } else {
+    send_chord(chord_release(&chord_state, key));
+  }
+  return false;
+}
+
+void matrix_scan_chording(void) {
+  if (CHORDING_WINDOW > 0 && chord_state.chord) {
+    send_chord(chord_timeout(&chord_state, timer_read()));
   }
-  return true;
 }
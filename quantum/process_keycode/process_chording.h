@@ -13,20 +13,22 @@
  * You should have received a copy of the GNU General Public License
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
-
 #ifndef PROCESS_CHORDING_H
 #define PROCESS_CHORDING_H
 
 #include "quantum.h"
+#include "chord_dictionary.h"
 
-// Chording stuff
-#define CHORDING_MAX 4
-bool chording = false;
-
-uint8_t chord_keys[CHORDING_MAX] = {0};
-uint8_t chord_key_count = 0;
-uint8_t chord_key_down = 0;
+// Chord key n, up to 31
+#define CH(n) (QK_CHORDING + (n))
 
 bool process_chording(uint16_t keycode, keyrecord_t *record);
+void matrix_scan_chording(void);
+
+// Called with the action of the chord typed, taps it as a keycode unless
+// the keymap has its own
+void chording_event(uint16_t action);
+// Called with chords that aren't in the dictionary
+void chording_unmatched(uint32_t keys);
 
 #endif
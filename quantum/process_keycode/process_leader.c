@@ -29,6 +29,32 @@ uint16_t leader_time = 0;
 uint16_t leader_sequence[5] = {0, 0, 0, 0, 0};
 uint8_t leader_sequence_size = 0;
 
+#if LEADER_DICTIONARY_SIZE > 0
+
+__attribute__ ((weak))
+void leader_dictionary_event(uint16_t action) {}
+
+static leader_match_t leader_match;
+static uint16_t leader_timeout = LEADER_TIMEOUT;
+// the keys so far are a whole sequence, but a longer one might follow
+static bool leader_pending = false;
+
+static void leader_finish(bool matched) {
+  leading = false;
+  if (matched) {
+    leader_dictionary_event(leader_match_action(&leader_match));
+  }
+  leader_end();
+}
+
+void matrix_scan_leader(void) {
+  if (leading && timer_elapsed(leader_time) > leader_timeout) {
+    leader_finish(leader_pending);
+  }
+}
+
+#endif
+
 bool process_leader(uint16_t keycode, keyrecord_t *record) {
   // Leader key set-up
   if (record->event.pressed) {
@@ -42,13 +68,36 @@ bool process_leader(uint16_t keycode, keyrecord_t *record) {
       leader_sequence[2] = 0;
       leader_sequence[3] = 0;
       leader_sequence[4] = 0;
+#if LEADER_DICTIONARY_SIZE > 0
+      leader_match_start(&leader_match);
+      leader_timeout = LEADER_TIMEOUT;
+      leader_pending = false;
+#endif
+      return false;
+    }
+#if LEADER_DICTIONARY_SIZE > 0
+    if (leading && timer_elapsed(leader_time) <= leader_timeout) {
+      if (leader_sequence_size < 5) {
+        leader_sequence[leader_sequence_size] = keycode;
+      }
+      leader_sequence_size++;
+      leader_time = timer_read();
+      uint8_t result = leader_match_key(&leader_match, keycode);
+      if (result == LEADER_NO_MATCH || result == LEADER_MATCH) {
+        leader_finish(result == LEADER_MATCH);
+      } else {
+        leader_pending = result == LEADER_PENDING;
+        leader_timeout = leader_match_timeout(&leader_match, LEADER_TIMEOUT);
+      }
       return false;
     }
+#else
     if (leading && timer_elapsed(leader_time) < LEADER_TIMEOUT) {
       leader_sequence[leader_sequence_size] = keycode;
       leader_sequence_size++;
       return false;
     }
+#endif
   }
   return true;
 }
@@ -18,6 +18,7 @@
 #define PROCESS_LEADER_H
 
 #include "quantum.h"
+#include "leader_dictionary.h"
 
 bool process_leader(uint16_t keycode, keyrecord_t *record);
 
@@ -33,6 +34,12 @@ void leader_end(void);
 #define SEQ_FOUR_KEYS(key1, key2, key3, key4) if (leader_sequence[0] == (key1) && leader_sequence[1] == (key2) && leader_sequence[2] == (key3) && leader_sequence[3] == (key4) && leader_sequence[4] == 0)
 #define SEQ_FIVE_KEYS(key1, key2, key3, key4, key5) if (leader_sequence[0] == (key1) && leader_sequence[1] == (key2) && leader_sequence[2] == (key3) && leader_sequence[3] == (key4) && leader_sequence[4] == (key5))
 
+#if LEADER_DICTIONARY_SIZE > 0
+// Called with the action of a sequence from leader_dictionary
+void leader_dictionary_event(uint16_t action);
+void matrix_scan_leader(void);
+#endif
+
 #define LEADER_EXTERNS() extern bool leading; extern uint16_t leader_time; extern uint16_t leader_sequence[5]; extern uint8_t leader_sequence_size
 #define LEADER_DICTIONARY() if (leading && timer_elapsed(leader_time) > LEADER_TIMEOUT)
 
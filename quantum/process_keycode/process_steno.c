@@ -0,0 +1,78 @@
+/* Copyright 2016 Jack Humbert
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "process_steno.h"
+#include "virtser.h"
+
+static steno_stroke_t stroke;
+static steno_stroke_t held;
+static uint8_t mode = 0xFF;
+
+void steno_set_mode(uint8_t new_mode) {
+  mode = new_mode;
+  eeconfig_update_cached(EECONFIG_STENOMODE, &mode, 1);
+}
+
+uint8_t steno_get_mode(void) {
+  if (mode == 0xFF) {
+    eeconfig_read_cached(EECONFIG_STENOMODE, &mode, 1);
+    if (mode != STENO_MODE_GEMINI) {
+      mode = STENO_MODE_BOLT;
+    }
+  }
+  return mode;
+}
+
+__attribute__((weak))
+bool send_steno_stroke_user(const steno_stroke_t *stroke) {
+  return true;
+}
+
+static void send_stroke(void) {
+  if (send_steno_stroke_user(&stroke)) {
+    uint8_t packet[STENO_PACKET_MAX];
+    uint8_t length = steno_encode(&stroke, steno_get_mode(), packet);
+    virtser_send_packet(packet, length);
+  }
+  steno_stroke_clear(&stroke);
+}
+
+bool process_steno(uint16_t keycode, keyrecord_t *record) {
+  if (keycode < QK_STENO || keycode > QK_STENO_MAX)
+    return true;
+
+  if (keycode == STN_BOLT || keycode == STN_GEMINI) {
+    if (record->event.pressed) {
+      steno_set_mode(keycode == STN_BOLT ? STENO_MODE_BOLT : STENO_MODE_GEMINI);
+    }
+    return false;
+  }
+
+  uint8_t key = keycode - QK_STENO;
+  if (key >= STENO_KEY_COUNT)
+    return false;
+
+  if (record->event.pressed) {
+    steno_stroke_add(&stroke, key);
+    steno_stroke_add(&held, key);
+  } else {
+    steno_stroke_remove(&held, key);
+    if (steno_stroke_empty(&held) && !steno_stroke_empty(&stroke)) {
+      send_stroke();
+    }
+  }
+  return false;
+}
@@ -0,0 +1,85 @@
+/* Copyright 2016 Jack Humbert
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef PROCESS_STENO_H
+#define PROCESS_STENO_H
+
+#include "quantum.h"
+#include "steno_packet.h"
+
+/*
+ * Steno keys, sent to the host as steno machine packets over the virtual
+ * serial port, one packet per stroke. A stroke is every steno key pressed
+ * until all of them are released again. STN_BOLT and STN_GEMINI pick the
+ * protocol, which is kept in the EEPROM.
+ */
+
+#define STN(key) (QK_STENO + (key))
+
+#define STN_FN  STN(STENO_FN)
+#define STN_N1  STN(STENO_N1)
+#define STN_N2  STN(STENO_N2)
+#define STN_N3  STN(STENO_N3)
+#define STN_N4  STN(STENO_N4)
+#define STN_N5  STN(STENO_N5)
+#define STN_N6  STN(STENO_N6)
+#define STN_N7  STN(STENO_N7)
+#define STN_N8  STN(STENO_N8)
+#define STN_N9  STN(STENO_N9)
+#define STN_NA  STN(STENO_NA)
+#define STN_NB  STN(STENO_NB)
+#define STN_NC  STN(STENO_NC)
+#define STN_S1  STN(STENO_S1)
+#define STN_S2  STN(STENO_S2)
+#define STN_TL  STN(STENO_TL)
+#define STN_KL  STN(STENO_KL)
+#define STN_PL  STN(STENO_PL)
+#define STN_WL  STN(STENO_WL)
+#define STN_HL  STN(STENO_HL)
+#define STN_RL  STN(STENO_RL)
+#define STN_A   STN(STENO_A)
+#define STN_O   STN(STENO_O)
+#define STN_ST1 STN(STENO_ST1)
+#define STN_ST2 STN(STENO_ST2)
+#define STN_ST3 STN(STENO_ST3)
+#define STN_ST4 STN(STENO_ST4)
+#define STN_RE1 STN(STENO_RE1)
+#define STN_RE2 STN(STENO_RE2)
+#define STN_PWR STN(STENO_PWR)
+#define STN_E   STN(STENO_E)
+#define STN_U   STN(STENO_U)
+#define STN_FR  STN(STENO_FR)
+#define STN_RR  STN(STENO_RR)
+#define STN_PR  STN(STENO_PR)
+#define STN_BR  STN(STENO_BR)
+#define STN_LR  STN(STENO_LR)
+#define STN_GR  STN(STENO_GR)
+#define STN_TR  STN(STENO_TR)
+#define STN_SR  STN(STENO_SR)
+#define STN_DR  STN(STENO_DR)
+#define STN_ZR  STN(STENO_ZR)
+
+#define STN_BOLT   (QK_STENO_MAX - 1)
+#define STN_GEMINI QK_STENO_MAX
+
+bool process_steno(uint16_t keycode, keyrecord_t *record);
+
+void steno_set_mode(uint8_t mode);
+uint8_t steno_get_mode(void);
+
+// Called with each stroke before it's sent, return false to not send it
+bool send_steno_stroke_user(const steno_stroke_t *stroke);
+
+#endif
@@ -18,8 +18,15 @@
 
 uint8_t get_oneshot_mods(void);
 
-static uint16_t last_td;
-static int8_t highest_td = -1;
+// Dances with taps counted, in the order they started. Only these are
+// looked at, however many dances the keymap has.
+static uint8_t active[TAP_DANCE_MAX_ACTIVE];
+static uint8_t active_count;
+
+// The scan has nothing to do until timeout_in has passed since timeout_at
+static uint16_t timeout_at;
+static uint16_t timeout_in;
+static bool timeout_set;
 
 void qk_tap_dance_pair_finished (qk_tap_dance_state_t *state, void *user_data) {
   qk_tap_dance_pair_t *pair = (qk_tap_dance_pair_t *)user_data;
@@ -41,6 +48,31 @@ void qk_tap_dance_pair_reset (qk_tap_dance_state_t *state, void *user_data) {
   }
 }
 
+void qk_tap_dance_tap_hold_finished (qk_tap_dance_state_t *state, void *user_data) {
+  qk_tap_dance_tap_hold_t *tap_hold = (qk_tap_dance_tap_hold_t *)user_data;
+
+  // still down when the tapping term ran out, or another key was pressed
+  if (state->pressed && state->count == 1) {
+    tap_hold->held = tap_hold->hold;
+  } else {
+    for (uint8_t i = 1; i < state->count; i++) {
+      register_code16 (tap_hold->tap);
+      unregister_code16 (tap_hold->tap);
+    }
+    tap_hold->held = tap_hold->tap;
+  }
+  register_code16 (tap_hold->held);
+}
+
+void qk_tap_dance_tap_hold_reset (qk_tap_dance_state_t *state, void *user_data) {
+  qk_tap_dance_tap_hold_t *tap_hold = (qk_tap_dance_tap_hold_t *)user_data;
+
+  if (tap_hold->held) {
+    unregister_code16 (tap_hold->held);
+    tap_hold->held = 0;
+  }
+}
+
 static inline void _process_tap_dance_action_fn (qk_tap_dance_state_t *state,
                                                  void *user_data,
                                                  qk_tap_dance_user_fn_t fn)
@@ -72,81 +104,133 @@ static inline void process_tap_dance_action_on_reset (qk_tap_dance_action_t *act
   send_keyboard_report();
 }
 
+static inline uint16_t tapping_term (qk_tap_dance_action_t *action)
+{
+  return action->custom_tapping_term > 0 ? action->custom_tapping_term : TAPPING_TERM;
+}
+
+// Works out when the first dance still counting taps runs out of time
+static void schedule_timeout (void) {
+  uint16_t now = timer_read();
+
+  timeout_set = false;
+  for (uint8_t i = 0; i < active_count; i++) {
+    qk_tap_dance_action_t *action = &tap_dance_actions[active[i]];
+    if (action->state.finished)
+      continue;
+    uint16_t elapsed = TIMER_DIFF_16(now, action->state.timer);
+    uint16_t term = tapping_term(action);
+    uint16_t left = elapsed < term ? term - elapsed : 0;
+    if (!timeout_set || left < timeout_in) {
+      timeout_in = left;
+      timeout_set = true;
+    }
+  }
+  timeout_at = now;
+}
+
+static void deactivate (uint8_t idx) {
+  for (uint8_t i = 0; i < active_count; i++) {
+    if (active[i] == idx) {
+      active_count--;
+      for (; i < active_count; i++) {
+        active[i] = active[i + 1];
+      }
+      return;
+    }
+  }
+}
+
+// Finishes the dance and resets it, unless its key is still down
+static void finish_tap_dance (qk_tap_dance_action_t *action) {
+  process_tap_dance_action_on_dance_finished (action);
+  // the finished function may have reset it already
+  if (action->state.count)
+    reset_tap_dance (&action->state);
+}
+
+// Interrupts every active dance but idx, oldest first
+static void interrupt_tap_dances (int16_t idx) {
+  uint8_t i = 0;
+
+  while (i < active_count) {
+    uint8_t current = active[i];
+    qk_tap_dance_action_t *action = &tap_dance_actions[current];
+    if (current != idx && !action->state.finished) {
+      action->state.interrupted = true;
+      finish_tap_dance (action);
+    }
+    // finishing takes it off the list, unless it's held
+    if (i < active_count && active[i] == current)
+      i++;
+  }
+}
+
+static void activate (uint8_t idx) {
+  for (uint8_t i = 0; i < active_count; i++) {
+    if (active[i] == idx)
+      return;
+  }
+  if (active_count == TAP_DANCE_MAX_ACTIVE) {
+    // the oldest has to make room, held or not
+    qk_tap_dance_action_t *oldest = &tap_dance_actions[active[0]];
+    oldest->state.pressed = false;
+    finish_tap_dance (oldest);
+  }
+  active[active_count++] = idx;
+}
+
 bool process_tap_dance(uint16_t keycode, keyrecord_t *record) {
   uint16_t idx = keycode - QK_TAP_DANCE;
   qk_tap_dance_action_t *action;
 
-  if (last_td && last_td != keycode) {
-    (&tap_dance_actions[last_td - QK_TAP_DANCE])->state.interrupted = true;
-  }
-
   switch(keycode) {
   case QK_TAP_DANCE ... QK_TAP_DANCE_MAX:
-    if ((int16_t)idx > highest_td)
-      highest_td = idx;
     action = &tap_dance_actions[idx];
 
     action->state.pressed = record->event.pressed;
     if (record->event.pressed) {
+      interrupt_tap_dances (idx);
+      activate (idx);
       action->state.keycode = keycode;
       action->state.count++;
       action->state.timer = timer_read();
       action->state.oneshot_mods = get_oneshot_mods();
       process_tap_dance_action_on_each_tap (action);
-
-      if (last_td && last_td != keycode) {
-        qk_tap_dance_action_t *paction = &tap_dance_actions[last_td - QK_TAP_DANCE];
-        paction->state.interrupted = true;
-        process_tap_dance_action_on_dance_finished (paction);
-        reset_tap_dance (&paction->state);
-      }
-
-      last_td = keycode;
+    } else if (action->state.finished && action->state.count) {
+      // held past the end of the dance
+      reset_tap_dance (&action->state);
     }
-
+    schedule_timeout ();
     break;
 
   default:
-    if (!record->event.pressed)
-      return true;
-
-    if (highest_td == -1)
+    if (!record->event.pressed || active_count == 0)
       return true;
 
-    for (int i = 0; i <= highest_td; i++) {
-      action = &tap_dance_actions[i];
-      if (action->state.count == 0)
-        continue;
-      action->state.interrupted = true;
-      process_tap_dance_action_on_dance_finished (action);
-      reset_tap_dance (&action->state);
-    }
+    interrupt_tap_dances (-1);
+    schedule_timeout ();
     break;
   }
 
   return true;
 }
 
-
-
 void matrix_scan_tap_dance () {
-  if (highest_td == -1)
+  if (!timeout_set || timer_elapsed (timeout_at) <= timeout_in)
     return;
-  uint16_t tap_user_defined;
 
-for (uint8_t i = 0; i <= highest_td; i++) {
-    qk_tap_dance_action_t *action = &tap_dance_actions[i];
-    if(action->custom_tapping_term > 0 ) {
-      tap_user_defined = action->custom_tapping_term;
-    }
-    else{
-      tap_user_defined = TAPPING_TERM;
-    }
-    if (action->state.count && timer_elapsed (action->state.timer) > tap_user_defined) {
-      process_tap_dance_action_on_dance_finished (action);
-      reset_tap_dance (&action->state);
+  uint8_t i = 0;
+  while (i < active_count) {
+    uint8_t current = active[i];
+    qk_tap_dance_action_t *action = &tap_dance_actions[current];
+    if (!action->state.finished && timer_elapsed (action->state.timer) > tapping_term(action)) {
+      finish_tap_dance (action);
     }
+    if (i < active_count && active[i] == current)
+      i++;
   }
+  schedule_timeout ();
 }
 
 void reset_tap_dance (qk_tap_dance_state_t *state) {
@@ -162,5 +246,5 @@ void reset_tap_dance (qk_tap_dance_state_t *state) {
   state->count = 0;
   state->interrupted = false;
   state->finished = false;
-  last_td = 0;
+  deactivate (state->keycode - QK_TAP_DANCE);
 }
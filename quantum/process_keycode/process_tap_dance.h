@@ -21,6 +21,11 @@
 #include <stdbool.h>
 #include <inttypes.h>
 
+// Dances that can be counting taps or held at once
+#ifndef TAP_DANCE_MAX_ACTIVE
+#define TAP_DANCE_MAX_ACTIVE 8
+#endif
+
 typedef struct
 {
   uint8_t count;
@@ -54,11 +59,31 @@ typedef struct
   uint16_t kc2;
 } qk_tap_dance_pair_t;
 
+typedef struct
+{
+  uint16_t tap;
+  uint16_t hold;
+  uint16_t held;
+} qk_tap_dance_tap_hold_t;
+
 #define ACTION_TAP_DANCE_DOUBLE(kc1, kc2) { \
     .fn = { NULL, qk_tap_dance_pair_finished, qk_tap_dance_pair_reset }, \
     .user_data = (void *)&((qk_tap_dance_pair_t) { kc1, kc2 }),  \
   }
 
+// tap when tapped, as many times as it was, hold when held past the
+// tapping term or until another key is pressed
+#define ACTION_TAP_DANCE_TAP_HOLD(kc_tap, kc_hold) { \
+    .fn = { NULL, qk_tap_dance_tap_hold_finished, qk_tap_dance_tap_hold_reset }, \
+    .user_data = (void *)&((qk_tap_dance_tap_hold_t) { kc_tap, kc_hold, 0 }), \
+  }
+
+#define ACTION_TAP_DANCE_TAP_HOLD_TIME(kc_tap, kc_hold, tap_specific_tapping_term) { \
+    .fn = { NULL, qk_tap_dance_tap_hold_finished, qk_tap_dance_tap_hold_reset }, \
+    .user_data = (void *)&((qk_tap_dance_tap_hold_t) { kc_tap, kc_hold, 0 }), \
+    .custom_tapping_term = tap_specific_tapping_term, \
+  }
+
 #define ACTION_TAP_DANCE_FN(user_fn) {  \
     .fn = { NULL, user_fn, NULL }, \
     .user_data = NULL, \
@@ -85,6 +110,8 @@ void reset_tap_dance (qk_tap_dance_state_t *state);
 
 void qk_tap_dance_pair_finished (qk_tap_dance_state_t *state, void *user_data);
 void qk_tap_dance_pair_reset (qk_tap_dance_state_t *state, void *user_data);
+void qk_tap_dance_tap_hold_finished (qk_tap_dance_state_t *state, void *user_data);
+void qk_tap_dance_tap_hold_reset (qk_tap_dance_state_t *state, void *user_data);
 
 #else
 
@@ -21,42 +21,32 @@ qk_ucis_state_t qk_ucis_state;
 void qk_ucis_start(void) {
   qk_ucis_state.count = 0;
   qk_ucis_state.in_progress = true;
+  ucis_match_start(&qk_ucis_state.match, ucis_symbol_table);
 
   qk_ucis_start_user();
 }
 
 __attribute__((weak))
 void qk_ucis_start_user(void) {
-  unicode_input_start();
-  register_hex(0x2328);
-  unicode_input_finish();
+  unicode_emit(0x2328);
 }
 
-static bool is_uni_seq(char *seq) {
-  uint8_t i;
-
-  for (i = 0; seq[i]; i++) {
-    uint16_t code;
-    if (('1' <= seq[i]) && (seq[i] <= '0'))
-      code = seq[i] - '1' + KC_1;
-    else
-      code = seq[i] - 'a' + KC_A;
-
-    if (i > qk_ucis_state.count || qk_ucis_state.codes[i] != code)
-      return false;
+static char ucis_char(uint16_t keycode) {
+  switch (keycode) {
+  case KC_A ... KC_Z:
+    return keycode - KC_A + 'a';
+  case KC_1 ... KC_9:
+    return keycode - KC_1 + '1';
+  case KC_0:
+    return '0';
   }
-
-  return (qk_ucis_state.codes[i] == KC_ENT ||
-          qk_ucis_state.codes[i] == KC_SPC);
+  return 0;
 }
 
 __attribute__((weak))
 void qk_ucis_symbol_fallback (void) {
   for (uint8_t i = 0; i < qk_ucis_state.count - 1; i++) {
-    uint8_t code = qk_ucis_state.codes[i];
-    register_code(code);
-    unregister_code(code);
-    wait_ms(UNICODE_TYPE_DELAY);
+    unicode_stream_tap(qk_ucis_state.codes[i], 1);
   }
 }
 
@@ -81,69 +71,54 @@ void register_ucis(const char *hex) {
     }
 
     if (kc) {
-      register_code (kc);
-      unregister_code (kc);
-      wait_ms (UNICODE_TYPE_DELAY);
+      unicode_stream_tap(kc, 1);
     }
   }
 }
 
 bool process_ucis (uint16_t keycode, keyrecord_t *record) {
-  uint8_t i;
-
   if (!qk_ucis_state.in_progress)
     return true;
 
-  if (qk_ucis_state.count >= UCIS_MAX_SYMBOL_LENGTH &&
-      !(keycode == KC_BSPC || keycode == KC_ESC || keycode == KC_SPC || keycode == KC_ENT)) {
-    return false;
-  }
-
   if (!record->event.pressed)
     return true;
 
-  qk_ucis_state.codes[qk_ucis_state.count] = keycode;
-  qk_ucis_state.count++;
-
   if (keycode == KC_BSPC) {
-    if (qk_ucis_state.count >= 2) {
-      qk_ucis_state.count -= 2;
-      return true;
-    } else {
-      qk_ucis_state.count--;
+    if (qk_ucis_state.count == 0)
       return false;
-    }
+    qk_ucis_state.count--;
+    ucis_match_back(&qk_ucis_state.match);
+    return true;
   }
 
   if (keycode == KC_ENT || keycode == KC_SPC || keycode == KC_ESC) {
-    bool symbol_found = false;
-
-    for (i = qk_ucis_state.count; i > 0; i--) {
-      register_code (KC_BSPC);
-      unregister_code (KC_BSPC);
-      wait_ms(UNICODE_TYPE_DELAY);
-    }
+    // the key ending it counts as well, and the backspaces take out the
+    // start symbol with the rest
+    qk_ucis_state.codes[qk_ucis_state.count] = keycode;
+    qk_ucis_state.count++;
+    qk_ucis_state.in_progress = false;
+    unicode_stream_tap(KC_BSPC, qk_ucis_state.count);
 
-    if (keycode == KC_ESC) {
-      qk_ucis_state.in_progress = false;
+    if (keycode == KC_ESC)
       return false;
-    }
 
-    unicode_input_start();
-    for (i = 0; ucis_symbol_table[i].symbol; i++) {
-      if (is_uni_seq (ucis_symbol_table[i].symbol)) {
-        symbol_found = true;
-        register_ucis(ucis_symbol_table[i].code + 2);
-        break;
-      }
-    }
-    if (!symbol_found) {
+    const qk_ucis_symbol_t *symbol = ucis_match_symbol(&qk_ucis_state.match);
+    if (symbol) {
+      unicode_emit(strtoul(symbol->code, NULL, 16));
+    } else {
+      // fallbacks may send keys themselves
+      unicode_stream_flush();
       qk_ucis_symbol_fallback();
     }
-    unicode_input_finish();
-
-    qk_ucis_state.in_progress = false;
     return false;
   }
+
+  // keys no symbol starts with never reach the host
+  char c = ucis_char(keycode);
+  if (!c || !ucis_match_char(&qk_ucis_state.match, c))
+    return false;
+
+  qk_ucis_state.codes[qk_ucis_state.count] = keycode;
+  qk_ucis_state.count++;
   return true;
 }
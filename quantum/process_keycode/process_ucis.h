@@ -19,24 +19,19 @@
 
 #include "quantum.h"
 #include "process_unicode_common.h"
-
-#ifndef UCIS_MAX_SYMBOL_LENGTH
-#define UCIS_MAX_SYMBOL_LENGTH 32
-#endif
-
-typedef struct {
-  char *symbol;
-  char *code;
-} qk_ucis_symbol_t;
+#include "ucis_index.h"
 
 typedef struct {
   uint8_t count;
   uint16_t codes[UCIS_MAX_SYMBOL_LENGTH];
   bool in_progress:1;
+  ucis_match_t match;
 } qk_ucis_state_t;
 
 extern qk_ucis_state_t qk_ucis_state;
 
+// Kept sorted by name, symbols are found with a binary search as they're
+// typed rather than compared one by one
 #define UCIS_TABLE(...) {__VA_ARGS__, {NULL, NULL}}
 #define UCIS_SYM(name, code) {name, #code}
 
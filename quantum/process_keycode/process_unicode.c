@@ -15,20 +15,20 @@
  */
 #include "process_unicode.h"
 #include "action_util.h"
-#include "eeprom.h"
+#include "eeconfig.h"
 
 static uint8_t first_flag = 0;
 
 bool process_unicode(uint16_t keycode, keyrecord_t *record) {
   if (keycode > QK_UNICODE && record->event.pressed) {
     if (first_flag == 0) {
-      set_unicode_input_mode(eeprom_read_byte(EECONFIG_UNICODEMODE));
+      uint8_t mode;
+      eeconfig_read_cached(EECONFIG_UNICODEMODE, &mode, 1);
+      set_unicode_input_mode(mode);
       first_flag = 1;
     }
     uint16_t unicode = keycode & 0x7FFF;
-    unicode_input_start();
-    register_hex(unicode);
-    unicode_input_finish();
+    unicode_emit(unicode);
   }
   return true;
 }
@@ -15,7 +15,7 @@
  */
 
 #include "process_unicode_common.h"
-#include "eeprom.h"
+#include "eeconfig.h"
 
 static uint8_t input_mode;
 uint8_t mods;
@@ -23,7 +23,7 @@ uint8_t mods;
 void set_unicode_input_mode(uint8_t os_target)
 {
   input_mode = os_target;
-  eeprom_update_byte(EECONFIG_UNICODEMODE, os_target);
+  eeconfig_update_cached(EECONFIG_UNICODEMODE, &os_target, 1);
 }
 
 uint8_t get_unicode_input_mode(void) {
@@ -32,18 +32,10 @@ uint8_t get_unicode_input_mode(void) {
 
 __attribute__((weak))
 void unicode_input_start (void) {
-  // save current mods
-  mods = keyboard_report->mods;
-
-  // unregister all mods to start from clean state
-  if (mods & MOD_BIT(KC_LSFT)) unregister_code(KC_LSFT);
-  if (mods & MOD_BIT(KC_RSFT)) unregister_code(KC_RSFT);
-  if (mods & MOD_BIT(KC_LCTL)) unregister_code(KC_LCTL);
-  if (mods & MOD_BIT(KC_RCTL)) unregister_code(KC_RCTL);
-  if (mods & MOD_BIT(KC_LALT)) unregister_code(KC_LALT);
-  if (mods & MOD_BIT(KC_RALT)) unregister_code(KC_RALT);
-  if (mods & MOD_BIT(KC_LGUI)) unregister_code(KC_LGUI);
-  if (mods & MOD_BIT(KC_RGUI)) unregister_code(KC_RGUI);
+  // save current mods, and let go of them all in one report
+  mods = get_mods();
+  clear_mods();
+  send_keyboard_report();
 
   switch(input_mode) {
   case UC_OSX:
@@ -85,14 +77,8 @@ void unicode_input_finish (void) {
   }
 
   // reregister previously set mods
-  if (mods & MOD_BIT(KC_LSFT)) register_code(KC_LSFT);
-  if (mods & MOD_BIT(KC_RSFT)) register_code(KC_RSFT);
-  if (mods & MOD_BIT(KC_LCTL)) register_code(KC_LCTL);
-  if (mods & MOD_BIT(KC_RCTL)) register_code(KC_RCTL);
-  if (mods & MOD_BIT(KC_LALT)) register_code(KC_LALT);
-  if (mods & MOD_BIT(KC_RALT)) register_code(KC_RALT);
-  if (mods & MOD_BIT(KC_LGUI)) register_code(KC_LGUI);
-  if (mods & MOD_BIT(KC_RGUI)) register_code(KC_RGUI);
+  set_mods(mods);
+  send_keyboard_report();
 }
 
 __attribute__((weak))
@@ -114,3 +100,128 @@ void register_hex(uint16_t hex) {
     unregister_code(hex_to_keycode(digit));
   }
 }
+
+// A tap when keycode is set, a code point otherwise
+typedef struct {
+  uint32_t code_point;
+  uint8_t keycode;
+  uint8_t count;
+} unicode_stream_entry_t;
+
+static unicode_stream_entry_t stream[UNICODE_STREAM_SIZE];
+static uint8_t stream_head;
+static uint8_t stream_length;
+static uint16_t stream_timer;
+
+static unicode_report_t program[UNICODE_PROGRAM_SIZE];
+static uint8_t program_length;
+static uint8_t program_position;
+static uint8_t program_key;
+
+// Works out the program for the entry at the head of the stream
+static void stream_compile(void) {
+  unicode_stream_entry_t *entry = &stream[stream_head];
+  uint8_t held = get_mods();
+
+  if (entry->keycode) {
+    program[0].mods = held;
+    program[0].keycode = entry->keycode;
+    program[1].mods = held;
+    program[1].keycode = 0;
+    program_length = 2;
+    if (--entry->count > 0) {
+      return;
+    }
+  } else {
+    program_length = unicode_program_compile(program, entry->code_point, input_mode, held);
+  }
+  program_position = 0;
+  stream_head = (stream_head + 1) % UNICODE_STREAM_SIZE;
+  stream_length--;
+}
+
+// Sends the next report, leaving any other key held alone. The mods of a
+// report only go into that report: the ones held are left as they are and
+// the last report puts back whatever is held by then, not what was held
+// when the program was worked out.
+static void stream_send(void) {
+  if (program_position >= program_length) {
+    program_position = 0;
+    program_length = 0;
+    stream_compile();
+    if (program_length == 0) {
+      return;
+    }
+  }
+  unicode_report_t *report = &program[program_position++];
+  if (program_key) {
+    del_key(program_key);
+  }
+  if (report->keycode) {
+    add_key(report->keycode);
+  }
+  program_key = report->keycode;
+  uint8_t held = get_mods();
+  if (program_position < program_length) {
+    set_mods(report->mods);
+  }
+  send_keyboard_report();
+  set_mods(held);
+}
+
+static unicode_stream_entry_t *stream_push(void) {
+  if (stream_length == UNICODE_STREAM_SIZE) {
+    unicode_stream_flush();
+  }
+  if (!unicode_stream_busy()) {
+    stream_timer = timer_read() - UNICODE_TYPE_DELAY;
+  }
+  stream_length++;
+  return &stream[(stream_head + stream_length - 1) % UNICODE_STREAM_SIZE];
+}
+
+bool unicode_emit(uint32_t code_point) {
+  if (!unicode_program_supported(code_point, input_mode)) {
+    return false;
+  }
+  unicode_stream_entry_t *entry = stream_push();
+  entry->code_point = code_point;
+  entry->keycode = 0;
+  entry->count = 1;
+  return true;
+}
+
+void unicode_stream_tap(uint8_t keycode, uint8_t count) {
+  if (keycode == 0 || count == 0) {
+    return;
+  }
+  if (stream_length > 0) {
+    unicode_stream_entry_t *last = &stream[(stream_head + stream_length - 1) % UNICODE_STREAM_SIZE];
+    if (last->keycode == keycode && last->count <= 255 - count) {
+      last->count += count;
+      return;
+    }
+  }
+  unicode_stream_entry_t *entry = stream_push();
+  entry->keycode = keycode;
+  entry->count = count;
+}
+
+bool unicode_stream_busy(void) {
+  return stream_length > 0 || program_position < program_length;
+}
+
+void unicode_stream_flush(void) {
+  while (unicode_stream_busy()) {
+    stream_send();
+    wait_ms(UNICODE_TYPE_DELAY);
+  }
+  stream_timer = timer_read();
+}
+
+void unicode_stream_task(void) {
+  if (unicode_stream_busy() && timer_elapsed(stream_timer) >= UNICODE_TYPE_DELAY) {
+    stream_send();
+    stream_timer = timer_read();
+  }
+}
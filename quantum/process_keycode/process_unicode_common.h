@@ -18,11 +18,18 @@
 #define PROCESS_UNICODE_COMMON_H
 
 #include "quantum.h"
+#include "unicode_program.h"
 
 #ifndef UNICODE_TYPE_DELAY
 #define UNICODE_TYPE_DELAY 10
 #endif
 
+// Code points and taps the keystroke stream holds before queueing has to
+// wait for it
+#ifndef UNICODE_STREAM_SIZE
+#define UNICODE_STREAM_SIZE 8
+#endif
+
 __attribute__ ((unused))
 static uint8_t input_mode;
 
@@ -32,11 +39,25 @@ void unicode_input_start(void);
 void unicode_input_finish(void);
 void register_hex(uint16_t hex);
 
-#define UC_OSX 0  // Mac OS X
-#define UC_LNX 1  // Linux
-#define UC_WIN 2  // Windows 'HexNumpad'
-#define UC_BSD 3  // BSD (not implemented)
-#define UC_WINC 4 // WinCompose https://github.com/samhocevar/wincompose
+/*
+ * Keystroke stream
+ *
+ * Code points queued here are typed by keystroke programs for the input
+ * mode (see unicode_program.h), a report every UNICODE_TYPE_DELAY from
+ * keyboard_task, so typing unicode doesn't stop the keyboard from
+ * scanning. The delay shouldn't be shorter than the host polls the
+ * keyboard, or reports get dropped. A tap queued after the same one is
+ * merged into it. While the stream is busy keyboard_task holds key events
+ * back, the matrix keeps them until the stream is done.
+ */
+// Returns false if code_point can't be typed in the input mode
+bool unicode_emit(uint32_t code_point);
+// Taps a basic keycode count times
+void unicode_stream_tap(uint8_t keycode, uint8_t count);
+bool unicode_stream_busy(void);
+// Sends whatever is queued, waiting in between
+void unicode_stream_flush(void);
+void unicode_stream_task(void);
 
 #define UC_BSPC	UC(0x0008)
 
@@ -0,0 +1,148 @@
+/* Copyright 2016 Jack Humbert
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "steno_packet.h"
+#include "progmem.h"
+
+#define GEMINI_START 0x80
+
+#define BOLT_SETS 4
+#define BOLT_NONE 0xFF
+// Key group in the top two bits, the key's bit in the rest
+#define BOLT(set, bit) (((set) << 6) | (1 << (bit)))
+
+#define BOLT_NUMBER BOLT(3, 4)
+#define BOLT_STAR   BOLT(1, 3)
+
+// The TX Bolt key for each Gemini key
+static const uint8_t bolt_keys[STENO_KEY_COUNT] PROGMEM = {
+    [STENO_FN]  = BOLT_NONE,
+    [STENO_N1]  = BOLT_NUMBER,
+    [STENO_N2]  = BOLT_NUMBER,
+    [STENO_N3]  = BOLT_NUMBER,
+    [STENO_N4]  = BOLT_NUMBER,
+    [STENO_N5]  = BOLT_NUMBER,
+    [STENO_N6]  = BOLT_NUMBER,
+
+    [STENO_S1]  = BOLT(0, 0),
+    [STENO_S2]  = BOLT(0, 0),
+    [STENO_TL]  = BOLT(0, 1),
+    [STENO_KL]  = BOLT(0, 2),
+    [STENO_PL]  = BOLT(0, 3),
+    [STENO_WL]  = BOLT(0, 4),
+    [STENO_HL]  = BOLT(0, 5),
+
+    [STENO_RL]  = BOLT(1, 0),
+    [STENO_A]   = BOLT(1, 1),
+    [STENO_O]   = BOLT(1, 2),
+    [STENO_ST1] = BOLT_STAR,
+    [STENO_ST2] = BOLT_STAR,
+    [STENO_RE1] = BOLT_NONE,
+    [STENO_RE2] = BOLT_NONE,
+
+    [STENO_PWR] = BOLT_NONE,
+    [STENO_ST3] = BOLT_STAR,
+    [STENO_ST4] = BOLT_STAR,
+    [STENO_E]   = BOLT(1, 4),
+    [STENO_U]   = BOLT(1, 5),
+    [STENO_FR]  = BOLT(2, 0),
+    [STENO_RR]  = BOLT(2, 1),
+
+    [STENO_PR]  = BOLT(2, 2),
+    [STENO_BR]  = BOLT(2, 3),
+    [STENO_LR]  = BOLT(2, 4),
+    [STENO_GR]  = BOLT(2, 5),
+    [STENO_TR]  = BOLT(3, 0),
+    [STENO_SR]  = BOLT(3, 1),
+    [STENO_DR]  = BOLT(3, 2),
+
+    [STENO_N7]  = BOLT_NUMBER,
+    [STENO_N8]  = BOLT_NUMBER,
+    [STENO_N9]  = BOLT_NUMBER,
+    [STENO_NA]  = BOLT_NUMBER,
+    [STENO_NB]  = BOLT_NUMBER,
+    [STENO_NC]  = BOLT_NUMBER,
+    [STENO_ZR]  = BOLT(3, 3),
+};
+
+void steno_stroke_clear(steno_stroke_t *stroke) {
+  for (uint8_t i = 0; i < STENO_STROKE_SIZE; i++) {
+    stroke->keys[i] = 0;
+  }
+}
+
+void steno_stroke_add(steno_stroke_t *stroke, uint8_t key) {
+  if (key < STENO_KEY_COUNT) {
+    stroke->keys[key / 7] |= 0x40 >> (key % 7);
+  }
+}
+
+void steno_stroke_remove(steno_stroke_t *stroke, uint8_t key) {
+  if (key < STENO_KEY_COUNT) {
+    stroke->keys[key / 7] &= ~(0x40 >> (key % 7));
+  }
+}
+
+bool steno_stroke_has(const steno_stroke_t *stroke, uint8_t key) {
+  return key < STENO_KEY_COUNT && (stroke->keys[key / 7] & (0x40 >> (key % 7)));
+}
+
+bool steno_stroke_empty(const steno_stroke_t *stroke) {
+  for (uint8_t i = 0; i < STENO_STROKE_SIZE; i++) {
+    if (stroke->keys[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint8_t steno_encode_gemini(const steno_stroke_t *stroke, uint8_t *packet) {
+  for (uint8_t i = 0; i < STENO_STROKE_SIZE; i++) {
+    packet[i] = stroke->keys[i];
+  }
+  packet[0] |= GEMINI_START;
+  return STENO_STROKE_SIZE;
+}
+
+uint8_t steno_encode_bolt(const steno_stroke_t *stroke, uint8_t *packet) {
+  uint8_t sets[BOLT_SETS] = {0};
+  for (uint8_t key = 0; key < STENO_KEY_COUNT; key++) {
+    if (!steno_stroke_has(stroke, key)) {
+      continue;
+    }
+    uint8_t bolt = pgm_read_byte(&bolt_keys[key]);
+    if (bolt != BOLT_NONE) {
+      sets[bolt >> 6] |= bolt & 0x3F;
+    }
+  }
+
+  uint8_t length = 0;
+  for (uint8_t set = 0; set < BOLT_SETS; set++) {
+    if (sets[set]) {
+      packet[length++] = (set << 6) | sets[set];
+    }
+  }
+  // the 0 ends the stroke, so the next one can start in any key group
+  packet[length++] = 0;
+  return length;
+}
+
+uint8_t steno_encode(const steno_stroke_t *stroke, uint8_t mode, uint8_t *packet) {
+  if (mode == STENO_MODE_GEMINI) {
+    return steno_encode_gemini(stroke, packet);
+  }
+  return steno_encode_bolt(stroke, packet);
+}
@@ -0,0 +1,111 @@
+/* Copyright 2016 Jack Humbert
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef STENO_PACKET_H
+#define STENO_PACKET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Steno strokes and the packets steno machines send them in
+ *
+ * A stroke is kept as the six bytes of a GeminiPR packet without the
+ * start bit: each key has a bit of its own, in the order of the Gemini
+ * chart, seven keys to a byte from the top bit down. Sending it as
+ * GeminiPR sets the start bit; TX Bolt packs the keys into a byte per
+ * key group that has any pressed, followed by a 0.
+ *
+ * TX Bolt has fewer keys. The number keys are all #, the stars are all *,
+ * S1- and S2- are both S-, and Fn, pwr and the reserved keys are left out.
+ */
+
+enum steno_keys {
+    STENO_FN,
+    STENO_N1,
+    STENO_N2,
+    STENO_N3,
+    STENO_N4,
+    STENO_N5,
+    STENO_N6,
+
+    STENO_S1,
+    STENO_S2,
+    STENO_TL,
+    STENO_KL,
+    STENO_PL,
+    STENO_WL,
+    STENO_HL,
+
+    STENO_RL,
+    STENO_A,
+    STENO_O,
+    STENO_ST1,
+    STENO_ST2,
+    STENO_RE1,
+    STENO_RE2,
+
+    STENO_PWR,
+    STENO_ST3,
+    STENO_ST4,
+    STENO_E,
+    STENO_U,
+    STENO_FR,
+    STENO_RR,
+
+    STENO_PR,
+    STENO_BR,
+    STENO_LR,
+    STENO_GR,
+    STENO_TR,
+    STENO_SR,
+    STENO_DR,
+
+    STENO_N7,
+    STENO_N8,
+    STENO_N9,
+    STENO_NA,
+    STENO_NB,
+    STENO_NC,
+    STENO_ZR,
+
+    STENO_KEY_COUNT
+};
+
+#define STENO_STROKE_SIZE 6
+// The longest packet either protocol sends for a stroke
+#define STENO_PACKET_MAX 6
+
+typedef struct {
+    uint8_t keys[STENO_STROKE_SIZE];
+} steno_stroke_t;
+
+enum steno_mode {
+    STENO_MODE_BOLT,
+    STENO_MODE_GEMINI,
+};
+
+void steno_stroke_clear(steno_stroke_t *stroke);
+void steno_stroke_add(steno_stroke_t *stroke, uint8_t key);
+void steno_stroke_remove(steno_stroke_t *stroke, uint8_t key);
+bool steno_stroke_has(const steno_stroke_t *stroke, uint8_t key);
+bool steno_stroke_empty(const steno_stroke_t *stroke);
+
+// Each writes the packet for stroke and returns its length
+uint8_t steno_encode_gemini(const steno_stroke_t *stroke, uint8_t *packet);
+uint8_t steno_encode_bolt(const steno_stroke_t *stroke, uint8_t *packet);
+uint8_t steno_encode(const steno_stroke_t *stroke, uint8_t mode, uint8_t *packet);
+
+#endif
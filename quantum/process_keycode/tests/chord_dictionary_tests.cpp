@@ -0,0 +1,211 @@
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+extern "C" {
+#include "process_keycode/chord_dictionary.h"
+}
+
+// Filled in by the tests, where keymaps have a const table in PROGMEM
+chord_t dictionary[CHORDING_DICTIONARY_SIZE] __asm__("chord_dictionary");
+
+// The 23 keys of a steno layout
+#define STENO_KEYS 23
+
+static uint32_t random_chord(void) {
+    uint32_t keys = 0;
+    int count = 1 + rand() % 8;
+    while (__builtin_popcount(keys) < count) {
+        keys |= CHORD_BIT(rand() % STENO_KEYS);
+    }
+    return keys;
+}
+
+class ChordDictionary : public testing::Test {
+public:
+    ChordDictionary() {
+        srand(3);
+        chords.clear();
+        while (chords.size() < CHORDING_DICTIONARY_SIZE) {
+            uint32_t keys = random_chord();
+            if (std::find(chords.begin(), chords.end(), keys) == chords.end()) {
+                chords.push_back(keys);
+            }
+        }
+        fill();
+        state = {};
+    }
+
+    void fill() {
+        for (size_t i = 0; i < chords.size(); i++) {
+            dictionary[i].keys = chords[i];
+            dictionary[i].action = 1000 + i;
+        }
+        chord_dictionary_init();
+    }
+
+    void sort() {
+        std::sort(chords.begin(), chords.end());
+        fill();
+    }
+
+    int expected(uint32_t keys) {
+        for (size_t i = 0; i < chords.size(); i++) {
+            if (chords[i] == keys) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    std::vector<uint32_t> chords;
+    chord_state_t state;
+};
+
+TEST_F(ChordDictionary, every_chord_is_found_sorted_or_not) {
+    for (int sorted = 0; sorted < 2; sorted++) {
+        if (sorted) {
+            sort();
+        }
+        EXPECT_EQ(chord_dictionary_sorted(), sorted == 1);
+        for (size_t i = 0; i < chords.size(); i++) {
+            uint16_t index = chord_lookup(chords[i]);
+            ASSERT_EQ(index, i);
+            EXPECT_EQ(chord_action(index), 1000 + i);
+        }
+    }
+}
+
+TEST_F(ChordDictionary, random_chords_match_every_entry_compared) {
+    for (int sorted = 0; sorted < 2; sorted++) {
+        if (sorted) {
+            sort();
+        }
+        srand(17);
+        for (int n = 0; n < 20000; n++) {
+            uint32_t keys = random_chord();
+            int want = expected(keys);
+            uint16_t index = chord_lookup(keys);
+            if (want < 0) {
+                ASSERT_EQ(index, CHORD_NOT_FOUND);
+            } else {
+                ASSERT_EQ(index, want);
+            }
+        }
+    }
+}
+
+TEST_F(ChordDictionary, sent_on_the_first_release) {
+    EXPECT_EQ(chord_press(&state, 0, 100), 0u);
+    EXPECT_EQ(chord_press(&state, 5, 110), 0u);
+    EXPECT_EQ(chord_press(&state, 22, 120), 0u);
+    EXPECT_EQ(chord_release(&state, 5), CHORD_BIT(0) | CHORD_BIT(5) | CHORD_BIT(22));
+    EXPECT_EQ(chord_release(&state, 0), 0u);
+    EXPECT_EQ(chord_release(&state, 22), 0u);
+    EXPECT_EQ(state.pressed, 0u);
+}
+
+TEST_F(ChordDictionary, keys_still_held_join_the_next_chord) {
+    chord_press(&state, 1, 0);
+    chord_press(&state, 2, 0);
+    EXPECT_EQ(chord_release(&state, 2), CHORD_BIT(1) | CHORD_BIT(2));
+    // 1 is still down when 3 goes down
+    chord_press(&state, 3, 10);
+    EXPECT_EQ(chord_release(&state, 3), CHORD_BIT(1) | CHORD_BIT(3));
+    EXPECT_EQ(chord_release(&state, 1), 0u);
+}
+
+TEST_F(ChordDictionary, window_sends_without_a_release) {
+    chord_press(&state, 4, 1000);
+    chord_press(&state, 7, 1010);
+    EXPECT_EQ(chord_timeout(&state, 1000 + CHORDING_WINDOW - 1), 0u);
+    EXPECT_EQ(chord_timeout(&state, 1000 + CHORDING_WINDOW), CHORD_BIT(4) | CHORD_BIT(7));
+    EXPECT_EQ(chord_timeout(&state, 2000), 0u);
+    EXPECT_EQ(chord_release(&state, 4), 0u);
+    EXPECT_EQ(chord_release(&state, 7), 0u);
+
+    // and the timer wraps
+    chord_press(&state, 4, 0xFFF0);
+    EXPECT_EQ(chord_timeout(&state, 0xFFF0 + CHORDING_WINDOW - 1), 0u);
+    EXPECT_EQ(chord_timeout(&state, (uint16_t)(0xFFF0 + CHORDING_WINDOW)), CHORD_BIT(4));
+}
+
+TEST_F(ChordDictionary, twenty_four_keys_at_once) {
+    uint32_t all = 0;
+    for (uint8_t key = 0; key < 24; key++) {
+        chord_press(&state, key, 0);
+        all |= CHORD_BIT(key);
+    }
+    chords[10] = all;
+    sort();
+    uint32_t chord = chord_release(&state, 12);
+    EXPECT_EQ(chord, all);
+    EXPECT_EQ(chord_action(chord_lookup(chord)) - 1000, (unsigned)expected(all));
+}
+
+// The keys_chord() way: every key of an entry looked for among the keys
+// pressed, entry by entry
+static bool keys_chord(const uint8_t* pressed, uint8_t pressed_count, uint32_t keys) {
+    uint8_t in = 0;
+    for (uint8_t i = 0; i < pressed_count; i++) {
+        if (!(keys & CHORD_BIT(pressed[i]))) {
+            return false;
+        }
+        in++;
+    }
+    return in == __builtin_popcount(keys);
+}
+
+template <typename F>
+static double time_lookups(F lookup, unsigned count) {
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < count; i++) {
+        lookup(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / count;
+}
+
+TEST_F(ChordDictionary, benchmark) {
+    sort();
+    std::vector<std::vector<uint8_t>> pressed;
+    for (uint32_t keys : chords) {
+        std::vector<uint8_t> list;
+        for (uint8_t key = 0; key < 32; key++) {
+            if (keys & CHORD_BIT(key)) {
+                list.push_back(key);
+            }
+        }
+        pressed.push_back(list);
+    }
+
+    volatile uint16_t sink = 0;
+    const unsigned count = 20000;
+    double list_time = time_lookups([&](unsigned n) {
+        const std::vector<uint8_t>& list = pressed[n % pressed.size()];
+        for (size_t i = 0; i < chords.size(); i++) {
+            if (keys_chord(list.data(), list.size(), chords[i])) {
+                sink = i;
+                break;
+            }
+        }
+    }, count);
+    double sorted_time = time_lookups([&](unsigned n) {
+        sink = chord_lookup(chords[n % chords.size()]);
+    }, count);
+
+    std::vector<uint32_t> shuffled = chords;
+    std::reverse(shuffled.begin(), shuffled.end());
+    chords = shuffled;
+    fill();
+    double unsorted_time = time_lookups([&](unsigned n) {
+        sink = chord_lookup(chords[n % chords.size()]);
+    }, count);
+    (void)sink;
+
+    printf("%d chords: %.0f ns per chord comparing key lists, %.0f ns with masks unsorted, "
+           "%.0f ns sorted\n",
+           CHORDING_DICTIONARY_SIZE, list_time, unsorted_time, sorted_time);
+}
@@ -0,0 +1,254 @@
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+extern "C" {
+#include "process_keycode/leader_dictionary.h"
+#include "keycode.h"
+}
+
+// Filled in by the tests, where keymaps have a const table in PROGMEM
+leader_sequence_t dictionary[LEADER_DICTIONARY_SIZE] __asm__("leader_dictionary");
+
+typedef std::vector<uint16_t> keys_t;
+
+// The SEQ_*_KEYS chain keymaps have used, every if evaluated once the
+// timeout has run out
+static int seq_chain(const std::vector<std::array<uint16_t, 5>>& chain, const uint16_t sequence[5]) {
+    int found = -1;
+    for (size_t i = 0; i < chain.size(); i++) {
+        if (sequence[0] == chain[i][0] && sequence[1] == chain[i][1] && sequence[2] == chain[i][2] &&
+            sequence[3] == chain[i][3] && sequence[4] == chain[i][4]) {
+            found = i;
+        }
+    }
+    return found;
+}
+
+// Random keys, leaving out the ones the fixed sequences start with
+static uint16_t random_key(void) {
+    static const uint16_t keys[] = {
+        KC_A, KC_B, KC_C, KC_D, KC_E, KC_F, KC_H, KC_I, KC_J, KC_K, KC_L,
+        KC_M, KC_N, KC_O, KC_P, KC_R, KC_S, KC_T, KC_U, KC_V, KC_W, KC_Y,
+    };
+    return keys[rand() % (sizeof(keys) / sizeof(keys[0]))];
+}
+
+class LeaderDictionary : public testing::Test {
+public:
+    LeaderDictionary() : sequences(LEADER_DICTIONARY_SIZE) {
+        // a few on purpose, with prefixes of each other
+        sequences[0] = { KC_G };
+        sequences[1] = { KC_G, KC_S };
+        sequences[2] = { KC_G, KC_C };
+        sequences[3] = { KC_G, KC_C, KC_A };
+        sequences[4] = { KC_Q, KC_W, KC_E, KC_R, KC_T, KC_Y, KC_U, KC_I, KC_O, KC_P, KC_A, KC_S };
+        sequences[5] = { KC_X };
+        sequences[6] = { KC_X, KC_X };
+        // and the rest random, one to five keys
+        srand(7);
+        for (size_t i = 7; i < sequences.size(); i++) {
+            do {
+                sequences[i].clear();
+                size_t length = 1 + rand() % 5;
+                for (size_t k = 0; k < length; k++) {
+                    sequences[i].push_back(random_key());
+                }
+            } while (first_equal(i) != i);
+        }
+        for (size_t i = 0; i < sequences.size(); i++) {
+            sequences[i].push_back(LEADER_END);
+            dictionary[i].keys = sequences[i].data();
+            dictionary[i].action = 1000 + i;
+            dictionary[i].timeout = 0;
+        }
+        dictionary[0].timeout = 500;
+        leader_dictionary_init();
+    }
+
+    size_t first_equal(size_t i) {
+        for (size_t j = 0; j < i; j++) {
+            if (sequences[j] == sequences[i]) {
+                return j;
+            }
+        }
+        return i;
+    }
+
+    // What typing keys should give, from every entry
+    uint8_t expected(const keys_t& keys, uint16_t* action) {
+        bool whole = false;
+        size_t longer = 0;
+        for (size_t i = 0; i < sequences.size(); i++) {
+            const keys_t& sequence = sequences[i];
+            if (sequence.size() - 1 < keys.size() ||
+                !std::equal(keys.begin(), keys.end(), sequence.begin())) {
+                continue;
+            }
+            if (sequence.size() - 1 == keys.size()) {
+                if (!whole) {
+                    *action = 1000 + i;
+                }
+                whole = true;
+            } else {
+                longer++;
+            }
+        }
+        if (whole) {
+            return longer ? LEADER_PENDING : LEADER_MATCH;
+        }
+        return longer ? LEADER_PARTIAL : LEADER_NO_MATCH;
+    }
+
+    uint8_t type(const keys_t& keys) {
+        leader_match_start(&match);
+        uint8_t result = LEADER_PARTIAL;
+        for (uint16_t key : keys) {
+            result = leader_match_key(&match, key);
+        }
+        return result;
+    }
+
+    std::vector<keys_t> sequences;
+    leader_match_t match;
+};
+
+TEST_F(LeaderDictionary, every_sequence_is_found) {
+    for (size_t i = 0; i < sequences.size(); i++) {
+        keys_t keys(sequences[i].begin(), sequences[i].end() - 1);
+        uint16_t action = 0;
+        uint8_t result = type(keys);
+        EXPECT_EQ(result, expected(keys, &action)) << i;
+        ASSERT_NE(result, LEADER_NO_MATCH) << i;
+        ASSERT_NE(result, LEADER_PARTIAL) << i;
+        EXPECT_EQ(leader_match_action(&match), 1000 + i) << i;
+    }
+}
+
+TEST_F(LeaderDictionary, fires_as_soon_as_it_is_unambiguous) {
+    EXPECT_EQ(type({ KC_G }), LEADER_PENDING);
+    EXPECT_EQ(type({ KC_G, KC_S }), LEADER_MATCH);
+    EXPECT_EQ(leader_match_action(&match), 1001);
+    EXPECT_EQ(type({ KC_G, KC_C }), LEADER_PENDING);
+    EXPECT_EQ(type({ KC_G, KC_C, KC_A }), LEADER_MATCH);
+    EXPECT_EQ(type({ KC_X, KC_X }), LEADER_MATCH);
+}
+
+TEST_F(LeaderDictionary, long_sequences) {
+    keys_t keys;
+    for (size_t k = 0; k + 1 < sequences[4].size(); k++) {
+        keys.push_back(sequences[4][k]);
+        uint8_t result = type(keys);
+        if (keys.size() < sequences[4].size() - 1) {
+            EXPECT_EQ(result, LEADER_PARTIAL) << keys.size();
+        } else {
+            EXPECT_EQ(result, LEADER_MATCH);
+            EXPECT_EQ(leader_match_action(&match), 1004);
+        }
+    }
+    keys.push_back(KC_A);
+    EXPECT_EQ(type(keys), LEADER_NO_MATCH);
+}
+
+TEST_F(LeaderDictionary, stays_out_once_nothing_matches) {
+    leader_match_start(&match);
+    EXPECT_EQ(leader_match_key(&match, KC_F1), LEADER_NO_MATCH);
+    EXPECT_EQ(leader_match_key(&match, KC_G), LEADER_NO_MATCH);
+}
+
+TEST_F(LeaderDictionary, timeouts_per_sequence) {
+    leader_match_start(&match);
+    EXPECT_EQ(leader_match_timeout(&match, 200), 200);
+    leader_match_key(&match, KC_G);
+    EXPECT_EQ(leader_match_timeout(&match, 200), 500);
+    leader_match_key(&match, KC_C);
+    EXPECT_EQ(leader_match_timeout(&match, 200), 200);
+}
+
+TEST_F(LeaderDictionary, random_typing_matches_every_entry_compared) {
+    srand(11);
+    for (int n = 0; n < 20000; n++) {
+        keys_t keys;
+        size_t length = 1 + rand() % 6;
+        for (size_t k = 0; k < length; k++) {
+            keys.push_back(KC_A + rand() % 26);
+        }
+        uint16_t action = 0;
+        uint8_t want = expected(keys, &action);
+        ASSERT_EQ(type(keys), want);
+        if (want == LEADER_MATCH || want == LEADER_PENDING) {
+            EXPECT_EQ(leader_match_action(&match), action);
+        }
+    }
+}
+
+TEST_F(LeaderDictionary, duplicates_fire_the_first) {
+    sequences[10] = sequences[20];
+    dictionary[10].keys = sequences[10].data();
+    leader_dictionary_init();
+    keys_t keys(sequences[20].begin(), sequences[20].end() - 1);
+    EXPECT_EQ(type(keys), LEADER_PENDING);
+    EXPECT_EQ(leader_match_action(&match), 1010);
+}
+
+template <typename F>
+static double time_lookups(F lookup, unsigned count) {
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < count; i++) {
+        lookup(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / count;
+}
+
+// Looks up every sequence of up to five keys both ways, and counts the key
+// comparisons, which are what cost on a keyboard
+TEST_F(LeaderDictionary, benchmark) {
+    std::vector<std::array<uint16_t, 5>> chain;
+    std::vector<size_t> short_ones;
+    for (size_t i = 0; i < sequences.size(); i++) {
+        if (sequences[i].size() <= 6) {
+            std::array<uint16_t, 5> slots = {};
+            std::copy(sequences[i].begin(), sequences[i].end() - 1, slots.begin());
+            chain.push_back(slots);
+            short_ones.push_back(i);
+        }
+    }
+
+    volatile int sink = 0;
+    const unsigned count = 200000;
+    double chain_time = time_lookups([&](unsigned n) {
+        const std::array<uint16_t, 5>& slots = chain[n % chain.size()];
+        sink = seq_chain(chain, slots.data());
+    }, count);
+    double trie_time = time_lookups([&](unsigned n) {
+        const keys_t& sequence = sequences[short_ones[n % short_ones.size()]];
+        leader_match_start(&match);
+        for (size_t k = 0; sequence[k] != LEADER_END; k++) {
+            leader_match_key(&match, sequence[k]);
+        }
+        sink = leader_match_action(&match);
+    }, count);
+    (void)sink;
+
+    // each if compares until the first slot that differs
+    size_t chain_compares = 0;
+    for (auto& slots : chain) {
+        for (auto& entry : chain) {
+            for (int k = 0; k < 5; k++) {
+                chain_compares++;
+                if (entry[k] != slots[k]) {
+                    break;
+                }
+            }
+        }
+    }
+    printf("%zu sequences: %.1f key compares and %.1f ns per lookup before, %.1f ns now, "
+           "at most %d key reads per key typed\n",
+           chain.size(), (double)chain_compares / chain.size(), chain_time, trie_time,
+           (int)ceil(log2(LEADER_DICTIONARY_SIZE)) * 2 + 1);
+}
@@ -0,0 +1,26 @@
+leader_dictionary_DEFS := -DLEADER_DICTIONARY_SIZE=200
+leader_dictionary_SRC :=\
+	$(QUANTUM_PATH)/process_keycode/tests/leader_dictionary_tests.cpp \
+	$(QUANTUM_PATH)/process_keycode/leader_dictionary.c
+
+ucis_index_SRC :=\
+	$(QUANTUM_PATH)/process_keycode/tests/ucis_index_tests.cpp \
+	$(QUANTUM_PATH)/process_keycode/ucis_index.c
+
+unicode_program_SRC :=\
+	$(QUANTUM_PATH)/process_keycode/tests/unicode_program_tests.cpp \
+	$(QUANTUM_PATH)/process_keycode/unicode_program.c
+
+tap_dance_DEFS := -DTAP_DANCE_ENABLE -DMATRIX_ROWS=4 -DMATRIX_COLS=4
+tap_dance_SRC :=\
+	$(QUANTUM_PATH)/process_keycode/tests/tap_dance_tests.cpp \
+	$(QUANTUM_PATH)/process_keycode/process_tap_dance.c
+
+chord_dictionary_DEFS := -DCHORDING_DICTIONARY_SIZE=2000 -DCHORDING_WINDOW=50
+chord_dictionary_SRC :=\
+	$(QUANTUM_PATH)/process_keycode/tests/chord_dictionary_tests.cpp \
+	$(QUANTUM_PATH)/process_keycode/chord_dictionary.c
+
+steno_packet_SRC :=\
+	$(QUANTUM_PATH)/process_keycode/tests/steno_packet_tests.cpp \
+	$(QUANTUM_PATH)/process_keycode/steno_packet.c
@@ -0,0 +1,149 @@
+#include "gtest/gtest.h"
+#include <initializer_list>
+#include <vector>
+extern "C" {
+#include "process_keycode/steno_packet.h"
+}
+
+typedef std::vector<uint8_t> packet_t;
+
+static steno_stroke_t stroke_of(std::initializer_list<uint8_t> keys) {
+    steno_stroke_t stroke;
+    steno_stroke_clear(&stroke);
+    for (uint8_t key : keys) {
+        steno_stroke_add(&stroke, key);
+    }
+    return stroke;
+}
+
+static packet_t encode(std::initializer_list<uint8_t> keys, uint8_t mode) {
+    steno_stroke_t stroke = stroke_of(keys);
+    uint8_t packet[STENO_PACKET_MAX + 1];
+    packet[STENO_PACKET_MAX] = 0xAA;
+    uint8_t length = steno_encode(&stroke, mode, packet);
+    EXPECT_LE(length, STENO_PACKET_MAX);
+    EXPECT_EQ(packet[STENO_PACKET_MAX], 0xAA);
+    return packet_t(packet, packet + length);
+}
+
+// The reference packets are what a Gemini PR and a TX Bolt machine send
+// for the same strokes, as read by Plover
+
+TEST(StenoPacket, gemini_reference_packets) {
+    // KAT
+    EXPECT_EQ(encode({ STENO_KL, STENO_A, STENO_TR }, STENO_MODE_GEMINI),
+              packet_t({ 0x80, 0x08, 0x20, 0x00, 0x04, 0x00 }));
+    // STKPWHR
+    EXPECT_EQ(encode({ STENO_S1, STENO_TL, STENO_KL, STENO_PL, STENO_WL, STENO_HL, STENO_RL },
+                     STENO_MODE_GEMINI),
+              packet_t({ 0x80, 0x5F, 0x40, 0x00, 0x00, 0x00 }));
+    // -FRPBLGTSDZ
+    EXPECT_EQ(encode({ STENO_FR, STENO_RR, STENO_PR, STENO_BR, STENO_LR, STENO_GR, STENO_TR,
+                       STENO_SR, STENO_DR, STENO_ZR }, STENO_MODE_GEMINI),
+              packet_t({ 0x80, 0x00, 0x00, 0x03, 0x7F, 0x01 }));
+    // the corners of the chart
+    EXPECT_EQ(encode({ STENO_FN }, STENO_MODE_GEMINI),
+              packet_t({ 0xC0, 0x00, 0x00, 0x00, 0x00, 0x00 }));
+    EXPECT_EQ(encode({ STENO_N6, STENO_N7 }, STENO_MODE_GEMINI),
+              packet_t({ 0x81, 0x00, 0x00, 0x00, 0x00, 0x40 }));
+    EXPECT_EQ(encode({ STENO_PWR, STENO_E, STENO_U }, STENO_MODE_GEMINI),
+              packet_t({ 0x80, 0x00, 0x00, 0x4C, 0x00, 0x00 }));
+}
+
+TEST(StenoPacket, bolt_reference_packets) {
+    // KAT
+    EXPECT_EQ(encode({ STENO_KL, STENO_A, STENO_TR }, STENO_MODE_BOLT),
+              packet_t({ 0x04, 0x42, 0xC1, 0x00 }));
+    // STKPWHR
+    EXPECT_EQ(encode({ STENO_S1, STENO_TL, STENO_KL, STENO_PL, STENO_WL, STENO_HL, STENO_RL },
+                     STENO_MODE_BOLT),
+              packet_t({ 0x3F, 0x41, 0x00 }));
+    // AO*EU
+    EXPECT_EQ(encode({ STENO_A, STENO_O, STENO_ST1, STENO_E, STENO_U }, STENO_MODE_BOLT),
+              packet_t({ 0x7E, 0x00 }));
+    // -FRPBLGTSDZ
+    EXPECT_EQ(encode({ STENO_FR, STENO_RR, STENO_PR, STENO_BR, STENO_LR, STENO_GR, STENO_TR,
+                       STENO_SR, STENO_DR, STENO_ZR }, STENO_MODE_BOLT),
+              packet_t({ 0xBF, 0xCF, 0x00 }));
+    // #T-
+    EXPECT_EQ(encode({ STENO_N1, STENO_TL }, STENO_MODE_BOLT),
+              packet_t({ 0x02, 0xD0, 0x00 }));
+}
+
+TEST(StenoPacket, bolt_merges_the_keys_it_has_one_of) {
+    EXPECT_EQ(encode({ STENO_S1, STENO_S2 }, STENO_MODE_BOLT), encode({ STENO_S1 }, STENO_MODE_BOLT));
+    EXPECT_EQ(encode({ STENO_ST1, STENO_ST2, STENO_ST3, STENO_ST4 }, STENO_MODE_BOLT),
+              encode({ STENO_ST4 }, STENO_MODE_BOLT));
+    for (uint8_t key : { STENO_N1, STENO_N2, STENO_N3, STENO_N4, STENO_N5, STENO_N6,
+                         STENO_N7, STENO_N8, STENO_N9, STENO_NA, STENO_NB, STENO_NC }) {
+        EXPECT_EQ(encode({ key }, STENO_MODE_BOLT), packet_t({ 0xD0, 0x00 })) << (int)key;
+    }
+    // and leaves out the ones it hasn't got
+    for (uint8_t key : { STENO_FN, STENO_PWR, STENO_RE1, STENO_RE2 }) {
+        EXPECT_EQ(encode({ key }, STENO_MODE_BOLT), packet_t({ 0x00 })) << (int)key;
+    }
+}
+
+TEST(StenoPacket, every_key_has_a_bit_of_its_own) {
+    steno_stroke_t all;
+    steno_stroke_clear(&all);
+    for (uint8_t key = 0; key < STENO_KEY_COUNT; key++) {
+        steno_stroke_t stroke = stroke_of({ key });
+        EXPECT_TRUE(steno_stroke_has(&stroke, key));
+        for (uint8_t other = 0; other < STENO_KEY_COUNT; other++) {
+            if (other != key) {
+                EXPECT_FALSE(steno_stroke_has(&stroke, other)) << (int)key << " " << (int)other;
+            }
+        }
+        // no key sets the start bit
+        EXPECT_EQ(stroke.keys[0] & 0x80, 0);
+        steno_stroke_add(&all, key);
+    }
+    uint8_t packet[STENO_PACKET_MAX];
+    steno_encode_gemini(&all, packet);
+    EXPECT_EQ(packet_t(packet, packet + 6), packet_t({ 0xFF, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F }));
+    EXPECT_EQ(encode({}, STENO_MODE_BOLT).size(), 1u);
+    EXPECT_EQ(steno_encode_bolt(&all, packet), 5);
+    EXPECT_EQ(packet_t(packet, packet + 5), packet_t({ 0x3F, 0x7F, 0xBF, 0xDF, 0x00 }));
+}
+
+TEST(StenoPacket, keys_come_and_go) {
+    steno_stroke_t stroke = stroke_of({ STENO_A, STENO_O });
+    EXPECT_FALSE(steno_stroke_empty(&stroke));
+    steno_stroke_remove(&stroke, STENO_A);
+    EXPECT_FALSE(steno_stroke_has(&stroke, STENO_A));
+    EXPECT_TRUE(steno_stroke_has(&stroke, STENO_O));
+    steno_stroke_remove(&stroke, STENO_O);
+    EXPECT_TRUE(steno_stroke_empty(&stroke));
+    // keys past the chart are ignored
+    steno_stroke_add(&stroke, STENO_KEY_COUNT);
+    EXPECT_TRUE(steno_stroke_empty(&stroke));
+}
+
+// One packet per stroke where emulating a QWERTY keyboard sends a report
+// for every key going down and every key coming up
+TEST(StenoPacket, packets_against_reports) {
+    const uint8_t strokes[][4] = {
+        { STENO_KL, STENO_A, STENO_TR, STENO_KEY_COUNT },
+        { STENO_S1, STENO_TL, STENO_O, STENO_PR },
+        { STENO_HL, STENO_E, STENO_LR, STENO_O },
+    };
+    unsigned reports = 0, gemini = 0, bolt = 0;
+    for (auto& keys : strokes) {
+        steno_stroke_t stroke;
+        steno_stroke_clear(&stroke);
+        for (uint8_t key : keys) {
+            if (key < STENO_KEY_COUNT) {
+                steno_stroke_add(&stroke, key);
+                reports += 2;
+            }
+        }
+        uint8_t packet[STENO_PACKET_MAX];
+        gemini += steno_encode_gemini(&stroke, packet);
+        bolt += steno_encode_bolt(&stroke, packet);
+    }
+    printf("%zu strokes: %u keyboard reports, %u bytes of GeminiPR, %u bytes of TX Bolt\n",
+           sizeof(strokes) / sizeof(strokes[0]), reports, gemini, bolt);
+    EXPECT_EQ(gemini, 18u);
+    EXPECT_EQ(bolt, 12u);
+}
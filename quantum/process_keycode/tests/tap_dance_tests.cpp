@@ -0,0 +1,273 @@
+#include "gtest/gtest.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+extern "C" {
+#include "action.h"
+#include "action_tapping.h"
+#include "quantum_keycodes.h"
+#include "keycode.h"
+#include "process_keycode/process_tap_dance.h"
+}
+
+#define DANCES 64
+
+qk_tap_dance_action_t tap_dance_actions[DANCES];
+
+static uint16_t now;
+static std::vector<std::string> events;
+
+// What the engine needs from the rest of the firmware
+extern "C" {
+uint16_t timer_read(void) { return now; }
+uint16_t timer_elapsed(uint16_t last) { return now - last; }
+uint8_t get_oneshot_mods(void) { return 0; }
+void add_mods(uint8_t mods) {}
+void del_mods(uint8_t mods) {}
+void send_keyboard_report(void) {}
+void register_code16(uint16_t code) { events.push_back("register " + std::to_string(code)); }
+void unregister_code16(uint16_t code) { events.push_back("unregister " + std::to_string(code)); }
+}
+
+static void finished(qk_tap_dance_state_t* state, void* user_data) {
+    std::string event = "finish " + std::to_string((intptr_t)user_data) + " x" + std::to_string(state->count);
+    if (state->pressed) {
+        event += " held";
+    }
+    if (state->interrupted) {
+        event += " interrupted";
+    }
+    events.push_back(event);
+}
+
+static void reset(qk_tap_dance_state_t* state, void* user_data) {
+    events.push_back("reset " + std::to_string((intptr_t)user_data));
+}
+
+// Resets itself from the finished function, as some keymaps do
+static void finished_and_reset(qk_tap_dance_state_t* state, void* user_data) {
+    finished(state, user_data);
+    reset_tap_dance(state);
+}
+
+enum { PAIR = 1, TAP_HOLD = 2, SLOW = 3, SELF_RESET = 4, LAST = DANCES - 1 };
+
+class TapDance : public testing::Test {
+public:
+    TapDance() : pair{ KC_A, KC_B }, tap_hold{ KC_ESC, KC_LCTL, 0 } {
+        for (intptr_t i = 0; i < DANCES; i++) {
+            tap_dance_actions[i] = {};
+            tap_dance_actions[i].fn.on_dance_finished = finished;
+            tap_dance_actions[i].fn.on_reset = reset;
+            tap_dance_actions[i].user_data = (void*)i;
+        }
+        tap_dance_actions[PAIR].fn = { NULL, qk_tap_dance_pair_finished, qk_tap_dance_pair_reset };
+        tap_dance_actions[PAIR].user_data = &pair;
+        tap_dance_actions[TAP_HOLD].fn = { NULL, qk_tap_dance_tap_hold_finished, qk_tap_dance_tap_hold_reset };
+        tap_dance_actions[TAP_HOLD].user_data = &tap_hold;
+        tap_dance_actions[SLOW].custom_tapping_term = 500;
+        tap_dance_actions[SELF_RESET].fn.on_dance_finished = finished_and_reset;
+        now = 1000;
+        events.clear();
+    }
+
+    ~TapDance() {
+        // nothing left behind for the next test
+        wait(TAPPING_TERM * 4);
+    }
+
+    // Returns whether the key goes on to be processed
+    bool key(uint16_t keycode, bool pressed) {
+        keyrecord_t record = {};
+        record.event.pressed = pressed;
+        record.event.time = now;
+        bool result = process_tap_dance(keycode, &record);
+        if (keycode < QK_TAP_DANCE || keycode > QK_TAP_DANCE_MAX) {
+            events.push_back(std::string(pressed ? "press " : "release ") + std::to_string(keycode));
+        }
+        return result;
+    }
+
+    void tap(uint16_t keycode) {
+        key(keycode, true);
+        wait(10);
+        key(keycode, false);
+    }
+
+    void wait(unsigned ms) {
+        for (unsigned i = 0; i < ms; i++) {
+            now++;
+            matrix_scan_tap_dance();
+        }
+    }
+
+    qk_tap_dance_pair_t pair;
+    qk_tap_dance_tap_hold_t tap_hold;
+};
+
+typedef std::vector<std::string> events_t;
+
+TEST_F(TapDance, finishes_when_the_tapping_term_runs_out) {
+    tap(TD(10));
+    wait(TAPPING_TERM - 20);
+    EXPECT_EQ(events, events_t());
+    wait(20);
+    EXPECT_EQ(events, events_t({ "finish 10 x1", "reset 10" }));
+}
+
+TEST_F(TapDance, counts_taps) {
+    tap(TD(10));
+    wait(100);
+    tap(TD(10));
+    wait(100);
+    tap(TD(10));
+    wait(TAPPING_TERM + 1);
+    EXPECT_EQ(events, events_t({ "finish 10 x3", "reset 10" }));
+}
+
+TEST_F(TapDance, pair) {
+    tap(TD(PAIR));
+    tap(TD(PAIR));
+    wait(TAPPING_TERM + 1);
+    EXPECT_EQ(events, events_t({ "register " + std::to_string(KC_B), "unregister " + std::to_string(KC_B) }));
+}
+
+TEST_F(TapDance, other_keys_interrupt_before_they_are_processed) {
+    tap(TD(10));
+    EXPECT_TRUE(key(KC_X, true));
+    EXPECT_EQ(events, events_t({ "finish 10 x1 interrupted", "reset 10", "press " + std::to_string(KC_X) }));
+    // and there's nothing left to time out
+    events.clear();
+    wait(TAPPING_TERM * 2);
+    EXPECT_EQ(events, events_t());
+}
+
+TEST_F(TapDance, held_past_the_term_resets_on_release) {
+    key(TD(10), true);
+    wait(TAPPING_TERM + 1);
+    EXPECT_EQ(events, events_t({ "finish 10 x1 held" }));
+    wait(500);
+    key(TD(10), false);
+    EXPECT_EQ(events, events_t({ "finish 10 x1 held", "reset 10" }));
+}
+
+TEST_F(TapDance, tap_hold) {
+    tap(TD(TAP_HOLD));
+    wait(TAPPING_TERM + 1);
+    EXPECT_EQ(events, events_t({ "register " + std::to_string(KC_ESC), "unregister " + std::to_string(KC_ESC) }));
+
+    events.clear();
+    key(TD(TAP_HOLD), true);
+    wait(TAPPING_TERM + 1);
+    key(KC_C, true);
+    key(KC_C, false);
+    key(TD(TAP_HOLD), false);
+    EXPECT_EQ(events, events_t({ "register " + std::to_string(KC_LCTL), "press " + std::to_string(KC_C),
+                                 "release " + std::to_string(KC_C), "unregister " + std::to_string(KC_LCTL) }));
+
+    // held down when another key comes is a hold as well
+    events.clear();
+    key(TD(TAP_HOLD), true);
+    key(KC_C, true);
+    EXPECT_EQ(events, events_t({ "register " + std::to_string(KC_LCTL), "press " + std::to_string(KC_C) }));
+    key(KC_C, false);
+    key(TD(TAP_HOLD), false);
+}
+
+TEST_F(TapDance, tapping_term_per_dance) {
+    tap(TD(SLOW));
+    wait(TAPPING_TERM + 100);
+    EXPECT_EQ(events, events_t());
+    wait(500 - TAPPING_TERM - 100);
+    EXPECT_EQ(events, events_t({ "finish 3 x1", "reset 3" }));
+}
+
+TEST_F(TapDance, interleaved_dances_in_the_order_they_came) {
+    // a held one stays until it's let go of, the others finish as the
+    // next dance starts
+    key(TD(20), true);
+    wait(TAPPING_TERM + 1);
+    tap(TD(30));
+    tap(TD(40));
+    key(TD(50), true);
+    tap(TD(40));
+    key(KC_X, true);
+    key(TD(50), false);
+    key(TD(20), false);
+    EXPECT_EQ(events, events_t({ "finish 20 x1 held", "finish 30 x1 interrupted", "reset 30",
+                                 "finish 40 x1 interrupted", "reset 40", "finish 50 x1 held interrupted",
+                                 "finish 40 x1 interrupted", "reset 40", "press " + std::to_string(KC_X),
+                                 "reset 50", "reset 20" }));
+}
+
+TEST_F(TapDance, reset_from_the_finished_function_resets_once) {
+    tap(TD(SELF_RESET));
+    wait(TAPPING_TERM + 1);
+    EXPECT_EQ(events, events_t({ "finish 4 x1", "reset 4" }));
+}
+
+TEST_F(TapDance, oldest_makes_room) {
+    for (int i = 0; i < TAP_DANCE_MAX_ACTIVE; i++) {
+        key(TD(20 + i), true);
+        wait(TAPPING_TERM + 1);
+    }
+    events.clear();
+    key(TD(40), true);
+    EXPECT_EQ(events, events_t({ "reset 20" }));
+    key(TD(40), false);
+    for (int i = 0; i < TAP_DANCE_MAX_ACTIVE; i++) {
+        key(TD(20 + i), false);
+    }
+}
+
+// What the scan and every other key press used to cost, going through
+// every dance up to the highest one used
+static uint16_t highest_td = LAST;
+static volatile unsigned finishes;
+
+static void old_matrix_scan_tap_dance(void) {
+    for (uint8_t i = 0; i <= highest_td; i++) {
+        qk_tap_dance_action_t* action = &tap_dance_actions[i];
+        uint16_t term = action->custom_tapping_term > 0 ? action->custom_tapping_term : TAPPING_TERM;
+        if (action->state.count && timer_elapsed(action->state.timer) > term) {
+            finishes++;
+        }
+    }
+}
+
+static void old_other_key(void) {
+    for (int i = 0; i <= highest_td; i++) {
+        qk_tap_dance_action_t* action = &tap_dance_actions[i];
+        if (action->state.count == 0)
+            continue;
+        finishes++;
+    }
+}
+
+template <typename F>
+static double time_calls(F call, unsigned count) {
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < count; i++) {
+        call();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / count;
+}
+
+TEST_F(TapDance, benchmark) {
+    // the last of 64 dances tapped once, so the old loops go through all of
+    // them, then the time a scan takes with it counting taps and a key
+    // press takes once it's done
+    tap(TD(LAST));
+    const unsigned count = 1000000;
+    double old_scan = time_calls(old_matrix_scan_tap_dance, count);
+    double old_key = time_calls(old_other_key, count);
+    double scan = time_calls(matrix_scan_tap_dance, count);
+    keyrecord_t record = {};
+    record.event.pressed = true;
+    double key = time_calls([&]() { process_tap_dance(KC_X, &record); }, count);
+    printf("%d dances: scan %.1f ns before, %.1f ns now; other key %.1f ns before, %.1f ns now\n",
+           DANCES, old_scan, scan, old_key, key);
+}
@@ -0,0 +1,7 @@
+TEST_LIST +=\
+	leader_dictionary \
+	ucis_index \
+	unicode_program \
+	tap_dance \
+	chord_dictionary \
+	steno_packet
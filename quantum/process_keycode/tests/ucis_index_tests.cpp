@@ -0,0 +1,264 @@
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+extern "C" {
+#include "process_keycode/ucis_index.h"
+#include "keycode.h"
+}
+
+static const char* alphabet = "abcdefghijklmnopqrstuvwxyz0123456789";
+
+// is_uni_seq() from before the index, with its codes typed as keycodes and
+// the digits it used to get wrong put right
+static bool linear_is_uni_seq(const char* seq, const uint16_t* codes, uint8_t count) {
+    uint8_t i;
+    for (i = 0; seq[i]; i++) {
+        uint16_t code;
+        if ('1' <= seq[i] && seq[i] <= '9')
+            code = seq[i] - '1' + KC_1;
+        else if (seq[i] == '0')
+            code = KC_0;
+        else
+            code = seq[i] - 'a' + KC_A;
+        if (i > count || codes[i] != code)
+            return false;
+    }
+    return codes[i] == KC_ENT || codes[i] == KC_SPC;
+}
+
+static uint16_t keycode(char c) {
+    if (c == '0')
+        return KC_0;
+    if (c >= '1' && c <= '9')
+        return c - '1' + KC_1;
+    return c - 'a' + KC_A;
+}
+
+// 1000 symbols, two to eight characters long, with a few prefixes of each
+// other on purpose
+class UcisIndex : public testing::Test {
+public:
+    UcisIndex() {
+        names = { "poop", "poo", "pooh", "snowman", "snow", "rofl", "kiss", "0" };
+        srand(5);
+        while (names.size() < 1000) {
+            std::string name;
+            size_t length = 2 + rand() % 7;
+            for (size_t k = 0; k < length; k++) {
+                name += alphabet[rand() % 26];
+            }
+            if (std::find(names.begin(), names.end(), name) == names.end()) {
+                names.push_back(name);
+            }
+        }
+        build();
+    }
+
+    void build() {
+        codes.clear();
+        table.clear();
+        for (size_t i = 0; i < names.size(); i++) {
+            char code[12];
+            snprintf(code, sizeof(code), "0x%X", (unsigned)(0x1F000 + i));
+            codes.push_back(code);
+        }
+        for (size_t i = 0; i < names.size(); i++) {
+            table.push_back({ (char*)names[i].c_str(), (char*)codes[i].c_str() });
+        }
+        table.push_back({ NULL, NULL });
+        // a new table can land where the last one was
+        ucis_index_init(table.data());
+    }
+
+    void sort() {
+        std::sort(names.begin(), names.end());
+        build();
+    }
+
+    // Whether typing text can still lead to a symbol
+    bool expected_prefix(const std::string& text) {
+        for (const std::string& name : names) {
+            if (name.compare(0, text.size(), text) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const qk_ucis_symbol_t* type(const std::string& text) {
+        ucis_match_start(&match, table.data());
+        for (char c : text) {
+            if (!ucis_match_char(&match, c)) {
+                return NULL;
+            }
+        }
+        return ucis_match_symbol(&match);
+    }
+
+    std::vector<std::string> names;
+    std::vector<std::string> codes;
+    std::vector<qk_ucis_symbol_t> table;
+    ucis_match_t match;
+};
+
+TEST_F(UcisIndex, every_symbol_is_found_sorted_or_not) {
+    for (int sorted = 0; sorted < 2; sorted++) {
+        if (sorted) {
+            sort();
+        }
+        EXPECT_EQ(ucis_index_sorted(), sorted == 1);
+        for (size_t i = 0; i < names.size(); i++) {
+            const qk_ucis_symbol_t* symbol = type(names[i]);
+            ASSERT_NE(symbol, nullptr) << names[i];
+            EXPECT_STREQ(symbol->code, codes[i].c_str());
+        }
+    }
+}
+
+TEST_F(UcisIndex, prefixes_are_not_symbols) {
+    sort();
+    EXPECT_STREQ(type("poo")->symbol, "poo");
+    EXPECT_STREQ(type("poop")->symbol, "poop");
+    EXPECT_EQ(type("po"), nullptr);
+    EXPECT_STREQ(type("snow")->symbol, "snow");
+    EXPECT_STREQ(type("0")->symbol, "0");
+}
+
+TEST_F(UcisIndex, wrong_keys_are_turned_down_as_typed) {
+    for (int sorted = 0; sorted < 2; sorted++) {
+        if (sorted) {
+            sort();
+        }
+        ucis_match_start(&match, table.data());
+        EXPECT_TRUE(ucis_match_char(&match, 's'));
+        EXPECT_TRUE(ucis_match_char(&match, 'n'));
+        EXPECT_TRUE(ucis_match_char(&match, 'o'));
+        EXPECT_FALSE(ucis_match_char(&match, '7'));
+        // and it carries on as if the key wasn't there
+        EXPECT_TRUE(ucis_match_char(&match, 'w'));
+        EXPECT_STREQ(ucis_match_symbol(&match)->symbol, "snow");
+    }
+}
+
+TEST_F(UcisIndex, backspace_widens_the_match_again) {
+    sort();
+    ucis_match_start(&match, table.data());
+    for (char c : std::string("snowm")) {
+        ASSERT_TRUE(ucis_match_char(&match, c));
+    }
+    ucis_match_back(&match);
+    EXPECT_STREQ(ucis_match_symbol(&match)->symbol, "snow");
+    ucis_match_back(&match);
+    EXPECT_EQ(ucis_match_symbol(&match), nullptr);
+    EXPECT_TRUE(ucis_match_char(&match, 'w'));
+    EXPECT_TRUE(ucis_match_char(&match, 'm'));
+    EXPECT_TRUE(ucis_match_char(&match, 'a'));
+    EXPECT_TRUE(ucis_match_char(&match, 'n'));
+    EXPECT_STREQ(ucis_match_symbol(&match)->symbol, "snowman");
+}
+
+TEST_F(UcisIndex, random_typing_matches_every_symbol_compared) {
+    for (int sorted = 0; sorted < 2; sorted++) {
+        if (sorted) {
+            sort();
+        }
+        srand(9);
+        for (int n = 0; n < 5000; n++) {
+            std::string text;
+            // mostly from the start of a real symbol, so the deep end gets
+            // its share too
+            const std::string& name = names[rand() % names.size()];
+            text = name.substr(0, rand() % (name.size() + 1));
+            size_t extra = rand() % 3;
+            for (size_t k = 0; k < extra; k++) {
+                text += alphabet[rand() % 36];
+            }
+
+            ucis_match_start(&match, table.data());
+            size_t accepted = 0;
+            while (accepted < text.size() && ucis_match_char(&match, text[accepted])) {
+                accepted++;
+            }
+            if (accepted < text.size()) {
+                ASSERT_FALSE(expected_prefix(text.substr(0, accepted + 1))) << text;
+            }
+            std::string typed = text.substr(0, accepted);
+            ASSERT_TRUE(expected_prefix(typed)) << text;
+            const qk_ucis_symbol_t* symbol = ucis_match_symbol(&match);
+            bool whole = std::find(names.begin(), names.end(), typed) != names.end();
+            ASSERT_EQ(symbol != NULL, whole) << typed;
+            if (symbol) {
+                EXPECT_EQ(typed, symbol->symbol);
+            }
+        }
+    }
+}
+
+template <typename F>
+static double time_lookups(F lookup, unsigned count) {
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < count; i++) {
+        lookup(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / count;
+}
+
+// Typing every symbol of the 1000 and finding it, the old way on Enter and
+// the new one as the keys come in
+TEST_F(UcisIndex, benchmark) {
+    sort();
+    std::vector<std::vector<uint16_t>> typed;
+    for (const std::string& name : names) {
+        std::vector<uint16_t> keys;
+        for (char c : name) {
+            keys.push_back(keycode(c));
+        }
+        keys.push_back(KC_ENT);
+        typed.push_back(keys);
+    }
+
+    volatile const char* sink = NULL;
+    const unsigned count = 20000;
+    size_t found = 0;
+    double linear_time = time_lookups([&](unsigned n) {
+        const std::vector<uint16_t>& keys = typed[n % typed.size()];
+        for (size_t i = 0; table[i].symbol; i++) {
+            if (linear_is_uni_seq(table[i].symbol, keys.data(), keys.size() - 1)) {
+                sink = table[i].code;
+                found++;
+                break;
+            }
+        }
+    }, count);
+    double index_time = time_lookups([&](unsigned n) {
+        const std::string& name = names[n % names.size()];
+        ucis_match_start(&match, table.data());
+        for (char c : name) {
+            ucis_match_char(&match, c);
+        }
+        sink = ucis_match_symbol(&match)->code;
+    }, count);
+    (void)sink;
+    EXPECT_EQ(found, count);
+
+    std::vector<qk_ucis_symbol_t> unsorted(table.begin(), table.end());
+    std::reverse(unsorted.begin(), unsorted.end() - 1);
+    ucis_index_init(unsorted.data());
+    double unsorted_time = time_lookups([&](unsigned n) {
+        const std::string& name = names[n % names.size()];
+        ucis_match_start(&match, unsorted.data());
+        for (char c : name) {
+            ucis_match_char(&match, c);
+        }
+        sink = ucis_match_symbol(&match)->code;
+    }, count);
+
+    printf("%zu symbols: %.0f ns per symbol comparing every entry, %.0f ns sorted, "
+           "%.0f ns unsorted\n",
+           names.size(), linear_time, index_time, unsorted_time);
+}
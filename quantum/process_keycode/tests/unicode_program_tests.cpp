@@ -0,0 +1,188 @@
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+extern "C" {
+#include "process_keycode/unicode_program.h"
+#include "keycode.h"
+
+uint16_t hex_to_keycode(uint8_t hex) {
+    if (hex == 0x0) {
+        return KC_0;
+    } else if (hex < 0xA) {
+        return KC_1 + (hex - 0x1);
+    } else {
+        return KC_A + (hex - 0xA);
+    }
+}
+}
+
+static const uint8_t modes[] = { UC_OSX, UC_LNX, UC_WIN, UC_WINC };
+static const char* mode_names[] = { "UC_OSX", "UC_LNX", "UC_WIN", "UC_BSD", "UC_WINC" };
+
+#define LALT MOD_BIT(KC_LALT)
+#define RALT MOD_BIT(KC_RALT)
+#define CTRL_SHIFT (MOD_BIT(KC_LCTL) | MOD_BIT(KC_LSFT))
+// held by whoever pressed the unicode key
+#define HELD (MOD_BIT(KC_RSFT) | MOD_BIT(KC_RGUI))
+
+static int digit(uint8_t keycode) {
+    for (int hex = 0; hex < 16; hex++) {
+        if (hex_to_keycode(hex) == keycode) {
+            return hex;
+        }
+    }
+    return -1;
+}
+
+// A key going down, with the mods held when it did
+struct press_t {
+    uint8_t mods;
+    uint8_t keycode;
+};
+
+// What the host makes of the reports, checking on the way that mods never
+// change in a report that presses a key, and that everything ends let go
+// of with the mods held before back
+static std::vector<press_t> replay(const unicode_report_t* program, uint8_t length) {
+    std::vector<press_t> presses;
+    uint8_t mods = HELD, keycode = 0;
+    for (uint8_t i = 0; i < length; i++) {
+        const unicode_report_t& report = program[i];
+        if (report.keycode && report.keycode != keycode) {
+            EXPECT_EQ(report.mods, mods) << "report " << (int)i;
+            presses.push_back({ report.mods, report.keycode });
+        }
+        mods = report.mods;
+        keycode = report.keycode;
+    }
+    EXPECT_EQ(mods, HELD);
+    EXPECT_EQ(keycode, 0);
+    return presses;
+}
+
+// Reads hex digits from presses from first on, all with mods held
+static uint32_t read_hex(const std::vector<press_t>& presses, size_t first, size_t last, uint8_t mods) {
+    uint32_t value = 0;
+    for (size_t i = first; i < last; i++) {
+        int hex = digit(presses[i].keycode);
+        EXPECT_GE(hex, 0);
+        EXPECT_EQ(presses[i].mods, mods);
+        value = value << 4 | hex;
+    }
+    return value;
+}
+
+// The code point each OS gets from the keys pressed
+static uint32_t decode(uint8_t mode, const std::vector<press_t>& presses) {
+    switch (mode) {
+    case UC_OSX: {
+        EXPECT_TRUE(presses.size() == 4 || presses.size() == 8);
+        uint32_t unit = read_hex(presses, 0, 4, LALT);
+        if (presses.size() == 8) {
+            uint32_t low = read_hex(presses, 4, 8, LALT);
+            EXPECT_GE(unit, 0xD800u);
+            EXPECT_GE(low, 0xDC00u);
+            return 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+        }
+        return unit;
+    }
+    case UC_LNX:
+        EXPECT_EQ(presses.front().keycode, KC_U);
+        EXPECT_EQ(presses.front().mods, CTRL_SHIFT);
+        EXPECT_EQ(presses.back().keycode, KC_SPC);
+        return read_hex(presses, 1, presses.size() - 1, 0);
+    case UC_WIN:
+        EXPECT_EQ(presses.front().keycode, KC_PPLS);
+        EXPECT_EQ(presses.front().mods, LALT);
+        return read_hex(presses, 1, presses.size(), LALT);
+    case UC_WINC:
+        EXPECT_EQ(presses.front().keycode, KC_U);
+        EXPECT_EQ(presses.front().mods, 0);
+        EXPECT_EQ(presses.back().keycode, KC_ENT);
+        return read_hex(presses, 1, presses.size() - 1, 0);
+    }
+    return 0;
+}
+
+// Reports unicode_input_start(), register_hex() or register_hex32() and
+// unicode_input_finish() sent, a mod or key each time one went up or down
+static unsigned reports_before(uint8_t mode, uint32_t code_point, unsigned held_mods) {
+    unsigned reports = held_mods * 2;
+    const unsigned start[] = { 1, 6, 3, 0, 4 };
+    const unsigned finish[] = { 1, 2, 1, 0, 0 };
+    unsigned digits = 4;
+    if (mode == UC_OSX && code_point > 0xFFFF) {
+        digits = 8;
+    } else {
+        while (digits < 8 && (code_point >> (digits * 4))) {
+            digits++;
+        }
+    }
+    return reports + start[mode] + digits * 2 + finish[mode];
+}
+
+TEST(UnicodeProgram, types_what_it_should) {
+    const uint32_t code_points[] = { 0x0, 0x41, 0xE9, 0x3BB, 0x2603, 0x1111, 0xFFFF, 0x10000, 0x1F4A9, 0x10FFFF };
+    unicode_report_t program[UNICODE_PROGRAM_SIZE];
+    for (uint8_t mode : modes) {
+        for (uint32_t code_point : code_points) {
+            uint8_t length = unicode_program_compile(program, code_point, mode, HELD);
+            ASSERT_GT(length, 0);
+            EXPECT_EQ(decode(mode, replay(program, length)), code_point) << mode_names[mode];
+        }
+    }
+}
+
+TEST(UnicodeProgram, every_code_point_fits) {
+    unicode_report_t program[UNICODE_PROGRAM_SIZE + 1];
+    for (uint8_t mode : modes) {
+        uint8_t longest = 0;
+        for (uint32_t code_point = 0; code_point <= 0x10FFFF; code_point++) {
+            program[UNICODE_PROGRAM_SIZE].keycode = 0xFF;
+            uint8_t length = unicode_program_compile(program, code_point, mode, 0);
+            longest = std::max(longest, length);
+            ASSERT_EQ(program[UNICODE_PROGRAM_SIZE].keycode, 0xFF);
+        }
+        EXPECT_LE(longest, UNICODE_PROGRAM_SIZE) << mode_names[mode];
+    }
+}
+
+TEST(UnicodeProgram, repeated_digits_are_let_go_of_in_between) {
+    unicode_report_t program[UNICODE_PROGRAM_SIZE];
+    uint8_t length = unicode_program_compile(program, 0x1111, UC_LNX, HELD);
+    std::vector<press_t> presses = replay(program, length);
+    EXPECT_EQ(presses.size(), 6u);
+    EXPECT_EQ(decode(UC_LNX, presses), 0x1111u);
+}
+
+TEST(UnicodeProgram, out_of_range) {
+    unicode_report_t program[UNICODE_PROGRAM_SIZE];
+    EXPECT_EQ(unicode_program_compile(program, 0x110000, UC_LNX, 0), 0);
+    EXPECT_EQ(unicode_program_compile(program, 0x41, UC_BSD, 0), 0);
+    EXPECT_FALSE(unicode_program_supported(0x110000, UC_OSX));
+    EXPECT_TRUE(unicode_program_supported(0x10FFFF, UC_OSX));
+}
+
+// Reports per code point in every mode, against unicode_input_start(),
+// register_hex() and unicode_input_finish() with two mods held
+TEST(UnicodeProgram, reports_per_code_point) {
+    const uint32_t code_points[] = { 0xE9, 0x2603, 0x1F4A9 };
+    unicode_report_t program[UNICODE_PROGRAM_SIZE];
+    printf("%-8s", "");
+    for (uint32_t code_point : code_points) {
+        printf("   U+%-5X", code_point);
+    }
+    printf("  (reports before -> now)\n");
+    for (uint8_t mode : modes) {
+        printf("%-8s", mode_names[mode]);
+        for (uint32_t code_point : code_points) {
+            uint8_t length = unicode_program_compile(program, code_point, mode, HELD);
+            unsigned before = reports_before(mode, code_point, 2);
+            EXPECT_LT(length, before);
+            printf("  %3u -> %2u", before, length);
+        }
+        printf("\n");
+    }
+}
@@ -0,0 +1,130 @@
+/* Copyright 2017 Jack Humbert
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "ucis_index.h"
+
+static const qk_ucis_symbol_t *index_table = NULL;
+static uint16_t index_count;
+static bool index_sorted;
+
+void ucis_index_init(const qk_ucis_symbol_t *table) {
+  index_table = table;
+  index_sorted = true;
+  for (index_count = 0; table[index_count].symbol; index_count++) {
+    if (index_count > 0 && strcmp(table[index_count - 1].symbol, table[index_count].symbol) > 0) {
+      index_sorted = false;
+    }
+  }
+}
+
+bool ucis_index_sorted(void) {
+  return index_sorted;
+}
+
+void ucis_match_start(ucis_match_t *match, const qk_ucis_symbol_t *table) {
+  if (table != index_table) {
+    ucis_index_init(table);
+  }
+  match->table = table;
+  match->first = 0;
+  match->last = index_count;
+  match->length = 0;
+}
+
+// The first symbol in [first, last) whose character at position is past c,
+// or isn't below it if inclusive is false
+static uint16_t search(const qk_ucis_symbol_t *table, uint16_t first, uint16_t last, uint8_t position, char c, bool inclusive) {
+  while (first < last) {
+    uint16_t middle = first + (last - first) / 2;
+    unsigned char s = table[middle].symbol[position];
+    if (s < (unsigned char)c || (inclusive && s == (unsigned char)c)) {
+      first = middle + 1;
+    } else {
+      last = middle;
+    }
+  }
+  return first;
+}
+
+bool ucis_match_char(ucis_match_t *match, char c) {
+  if (c == 0 || match->length >= UCIS_MAX_SYMBOL_LENGTH - 1) {
+    return false;
+  }
+  const qk_ucis_symbol_t *table = match->table;
+  uint8_t position = match->length;
+
+  if (index_sorted) {
+    // everything in the range shares the characters so far, so it's
+    // sorted by the one that comes next
+    uint16_t first = search(table, match->first, match->last, position, c, false);
+    uint16_t last = search(table, first, match->last, position, c, true);
+    if (first >= last) {
+      return false;
+    }
+    match->first = first;
+    match->last = last;
+  } else {
+    // the range is whatever lies between the first and the last symbol
+    // that still fits
+    uint16_t first = match->last, last = match->first;
+    for (uint16_t i = match->first; i < match->last; i++) {
+      if (strncmp(table[i].symbol, match->typed, position) == 0 && table[i].symbol[position] == c) {
+        if (first > i) {
+          first = i;
+        }
+        last = i + 1;
+      }
+    }
+    if (first >= last) {
+      return false;
+    }
+    match->first = first;
+    match->last = last;
+  }
+  match->typed[position] = c;
+  match->length++;
+  return true;
+}
+
+void ucis_match_back(ucis_match_t *match) {
+  if (match->length == 0) {
+    return;
+  }
+  uint8_t length = match->length - 1;
+  ucis_match_start(match, match->table);
+  for (uint8_t i = 0; i < length; i++) {
+    ucis_match_char(match, match->typed[i]);
+  }
+}
+
+const qk_ucis_symbol_t *ucis_match_symbol(ucis_match_t *match) {
+  match->typed[match->length] = 0;
+  if (index_sorted) {
+    // a symbol that ends here sorts first
+    if (match->first < match->last && match->table[match->first].symbol[match->length] == 0) {
+      return &match->table[match->first];
+    }
+    return NULL;
+  }
+  for (uint16_t i = match->first; i < match->last; i++) {
+    if (strcmp(match->table[i].symbol, match->typed) == 0) {
+      return &match->table[i];
+    }
+  }
+  return NULL;
+}
@@ -0,0 +1,61 @@
+/* Copyright 2017 Jack Humbert
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UCIS_INDEX_H
+#define UCIS_INDEX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Matching UCIS symbols as they are typed
+ *
+ * A symbol table sorted by name is its own index: the symbols starting
+ * with what was typed so far are a range of it, and every character
+ * narrows that range with a binary search. A table that isn't sorted
+ * still works, with a scan over what is left of it per character.
+ */
+
+#ifndef UCIS_MAX_SYMBOL_LENGTH
+#define UCIS_MAX_SYMBOL_LENGTH 32
+#endif
+
+typedef struct {
+  char *symbol;
+  char *code;
+} qk_ucis_symbol_t;
+
+typedef struct {
+  const qk_ucis_symbol_t *table;
+  uint16_t first;
+  uint16_t last;    // one past
+  uint8_t  length;
+  char     typed[UCIS_MAX_SYMBOL_LENGTH];
+} ucis_match_t;
+
+// Counts the table and checks whether it is sorted
+void ucis_index_init(const qk_ucis_symbol_t *table);
+bool ucis_index_sorted(void);
+
+void ucis_match_start(ucis_match_t *match, const qk_ucis_symbol_t *table);
+// Returns false, and leaves the match as it was, if no symbol starts with
+// the characters typed followed by c
+bool ucis_match_char(ucis_match_t *match, char c);
+void ucis_match_back(ucis_match_t *match);
+// The symbol typed, or NULL
+const qk_ucis_symbol_t *ucis_match_symbol(ucis_match_t *match);
+
+#endif
@@ -0,0 +1,108 @@
+/* Copyright 2017 Jack Humbert
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "unicode_program.h"
+#include "keycode.h"
+
+typedef struct {
+  unicode_report_t *program;
+  uint8_t length;
+} builder_t;
+
+static void report(builder_t *builder, uint8_t mods, uint8_t keycode) {
+  builder->program[builder->length].mods = mods;
+  builder->program[builder->length].keycode = keycode;
+  builder->length++;
+}
+
+// Presses keycode and lets go of the key before it, which has to be let
+// go of on its own if it's the same one
+static void press(builder_t *builder, uint8_t mods, uint8_t keycode) {
+  if (builder->length > 0 && builder->program[builder->length - 1].keycode == keycode) {
+    report(builder, mods, 0);
+  }
+  report(builder, mods, keycode);
+}
+
+// At least digits hex digits, leading zeros left out past that
+static void hex(builder_t *builder, uint8_t mods, uint32_t value, int8_t digits) {
+  int8_t i = 7;
+  while (i >= digits && ((value >> (i * 4)) & 0xF) == 0) {
+    i--;
+  }
+  for (; i >= 0; i--) {
+    press(builder, mods, hex_to_keycode((value >> (i * 4)) & 0xF));
+  }
+}
+
+bool unicode_program_supported(uint32_t code_point, uint8_t mode) {
+  if (code_point > 0x10FFFF) {
+    return false;
+  }
+  switch (mode) {
+  case UC_OSX:
+  case UC_LNX:
+  case UC_WIN:
+  case UC_WINC:
+    return true;
+  }
+  return false;
+}
+
+uint8_t unicode_program_compile(unicode_report_t *program, uint32_t code_point, uint8_t mode, uint8_t mods) {
+  builder_t builder = { program, 0 };
+
+  if (!unicode_program_supported(code_point, mode)) {
+    return 0;
+  }
+
+  switch (mode) {
+  case UC_OSX:
+    // Unicode Hex Input takes UTF-16, four digits at a time
+    report(&builder, MOD_BIT(KC_LALT), 0);
+    if (code_point > 0xFFFF) {
+      code_point -= 0x10000;
+      hex(&builder, MOD_BIT(KC_LALT), 0xD800 + (code_point >> 10), 4);
+      hex(&builder, MOD_BIT(KC_LALT), 0xDC00 + (code_point & 0x3FF), 4);
+    } else {
+      hex(&builder, MOD_BIT(KC_LALT), code_point, 4);
+    }
+    break;
+  case UC_LNX:
+    report(&builder, MOD_BIT(KC_LCTL) | MOD_BIT(KC_LSFT), 0);
+    press(&builder, MOD_BIT(KC_LCTL) | MOD_BIT(KC_LSFT), KC_U);
+    report(&builder, 0, 0);
+    hex(&builder, 0, code_point, 1);
+    press(&builder, 0, KC_SPC);
+    break;
+  case UC_WIN:
+    report(&builder, MOD_BIT(KC_LALT), 0);
+    press(&builder, MOD_BIT(KC_LALT), KC_PPLS);
+    hex(&builder, MOD_BIT(KC_LALT), code_point, 1);
+    break;
+  case UC_WINC:
+    report(&builder, MOD_BIT(KC_RALT), 0);
+    report(&builder, 0, 0);
+    press(&builder, 0, KC_U);
+    hex(&builder, 0, code_point, 1);
+    press(&builder, 0, KC_ENT);
+    break;
+  }
+
+  // lets go of the last key as well
+  report(&builder, mods, 0);
+  return builder.length;
+}
@@ -0,0 +1,55 @@
+/* Copyright 2017 Jack Humbert
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UNICODE_PROGRAM_H
+#define UNICODE_PROGRAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Keystroke programs for unicode input
+ *
+ * A code point becomes the list of reports that types it in one input
+ * mode, worked out in full before the first one is sent. Modifiers only
+ * change in reports of their own, and the mods held before are put back
+ * in one report at the end. A hex digit is pressed in the same report
+ * that lets go of the one before, unless they're the same key.
+ */
+
+#define UC_OSX 0  // Mac OS X
+#define UC_LNX 1  // Linux
+#define UC_WIN 2  // Windows 'HexNumpad'
+#define UC_BSD 3  // BSD (not implemented)
+#define UC_WINC 4 // WinCompose https://github.com/samhocevar/wincompose
+
+// Longest program, a code point past U+FFFF in surrogates on OS X
+#define UNICODE_PROGRAM_SIZE 20
+
+typedef struct {
+  uint8_t mods;
+  uint8_t keycode;
+} unicode_report_t;
+
+// Keys typing hex digits, keymaps can choose their own
+uint16_t hex_to_keycode(uint8_t hex);
+
+bool unicode_program_supported(uint32_t code_point, uint8_t mode);
+// Fills program with the reports that type code_point with mods held
+// before, and returns how many there are, 0 if it can't be typed
+uint8_t unicode_program_compile(unicode_report_t *program, uint32_t code_point, uint8_t mode, uint8_t mods);
+
+#endif
@@ -118,6 +118,7 @@ void reset_keyboard(void) {
   music_all_notes_off();
   shutdown_user();
 #endif
+  eeconfig_commit();
   wait_ms(250);
 #ifdef CATERINA_BOOTLOADER
   *(uint16_t *)0x0800 = 0x7777; // these two are a-star-specific
@@ -143,6 +144,10 @@ bool process_record_quantum(keyrecord_t *record) {
   keypos_t key = record->event.key;
   uint16_t keycode;
 
+  #ifdef RGB_REACTIVE_ENABLE
+    rgb_reactive_key_event(key.row, key.col, record->event.pressed);
+  #endif
+
   #if !defined(NO_ACTION_LAYER) && defined(PREVENT_STUCK_MODIFIERS)
     /* TODO: Use store_or_get_action() or a similar function. */
     if (!disable_action_cache) {
@@ -184,9 +189,12 @@ bool process_record_quantum(keyrecord_t *record) {
   #ifndef DISABLE_LEADER
     process_leader(keycode, record) &&
   #endif
-  #ifndef DISABLE_CHORDING
+  #ifdef CHORDING_ENABLE
     process_chording(keycode, record) &&
   #endif
+  #ifdef STENO_ENABLE
+    process_steno(keycode, record) &&
+  #endif
   #ifdef COMBO_ENABLE
     process_combo(keycode, record) &&
   #endif
@@ -615,6 +623,14 @@ void matrix_scan_quantum() {
     matrix_scan_combo();
   #endif
 
+  #if !defined(DISABLE_LEADER) && LEADER_DICTIONARY_SIZE > 0
+    matrix_scan_leader();
+  #endif
+
+  #ifdef CHORDING_ENABLE
+    matrix_scan_chording();
+  #endif
+
   #if defined(BACKLIGHT_ENABLE) && defined(BACKLIGHT_PIN)
     backlight_task();
   #endif
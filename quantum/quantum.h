@@ -30,6 +30,9 @@
 #ifdef RGBLIGHT_ENABLE
   #include "rgblight.h"
 #endif
+#ifdef RGB_REACTIVE_ENABLE
+  #include "rgb_reactive/rgb_reactive.h"
+#endif
 #include "action_layer.h"
 #include "eeconfig.h"
 #include <stddef.h>
@@ -67,11 +70,14 @@ extern uint32_t default_layer_state;
 	#include "process_leader.h"
 #endif
 
-#define DISABLE_CHORDING
-#ifndef DISABLE_CHORDING
+#ifdef CHORDING_ENABLE
 	#include "process_chording.h"
 #endif
 
+#ifdef STENO_ENABLE
+	#include "process_steno.h"
+#endif
+
 #ifdef UNICODE_ENABLE
 	#include "process_unicode.h"
 #endif
@@ -0,0 +1,201 @@
+#include "rgb_reactive.h"
+#include "color/color.h"
+
+typedef struct {
+    uint8_t led;
+    uint8_t level;
+} spot_t;
+
+typedef struct {
+    uint8_t origin;
+    uint8_t radius;
+} ripple_t;
+
+// The lit LEDs, in no particular order
+static spot_t spots[RGB_REACTIVE_MAX_ACTIVE];
+static uint8_t spot_count;
+static ripple_t ripples[RGB_REACTIVE_RIPPLES];
+static uint8_t ripple_count;
+
+static uint8_t effect = RGB_REACTIVE_EFFECT;
+static uint8_t hue = RGB_REACTIVE_HUE;
+static uint16_t last_update;
+static bool changed;
+
+void rgb_reactive_init(void) {
+    spot_count = 0;
+    ripple_count = 0;
+    changed = true;
+}
+
+void rgb_reactive_set_effect(uint8_t new_effect) {
+    if (new_effect < RGB_REACTIVE_EFFECTS && new_effect != effect) {
+        effect = new_effect;
+        rgb_reactive_init();
+    }
+}
+
+uint8_t rgb_reactive_get_effect(void) {
+    return effect;
+}
+
+void rgb_reactive_set_hue(uint8_t new_hue) {
+    hue = new_hue;
+    changed = true;
+}
+
+uint8_t rgb_reactive_active_count(void) {
+    return spot_count;
+}
+
+static spot_t* get_spot(uint8_t led) {
+    uint8_t faintest = 0;
+    for (uint8_t i = 0; i < spot_count; i++) {
+        if (spots[i].led == led) {
+            return &spots[i];
+        }
+        if (spots[i].level < spots[faintest].level) {
+            faintest = i;
+        }
+    }
+    spot_t* spot = spot_count < RGB_REACTIVE_MAX_ACTIVE ? &spots[spot_count++] : &spots[faintest];
+    spot->led = led;
+    spot->level = 0;
+    return spot;
+}
+
+static void light(uint8_t led, uint8_t level) {
+    spot_t* spot = get_spot(led);
+    if (spot->level < level) {
+        spot->level = level;
+    }
+}
+
+static void heat(uint8_t led) {
+    spot_t* spot = get_spot(led);
+    spot->level = spot->level > 255 - RGB_REACTIVE_HEAT_STEP ? 255 : spot->level + RGB_REACTIVE_HEAT_STEP;
+}
+
+static void start_ripple(uint8_t led) {
+    ripple_t* ripple;
+    if (ripple_count < RGB_REACTIVE_RIPPLES) {
+        ripple = &ripples[ripple_count++];
+    } else {
+        // the oldest ring is the widest one
+        ripple = &ripples[0];
+        for (uint8_t i = 1; i < ripple_count; i++) {
+            if (ripples[i].radius > ripple->radius) {
+                ripple = &ripples[i];
+            }
+        }
+    }
+    ripple->origin = led;
+    ripple->radius = 0;
+}
+
+void rgb_reactive_key_event(uint8_t row, uint8_t col, bool pressed) {
+    if (!pressed) {
+        return;
+    }
+    uint8_t led = pgm_read_byte(&rgb_reactive_key_leds[row][col]);
+    if (led >= RGBLED_NUM) {
+        return;
+    }
+    switch (effect) {
+        case RGB_REACTIVE_FADE:
+            light(led, 255);
+            break;
+        case RGB_REACTIVE_RIPPLE:
+            light(led, 255);
+            start_ripple(led);
+            break;
+        case RGB_REACTIVE_HEATMAP:
+            heat(led);
+            break;
+    }
+    // shown with the next update, so a burst of presses costs one frame
+    changed = true;
+}
+
+// Widens a ring by one LED, returns false once it has faded out or left
+// the strip on both sides
+static bool move_ripple(ripple_t* ripple) {
+    ripple->radius++;
+    uint16_t fade = ripple->radius * RGB_REACTIVE_RIPPLE_FADE;
+    if (fade >= 255) {
+        return false;
+    }
+    bool visible = false;
+    if (ripple->origin >= ripple->radius) {
+        light(ripple->origin - ripple->radius, 255 - fade);
+        visible = true;
+    }
+    if (ripple->origin + ripple->radius < RGBLED_NUM) {
+        light(ripple->origin + ripple->radius, 255 - fade);
+        visible = true;
+    }
+    return visible;
+}
+
+bool rgb_reactive_update(uint16_t now) {
+    uint16_t elapsed = now - last_update;
+    if (elapsed < RGB_REACTIVE_INTERVAL) {
+        return false;
+    }
+    uint8_t ticks = 0;
+    while (elapsed >= RGB_REACTIVE_INTERVAL && ticks < 255) {
+        elapsed -= RGB_REACTIVE_INTERVAL;
+        ticks++;
+    }
+    last_update = ticks < 255 ? now - elapsed : now;
+
+    if (spot_count == 0 && ripple_count == 0) {
+        bool result = changed;
+        changed = false;
+        return result;
+    }
+
+    uint16_t loss = ticks * (effect == RGB_REACTIVE_HEATMAP ? RGB_REACTIVE_COOL_STEP : RGB_REACTIVE_FADE_STEP);
+    for (uint8_t i = 0; i < spot_count;) {
+        if (spots[i].level <= loss) {
+            spots[i] = spots[--spot_count];
+        } else {
+            spots[i].level -= loss;
+            i++;
+        }
+    }
+    // rings move after the decay, so their front is at full strength
+    for (uint8_t i = 0; i < ripple_count;) {
+        bool alive = true;
+        for (uint8_t t = 0; t < ticks && alive; t++) {
+            alive = move_ripple(&ripples[i]);
+        }
+        if (alive) {
+            i++;
+        } else {
+            ripples[i] = ripples[--ripple_count];
+        }
+    }
+    changed = false;
+    return true;
+}
+
+void rgb_reactive_draw(LED_TYPE *frame, uint8_t val) {
+    for (uint8_t i = 0; i < spot_count; i++) {
+        uint8_t level = spots[i].level;
+        rgb_t color;
+        uint8_t alpha;
+        if (effect == RGB_REACTIVE_HEATMAP) {
+            // from blue when cold to red when hot
+            color = hsv_to_rgb(170 - ((170 * level) >> 8), 255, val);
+            alpha = level < 64 ? level * 4 : 255;
+        } else {
+            color = hsv_to_rgb(hue, 255, val);
+            alpha = level;
+        }
+        LED_TYPE *led = &frame[spots[i].led];
+        led->r = blend8(led->r, color.r, alpha);
+        led->g = blend8(led->g, color.g, alpha);
+        led->b = blend8(led->b, color.b, alpha);
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef RGB_REACTIVE_H
+#define RGB_REACTIVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "matrix.h"
+#include "progmem.h"
+#include "light_ws2812.h"
+
+/*
+ * Reactive lighting
+ *
+ * Key presses light up the LED under the key, and the light then fades
+ * away. Only the LEDs that are still lit are kept in a list, so the work
+ * per update depends on how many LEDs are active, not on the length of the
+ * strip. Updates happen at most every RGB_REACTIVE_INTERVAL ms however
+ * fast the keys come in.
+ *
+ * The keyboard maps its keys to LEDs with
+ *
+ *   const uint8_t PROGMEM rgb_reactive_key_leds[MATRIX_ROWS][MATRIX_COLS]
+ *
+ * using RGB_REACTIVE_NO_LED for keys without one. With rgblight the effect
+ * is drawn as an overlay on top of the current mode.
+ */
+
+#define RGB_REACTIVE_NO_LED 0xFF
+
+// Effects
+#define RGB_REACTIVE_FADE    0  // the key lights up and fades
+#define RGB_REACTIVE_RIPPLE  1  // a ring of light runs away from the key
+#define RGB_REACTIVE_HEATMAP 2  // keys warm up from blue to red as they are used
+#define RGB_REACTIVE_EFFECTS 3
+
+#ifndef RGB_REACTIVE_EFFECT
+#define RGB_REACTIVE_EFFECT RGB_REACTIVE_FADE
+#endif
+
+// ms between two updates
+#ifndef RGB_REACTIVE_INTERVAL
+#define RGB_REACTIVE_INTERVAL 16
+#endif
+
+// LEDs lit at the same time, the faintest one makes room for a new one
+#ifndef RGB_REACTIVE_MAX_ACTIVE
+#define RGB_REACTIVE_MAX_ACTIVE 16
+#endif
+
+// Brightness lost per update
+#ifndef RGB_REACTIVE_FADE_STEP
+#define RGB_REACTIVE_FADE_STEP 16
+#endif
+
+#ifndef RGB_REACTIVE_RIPPLES
+#define RGB_REACTIVE_RIPPLES 4
+#endif
+// Brightness the ring loses for every LED it moves
+#ifndef RGB_REACTIVE_RIPPLE_FADE
+#define RGB_REACTIVE_RIPPLE_FADE 8
+#endif
+
+// Heat gained per press and lost per update
+#ifndef RGB_REACTIVE_HEAT_STEP
+#define RGB_REACTIVE_HEAT_STEP 48
+#endif
+#ifndef RGB_REACTIVE_COOL_STEP
+#define RGB_REACTIVE_COOL_STEP 1
+#endif
+
+// Color of fade and ripple, on the 256 step hue wheel
+#ifndef RGB_REACTIVE_HUE
+#define RGB_REACTIVE_HUE 0
+#endif
+
+extern const uint8_t PROGMEM rgb_reactive_key_leds[MATRIX_ROWS][MATRIX_COLS];
+
+void rgb_reactive_init(void);
+void rgb_reactive_set_effect(uint8_t effect);
+uint8_t rgb_reactive_get_effect(void);
+void rgb_reactive_set_hue(uint8_t hue);
+
+// Called for every key event, from process_record_quantum
+void rgb_reactive_key_event(uint8_t row, uint8_t col, bool pressed);
+// Moves the effect forward to now, returns true when the LEDs changed
+bool rgb_reactive_update(uint16_t now);
+// Draws the lit LEDs over frame, at brightness val
+void rgb_reactive_draw(LED_TYPE *frame, uint8_t val);
+
+uint8_t rgb_reactive_active_count(void);
+
+#endif
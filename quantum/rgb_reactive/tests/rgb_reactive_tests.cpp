@@ -0,0 +1,160 @@
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+extern "C" {
+#include "rgb_reactive/rgb_reactive.h"
+}
+
+// A 2x8 board with one LED under every key, left to right and top to
+// bottom
+extern "C" const uint8_t rgb_reactive_key_leds[MATRIX_ROWS][MATRIX_COLS] = {
+    { 0, 1, 2, 3, 4, 5, 6, 7 },
+    { 8, 9, 10, 11, 12, 13, 14, RGB_REACTIVE_NO_LED },
+};
+
+// Runs the effect and keeps every frame it draws, for checking and for
+// dumping as text and as a PPM image with one line of pixels per frame
+class RgbReactive : public testing::Test {
+public:
+    RgbReactive() : now(0) {
+        rgb_reactive_set_effect(RGB_REACTIVE_FADE);
+        rgb_reactive_init();
+        rgb_reactive_update(now);
+        while (rgb_reactive_update(now += RGB_REACTIVE_INTERVAL));
+        frames.clear();
+    }
+
+    void press(uint8_t row, uint8_t col) {
+        rgb_reactive_key_event(row, col, true);
+        rgb_reactive_key_event(row, col, false);
+    }
+
+    // Advances time by one update and records the frame if it changed
+    bool step() {
+        now += RGB_REACTIVE_INTERVAL;
+        if (!rgb_reactive_update(now)) {
+            return false;
+        }
+        std::vector<LED_TYPE> frame(RGBLED_NUM);
+        memset(frame.data(), 0, sizeof(LED_TYPE) * RGBLED_NUM);
+        rgb_reactive_draw(frame.data(), 255);
+        frames.push_back(frame);
+        return true;
+    }
+
+    static unsigned brightness(const LED_TYPE& led) {
+        return std::max(led.r, std::max(led.g, led.b));
+    }
+
+    std::string text() const {
+        static const char shades[] = " .:-=+*#%@";
+        std::string result;
+        for (const auto& frame : frames) {
+            for (const auto& led : frame) {
+                result += shades[brightness(led) * 9 / 255];
+            }
+            result += "\n";
+        }
+        return result;
+    }
+
+    void dump(const char* name) const {
+        printf("%s:\n%s", name, text().c_str());
+        std::string path = std::string(".build/rgb_reactive_") + name + ".ppm";
+        FILE* file = fopen(path.c_str(), "w");
+        if (!file) {
+            return;
+        }
+        fprintf(file, "P3\n%d %zu\n255\n", RGBLED_NUM, frames.size());
+        for (const auto& frame : frames) {
+            for (const auto& led : frame) {
+                fprintf(file, "%u %u %u ", led.r, led.g, led.b);
+            }
+            fprintf(file, "\n");
+        }
+        fclose(file);
+    }
+
+    uint16_t now;
+    std::vector<std::vector<LED_TYPE>> frames;
+};
+
+TEST_F(RgbReactive, fade_lights_the_key_and_goes_dark) {
+    press(0, 3);
+    EXPECT_TRUE(step());
+    EXPECT_GT(brightness(frames[0][3]), 200u);
+    EXPECT_EQ(brightness(frames[0][2]), 0u);
+    while (step());
+    dump("fade");
+    EXPECT_EQ(rgb_reactive_active_count(), 0);
+    for (unsigned i = 1; i < frames.size(); i++) {
+        EXPECT_LE(brightness(frames[i][3]), brightness(frames[i - 1][3]));
+    }
+    EXPECT_EQ(brightness(frames.back()[3]), 0u);
+    EXPECT_EQ(frames.size(), 255 / RGB_REACTIVE_FADE_STEP + 1);
+}
+
+TEST_F(RgbReactive, a_burst_of_presses_is_one_frame) {
+    for (uint8_t col = 0; col < 8; col++) {
+        press(0, col);
+        EXPECT_FALSE(rgb_reactive_update(now + RGB_REACTIVE_INTERVAL - 1));
+    }
+    EXPECT_TRUE(step());
+    EXPECT_EQ(frames.size(), 1u);
+    for (uint8_t col = 0; col < 8; col++) {
+        EXPECT_GT(brightness(frames[0][col]), 200u);
+    }
+}
+
+TEST_F(RgbReactive, keys_without_an_led_are_ignored) {
+    press(1, 7);
+    EXPECT_FALSE(step());
+    EXPECT_EQ(rgb_reactive_active_count(), 0);
+}
+
+TEST_F(RgbReactive, the_active_list_is_bounded) {
+    for (uint8_t row = 0; row < 2; row++) {
+        for (uint8_t col = 0; col < 7; col++) {
+            press(row, col);
+        }
+    }
+    EXPECT_EQ(rgb_reactive_active_count(), RGB_REACTIVE_MAX_ACTIVE);
+}
+
+TEST_F(RgbReactive, ripple_moves_away_from_the_key) {
+    rgb_reactive_set_effect(RGB_REACTIVE_RIPPLE);
+    press(1, 0);
+    while (step());
+    dump("ripple");
+    ASSERT_GE(frames.size(), 4u);
+    // after n updates the front of the ring is n LEDs away on both sides,
+    // brighter than the trail behind it
+    for (unsigned n = 1; n < 4; n++) {
+        const auto& frame = frames[n - 1];
+        EXPECT_EQ(brightness(frame[8 - n - 1]), 0u);
+        EXPECT_EQ(brightness(frame[8 + n + 1]), 0u);
+        EXPECT_GT(brightness(frame[8 - n]), brightness(frame[8 - n + 1]));
+        EXPECT_GT(brightness(frame[8 + n]), brightness(frame[8 + n - 1]));
+    }
+    EXPECT_EQ(rgb_reactive_active_count(), 0);
+}
+
+TEST_F(RgbReactive, heatmap_warms_up_with_use) {
+    rgb_reactive_set_effect(RGB_REACTIVE_HEATMAP);
+    press(0, 0);
+    for (int i = 0; i < 5; i++) {
+        press(0, 5);
+    }
+    step();
+    for (int i = 0; i < 40; i++) {
+        step();
+    }
+    dump("heatmap");
+    const auto& cold = frames[0][0];
+    const auto& hot = frames[0][5];
+    EXPECT_GT(cold.b, cold.r);
+    EXPECT_GT(hot.r, hot.b);
+    EXPECT_EQ(rgb_reactive_active_count(), 2);
+}
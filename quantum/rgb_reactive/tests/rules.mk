@@ -0,0 +1,5 @@
+rgb_reactive_DEFS := -DMATRIX_ROWS=2 -DMATRIX_COLS=8 -DRGBLED_NUM=16 -DRGB_REACTIVE_MAX_ACTIVE=8
+rgb_reactive_SRC :=\
+	$(QUANTUM_PATH)/rgb_reactive/tests/rgb_reactive_tests.cpp \
+	$(QUANTUM_PATH)/rgb_reactive/rgb_reactive.c \
+	$(QUANTUM_PATH)/color/color.c
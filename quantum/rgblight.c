@@ -13,14 +13,21 @@
  * You should have received a copy of the GNU General Public License
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
-#include <avr/eeprom.h>
-#include <avr/interrupt.h>
-#include <util/delay.h>
+#include <string.h>
 #include "progmem.h"
+#include "wait.h"
 #include "timer.h"
 #include "rgblight.h"
 #include "debug.h"
+#include "led.h"
+#include "host.h"
+#include "action_layer.h"
+#include "util.h"
 #include "led_tables.h"
+#include "color/color.h"
+#ifdef RGB_REACTIVE_ENABLE
+  #include "rgb_reactive/rgb_reactive.h"
+#endif
 
 
 __attribute__ ((weak))
@@ -43,55 +50,87 @@ LED_TYPE led[RGBLED_NUM];
 uint8_t rgblight_inited = 0;
 bool rgblight_timer_enabled = false;
 
-void sethsv(uint16_t hue, uint8_t sat, uint8_t val, LED_TYPE *led1) {
-  uint8_t r = 0, g = 0, b = 0, base, color;
+// led[] with the overlays drawn over it, and what the LEDs currently show
+static LED_TYPE composed[RGBLED_NUM];
+static LED_TYPE committed[RGBLED_NUM];
+static bool committed_valid = false;
+static bool frame_pending = false;
+static uint16_t last_frame_timer = 0;
+static uint16_t last_compose_timer = 0;
 
-  if (sat == 0) { // Acromatic color (gray). Hue doesn't mind.
-    r = val;
-    g = val;
-    b = val;
-  } else {
-    base = ((255 - sat) * val) >> 8;
-    color = (val - base) * (hue % 60) / 60;
-
-    switch (hue / 60) {
-      case 0:
-        r = val;
-        g = base + color;
-        b = base;
-        break;
-      case 1:
-        r = val - color;
-        g = val;
-        b = base;
-        break;
-      case 2:
-        r = base;
-        g = val;
-        b = base + color;
-        break;
-      case 3:
-        r = base;
-        g = val - color;
-        b = val;
-        break;
-      case 4:
-        r = base + color;
-        g = base;
-        b = val;
-        break;
-      case 5:
-        r = val;
-        g = base;
-        b = val - color;
-        break;
+static rgblight_overlay_t overlays[RGBLIGHT_OVERLAYS];
+static uint8_t overlay_count = 0;
+
+uint16_t rgblight_frames_sent = 0;
+uint16_t rgblight_frames_skipped = 0;
+// Set while rgblight_task recomposes the overlays on their own, which
+// doesn't count as a frame
+static bool overlay_refresh = false;
+
+#ifdef RGBLIGHT_ANIMATIONS
+static void rgblight_effects_task(void);
+#endif
+
+static void rgblight_effect_static_light(uint8_t variant);
+#ifdef RGBLIGHT_ANIMATIONS
+static void rgblight_effect_static_gradient(uint8_t variant);
+static void rgblight_effect_christmas_variant(uint8_t variant);
+#  define ANIMATION(effect) effect
+#else
+#  define ANIMATION(effect) NULL
+#endif
+
+// Effect flags
+#define EFFECT_ANIMATED   (1<<0)
+// hue or val changes only update the config, the effect cycles through them
+#define EFFECT_HUE_CYCLES (1<<1)
+#define EFFECT_VAL_CYCLES (1<<2)
+
+typedef struct {
+  uint8_t variants;
+  uint8_t flags;
+  // draws the first frame of a static effect, or the next frame of an
+  // animated one
+  void (*draw)(uint8_t variant);
+} rgblight_effect_t;
+
+// The effects in mode order, each one taking as many modes as it has
+// variants (speeds or directions)
+static const rgblight_effect_t PROGMEM rgblight_effects[] = {
+  { 1,  0,                                   rgblight_effect_static_light },                 // 1
+  { 4,  EFFECT_ANIMATED | EFFECT_VAL_CYCLES, ANIMATION(rgblight_effect_breathing) },         // 2-5
+  { 3,  EFFECT_ANIMATED | EFFECT_HUE_CYCLES, ANIMATION(rgblight_effect_rainbow_mood) },      // 6-8
+  { 6,  EFFECT_ANIMATED | EFFECT_HUE_CYCLES, ANIMATION(rgblight_effect_rainbow_swirl) },     // 9-14
+  { 6,  EFFECT_ANIMATED,                     ANIMATION(rgblight_effect_snake) },             // 15-20
+  { 3,  EFFECT_ANIMATED,                     ANIMATION(rgblight_effect_knight) },            // 21-23
+  { 1,  EFFECT_ANIMATED,                     ANIMATION(rgblight_effect_christmas_variant) }, // 24
+  { 10, 0,                                   ANIMATION(rgblight_effect_static_gradient) },   // 25-34
+};
+
+// Looks up the effect of a mode, and the variant of it the mode selects
+static void rgblight_find_effect(uint8_t mode, rgblight_effect_t *effect, uint8_t *variant) {
+  uint8_t first = 1;
+  for (uint8_t i = 0; i < sizeof(rgblight_effects) / sizeof(rgblight_effects[0]); i++) {
+    memcpy_P(effect, &rgblight_effects[i], sizeof(*effect));
+    if (mode < first + effect->variants) {
+      *variant = mode - first;
+      return;
     }
+    first += effect->variants;
   }
-  r = pgm_read_byte(&CIE1931_CURVE[r]);
-  g = pgm_read_byte(&CIE1931_CURVE[g]);
-  b = pgm_read_byte(&CIE1931_CURVE[b]);
+  memcpy_P(effect, &rgblight_effects[0], sizeof(*effect));
+  *variant = 0;
+}
+
+static void sethsv8(uint8_t hue, uint8_t sat, uint8_t val, LED_TYPE *led1) {
+  rgb_t rgb = hsv_to_rgb(hue, sat, val);
+  setrgb(pgm_read_byte(&CIE1931_CURVE[rgb.r]),
+         pgm_read_byte(&CIE1931_CURVE[rgb.g]),
+         pgm_read_byte(&CIE1931_CURVE[rgb.b]), led1);
+}
 
-  setrgb(r, g, b, led1);
+void sethsv(uint16_t hue, uint8_t sat, uint8_t val, LED_TYPE *led1) {
+  sethsv8(HUE_360_TO_8(hue), sat, val, led1);
 }
 
 void setrgb(uint8_t r, uint8_t g, uint8_t b, LED_TYPE *led1) {
@@ -102,10 +141,12 @@ void setrgb(uint8_t r, uint8_t g, uint8_t b, LED_TYPE *led1) {
 
 
 uint32_t eeconfig_read_rgblight(void) {
-  return eeprom_read_dword(EECONFIG_RGBLIGHT);
+  uint32_t val;
+  eeconfig_read_cached(EECONFIG_RGBLIGHT, &val, sizeof(val));
+  return val;
 }
 void eeconfig_update_rgblight(uint32_t val) {
-  eeprom_update_dword(EECONFIG_RGBLIGHT, val);
+  eeconfig_update_cached(EECONFIG_RGBLIGHT, &val, sizeof(val));
 }
 void eeconfig_update_rgblight_default(void) {
   dprintf("eeconfig_update_rgblight_default\n");
@@ -125,9 +166,47 @@ void eeconfig_debug_rgblight(void) {
   dprintf("rgblight_config.val = %d\n", rgblight_config.val);
 }
 
+#ifdef RGBLIGHT_CAPS_LOCK_LED
+// Lights RGBLIGHT_CAPS_LOCK_LED while caps lock is on
+static void rgblight_overlay_caps_lock(LED_TYPE *frame) {
+  if (host_keyboard_leds() & (1<<USB_LED_CAPS_LOCK)) {
+    sethsv(RGBLIGHT_CAPS_LOCK_HUE, 255, rgblight_config.val, &frame[RGBLIGHT_CAPS_LOCK_LED]);
+  }
+}
+#endif
+
+#if defined(RGBLIGHT_LAYER_INDICATOR_LED) && !defined(NO_ACTION_LAYER)
+// Shows the highest active layer on RGBLIGHT_LAYER_INDICATOR_LED, in a hue
+// of its own for every layer
+static void rgblight_overlay_layer_indicator(LED_TYPE *frame) {
+  uint8_t layer = biton32(layer_state);
+  if (layer) {
+    sethsv8(layer * RGBLIGHT_LAYER_INDICATOR_HUE_STEP, 255, rgblight_config.val, &frame[RGBLIGHT_LAYER_INDICATOR_LED]);
+  }
+}
+#endif
+
+#ifdef RGB_REACTIVE_ENABLE
+static void rgblight_overlay_reactive(LED_TYPE *frame) {
+  rgb_reactive_draw(frame, rgblight_config.val);
+}
+#endif
+
 void rgblight_init(void) {
   debug_enable = 1; // Debug ON!
   dprintf("rgblight_init called.\n");
+  if (!rgblight_inited) {
+    #ifdef RGBLIGHT_CAPS_LOCK_LED
+      rgblight_add_overlay(rgblight_overlay_caps_lock);
+    #endif
+    #if defined(RGBLIGHT_LAYER_INDICATOR_LED) && !defined(NO_ACTION_LAYER)
+      rgblight_add_overlay(rgblight_overlay_layer_indicator);
+    #endif
+    #ifdef RGB_REACTIVE_ENABLE
+      rgb_reactive_init();
+      rgblight_add_overlay(rgblight_overlay_reactive);
+    #endif
+  }
   rgblight_inited = 1;
   dprintf("rgblight_init start!\n");
   if (!eeconfig_is_enabled()) {
@@ -210,27 +289,16 @@ void rgblight_mode(uint8_t mode) {
   }
   eeconfig_update_rgblight(rgblight_config.raw);
   xprintf("rgblight mode: %u\n", rgblight_config.mode);
-  if (rgblight_config.mode == 1) {
-    #ifdef RGBLIGHT_ANIMATIONS
-      rgblight_timer_disable();
-    #endif
-  } else if (rgblight_config.mode >= 2 && rgblight_config.mode <= 24) {
-    // MODE 2-5, breathing
-    // MODE 6-8, rainbow mood
-    // MODE 9-14, rainbow swirl
-    // MODE 15-20, snake
-    // MODE 21-23, knight
-
-    #ifdef RGBLIGHT_ANIMATIONS
+  #ifdef RGBLIGHT_ANIMATIONS
+    rgblight_effect_t effect;
+    uint8_t variant;
+    rgblight_find_effect(rgblight_config.mode, &effect, &variant);
+    if (effect.flags & EFFECT_ANIMATED) {
       rgblight_timer_enable();
-    #endif
-  } else if (rgblight_config.mode >= 25 && rgblight_config.mode <= 34) {
-    // MODE 25-34, static gradient
-
-    #ifdef RGBLIGHT_ANIMATIONS
+    } else {
       rgblight_timer_disable();
-    #endif
-  }
+    }
+  #endif
   rgblight_sethsv(rgblight_config.hue, rgblight_config.sat, rgblight_config.val);
 }
 
@@ -244,7 +312,7 @@ void rgblight_toggle(void) {
     #ifdef RGBLIGHT_ANIMATIONS
       rgblight_timer_disable();
     #endif
-    _delay_ms(50);
+    wait_ms(50);
     rgblight_set();
   }
 }
@@ -308,6 +376,11 @@ void rgblight_decrease_val(void) {
   rgblight_sethsv(rgblight_config.hue, rgblight_config.sat, val);
 }
 
+static void rgblight_effect_static_light(uint8_t variant) {
+  (void)variant;
+  rgblight_sethsv_noeeprom(rgblight_config.hue, rgblight_config.sat, rgblight_config.val);
+}
+
 void rgblight_sethsv_noeeprom(uint16_t hue, uint8_t sat, uint8_t val) {
   inmem_config.raw = rgblight_config.raw;
   if (rgblight_config.enable) {
@@ -322,33 +395,21 @@ void rgblight_sethsv_noeeprom(uint16_t hue, uint8_t sat, uint8_t val) {
 }
 void rgblight_sethsv(uint16_t hue, uint8_t sat, uint8_t val) {
   if (rgblight_config.enable) {
-    if (rgblight_config.mode == 1) {
-      // same static color
-      rgblight_sethsv_noeeprom(hue, sat, val);
-    } else {
-      // all LEDs in same color
-      if (rgblight_config.mode >= 2 && rgblight_config.mode <= 5) {
-        // breathing mode, ignore the change of val, use in memory value instead
-        val = rgblight_config.val;
-      } else if (rgblight_config.mode >= 6 && rgblight_config.mode <= 14) {
-        // rainbow mood and rainbow swirl, ignore the change of hue
-        hue = rgblight_config.hue;
-      } else if (rgblight_config.mode >= 25 && rgblight_config.mode <= 34) {
-        // static gradient
-        uint16_t _hue;
-        int8_t direction = ((rgblight_config.mode - 25) % 2) ? -1 : 1;
-        uint16_t range = pgm_read_word(&RGBLED_GRADIENT_RANGES[(rgblight_config.mode - 25) / 2]);
-        for (uint8_t i = 0; i < RGBLED_NUM; i++) {
-          _hue = (range / RGBLED_NUM * i * direction + hue + 360) % 360;
-          dprintf("rgblight rainbow set hsv: %u,%u,%d,%u\n", i, _hue, direction, range);
-          sethsv(_hue, sat, val, (LED_TYPE *)&led[i]);
-        }
-        rgblight_set();
-      }
+    rgblight_effect_t effect;
+    uint8_t variant;
+    rgblight_find_effect(rgblight_config.mode, &effect, &variant);
+    if (effect.flags & EFFECT_VAL_CYCLES) {
+      val = rgblight_config.val;
+    }
+    if (effect.flags & EFFECT_HUE_CYCLES) {
+      hue = rgblight_config.hue;
     }
     rgblight_config.hue = hue;
     rgblight_config.sat = sat;
     rgblight_config.val = val;
+    if (!(effect.flags & EFFECT_ANIMATED) && effect.draw) {
+      effect.draw(variant);
+    }
     eeconfig_update_rgblight(rgblight_config.raw);
     xprintf("rgblight set hsv [EEPROM]: %u,%u,%u\n", rgblight_config.hue, rgblight_config.sat, rgblight_config.val);
   }
@@ -364,26 +425,112 @@ void rgblight_setrgb(uint8_t r, uint8_t g, uint8_t b) {
   rgblight_set();
 }
 
+bool rgblight_add_overlay(rgblight_overlay_t overlay) {
+  if (overlay_count == RGBLIGHT_OVERLAYS) {
+    return false;
+  }
+  overlays[overlay_count++] = overlay;
+  return true;
+}
+
+void rgblight_remove_overlay(rgblight_overlay_t overlay) {
+  for (uint8_t i = 0; i < overlay_count; i++) {
+    if (overlays[i] == overlay) {
+      overlays[i] = overlays[--overlay_count];
+      return;
+    }
+  }
+}
+
+void rgblight_blend(LED_TYPE *led1, uint8_t r, uint8_t g, uint8_t b, uint8_t alpha) {
+  led1->r = blend8(led1->r, r, alpha);
+  led1->g = blend8(led1->g, g, alpha);
+  led1->b = blend8(led1->b, b, alpha);
+}
+
+void rgblight_blend_hsv(LED_TYPE *led1, uint16_t hue, uint8_t sat, uint8_t val, uint8_t alpha) {
+  LED_TYPE color;
+  sethsv(hue, sat, val, &color);
+  rgblight_blend(led1, color.r, color.g, color.b, alpha);
+}
+
+static void rgblight_compose(void) {
+  memcpy(composed, led, sizeof(composed));
+  if (rgblight_config.enable) {
+    for (uint8_t i = 0; i < overlay_count; i++) {
+      overlays[i](composed);
+    }
+  }
+  last_compose_timer = timer_read();
+}
+
+static void rgblight_send_frame(void) {
+  memcpy(committed, composed, sizeof(committed));
+  committed_valid = true;
+  frame_pending = false;
+  last_frame_timer = timer_read();
+  rgblight_frames_sent++;
+  #ifdef RGBW
+    ws2812_setleds_rgbw(committed, RGBLED_NUM);
+  #else
+    ws2812_setleds(committed, RGBLED_NUM);
+  #endif
+}
+
+// Sends led[] to the LEDs, unless they already show it. Within
+// RGBLIGHT_FRAME_INTERVAL of the previous frame it's only marked pending,
+// and rgblight_task sends whatever led[] holds once the interval is over.
 __attribute__ ((weak))
 void rgblight_set(void) {
-  if (rgblight_config.enable) {
-    #ifdef RGBW
-      ws2812_setleds_rgbw(led, RGBLED_NUM);
-    #else
-      ws2812_setleds(led, RGBLED_NUM);
-    #endif
-  } else {
+  if (!rgblight_config.enable) {
     for (uint8_t i = 0; i < RGBLED_NUM; i++) {
       led[i].r = 0;
       led[i].g = 0;
       led[i].b = 0;
     }
-    #ifdef RGBW
-      ws2812_setleds_rgbw(led, RGBLED_NUM);
-    #else
-      ws2812_setleds(led, RGBLED_NUM);
-    #endif
   }
+  rgblight_compose();
+  if (committed_valid && memcmp(composed, committed, sizeof(committed)) == 0) {
+    frame_pending = false;
+    if (!overlay_refresh) {
+      rgblight_frames_skipped++;
+    }
+    return;
+  }
+  // switching off is never held back, it may come right before a suspend
+  if (rgblight_config.enable && committed_valid &&
+      timer_elapsed(last_frame_timer) < RGBLIGHT_FRAME_INTERVAL) {
+    if (frame_pending && !overlay_refresh) {
+      rgblight_frames_skipped++;
+    }
+    frame_pending = true;
+    return;
+  }
+  rgblight_send_frame();
+}
+
+void rgblight_print_stats(void) {
+  xprintf("rgblight frames sent: %u, skipped: %u\n", rgblight_frames_sent, rgblight_frames_skipped);
+}
+
+void rgblight_task(void) {
+  if (frame_pending && timer_elapsed(last_frame_timer) >= RGBLIGHT_FRAME_INTERVAL) {
+    rgblight_compose();
+    rgblight_send_frame();
+  } else if (overlay_count && timer_elapsed(last_compose_timer) >= RGBLIGHT_OVERLAY_INTERVAL) {
+    // overlays follow state rgblight isn't told about, like the layers
+    overlay_refresh = true;
+    rgblight_set();
+    overlay_refresh = false;
+  }
+#ifdef RGB_REACTIVE_ENABLE
+  if (rgb_reactive_update(timer_read())) {
+    rgblight_set();
+  }
+#endif
+#ifdef RGBLIGHT_ANIMATIONS
+  rgblight_effects_task();
+#endif
 }
 
 #ifdef RGBLIGHT_ANIMATIONS
@@ -426,27 +573,13 @@ void rgblight_show_solid_color(uint8_t r, uint8_t g, uint8_t b) {
   rgblight_setrgb(r, g, b);
 }
 
-void rgblight_task(void) {
+static void rgblight_effects_task(void) {
   if (rgblight_timer_enabled) {
-    // mode = 1, static light, do nothing here
-    if (rgblight_config.mode >= 2 && rgblight_config.mode <= 5) {
-      // mode = 2 to 5, breathing mode
-      rgblight_effect_breathing(rgblight_config.mode - 2);
-    } else if (rgblight_config.mode >= 6 && rgblight_config.mode <= 8) {
-      // mode = 6 to 8, rainbow mood mod
-      rgblight_effect_rainbow_mood(rgblight_config.mode - 6);
-    } else if (rgblight_config.mode >= 9 && rgblight_config.mode <= 14) {
-      // mode = 9 to 14, rainbow swirl mode
-      rgblight_effect_rainbow_swirl(rgblight_config.mode - 9);
-    } else if (rgblight_config.mode >= 15 && rgblight_config.mode <= 20) {
-      // mode = 15 to 20, snake mode
-      rgblight_effect_snake(rgblight_config.mode - 15);
-    } else if (rgblight_config.mode >= 21 && rgblight_config.mode <= 23) {
-      // mode = 21 to 23, knight mode
-      rgblight_effect_knight(rgblight_config.mode - 21);
-    } else if (rgblight_config.mode == 24) {
-      // mode = 24, christmas mode
-      rgblight_effect_christmas();
+    rgblight_effect_t effect;
+    uint8_t variant;
+    rgblight_find_effect(rgblight_config.mode, &effect, &variant);
+    if ((effect.flags & EFFECT_ANIMATED) && effect.draw) {
+      effect.draw(variant);
     }
   }
 }
@@ -475,18 +608,22 @@ void rgblight_effect_rainbow_mood(uint8_t interval) {
   rgblight_sethsv_noeeprom(current_hue, rgblight_config.sat, rgblight_config.val);
   current_hue = (current_hue + 1) % 360;
 }
+#define RAINBOW_STEP ((uint16_t)(65536UL / RGBLED_NUM))
+
 void rgblight_effect_rainbow_swirl(uint8_t interval) {
   static uint16_t current_hue = 0;
   static uint16_t last_timer = 0;
-  uint16_t hue;
   uint8_t i;
   if (timer_elapsed(last_timer) < pgm_read_byte(&RGBLED_RAINBOW_MOOD_INTERVALS[interval / 2])) {
     return;
   }
   last_timer = timer_read();
+  // the rainbow is spread over the strip with an 8.8 fixed point hue step
+  uint8_t hue = HUE_360_TO_8(current_hue);
+  uint16_t offset = 0;
   for (i = 0; i < RGBLED_NUM; i++) {
-    hue = (360 / RGBLED_NUM * i + current_hue) % 360;
-    sethsv(hue, rgblight_config.sat, rgblight_config.val, (LED_TYPE *)&led[i]);
+    sethsv8(hue + (offset >> 8), rgblight_config.sat, rgblight_config.val, (LED_TYPE *)&led[i]);
+    offset += RAINBOW_STEP;
   }
   rgblight_set();
 
@@ -610,4 +747,23 @@ void rgblight_effect_christmas(void) {
   rgblight_set();
 }
 
+static void rgblight_effect_christmas_variant(uint8_t variant) {
+  (void)variant;
+  rgblight_effect_christmas();
+}
+
+static void rgblight_effect_static_gradient(uint8_t variant) {
+  uint16_t range = pgm_read_word(&RGBLED_GRADIENT_RANGES[variant / 2]);
+  // hue step between two LEDs in 1/256ths of the 256 step wheel
+  uint16_t step = ((uint32_t)HUE_360_TO_8(range) << 8) / RGBLED_NUM;
+  uint8_t hue = HUE_360_TO_8(rgblight_config.hue);
+  uint16_t offset = 0;
+  for (uint8_t i = 0; i < RGBLED_NUM; i++) {
+    uint8_t shift = offset >> 8;
+    sethsv8((variant % 2) ? hue - shift : hue + shift, rgblight_config.sat, rgblight_config.val, (LED_TYPE *)&led[i]);
+    offset += step;
+  }
+  rgblight_set();
+}
+
 #endif
@@ -55,6 +55,32 @@
 #define RGBLIGHT_VAL_STEP 17
 #endif
 
+// Minimum time in ms between two frames sent to the LEDs, changes made in
+// between are sent together by rgblight_task. 16ms caps the output at
+// about 60fps, 0 sends every change right away.
+#ifndef RGBLIGHT_FRAME_INTERVAL
+#define RGBLIGHT_FRAME_INTERVAL 16
+#endif
+
+// Overlays drawn over the effect, see rgblight_add_overlay
+#ifndef RGBLIGHT_OVERLAYS
+#define RGBLIGHT_OVERLAYS 4
+#endif
+// ms between two checks of the overlays while nothing else changes
+#ifndef RGBLIGHT_OVERLAY_INTERVAL
+#define RGBLIGHT_OVERLAY_INTERVAL 20
+#endif
+// Built in overlays, enabled by defining the index of their LED:
+// RGBLIGHT_CAPS_LOCK_LED lights up while caps lock is on,
+// RGBLIGHT_LAYER_INDICATOR_LED shows the highest active layer
+#ifndef RGBLIGHT_CAPS_LOCK_HUE
+#define RGBLIGHT_CAPS_LOCK_HUE 0
+#endif
+// on the 256 step hue wheel
+#ifndef RGBLIGHT_LAYER_INDICATOR_HUE_STEP
+#define RGBLIGHT_LAYER_INDICATOR_HUE_STEP 40
+#endif
+
 #define RGBLED_TIMER_TOP F_CPU/(256*64)
 // #define RGBLED_TIMER_TOP 0xFF10
 
@@ -110,10 +136,27 @@ void sethsv(uint16_t hue, uint8_t sat, uint8_t val, LED_TYPE *led1);
 void setrgb(uint8_t r, uint8_t g, uint8_t b, LED_TYPE *led1);
 void rgblight_sethsv_noeeprom(uint16_t hue, uint8_t sat, uint8_t val);
 
+// An overlay draws over a copy of led[] before it's sent, every frame, so
+// effects and overlays never overwrite each other. Overlays are drawn in
+// the order they were added.
+typedef void (*rgblight_overlay_t)(LED_TYPE *frame);
+bool rgblight_add_overlay(rgblight_overlay_t overlay);
+void rgblight_remove_overlay(rgblight_overlay_t overlay);
+// Mixes a color into an LED, alpha 0 keeps the LED and 255 replaces it
+void rgblight_blend(LED_TYPE *led1, uint8_t r, uint8_t g, uint8_t b, uint8_t alpha);
+void rgblight_blend_hsv(LED_TYPE *led1, uint16_t hue, uint8_t sat, uint8_t val, uint8_t alpha);
+
 #define EZ_RGB(val) rgblight_show_solid_color((val >> 16) & 0xFF, (val >> 8) & 0xFF, val & 0xFF)
 void rgblight_show_solid_color(uint8_t r, uint8_t g, uint8_t b);
 
+// Runs the animations and sends frames held back by RGBLIGHT_FRAME_INTERVAL
 void rgblight_task(void);
+// Frames sent to the LEDs, and frames not sent because they were identical
+// to the LEDs' state or were replaced before their turn came. The overlays
+// being recomposed every RGBLIGHT_OVERLAY_INTERVAL don't count as frames.
+extern uint16_t rgblight_frames_sent;
+extern uint16_t rgblight_frames_skipped;
+void rgblight_print_stats(void);
 
 void rgblight_timer_init(void);
 void rgblight_timer_enable(void);
@@ -5,6 +5,7 @@
 #include <util/twi.h>
 #include <stdbool.h>
 #include "i2c.h"
+#include "split_transport.h"
 
 #ifdef USE_I2C
 
@@ -16,12 +17,9 @@
 // poll loop takes at least 8 clock cycles to execute
 #define I2C_LOOP_TIMEOUT (9+1)*(F_CPU/SCL_CLOCK)/8
 
-#define BUFFER_POS_INC() (slave_buffer_pos = (slave_buffer_pos+1)%SLAVE_BUFFER_SIZE)
-
-volatile uint8_t i2c_slave_buffer[SLAVE_BUFFER_SIZE];
-
-static volatile uint8_t slave_buffer_pos;
-static volatile bool slave_has_register_set = false;
+static uint8_t slave_frame[SPLIT_FRAME_MAX_LENGTH];
+static volatile uint8_t slave_frame_pos;
+static volatile uint8_t slave_frame_length;
 
 // Wait for an i2c operation to finish
 inline static
@@ -113,42 +111,87 @@ void i2c_slave_init(uint8_t address) {
   TWCR = (1<<TWIE) | (1<<TWEA) | (1<<TWINT) | (1<<TWEN);
 }
 
+void transport_master_init(void) {
+  i2c_master_init();
+}
+
+void transport_slave_init(void) {
+  i2c_slave_init(SLAVE_I2C_ADDRESS);
+}
+
+// Reads the slave's frame, then writes the master's frame back. Both are
+// sent in one go, the slave builds its frame when it's addressed.
+uint8_t transport_master_update(void) {
+  uint8_t frame[SPLIT_FRAME_MAX_LENGTH];
+
+  int err = i2c_master_start(SLAVE_I2C_ADDRESS + I2C_READ);
+  if (err) goto i2c_error;
+
+  uint8_t header = split_transport_header_length(&split_transport);
+  uint8_t i;
+  for (i = 0; i < header; ++i) {
+    frame[i] = i2c_master_read(I2C_ACK);
+  }
+  uint8_t length = split_transport_frame_length(&split_transport, frame);
+  for (; i < length - 1; ++i) {
+    frame[i] = i2c_master_read(I2C_ACK);
+  }
+  frame[i] = i2c_master_read(I2C_NACK);
+  i2c_master_stop();
+
+  bool valid = split_transport_receive_frame(&split_transport, frame, length);
+
+  length = split_transport_build_frame(&split_transport, frame);
+  err = i2c_master_start(SLAVE_I2C_ADDRESS + I2C_WRITE);
+  if (err) goto i2c_error;
+  for (i = 0; i < length; ++i) {
+    err = i2c_master_write(frame[i]);
+    if (err) goto i2c_error;
+  }
+  i2c_master_stop();
+
+  return valid ? SPLIT_OK : SPLIT_ERROR;
+
+i2c_error: // the cable is disconnceted, or something else went wrong
+  i2c_reset_state();
+  split_transport_failed(&split_transport);
+  return SPLIT_ERROR;
+}
+
 ISR(TWI_vect);
 
 ISR(TWI_vect) {
   uint8_t ack = 1;
   switch(TW_STATUS) {
     case TW_SR_SLA_ACK:
-      // this device has been addressed as a slave receiver
-      slave_has_register_set = false;
+      // this device has been addressed as a slave receiver, the master is
+      // about to send its frame
+      slave_frame_pos = 0;
       break;
 
     case TW_SR_DATA_ACK:
-      // this device has received data as a slave receiver
-      // The first byte that we receive in this transaction sets the location
-      // of the read/write location of the slaves memory that it exposes over
-      // i2c.  After that, bytes will be written at slave_buffer_pos, incrementing
-      // slave_buffer_pos after each write.
-      if(!slave_has_register_set) {
-        slave_buffer_pos = TWDR;
-        // don't acknowledge the master if this memory loctaion is out of bounds
-        if ( slave_buffer_pos >= SLAVE_BUFFER_SIZE ) {
-          ack = 0;
-          slave_buffer_pos = 0;
-        }
-        slave_has_register_set = true;
+      if (slave_frame_pos < SPLIT_FRAME_MAX_LENGTH) {
+        slave_frame[slave_frame_pos++] = TWDR;
       } else {
-        i2c_slave_buffer[slave_buffer_pos] = TWDR;
-        BUFFER_POS_INC();
+        ack = 0;
+      }
+      break;
+
+    case TW_SR_STOP:
+      if (slave_frame_pos) {
+        split_transport_receive_frame(&split_transport, slave_frame, slave_frame_pos);
+        slave_frame_pos = 0;
       }
       break;
 
     case TW_ST_SLA_ACK:
-    case TW_ST_DATA_ACK:
       // master has addressed this device as a slave transmitter and is
-      // requesting data.
-      TWDR = i2c_slave_buffer[slave_buffer_pos];
-      BUFFER_POS_INC();
+      // requesting data, snapshot the matrix into a fresh frame
+      slave_frame_length = split_transport_build_frame(&split_transport, slave_frame);
+      slave_frame_pos = 0;
+      // fall through
+    case TW_ST_DATA_ACK:
+      TWDR = slave_frame_pos < slave_frame_length ? slave_frame[slave_frame_pos++] : 0xFF;
       break;
 
     case TW_BUS_ERROR: // something went wrong, reset twi state
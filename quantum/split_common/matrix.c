@@ -23,30 +23,31 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <avr/io.h>
 #include <avr/wdt.h>
 #include <avr/interrupt.h>
+#include <util/atomic.h>
 #include <util/delay.h>
 #include "print.h"
+#include "timer.h"
 #include "debug.h"
 #include "util.h"
 #include "matrix.h"
+#include "host.h"
+#include "action_layer.h"
 #include "split_util.h"
 #include "pro_micro.h"
 #include "config.h"
 
-#ifdef USE_I2C
-#  include "i2c.h"
-#else // USE_SERIAL
-#  include "serial.h"
+#ifdef SPLIT_TRANSPORT_RGBLIGHT
+#  include "rgblight.h"
+extern rgblight_config_t rgblight_config;
 #endif
 
 #ifndef DEBOUNCE
 #  define DEBOUNCE	5
 #endif
 
-#define ERROR_DISCONNECT_COUNT 5
-
-static uint8_t debouncing = DEBOUNCE;
+static bool debouncing = false;
+static uint16_t debouncing_time;
 static const int ROWS_PER_HAND = MATRIX_ROWS/2;
-static uint8_t error_count = 0;
 
 static const uint8_t row_pins[MATRIX_ROWS] = MATRIX_ROW_PINS;
 static const uint8_t col_pins[MATRIX_COLS] = MATRIX_COL_PINS;
@@ -131,100 +132,55 @@ uint8_t _matrix_scan(void)
         matrix_row_t cols = read_cols();
         if (matrix_debouncing[i+offset] != cols) {
             matrix_debouncing[i+offset] = cols;
-            debouncing = DEBOUNCE;
+            debouncing = true;
+            debouncing_time = timer_read();
         }
         unselect_rows();
     }
 
-    if (debouncing) {
-        if (--debouncing) {
-            _delay_ms(1);
-        } else {
-            for (uint8_t i = 0; i < ROWS_PER_HAND; i++) {
-                matrix[i+offset] = matrix_debouncing[i+offset];
-            }
+    if (debouncing && (timer_elapsed(debouncing_time) > DEBOUNCE)) {
+        for (uint8_t i = 0; i < ROWS_PER_HAND; i++) {
+            matrix[i+offset] = matrix_debouncing[i+offset];
         }
+        debouncing = false;
     }
 
     return 1;
 }
 
-#ifdef USE_I2C
-
-// Get rows from other half over i2c
-int i2c_transaction(void) {
-    int slaveOffset = (isLeftHand) ? (ROWS_PER_HAND) : 0;
-
-    int err = i2c_master_start(SLAVE_I2C_ADDRESS + I2C_WRITE);
-    if (err) goto i2c_error;
-
-    // start of matrix stored at 0x00
-    err = i2c_master_write(0x00);
-    if (err) goto i2c_error;
-
-    // Start read
-    err = i2c_master_start(SLAVE_I2C_ADDRESS + I2C_READ);
-    if (err) goto i2c_error;
-
-    if (!err) {
-        int i;
-        for (i = 0; i < ROWS_PER_HAND-1; ++i) {
-            matrix[slaveOffset+i] = i2c_master_read(I2C_ACK);
-        }
-        matrix[slaveOffset+i] = i2c_master_read(I2C_NACK);
-        i2c_master_stop();
-    } else {
-i2c_error: // the cable is disconnceted, or something else went wrong
-        i2c_reset_state();
-        return err;
-    }
-
-    return 0;
-}
-
-#else // USE_SERIAL
-
-int serial_transaction(void) {
-    int slaveOffset = (isLeftHand) ? (ROWS_PER_HAND) : 0;
-
-    if (serial_update_buffers()) {
-        return 1;
-    }
-
-    for (int i = 0; i < ROWS_PER_HAND; ++i) {
-        matrix[slaveOffset+i] = serial_slave_buffer[i];
-    }
-    return 0;
-}
+// Fill in everything the slave gets to see
+static void update_master_data(void) {
+    split_master_data_t* data = &split_transport.master;
+    data->leds = host_keyboard_leds();
+#if defined(SPLIT_TRANSPORT_LAYER_STATE) && !defined(NO_ACTION_LAYER)
+    data->layer_state = layer_state;
+#endif
+#ifdef SPLIT_TRANSPORT_RGBLIGHT
+    data->rgblight_config = rgblight_config.raw;
 #endif
+    split_transport_master_data_kb(data);
+}
 
 uint8_t matrix_scan(void)
 {
     int ret = _matrix_scan();
 
-
-
-#ifdef USE_I2C
-    if( i2c_transaction() ) {
-#else // USE_SERIAL
-    if( serial_transaction() ) {
-#endif
+    update_master_data();
+    uint8_t result = transport_master_update();
+    if (result != SPLIT_BUSY) {
         // turn on the indicator led when halves are disconnected
-        TXLED1;
-
-        error_count++;
+        if (result == SPLIT_OK) {
+            TXLED0;
+        } else {
+            TXLED1;
+        }
 
-        if (error_count > ERROR_DISCONNECT_COUNT) {
-            // reset other half if disconnected
-            int slaveOffset = (isLeftHand) ? (ROWS_PER_HAND) : 0;
-            for (int i = 0; i < ROWS_PER_HAND; ++i) {
-                matrix[slaveOffset+i] = 0;
-            }
+        // the transport clears the rows of the other half once it's
+        // disconnected for too long
+        int slaveOffset = (isLeftHand) ? (ROWS_PER_HAND) : 0;
+        for (int i = 0; i < ROWS_PER_HAND; ++i) {
+            matrix[slaveOffset+i] = split_transport.slave.rows[i];
         }
-    } else {
-        // turn off the indicator led on no error
-        TXLED0;
-        error_count = 0;
     }
     matrix_scan_quantum();
     return ret;
@@ -235,16 +191,26 @@ void matrix_slave_scan(void) {
 
     int offset = (isLeftHand) ? 0 : (MATRIX_ROWS / 2);
 
-#ifdef USE_I2C
     for (int i = 0; i < ROWS_PER_HAND; ++i) {
-        /* i2c_slave_buffer[i] = matrix[offset+i]; */
-        i2c_slave_buffer[i] = matrix[offset+i];
+        split_transport.slave.rows[i] = matrix[offset+i];
     }
-#else // USE_SERIAL
-    for (int i = 0; i < ROWS_PER_HAND; ++i) {
-        serial_slave_buffer[i] = matrix[offset+i];
+
+    // the transport interrupt writes the master's data as it comes in
+    split_master_data_t data;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        data = split_transport.master;
+    }
+#if defined(SPLIT_TRANSPORT_LAYER_STATE) && !defined(NO_ACTION_LAYER)
+    layer_state = data.layer_state;
+#endif
+#ifdef SPLIT_TRANSPORT_RGBLIGHT
+    if (rgblight_config.raw != data.rgblight_config) {
+        rgblight_update_dword(data.rgblight_config);
     }
+    // the slave never runs the main loop, send held back frames from here
+    rgblight_task();
 #endif
+    split_transport_slave_data_kb(&data);
 }
 
 bool matrix_is_modified(void)
@@ -0,0 +1,147 @@
+/*
+ * WARNING: be careful changing this code, it is very timing dependent
+ */
+
+#ifndef F_CPU
+#define F_CPU 16000000
+#endif
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdbool.h>
+#include "serial.h"
+#include "serial_protocol.h"
+
+#ifdef USE_SERIAL
+
+// Serial pulse period in microseconds. Its probably a bad idea to lower this
+// value.
+#ifndef SERIAL_DELAY
+#define SERIAL_DELAY 24
+#endif
+
+// Timer1 runs in CTC mode without prescaler and fires once per bit period.
+// The hardware keeps the cadence, so a late interrupt (USB, timer0) only
+// shifts the sample point, it does not accumulate.
+#define SERIAL_TIMER_TOP ((F_CPU / 1000000) * SERIAL_DELAY - 1)
+
+static serial_protocol_t protocol;
+static bool is_master = false;
+
+inline static
+void serial_output(void) {
+  SERIAL_PIN_DDR |= SERIAL_PIN_MASK;
+}
+
+// make the serial pin an input with pull-up resistor
+inline static
+void serial_input(void) {
+  SERIAL_PIN_DDR  &= ~SERIAL_PIN_MASK;
+  SERIAL_PIN_PORT |= SERIAL_PIN_MASK;
+}
+
+inline static
+uint8_t serial_read_pin(void) {
+  return !!(SERIAL_PIN_INPUT & SERIAL_PIN_MASK);
+}
+
+inline static
+void serial_low(void) {
+  SERIAL_PIN_PORT &= ~SERIAL_PIN_MASK;
+}
+
+// The line is open drain, it's either pulled low or left to the pull-up
+inline static
+void serial_drive(uint8_t out) {
+  if (out == SERIAL_LINE_LOW) {
+    serial_low();
+    serial_output();
+  } else {
+    serial_input();
+  }
+}
+
+inline static
+void serial_timer_start(uint16_t count) {
+  TCCR1A = 0;
+  TCCR1B = 0;
+  OCR1A = SERIAL_TIMER_TOP;
+  TCNT1 = count;
+  TIFR1 = _BV(OCF1A);
+  TIMSK1 |= _BV(OCIE1A);
+  TCCR1B = _BV(WGM12) | _BV(CS10);
+}
+
+inline static
+void serial_timer_stop(void) {
+  TCCR1B = 0;
+  TIMSK1 &= ~_BV(OCIE1A);
+}
+
+inline static
+void serial_slave_arm(void) {
+  // clear edges seen during the last transaction before listening again
+  EIFR = _BV(INTF0);
+  EIMSK |= _BV(INT0);
+}
+
+void transport_master_init(void) {
+  is_master = true;
+  serial_protocol_init(&protocol, &split_transport);
+  serial_input();
+}
+
+void transport_slave_init(void) {
+  is_master = false;
+  serial_protocol_init(&protocol, &split_transport);
+  serial_input();
+
+  // Trigger on falling edge of INT0
+  EICRA = (EICRA & ~_BV(ISC00)) | _BV(ISC01);
+  serial_slave_arm();
+}
+
+// Start bit from the master, tick half a period later so that the slave
+// samples in the middle of the master's bits and vice versa
+ISR(SERIAL_PIN_INTERRUPT) {
+  EIMSK &= ~_BV(INT0);
+  serial_protocol_begin(&protocol);
+  serial_timer_start(SERIAL_TIMER_TOP / 2);
+}
+
+ISR(TIMER1_COMPA_vect) {
+  uint8_t line = serial_read_pin();
+  if (is_master) {
+    serial_drive(serial_master_tick(&protocol, line));
+  } else {
+    serial_drive(serial_slave_tick(&protocol, line));
+  }
+
+  if (!serial_protocol_busy(&protocol)) {
+    serial_timer_stop();
+    if (!is_master) {
+      serial_slave_arm();
+    }
+  }
+}
+
+// Picks up the result of the last exchange and starts the next one in the
+// background.
+uint8_t transport_master_update(void) {
+  if (serial_protocol_busy(&protocol)) {
+    return SPLIT_BUSY;
+  }
+
+  uint8_t result = protocol.result;
+
+  cli();
+  serial_protocol_begin(&protocol);
+  // the first tick pulls the line low right away, the rest runs from the timer
+  serial_drive(serial_master_tick(&protocol, serial_read_pin()));
+  serial_timer_start(0);
+  sei();
+
+  return result;
+}
+
+#endif
@@ -0,0 +1,138 @@
+#include <string.h>
+#include "serial_protocol.h"
+
+enum serial_state {
+    SERIAL_STATE_IDLE,
+    SERIAL_STATE_START,
+    SERIAL_STATE_RELEASE,
+    SERIAL_STATE_PRESENCE,
+    SERIAL_STATE_RECEIVE,
+    SERIAL_STATE_SEND,
+};
+
+void serial_protocol_init(serial_protocol_t* p, split_transport_t* transport) {
+    memset(p, 0, sizeof(*p));
+    p->transport = transport;
+    p->state = SERIAL_STATE_IDLE;
+    p->result = SPLIT_BUSY;
+}
+
+void serial_protocol_begin(serial_protocol_t* p) {
+    p->state = SERIAL_STATE_START;
+    p->result = SPLIT_BUSY;
+}
+
+bool serial_protocol_busy(const serial_protocol_t* p) {
+    return p->state != SERIAL_STATE_IDLE;
+}
+
+static void start_frame(serial_protocol_t* p, uint8_t length) {
+    p->pos = 0;
+    p->bit = 8;
+    p->length = length;
+    p->shift = p->frame[0];
+}
+
+static void start_send(serial_protocol_t* p) {
+    start_frame(p, split_transport_build_frame(p->transport, p->frame));
+    p->state = SERIAL_STATE_SEND;
+}
+
+static void start_receive(serial_protocol_t* p) {
+    start_frame(p, split_transport_header_length(p->transport));
+    p->state = SERIAL_STATE_RECEIVE;
+}
+
+static uint8_t send_bit(serial_protocol_t* p) {
+    uint8_t out = (p->shift & 0x80) ? SERIAL_LINE_RELEASE : SERIAL_LINE_LOW;
+    p->shift <<= 1;
+    if (--p->bit == 0) {
+        p->bit = 8;
+        p->pos++;
+        if (p->pos < p->length) {
+            p->shift = p->frame[p->pos];
+        }
+    }
+    return out;
+}
+
+// Returns true when the whole frame has been received
+static bool receive_bit(serial_protocol_t* p, uint8_t line) {
+    p->shift = (p->shift << 1) | (line ? 1 : 0);
+    if (--p->bit == 0) {
+        p->bit = 8;
+        p->frame[p->pos++] = p->shift;
+        if (p->pos == split_transport_header_length(p->transport)) {
+            p->length = split_transport_frame_length(p->transport, p->frame);
+        }
+        return p->pos == p->length;
+    }
+    return false;
+}
+
+static bool finish_receive(serial_protocol_t* p) {
+    return split_transport_receive_frame(p->transport, p->frame, p->length);
+}
+
+uint8_t serial_master_tick(serial_protocol_t* p, uint8_t line) {
+    switch (p->state) {
+    case SERIAL_STATE_START:
+        p->state = SERIAL_STATE_RELEASE;
+        return SERIAL_LINE_LOW;
+    case SERIAL_STATE_RELEASE:
+        p->state = SERIAL_STATE_PRESENCE;
+        return SERIAL_LINE_RELEASE;
+    case SERIAL_STATE_PRESENCE:
+        if (line) {
+            // nobody pulled the line low, the other half is not there
+            split_transport_failed(p->transport);
+            p->result = SPLIT_ERROR;
+            p->state = SERIAL_STATE_IDLE;
+        } else {
+            start_receive(p);
+        }
+        return SERIAL_LINE_RELEASE;
+    case SERIAL_STATE_RECEIVE:
+        if (receive_bit(p, line)) {
+            p->result = finish_receive(p) ? SPLIT_OK : SPLIT_ERROR;
+            // the slave releases the line during this period
+            start_send(p);
+        }
+        return SERIAL_LINE_RELEASE;
+    case SERIAL_STATE_SEND:
+        if (p->pos == p->length) {
+            p->state = SERIAL_STATE_IDLE;
+            return SERIAL_LINE_RELEASE;
+        }
+        return send_bit(p);
+    default:
+        return SERIAL_LINE_RELEASE;
+    }
+}
+
+uint8_t serial_slave_tick(serial_protocol_t* p, uint8_t line) {
+    switch (p->state) {
+    case SERIAL_STATE_START:
+        start_send(p);
+        p->state = SERIAL_STATE_PRESENCE;
+        return SERIAL_LINE_LOW;
+    case SERIAL_STATE_PRESENCE:
+        p->state = SERIAL_STATE_SEND;
+        return SERIAL_LINE_LOW;
+    case SERIAL_STATE_SEND:
+        if (p->pos == p->length) {
+            // release the line for a period before the master starts talking
+            start_receive(p);
+            return SERIAL_LINE_RELEASE;
+        }
+        return send_bit(p);
+    case SERIAL_STATE_RECEIVE:
+        if (receive_bit(p, line)) {
+            p->result = finish_receive(p) ? SPLIT_OK : SPLIT_ERROR;
+            p->state = SERIAL_STATE_IDLE;
+        }
+        return SERIAL_LINE_RELEASE;
+    default:
+        return SERIAL_LINE_RELEASE;
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef SERIAL_PROTOCOL_H
+#define SERIAL_PROTOCOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "split_transport.h"
+
+/*
+ * Bit level state machine of the single wire soft serial backend.
+ *
+ * Both sides are ticked once per bit period from a timer interrupt. The
+ * master ticks on the bit boundaries, the slave is started by the falling
+ * edge of the start bit and ticks half a period later, so every sample lands
+ * in the middle of the other side's bit. The line is open drain: a side
+ * either pulls it low or releases it to the pull-up.
+ *
+ *   master: START  - pulls the line low for one period
+ *   slave:  ACK    - pulls the line low for two periods (presence)
+ *   slave:  frame  - see split_transport.h
+ *   both:   guard  - one released period while the line turns around
+ *   master: frame
+ */
+
+// Line output requested by a tick
+#define SERIAL_LINE_RELEASE 0
+#define SERIAL_LINE_LOW 1
+
+typedef struct {
+    split_transport_t* transport;
+
+    uint8_t state;
+    uint8_t result;
+    uint8_t shift;
+    uint8_t bit;
+    uint8_t pos;
+    uint8_t length;
+    uint8_t frame[SPLIT_FRAME_MAX_LENGTH];
+} serial_protocol_t;
+
+void serial_protocol_init(serial_protocol_t* p, split_transport_t* transport);
+void serial_protocol_begin(serial_protocol_t* p);
+bool serial_protocol_busy(const serial_protocol_t* p);
+
+// Called once per bit period with the sampled line level (0 or 1), returns
+// the output for the next period.
+uint8_t serial_master_tick(serial_protocol_t* p, uint8_t line);
+uint8_t serial_slave_tick(serial_protocol_t* p, uint8_t line);
+
+#endif
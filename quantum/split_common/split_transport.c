@@ -0,0 +1,147 @@
+#include <string.h>
+#include "split_transport.h"
+
+#define HEADER_SEQ 0
+#define HEADER_ACK 1
+#define HEADER_LENGTH 2
+
+// CRC-8 with the polynomial x^8 + x^2 + x + 1, computed bitwise to keep it
+// out of flash
+uint8_t crc8(const uint8_t* data, uint8_t length) {
+    uint8_t crc = 0;
+    while (length--) {
+        crc ^= *data++;
+        for (uint8_t i = 0; i < 8; i++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+uint8_t split_delta_encode(const uint8_t* current, const uint8_t* reference,
+                           uint8_t length, bool full, uint8_t* out) {
+    uint8_t* mask = out;
+    uint8_t* data = out + SPLIT_MASK_LENGTH(length);
+    memset(mask, 0, SPLIT_MASK_LENGTH(length));
+    for (uint8_t i = 0; i < length; i++) {
+        if (full || current[i] != reference[i]) {
+            mask[i / 8] |= 1 << (i % 8);
+            *data++ = current[i];
+        }
+    }
+    return data - out;
+}
+
+static uint8_t delta_length(const uint8_t* mask, uint8_t length) {
+    uint8_t encoded = SPLIT_MASK_LENGTH(length);
+    for (uint8_t i = 0; i < length; i++) {
+        if (mask[i / 8] & (1 << (i % 8))) {
+            encoded++;
+        }
+    }
+    return encoded;
+}
+
+bool split_delta_decode(const uint8_t* in, uint8_t encoded_length,
+                        uint8_t* target, uint8_t length) {
+    if (encoded_length < SPLIT_MASK_LENGTH(length) ||
+        delta_length(in, length) != encoded_length) {
+        return false;
+    }
+    const uint8_t* data = in + SPLIT_MASK_LENGTH(length);
+    for (uint8_t i = 0; i < length; i++) {
+        if (in[i / 8] & (1 << (i % 8))) {
+            target[i] = *data++;
+        }
+    }
+    return true;
+}
+
+static uint8_t* outgoing(split_transport_t* t) {
+    return t->is_master ? (uint8_t*)&t->master : (uint8_t*)&t->slave;
+}
+
+static uint8_t outgoing_length(const split_transport_t* t) {
+    return t->is_master ? sizeof(split_master_data_t) : sizeof(split_slave_data_t);
+}
+
+static uint8_t* incoming(split_transport_t* t) {
+    return t->is_master ? (uint8_t*)&t->slave : (uint8_t*)&t->master;
+}
+
+static uint8_t incoming_length(const split_transport_t* t) {
+    return t->is_master ? sizeof(split_slave_data_t) : sizeof(split_master_data_t);
+}
+
+void split_transport_init(split_transport_t* t, bool is_master) {
+    memset(t, 0, sizeof(*t));
+    t->is_master = is_master;
+}
+
+uint8_t split_transport_build_frame(split_transport_t* t, uint8_t* frame) {
+    uint8_t length = outgoing_length(t);
+    // the previous frame was never answered, the other side may or may not
+    // have it, so start over from a full frame
+    if (t->awaiting_ack) {
+        t->synced = false;
+    }
+    memcpy(t->pending, outgoing(t), length);
+    frame[HEADER_SEQ] = ++t->tx_seq;
+    frame[HEADER_ACK] = t->rx_seq;
+    uint8_t encoded = HEADER_LENGTH +
+        split_delta_encode(t->pending, t->acked, length, !t->synced, frame + HEADER_LENGTH);
+    frame[encoded] = crc8(frame, encoded);
+    t->awaiting_ack = true;
+    return encoded + 1;
+}
+
+uint8_t split_transport_header_length(const split_transport_t* t) {
+    return HEADER_LENGTH + SPLIT_MASK_LENGTH(incoming_length(t));
+}
+
+uint8_t split_transport_frame_length(const split_transport_t* t, const uint8_t* frame) {
+    return HEADER_LENGTH + delta_length(frame + HEADER_LENGTH, incoming_length(t)) + 1;
+}
+
+static void count_error(split_transport_t* t) {
+    t->frames_failed++;
+    if (t->error_count <= SPLIT_ERROR_DISCONNECT_COUNT) {
+        t->error_count++;
+    }
+    if (t->error_count > SPLIT_ERROR_DISCONNECT_COUNT) {
+        // release everything the other half was holding down
+        memset(incoming(t), 0, incoming_length(t));
+        t->synced = false;
+    }
+}
+
+bool split_transport_receive_frame(split_transport_t* t, const uint8_t* frame, uint8_t length) {
+    if (length < split_transport_header_length(t) + 1 ||
+        length != split_transport_frame_length(t, frame) ||
+        crc8(frame, length - 1) != frame[length - 1] ||
+        !split_delta_decode(frame + HEADER_LENGTH, length - HEADER_LENGTH - 1,
+                            incoming(t), incoming_length(t))) {
+        count_error(t);
+        return false;
+    }
+
+    t->rx_seq = frame[HEADER_SEQ];
+    if (t->awaiting_ack) {
+        t->synced = frame[HEADER_ACK] == t->tx_seq;
+        if (t->synced) {
+            memcpy(t->acked, t->pending, outgoing_length(t));
+        }
+        t->awaiting_ack = false;
+    }
+    t->error_count = 0;
+    t->frames_ok++;
+    return true;
+}
+
+void split_transport_failed(split_transport_t* t) {
+    count_error(t);
+}
+
+bool split_transport_connected(const split_transport_t* t) {
+    return t->error_count <= SPLIT_ERROR_DISCONNECT_COUNT;
+}
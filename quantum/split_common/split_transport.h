@@ -0,0 +1,121 @@
+#ifndef SPLIT_TRANSPORT_H
+#define SPLIT_TRANSPORT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "matrix.h"
+
+/*
+ * Hardware independent half-to-half protocol shared by the split keyboards.
+ *
+ * The master (the half with USB) and the slave each own one block of data
+ * that is mirrored on the other side: the slave sends its half of the
+ * matrix, the master sends its LED, layer and lighting state. The physical
+ * backends (soft serial, i2c, uart) only move frames around, the encoding
+ * lives here:
+ *
+ *   [seq] [ack] [mask ...] [changed bytes ...] [crc8]
+ *
+ * seq numbers the frame, ack is the seq of the last valid frame received
+ * from the other side. Only the bytes that changed since the last
+ * acknowledged frame are sent; when an acknowledge goes missing the next
+ * frame is a full one, so both sides can never drift apart.
+ */
+
+#define SPLIT_ROWS_PER_HAND (MATRIX_ROWS / 2)
+
+// Transaction results reported to the master
+#define SPLIT_OK 0
+#define SPLIT_ERROR 1
+#define SPLIT_BUSY 2
+
+#ifndef SPLIT_ERROR_DISCONNECT_COUNT
+#define SPLIT_ERROR_DISCONNECT_COUNT 5
+#endif
+
+#ifndef SPLIT_TRANSPORT_USER_LENGTH
+#define SPLIT_TRANSPORT_USER_LENGTH 0
+#endif
+
+typedef struct {
+    matrix_row_t rows[SPLIT_ROWS_PER_HAND];
+} split_slave_data_t;
+
+typedef struct {
+    uint8_t leds;
+#ifdef SPLIT_TRANSPORT_LAYER_STATE
+    uint32_t layer_state;
+#endif
+#ifdef SPLIT_TRANSPORT_RGBLIGHT
+    uint32_t rgblight_config;
+#endif
+#if SPLIT_TRANSPORT_USER_LENGTH > 0
+    uint8_t user[SPLIT_TRANSPORT_USER_LENGTH];
+#endif
+} split_master_data_t;
+
+#define SPLIT_MAX(a, b) ((a) > (b) ? (a) : (b))
+#define SPLIT_MASK_LENGTH(length) (((length) + 7) / 8)
+#define SPLIT_FRAME_LENGTH(length) (2 + SPLIT_MASK_LENGTH(length) + (length) + 1)
+#define SPLIT_DATA_MAX_LENGTH \
+    SPLIT_MAX(sizeof(split_slave_data_t), sizeof(split_master_data_t))
+#define SPLIT_FRAME_MAX_LENGTH SPLIT_FRAME_LENGTH(SPLIT_DATA_MAX_LENGTH)
+
+typedef struct {
+    // master: own state and a mirror of the slave, and vice versa
+    split_master_data_t master;
+    split_slave_data_t slave;
+
+    bool is_master;
+    // outgoing direction
+    uint8_t tx_seq;
+    bool synced;
+    bool awaiting_ack;
+    uint8_t acked[SPLIT_DATA_MAX_LENGTH];
+    uint8_t pending[SPLIT_DATA_MAX_LENGTH];
+    // incoming direction
+    uint8_t rx_seq;
+
+    uint8_t error_count;
+
+    // statistics
+    uint16_t frames_ok;
+    uint16_t frames_failed;
+} split_transport_t;
+
+uint8_t crc8(const uint8_t* data, uint8_t length);
+
+// Writes the mask and the bytes of current that differ from reference to
+// out, all of them if full is set. Returns the number of bytes written.
+uint8_t split_delta_encode(const uint8_t* current, const uint8_t* reference,
+                           uint8_t length, bool full, uint8_t* out);
+// Applies an encoded delta of encoded_length bytes to target, returns false
+// if the encoded length does not match the mask.
+bool split_delta_decode(const uint8_t* in, uint8_t encoded_length,
+                        uint8_t* target, uint8_t length);
+
+void split_transport_init(split_transport_t* t, bool is_master);
+
+// Builds the next outgoing frame, returns its length
+uint8_t split_transport_build_frame(split_transport_t* t, uint8_t* frame);
+// Number of bytes an incoming frame needs before its length is known
+uint8_t split_transport_header_length(const split_transport_t* t);
+// Total length of an incoming frame, given at least the header
+uint8_t split_transport_frame_length(const split_transport_t* t, const uint8_t* frame);
+// Validates and applies an incoming frame, returns false if it was corrupt
+bool split_transport_receive_frame(split_transport_t* t, const uint8_t* frame, uint8_t length);
+// Called by a backend when a transaction failed before a frame arrived
+void split_transport_failed(split_transport_t* t);
+
+bool split_transport_connected(const split_transport_t* t);
+
+// Implemented by the physical backend selected with USE_SERIAL, USE_I2C or
+// USE_UART, operating on split_transport
+extern split_transport_t split_transport;
+void transport_master_init(void);
+void transport_slave_init(void);
+// Starts or continues an exchange, returns SPLIT_OK or SPLIT_ERROR when one
+// has finished and SPLIT_BUSY while it's still running in the background
+uint8_t transport_master_update(void);
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ * Full duplex backend for halves wired RX to TX over USART1 (D2/D3 on the
+ * atmega32u4). The master sends its frame, the slave answers with its own
+ * straight from the receive interrupt. Everything is interrupt driven, the
+ * master only checks for the answer on the next scan.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdbool.h>
+#include "config.h"
+#include "timer.h"
+#include "split_transport.h"
+
+#ifdef USE_UART
+
+#ifndef SPLIT_UART_BAUD
+#define SPLIT_UART_BAUD 500000
+#endif
+
+// How long the master waits for the answer, in milliseconds
+#ifndef SPLIT_UART_TIMEOUT
+#define SPLIT_UART_TIMEOUT 5
+#endif
+
+// Marks the start of a frame, the length follows from the frame header
+#define SPLIT_UART_SYNC 0x7E
+
+static bool is_master = false;
+
+static uint8_t tx_frame[SPLIT_FRAME_MAX_LENGTH + 1];
+static volatile uint8_t tx_pos;
+static volatile uint8_t tx_length;
+
+static uint8_t rx_frame[SPLIT_FRAME_MAX_LENGTH];
+static volatile uint8_t rx_pos;
+static volatile uint8_t rx_length;
+static volatile bool rx_sync;
+
+static bool waiting;
+static volatile bool answered;
+static volatile bool answer_valid;
+static uint16_t sent_time;
+
+static void uart_init(void) {
+  UBRR1 = (F_CPU / 8 / SPLIT_UART_BAUD) - 1;
+  UCSR1A = _BV(U2X1);
+  UCSR1C = _BV(UCSZ11) | _BV(UCSZ10);
+  UCSR1B = _BV(RXEN1) | _BV(TXEN1) | _BV(RXCIE1);
+}
+
+// Queues the next frame from split_transport and starts sending it
+static void uart_send_frame(void) {
+  tx_frame[0] = SPLIT_UART_SYNC;
+  tx_length = split_transport_build_frame(&split_transport, tx_frame + 1) + 1;
+  tx_pos = 0;
+  UCSR1B |= _BV(UDRIE1);
+}
+
+void transport_master_init(void) {
+  is_master = true;
+  uart_init();
+}
+
+void transport_slave_init(void) {
+  is_master = false;
+  uart_init();
+}
+
+ISR(USART1_UDRE_vect) {
+  UDR1 = tx_frame[tx_pos++];
+  if (tx_pos == tx_length) {
+    UCSR1B &= ~_BV(UDRIE1);
+  }
+}
+
+ISR(USART1_RX_vect) {
+  bool error = UCSR1A & (_BV(FE1) | _BV(DOR1));
+  uint8_t data = UDR1;
+
+  if (!rx_sync) {
+    if (data == SPLIT_UART_SYNC && !error) {
+      rx_sync = true;
+      rx_pos = 0;
+      rx_length = split_transport_header_length(&split_transport);
+    }
+    return;
+  }
+
+  rx_frame[rx_pos++] = data;
+  if (rx_pos == split_transport_header_length(&split_transport)) {
+    rx_length = split_transport_frame_length(&split_transport, rx_frame);
+  }
+  if (rx_pos < rx_length && !error) {
+    return;
+  }
+
+  rx_sync = false;
+  bool valid = false;
+  if (error) {
+    split_transport_failed(&split_transport);
+  } else {
+    valid = split_transport_receive_frame(&split_transport, rx_frame, rx_pos);
+  }
+  if (is_master) {
+    answer_valid = valid;
+    answered = true;
+  } else if (valid) {
+    uart_send_frame();
+  }
+}
+
+uint8_t transport_master_update(void) {
+  if (waiting) {
+    if (answered) {
+      waiting = false;
+      return answer_valid ? SPLIT_OK : SPLIT_ERROR;
+    }
+    if (timer_elapsed(sent_time) < SPLIT_UART_TIMEOUT) {
+      return SPLIT_BUSY;
+    }
+    // no answer, drop whatever was received so far and try again
+    rx_sync = false;
+    waiting = false;
+    split_transport_failed(&split_transport);
+    return SPLIT_ERROR;
+  }
+
+  answered = false;
+  waiting = true;
+  sent_time = timer_read();
+  uart_send_frame();
+  return SPLIT_BUSY;
+}
+
+#endif
@@ -7,16 +7,13 @@
 #include "split_util.h"
 #include "matrix.h"
 #include "keyboard.h"
+#include "timer.h"
 #include "config.h"
 
-#ifdef USE_I2C
-#  include "i2c.h"
-#else
-#  include "serial.h"
-#endif
-
 volatile bool isLeftHand = true;
 
+split_transport_t split_transport;
+
 static void setup_handedness(void) {
   #ifdef EE_HANDS
     isLeftHand = eeprom_read_byte(EECONFIG_HANDEDNESS);
@@ -31,22 +28,16 @@ static void setup_handedness(void) {
 }
 
 static void keyboard_master_setup(void) {
-#ifdef USE_I2C
-    i2c_master_init();
-#ifdef SSD1306OLED
+    split_transport_init(&split_transport, true);
+    transport_master_init();
+#if defined(USE_I2C) && defined(SSD1306OLED)
     matrix_master_OLED_init ();
 #endif
-#else
-    serial_master_init();
-#endif
 }
 
 static void keyboard_slave_setup(void) {
-#ifdef USE_I2C
-    i2c_slave_init(SLAVE_I2C_ADDRESS);
-#else
-    serial_slave_init();
-#endif
+    split_transport_init(&split_transport, false);
+    transport_slave_init();
 }
 
 bool has_usb(void) {
@@ -67,6 +58,8 @@ void split_keyboard_setup(void) {
 }
 
 void keyboard_slave_loop(void) {
+   // the slave never reaches keyboard_init, but debouncing needs the timer
+   timer_init();
    matrix_init();
 
    while (1) {
@@ -82,3 +75,13 @@ void matrix_setup(void) {
         keyboard_slave_loop();
     }
 }
+
+__attribute__ ((weak))
+void split_transport_master_data_kb(split_master_data_t* data) {
+    (void)data;
+}
+
+__attribute__ ((weak))
+void split_transport_slave_data_kb(const split_master_data_t* data) {
+    (void)data;
+}
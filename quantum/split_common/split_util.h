@@ -2,14 +2,13 @@
 #define SPLIT_KEYBOARD_UTIL_H
 
 #include <stdbool.h>
+#include "split_transport.h"
 
 #ifdef EE_HANDS
 	#define EECONFIG_BOOTMAGIC_END      (uint8_t *)10
 	#define EECONFIG_HANDEDNESS         EECONFIG_BOOTMAGIC_END
 #endif
 
-#define SLAVE_I2C_ADDRESS           0x32
-
 extern volatile bool isLeftHand;
 
 // slave version of matix scan, defined in matrix.c
@@ -21,4 +20,9 @@ void keyboard_slave_loop(void);
 
 void matrix_master_OLED_init (void);
 
+// Lets the keyboard add its own data (SPLIT_TRANSPORT_USER_LENGTH bytes of
+// user) on the master before each exchange, and use it on the slave
+void split_transport_master_data_kb(split_master_data_t* data);
+void split_transport_slave_data_kb(const split_master_data_t* data);
+
 #endif
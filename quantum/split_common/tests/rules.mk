@@ -0,0 +1,10 @@
+split_common_split_transport_DEFS := -DMATRIX_ROWS=8 -DMATRIX_COLS=6
+split_common_split_transport_SRC :=\
+	$(QUANTUM_PATH)/split_common/tests/split_transport_tests.cpp \
+	$(QUANTUM_PATH)/split_common/split_transport.c
+
+split_common_serial_protocol_DEFS := -DMATRIX_ROWS=8 -DMATRIX_COLS=6
+split_common_serial_protocol_SRC :=\
+	$(QUANTUM_PATH)/split_common/tests/serial_protocol_tests.cpp \
+	$(QUANTUM_PATH)/split_common/serial_protocol.c \
+	$(QUANTUM_PATH)/split_common/split_transport.c
@@ -0,0 +1,117 @@
+#include "gtest/gtest.h"
+extern "C" {
+#include "split_common/serial_protocol.h"
+}
+
+// Runs both state machines against a simulated open drain wire. The slave
+// ticks half a period after the master, like it does on the real hardware.
+class SerialProtocol : public testing::Test {
+public:
+    SerialProtocol() {
+        split_transport_init(&master_transport, true);
+        split_transport_init(&slave_transport, false);
+        serial_protocol_init(&master, &master_transport);
+        serial_protocol_init(&slave, &slave_transport);
+    }
+
+    uint8_t wire() {
+        if (!connected) {
+            return master_out == SERIAL_LINE_LOW ? 0 : 1;
+        }
+        return (master_out == SERIAL_LINE_LOW || slave_out == SERIAL_LINE_LOW) ? 0 : 1;
+    }
+
+    // Returns the number of bit periods the transaction took
+    unsigned run_transaction() {
+        unsigned ticks = 0;
+        serial_protocol_begin(&master);
+        master_out = serial_master_tick(&master, wire());
+        // the falling edge starts the slave
+        if (connected && wire() == 0) {
+            serial_protocol_begin(&slave);
+        }
+        while (serial_protocol_busy(&master) || serial_protocol_busy(&slave)) {
+            if (serial_protocol_busy(&slave)) {
+                uint8_t line = wire();
+                if (flip_tick == ticks) {
+                    line = !line;
+                }
+                slave_out = serial_slave_tick(&slave, line);
+            }
+            ticks++;
+            if (serial_protocol_busy(&master)) {
+                uint8_t line = wire();
+                if (flip_tick == ticks) {
+                    line = !line;
+                }
+                master_out = serial_master_tick(&master, line);
+            }
+            EXPECT_LT(ticks, 1000u);
+            if (ticks >= 1000) {
+                break;
+            }
+        }
+        return ticks;
+    }
+
+    split_transport_t master_transport;
+    split_transport_t slave_transport;
+    serial_protocol_t master;
+    serial_protocol_t slave;
+    uint8_t master_out = SERIAL_LINE_RELEASE;
+    uint8_t slave_out = SERIAL_LINE_RELEASE;
+    bool connected = true;
+    unsigned flip_tick = ~0u;
+};
+
+// Bit periods from the start bit to the first bit of the slave's frame
+static const unsigned slave_frame_start = 3;
+
+TEST_F(SerialProtocol, exchanges_both_sides) {
+    slave_transport.slave.rows[0] = 0x21;
+    slave_transport.slave.rows[3] = 0x3F;
+    master_transport.master.leds = 0xA5;
+    run_transaction();
+    EXPECT_EQ(master.result, SPLIT_OK);
+    EXPECT_EQ(slave.result, SPLIT_OK);
+    EXPECT_EQ(master_transport.slave.rows[0], 0x21);
+    EXPECT_EQ(master_transport.slave.rows[3], 0x3F);
+    EXPECT_EQ(slave_transport.master.leds, 0xA5);
+}
+
+TEST_F(SerialProtocol, sends_only_changed_rows_once_synced) {
+    unsigned full = run_transaction();
+    unsigned empty = run_transaction();
+    slave_transport.slave.rows[2] = 0x10;
+    unsigned one_row = run_transaction();
+    EXPECT_EQ(master.result, SPLIT_OK);
+    EXPECT_EQ(master_transport.slave.rows[2], 0x10);
+    EXPECT_EQ(full - empty, (sizeof(split_slave_data_t) + sizeof(split_master_data_t)) * 8u);
+    EXPECT_EQ(one_row - empty, 8u);
+}
+
+TEST_F(SerialProtocol, reports_a_missing_slave) {
+    connected = false;
+    run_transaction();
+    EXPECT_EQ(master.result, SPLIT_ERROR);
+    EXPECT_EQ(master_transport.frames_failed, 1);
+}
+
+TEST_F(SerialProtocol, recovers_from_a_corrupted_slave_frame) {
+    run_transaction();
+    run_transaction();
+    slave_transport.slave.rows[1] = 0x01;
+    // corrupt a bit of the changed row as seen by the master
+    flip_tick = slave_frame_start + (2 + SPLIT_MASK_LENGTH(sizeof(split_slave_data_t))) * 8 + 2;
+    run_transaction();
+    EXPECT_EQ(master.result, SPLIT_ERROR);
+    EXPECT_EQ(slave.result, SPLIT_OK);
+    flip_tick = ~0u;
+    slave_transport.slave.rows[1] = 0x00;
+    slave_transport.slave.rows[2] = 0x04;
+    run_transaction();
+    EXPECT_EQ(master.result, SPLIT_OK);
+    for (int i = 0; i < SPLIT_ROWS_PER_HAND; i++) {
+        EXPECT_EQ(master_transport.slave.rows[i], slave_transport.slave.rows[i]);
+    }
+}
@@ -0,0 +1,141 @@
+#include "gtest/gtest.h"
+extern "C" {
+#include "split_common/split_transport.h"
+}
+
+class SplitTransport : public testing::Test {
+public:
+    SplitTransport() {
+        split_transport_init(&master, true);
+        split_transport_init(&slave, false);
+    }
+
+    // Moves one frame from one side to the other, returns the frame length
+    uint8_t send(split_transport_t* from, split_transport_t* to, bool corrupt = false) {
+        uint8_t frame[SPLIT_FRAME_MAX_LENGTH];
+        uint8_t length = split_transport_build_frame(from, frame);
+        if (corrupt) {
+            frame[length - 1] ^= 0x01;
+        }
+        received = split_transport_receive_frame(to, frame, length);
+        return length;
+    }
+
+    split_transport_t master;
+    split_transport_t slave;
+    bool received = false;
+};
+
+TEST(SplitCrc, matches_the_crc8_check_value) {
+    const uint8_t data[] = "123456789";
+    EXPECT_EQ(crc8(data, 9), 0xF4);
+}
+
+TEST(SplitDelta, encodes_only_changed_bytes) {
+    uint8_t current[] = {1, 2, 3, 4};
+    uint8_t reference[] = {1, 0, 3, 0};
+    uint8_t out[SPLIT_MASK_LENGTH(4) + 4];
+    ASSERT_EQ(split_delta_encode(current, reference, 4, false, out), 3);
+    EXPECT_EQ(out[0], 0x0A);
+    EXPECT_EQ(out[1], 2);
+    EXPECT_EQ(out[2], 4);
+
+    uint8_t target[] = {1, 0, 3, 0};
+    EXPECT_TRUE(split_delta_decode(out, 3, target, 4));
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(target[i], current[i]);
+    }
+}
+
+TEST(SplitDelta, encodes_everything_when_asked_to) {
+    uint8_t current[] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    uint8_t out[SPLIT_MASK_LENGTH(9) + 9];
+    ASSERT_EQ(split_delta_encode(current, current, 9, true, out), 11);
+    EXPECT_EQ(out[0], 0xFF);
+    EXPECT_EQ(out[1], 0x01);
+}
+
+TEST(SplitDelta, rejects_a_length_that_does_not_match_the_mask) {
+    uint8_t in[] = {0x03, 1};
+    uint8_t target[4] = {};
+    EXPECT_FALSE(split_delta_decode(in, 2, target, 4));
+}
+
+TEST_F(SplitTransport, delivers_the_rows_of_the_slave) {
+    slave.slave.rows[0] = 0x21;
+    slave.slave.rows[3] = 0x3F;
+    send(&slave, &master);
+    EXPECT_TRUE(received);
+    EXPECT_EQ(master.slave.rows[0], 0x21);
+    EXPECT_EQ(master.slave.rows[3], 0x3F);
+}
+
+TEST_F(SplitTransport, delivers_the_state_of_the_master) {
+    master.master.leds = 0x02;
+    send(&master, &slave);
+    EXPECT_TRUE(received);
+    EXPECT_EQ(slave.master.leds, 0x02);
+}
+
+TEST_F(SplitTransport, sends_only_changed_bytes_once_acknowledged) {
+    uint8_t full = send(&slave, &master);
+    send(&master, &slave);
+    uint8_t empty = send(&slave, &master);
+    send(&master, &slave);
+    slave.slave.rows[2] = 0x10;
+    uint8_t one_row = send(&slave, &master);
+    EXPECT_TRUE(received);
+    EXPECT_EQ(master.slave.rows[2], 0x10);
+    EXPECT_EQ(full - empty, sizeof(split_slave_data_t));
+    EXPECT_EQ(one_row - empty, 1);
+}
+
+TEST_F(SplitTransport, rejects_a_corrupted_frame) {
+    slave.slave.rows[1] = 0x01;
+    send(&slave, &master, true);
+    EXPECT_FALSE(received);
+    EXPECT_EQ(master.slave.rows[1], 0);
+    EXPECT_EQ(master.frames_failed, 1);
+}
+
+TEST_F(SplitTransport, resends_everything_when_the_ack_is_lost) {
+    send(&slave, &master);
+    send(&master, &slave);
+    slave.slave.rows[1] = 0x01;
+    send(&slave, &master);
+    // the master applied the row but the acknowledge never arrives
+    send(&master, &slave, true);
+    // the row goes back to its old value, a delta against the stale
+    // reference would miss it
+    slave.slave.rows[1] = 0x00;
+    uint8_t length = send(&slave, &master);
+    EXPECT_TRUE(received);
+    EXPECT_EQ(master.slave.rows[1], 0x00);
+    EXPECT_EQ(length, SPLIT_FRAME_LENGTH(sizeof(split_slave_data_t)));
+}
+
+TEST_F(SplitTransport, resends_everything_when_a_frame_is_never_answered) {
+    send(&slave, &master);
+    send(&master, &slave);
+    uint8_t frame[SPLIT_FRAME_MAX_LENGTH];
+    split_transport_build_frame(&slave, frame);
+    uint8_t length = send(&slave, &master);
+    EXPECT_EQ(length, SPLIT_FRAME_LENGTH(sizeof(split_slave_data_t)));
+}
+
+TEST_F(SplitTransport, releases_the_other_half_when_disconnected) {
+    slave.slave.rows[0] = 0x04;
+    send(&slave, &master);
+    for (int i = 0; i < SPLIT_ERROR_DISCONNECT_COUNT; i++) {
+        split_transport_failed(&master);
+        EXPECT_TRUE(split_transport_connected(&master));
+        EXPECT_EQ(master.slave.rows[0], 0x04);
+    }
+    split_transport_failed(&master);
+    EXPECT_FALSE(split_transport_connected(&master));
+    EXPECT_EQ(master.slave.rows[0], 0);
+
+    send(&slave, &master);
+    EXPECT_TRUE(split_transport_connected(&master));
+    EXPECT_EQ(master.slave.rows[0], 0x04);
+}
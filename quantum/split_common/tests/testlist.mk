@@ -0,0 +1,3 @@
+TEST_LIST +=\
+	split_common_split_transport\
+	split_common_serial_protocol
@@ -41,6 +41,7 @@ bool backlight_keyframe_animate_color(keyframe_animation_t* animation, visualize
     sat += p_s;
     intensity += p_i;
     state->current_lcd_color = LCD_COLOR(hue, sat, intensity);
+    visualizer_invalidate_nothing(state);
     lcd_backlight_color(
             LCD_HUE(state->current_lcd_color),
             LCD_SAT(state->current_lcd_color),
@@ -51,6 +52,7 @@ bool backlight_keyframe_animate_color(keyframe_animation_t* animation, visualize
 
 bool backlight_keyframe_set_color(keyframe_animation_t* animation, visualizer_state_t* state) {
     (void)animation;
+    visualizer_invalidate_nothing(state);
     state->prev_lcd_color = state->target_lcd_color;
     state->current_lcd_color = state->target_lcd_color;
     lcd_backlight_color(
@@ -62,14 +64,14 @@ bool backlight_keyframe_set_color(keyframe_animation_t* animation, visualizer_st
 
 bool backlight_keyframe_disable(keyframe_animation_t* animation, visualizer_state_t* state) {
     (void)animation;
-    (void)state;
+    visualizer_invalidate_nothing(state);
     lcd_backlight_hal_color(0, 0, 0);
     return false;
 }
 
 bool backlight_keyframe_enable(keyframe_animation_t* animation, visualizer_state_t* state) {
     (void)animation;
-    (void)state;
+    visualizer_invalidate_nothing(state);
     lcd_backlight_color(LCD_HUE(state->current_lcd_color),
         LCD_SAT(state->current_lcd_color),
         LCD_INT(state->current_lcd_color));
@@ -23,6 +23,7 @@
 bool lcd_keyframe_display_layer_text(keyframe_animation_t* animation, visualizer_state_t* state) {
     (void)animation;
     gdispClear(White);
+    visualizer_invalidate_display(state, GDISP);
     gdispDrawString(0, 10, state->layer_text, state->font_dejavusansbold12, Black);
     return false;
 }
@@ -57,6 +58,7 @@ bool lcd_keyframe_display_layer_bitmap(keyframe_animation_t* animation, visualiz
     const char* layer_help = "1=On D=Default B=Both";
     char layer_buffer[16 + 4]; // 3 spaces and one null terminator
     gdispClear(White);
+    visualizer_invalidate_display(state, GDISP);
     gdispDrawString(0, 0, layer_help, state->font_fixed5x8, Black);
     format_layer_bitmap_string(state->status.default_layer, state->status.layer, layer_buffer);
     gdispDrawString(0, 10, layer_buffer, state->font_fixed5x8, Black);
@@ -95,6 +97,7 @@ bool lcd_keyframe_display_mods_bitmap(keyframe_animation_t* animation, visualize
     char status_buffer[12];
 
     gdispClear(White);
+    visualizer_invalidate_display(state, GDISP);
     gdispDrawString(0, 0, title, state->font_fixed5x8, Black);
     gdispDrawString(0, 10, mods_header, state->font_fixed5x8, Black);
     format_mods_bitmap_string(state->status.mods, status_buffer);
@@ -137,6 +140,7 @@ bool lcd_keyframe_display_led_states(keyframe_animation_t* animation, visualizer
     char output[LED_STATE_STRING_SIZE];
     get_led_state_string(output, state);
     gdispClear(White);
+    visualizer_invalidate_display(state, GDISP);
     gdispDrawString(0, 10, output, state->font_dejavusansbold12, Black);
     return false;
 }
@@ -144,6 +148,7 @@ bool lcd_keyframe_display_led_states(keyframe_animation_t* animation, visualizer
 bool lcd_keyframe_display_layer_and_led_states(keyframe_animation_t* animation, visualizer_state_t* state) {
     (void)animation;
     gdispClear(White);
+    visualizer_invalidate_display(state, GDISP);
     uint8_t y = 10;
     if (state->status.leds) {
         char output[LED_STATE_STRING_SIZE];
@@ -156,11 +161,11 @@ bool lcd_keyframe_display_layer_and_led_states(keyframe_animation_t* animation,
 }
 
 bool lcd_keyframe_draw_logo(keyframe_animation_t* animation, visualizer_state_t* state) {
-    (void)state;
     (void)animation;
     // Read the uGFX documentation for information how to use the displays
     // http://wiki.ugfx.org/index.php/Main_Page
     gdispClear(White);
+    visualizer_invalidate_display(state, GDISP);
 
     // You can use static variables for things that can't be found in the animation
     // or state structs, here we use the image
@@ -175,14 +180,14 @@ bool lcd_keyframe_draw_logo(keyframe_animation_t* animation, visualizer_state_t*
 
 bool lcd_keyframe_disable(keyframe_animation_t* animation, visualizer_state_t* state) {
     (void)animation;
-    (void)state;
+    visualizer_invalidate_nothing(state);
     gdispSetPowerMode(powerOff);
     return false;
 }
 
 bool lcd_keyframe_enable(keyframe_animation_t* animation, visualizer_state_t* state) {
     (void)animation;
-    (void)state;
+    visualizer_invalidate_nothing(state);
     gdispSetPowerMode(powerOn);
     return false;
 }
@@ -34,10 +34,11 @@ static uint8_t fade_led_color(keyframe_animation_t* animation, int from, int to)
     return luma;
 }
 
-static void keyframe_fade_all_leds_from_to(keyframe_animation_t* animation, uint8_t from, uint8_t to) {
+static void keyframe_fade_all_leds_from_to(keyframe_animation_t* animation, visualizer_state_t* state, uint8_t from, uint8_t to) {
     uint8_t luma = fade_led_color(animation, from, to);
     color_t color = LUMA2COLOR(luma);
     gdispGClear(LED_DISPLAY, color);
+    visualizer_invalidate_display(state, LED_DISPLAY);
 }
 
 // TODO: Should be customizable per keyboard
@@ -56,19 +57,16 @@ static uint8_t compute_gradient_color(float t, float index, float num) {
 }
 
 bool led_keyframe_fade_in_all(keyframe_animation_t* animation, visualizer_state_t* state) {
-    (void)state;
-    keyframe_fade_all_leds_from_to(animation, 0, 255);
+    keyframe_fade_all_leds_from_to(animation, state, 0, 255);
     return true;
 }
 
 bool led_keyframe_fade_out_all(keyframe_animation_t* animation, visualizer_state_t* state) {
-    (void)state;
-    keyframe_fade_all_leds_from_to(animation, 255, 0);
+    keyframe_fade_all_leds_from_to(animation, state, 255, 0);
     return true;
 }
 
 bool led_keyframe_left_to_right_gradient(keyframe_animation_t* animation, visualizer_state_t* state) {
-    (void)state;
     float frame_length = animation->frame_lengths[animation->current_frame];
     float current_pos = frame_length - animation->time_left_in_frame;
     float t = current_pos / frame_length;
@@ -76,11 +74,11 @@ bool led_keyframe_left_to_right_gradient(keyframe_animation_t* animation, visual
         uint8_t color = compute_gradient_color(t, i, NUM_COLS);
         gdispGDrawLine(LED_DISPLAY, i, 0, i, NUM_ROWS - 1, LUMA2COLOR(color));
     }
+    visualizer_invalidate(state, LED_DISPLAY, 0, 0, NUM_COLS, NUM_ROWS);
     return true;
 }
 
 bool led_keyframe_top_to_bottom_gradient(keyframe_animation_t* animation, visualizer_state_t* state) {
-    (void)state;
     float frame_length = animation->frame_lengths[animation->current_frame];
     float current_pos = frame_length - animation->time_left_in_frame;
     float t = current_pos / frame_length;
@@ -88,6 +86,7 @@ bool led_keyframe_top_to_bottom_gradient(keyframe_animation_t* animation, visual
         uint8_t color = compute_gradient_color(t, i, NUM_ROWS);
         gdispGDrawLine(LED_DISPLAY, 0, i, NUM_COLS - 1, i, LUMA2COLOR(color));
     }
+    visualizer_invalidate(state, LED_DISPLAY, 0, 0, NUM_COLS, NUM_ROWS);
     return true;
 }
 
@@ -99,7 +98,6 @@ static void copy_current_led_state(uint8_t* dest) {
     }
 }
 bool led_keyframe_crossfade(keyframe_animation_t* animation, visualizer_state_t* state) {
-    (void)state;
     if (animation->first_update_of_frame) {
         copy_current_led_state(&crossfade_start_frame[0][0]);
         run_next_keyframe(animation, state);
@@ -111,19 +109,22 @@ bool led_keyframe_crossfade(keyframe_animation_t* animation, visualizer_state_t*
             gdispGDrawPixel(LED_DISPLAY, j, i, color);
         }
     }
+    visualizer_invalidate(state, LED_DISPLAY, 0, 0, NUM_COLS, NUM_ROWS);
     return true;
 }
 
 bool led_keyframe_mirror_orientation(keyframe_animation_t* animation, visualizer_state_t* state) {
-    (void)state;
     (void)animation;
+    // Takes effect when the display is drawn to the next time
+    visualizer_invalidate_nothing(state);
     gdispGSetOrientation(LED_DISPLAY, GDISP_ROTATE_180);
     return false;
 }
 
 bool led_keyframe_normal_orientation(keyframe_animation_t* animation, visualizer_state_t* state) {
-    (void)state;
     (void)animation;
+    // Takes effect when the display is drawn to the next time
+    visualizer_invalidate_nothing(state);
     gdispGSetOrientation(LED_DISPLAY, GDISP_ROTATE_0);
     return false;
 }
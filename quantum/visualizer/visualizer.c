@@ -25,6 +25,9 @@ SOFTWARE.
 #include "visualizer.h"
 #include "config.h"
 #include <string.h>
+#ifdef EMULATOR
+#include <stdio.h>
+#endif
 #ifdef PROTOCOL_CHIBIOS
 #include "ch.h"
 #endif
@@ -55,6 +58,8 @@ SOFTWARE.
 #define "Visualizer thread priority not defined"
 #endif
 
+// The status is written by the main loop and read by the visualizer thread,
+// guarded by status_version which is odd while a write is in progress
 static visualizer_keyboard_status_t current_status = {
     .layer = 0xFFFFFFFF,
     .default_layer = 0xFFFFFFFF,
@@ -66,6 +71,29 @@ static visualizer_keyboard_status_t current_status = {
 #endif
 };
 
+static volatile uint32_t status_version = 0;
+
+static void publish_status(const visualizer_keyboard_status_t* status) {
+    status_version++;
+    __sync_synchronize();
+    current_status = *status;
+    __sync_synchronize();
+    status_version++;
+}
+
+// Copies a consistent snapshot of the status, returns its version
+static uint32_t read_status(visualizer_keyboard_status_t* status) {
+    uint32_t version;
+    do {
+        version = status_version;
+        __sync_synchronize();
+        *status = current_status;
+        __sync_synchronize();
+    } while ((version & 1) || version != status_version);
+    return version;
+}
+
+#ifdef SERIAL_LINK_ENABLE
 static bool same_status(visualizer_keyboard_status_t* status1, visualizer_keyboard_status_t* status2) {
     return status1->layer == status2->layer &&
         status1->default_layer == status2->default_layer &&
@@ -77,11 +105,13 @@ static bool same_status(visualizer_keyboard_status_t* status1, visualizer_keyboa
 #endif
     ;
 }
+#endif
 
 static bool visualizer_enabled = false;
 
 #ifdef VISUALIZER_USER_DATA_SIZE
 static uint8_t user_data[VISUALIZER_USER_DATA_SIZE];
+static bool user_data_dirty = false;
 #endif
 
 #define MAX_SIMULTANEOUS_ANIMATIONS 4
@@ -154,6 +184,62 @@ void stop_all_keyframe_animations(void) {
     }
 }
 
+static void add_rect(visualizer_rect_t* rect, coord_t x, coord_t y, coord_t cx, coord_t cy) {
+    if (cx <= 0 || cy <= 0) {
+        return;
+    }
+    if (rect->cx == 0 || rect->cy == 0) {
+        *rect = (visualizer_rect_t){x, y, cx, cy};
+        return;
+    }
+    coord_t x1 = rect->x + rect->cx > x + cx ? rect->x + rect->cx : x + cx;
+    coord_t y1 = rect->y + rect->cy > y + cy ? rect->y + rect->cy : y + cy;
+    rect->x = rect->x < x ? rect->x : x;
+    rect->y = rect->y < y ? rect->y : y;
+    rect->cx = x1 - rect->x;
+    rect->cy = y1 - rect->y;
+}
+
+void visualizer_invalidate(visualizer_state_t* state, GDisplay* display,
+        coord_t x, coord_t y, coord_t cx, coord_t cy) {
+    state->frame_reported = true;
+    if (display == NULL) {
+        return;
+    }
+    if (display == LCD_DISPLAY) {
+        add_rect(&state->lcd_dirty, x, y, cx, cy);
+    }
+    else if (display == LED_DISPLAY) {
+        add_rect(&state->led_dirty, x, y, cx, cy);
+    }
+}
+
+void visualizer_invalidate_display(visualizer_state_t* state, GDisplay* display) {
+    state->frame_reported = true;
+    if (display) {
+        visualizer_invalidate(state, display, 0, 0, gdispGGetWidth(display), gdispGGetHeight(display));
+    }
+}
+
+void visualizer_invalidate_nothing(visualizer_state_t* state) {
+    state->frame_reported = true;
+}
+
+static void invalidate_all_displays(visualizer_state_t* state) {
+    visualizer_invalidate_display(state, LCD_DISPLAY);
+    visualizer_invalidate_display(state, LED_DISPLAY);
+}
+
+static bool run_frame_function(keyframe_animation_t* animation, visualizer_state_t* state) {
+    state->frame_reported = false;
+    bool ret = (*animation->frame_functions[animation->current_frame])(animation, state);
+    if (!state->frame_reported) {
+        // Nothing reported, so it could have drawn anywhere
+        invalidate_all_displays(state);
+    }
+    return ret;
+}
+
 static uint8_t get_num_running_animations(void) {
     uint8_t count = 0;
     for (int i=0;i<MAX_SIMULTANEOUS_ANIMATIONS;i++) {
@@ -182,7 +268,7 @@ static bool update_keyframe_animation(keyframe_animation_t* animation, visualize
             if (animation->need_update) {
                 animation->time_left_in_frame = 0;
                 animation->last_update_of_frame = true;
-                (*animation->frame_functions[animation->current_frame])(animation, state);
+                run_frame_function(animation, state);
                 animation->last_update_of_frame = false;
             }
             animation->current_frame++;
@@ -203,11 +289,11 @@ static bool update_keyframe_animation(keyframe_animation_t* animation, visualize
         }
     }
     if (animation->need_update) {
-        animation->need_update = (*animation->frame_functions[animation->current_frame])(animation, state);
+        animation->need_update = run_frame_function(animation, state);
         animation->first_update_of_frame = false;
     }
 
-    systemticks_t wanted_sleep = animation->need_update ? gfxMillisecondsToTicks(10) : (unsigned)animation->time_left_in_frame;
+    systemticks_t wanted_sleep = animation->need_update ? gfxMillisecondsToTicks(VISUALIZER_FRAME_TIME) : (unsigned)animation->time_left_in_frame;
     if (wanted_sleep < *sleep_time) {
         *sleep_time = wanted_sleep;
     }
@@ -227,9 +313,46 @@ void run_next_keyframe(keyframe_animation_t* animation, visualizer_state_t* stat
     temp_animation.last_update_of_frame = false;
     temp_animation.need_update  = false;
     visualizer_state_t temp_state = *state;
-    (*temp_animation.frame_functions[next_frame])(&temp_animation, &temp_state);
+    run_frame_function(&temp_animation, &temp_state);
+    // The frame ran on a copy of the state, but what it drew still has to
+    // be flushed
+    add_rect(&state->lcd_dirty, temp_state.lcd_dirty.x, temp_state.lcd_dirty.y,
+            temp_state.lcd_dirty.cx, temp_state.lcd_dirty.cy);
+    add_rect(&state->led_dirty, temp_state.led_dirty.x, temp_state.led_dirty.y,
+            temp_state.led_dirty.cx, temp_state.led_dirty.cy);
 }
 
+#ifdef EMULATOR
+// Prints the number of frames and the bytes flushed to the displays each
+// second, assuming a monochrome LCD with 8 pixel high pages and one byte
+// per LED
+static void update_stats(visualizer_state_t* state) {
+    static systemticks_t start = 0;
+    static unsigned frames = 0;
+    static unsigned bytes = 0;
+    visualizer_rect_t* lcd = &state->lcd_dirty;
+    visualizer_rect_t* led = &state->led_dirty;
+    bool lcd_flushed = lcd->cx && lcd->cy;
+    bool led_flushed = led->cx && led->cy;
+    if (lcd_flushed) {
+        bytes += lcd->cx * ((lcd->y + lcd->cy + 7) / 8 - lcd->y / 8);
+    }
+    if (led_flushed) {
+        bytes += led->cx * led->cy;
+    }
+    if (lcd_flushed || led_flushed) {
+        frames++;
+    }
+    systemticks_t now = gfxSystemTicks();
+    if (now - start >= gfxMillisecondsToTicks(1000)) {
+        printf("visualizer: %u frames/s, %u bytes flushed/s\n", frames, bytes);
+        start = now;
+        frames = 0;
+        bytes = 0;
+    }
+}
+#endif
+
 // TODO: Optimize the stack size, this is probably way too big
 static DECLARE_THREAD_STACK(visualizerThreadStack, 1024);
 static DECLARE_THREAD_FUNCTION(visualizerThread, arg) {
@@ -258,6 +381,7 @@ static DECLARE_THREAD_FUNCTION(visualizerThread, arg) {
         .font_dejavusansbold12 = gdispOpenFont("DejaVuSansBold12")
 #endif
     };
+    invalidate_all_displays(&state);
     initialize_user_visualizer(&state);
     state.prev_lcd_color = state.current_lcd_color;
 
@@ -271,35 +395,44 @@ static DECLARE_THREAD_FUNCTION(visualizerThread, arg) {
     systemticks_t sleep_time = TIME_INFINITE;
     systemticks_t current_time = gfxSystemTicks();
     bool force_update = true;
+    visualizer_keyboard_status_t new_status;
+    uint32_t new_status_version = read_status(&new_status);
 
     while(true) {
         systemticks_t new_time = gfxSystemTicks();
         systemticks_t delta = new_time - current_time;
         current_time = new_time;
         bool enabled = visualizer_enabled;
-        if (force_update || !same_status(&state.status, &current_status)) {
+        bool status_changed = status_version != new_status_version;
+        if (status_changed) {
+            new_status_version = read_status(&new_status);
+        }
+        if (force_update || status_changed) {
             force_update = false;
             if (visualizer_enabled) {
-                if (current_status.suspended) {
+                // The user code might draw directly
+                invalidate_all_displays(&state);
+                if (new_status.suspended) {
                     stop_all_keyframe_animations();
                     visualizer_enabled = false;
-                    state.status = current_status;
+                    state.status = new_status;
                     user_visualizer_suspend(&state);
                 }
                 else {
                     visualizer_keyboard_status_t prev_status = state.status;
-                    state.status = current_status;
+                    state.status = new_status;
                     update_user_visualizer_state(&state, &prev_status);
                 }
                 state.prev_lcd_color = state.current_lcd_color;
             }
         }
-        if (!enabled && state.status.suspended && current_status.suspended == false) {
+        if (!enabled && state.status.suspended && new_status.suspended == false) {
             // Setting the status to the initial status will force an update
             // when the visualizer is enabled again
             state.status = initial_status;
             state.status.suspended = false;
             stop_all_keyframe_animations();
+            invalidate_all_displays(&state);
             user_visualizer_resume(&state);
             state.prev_lcd_color = state.current_lcd_color;
         }
@@ -310,23 +443,26 @@ static DECLARE_THREAD_FUNCTION(visualizerThread, arg) {
             }
         }
 #ifdef LED_ENABLE
-        gdispGFlush(LED_DISPLAY);
+        if (state.led_dirty.cx && state.led_dirty.cy) {
+            gdispGFlush(LED_DISPLAY);
+        }
 #endif
 
 #ifdef LCD_ENABLE
-        gdispGFlush(LCD_DISPLAY);
+        if (state.lcd_dirty.cx && state.lcd_dirty.cy) {
+            gdispGFlush(LCD_DISPLAY);
+        }
 #endif
 
 #ifdef EMULATOR
-        draw_emulator();
+        update_stats(&state);
 #endif
-        // Enable the visualizer when the startup or the suspend animation has finished
-        if (!visualizer_enabled && state.status.suspended == false && get_num_running_animations() == 0) {
-            visualizer_enabled = true;
-            force_update = true;
-            sleep_time = 0;
-        }
+        state.lcd_dirty = (visualizer_rect_t){0};
+        state.led_dirty = (visualizer_rect_t){0};
 
+#ifdef EMULATOR
+        draw_emulator();
+#endif
         systemticks_t after_update = gfxSystemTicks();
         unsigned update_delta = after_update - current_time;
         if (sleep_time != TIME_INFINITE) {
@@ -334,9 +470,18 @@ static DECLARE_THREAD_FUNCTION(visualizerThread, arg) {
                 sleep_time -= update_delta;
             }
             else {
-                sleep_time = 0;
+                // Over the frame time budget, don't let the animations fall
+                // behind, they'll skip ahead by the time it took instead
+                sleep_time = gfxMillisecondsToTicks(VISUALIZER_MIN_SLEEP);
             }
         }
+
+        // Enable the visualizer when the startup or the suspend animation has finished
+        if (!visualizer_enabled && state.status.suspended == false && get_num_running_animations() == 0) {
+            visualizer_enabled = true;
+            force_update = true;
+            sleep_time = 0;
+        }
         dprintf("Update took %d, last delta %d, sleep_time %d\n", update_delta, delta, sleep_time);
 #ifdef PROTOCOL_CHIBIOS
         // The gEventWait function really takes milliseconds, even if the documentation says ticks.
@@ -415,15 +560,17 @@ uint8_t visualizer_get_mods() {
 
 #ifdef VISUALIZER_USER_DATA_SIZE
 void visualizer_set_user_data(void* u) {
-    memcpy(user_data, u, VISUALIZER_USER_DATA_SIZE);
+    if (memcmp(user_data, u, VISUALIZER_USER_DATA_SIZE) != 0) {
+        memcpy(user_data, u, VISUALIZER_USER_DATA_SIZE);
+        user_data_dirty = true;
+    }
 }
 #endif
 
 void visualizer_update(uint32_t default_state, uint32_t state, uint8_t mods, uint32_t leds) {
-    // Note that there's a small race condition here, the thread could read
-    // a state where one of these are set but not the other. But this should
-    // not really matter as it will be fixed during the next loop step.
-    // Alternatively a mutex could be used instead of the volatile variables
+    // This is called every scan, so only a few compares are done unless
+    // something has changed. The main loop is the only writer of
+    // current_status, so it can read it without going through read_status.
 
     bool changed = false;
 #ifdef SERIAL_LINK_ENABLE
@@ -432,7 +579,7 @@ void visualizer_update(uint32_t default_state, uint32_t state, uint8_t mods, uin
         if (new_status) {
             if (!same_status(&current_status, new_status)) {
                 changed = true;
-                current_status = *new_status;
+                publish_status(new_status);
             }
         }
     }
@@ -440,30 +587,42 @@ void visualizer_update(uint32_t default_state, uint32_t state, uint8_t mods, uin
 #else
    {
 #endif
-        visualizer_keyboard_status_t new_status = {
-            .layer = state,
-            .default_layer = default_state,
-            .mods = mods,
-            .leds = leds,
-            .suspended = current_status.suspended,
-        };
+        if (current_status.layer != state ||
+            current_status.default_layer != default_state ||
+            current_status.mods != mods ||
+            current_status.leds != leds
+#ifdef VISUALIZER_USER_DATA_SIZE
+            || user_data_dirty
+#endif
+           ) {
+            visualizer_keyboard_status_t new_status = {
+                .layer = state,
+                .default_layer = default_state,
+                .mods = mods,
+                .leds = leds,
+                .suspended = current_status.suspended,
+            };
 #ifdef VISUALIZER_USER_DATA_SIZE
-       memcpy(new_status.user_data, user_data, VISUALIZER_USER_DATA_SIZE);
+            memcpy(new_status.user_data, user_data, VISUALIZER_USER_DATA_SIZE);
+            user_data_dirty = false;
 #endif
-        if (!same_status(&current_status, &new_status)) {
             changed = true;
-            current_status = new_status;
+            publish_status(&new_status);
         }
     }
     update_status(changed);
 }
 
 void visualizer_suspend(void) {
-    current_status.suspended = true;
+    visualizer_keyboard_status_t new_status = current_status;
+    new_status.suspended = true;
+    publish_status(&new_status);
     update_status(true);
 }
 
 void visualizer_resume(void) {
-    current_status.suspended = false;
+    visualizer_keyboard_status_t new_status = current_status;
+    new_status.suspended = false;
+    publish_status(&new_status);
     update_status(true);
 }
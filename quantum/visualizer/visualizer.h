@@ -60,6 +60,18 @@ void draw_emulator(void);
 // If you need support for more than 16 keyframes per animation, you can change this
 #define MAX_VISUALIZER_KEY_FRAMES 16
 
+// The time between updates of animations that want continuous updates
+#ifndef VISUALIZER_FRAME_TIME
+#define VISUALIZER_FRAME_TIME 10
+#endif
+
+// When an update takes longer than the animations wanted, the visualizer
+// still sleeps this long and lets the animations skip ahead, instead of
+// running flat out and letting them lag behind
+#ifndef VISUALIZER_MIN_SLEEP
+#define VISUALIZER_MIN_SLEEP 2
+#endif
+
 struct keyframe_animation_t;
 
 typedef struct {
@@ -73,6 +85,14 @@ typedef struct {
 #endif
 } visualizer_keyboard_status_t;
 
+// An area of a display, empty when cx or cy is zero
+typedef struct {
+    coord_t x;
+    coord_t y;
+    coord_t cx;
+    coord_t cy;
+} visualizer_rect_t;
+
 // The state struct is used by the various keyframe functions
 // It's also used for setting the LCD color and layer text
 // from the user customized code
@@ -91,11 +111,20 @@ typedef struct visualizer_state_t {
     font_t font_fixed5x8;
     font_t font_dejavusansbold12;
 #endif
+
+    // The areas drawn to since the displays were last flushed, reported by
+    // the keyframe functions through visualizer_invalidate
+    visualizer_rect_t lcd_dirty;
+    visualizer_rect_t led_dirty;
+    bool frame_reported;
 } visualizer_state_t;
 
 // Any custom keyframe function should have this signature
 // return true to get continuous updates, otherwise you will only get one
 // update per frame
+// The function should report what it has drawn with the visualizer_invalidate
+// functions, so that displays without changes are not flushed. Functions that
+// don't report anything are assumed to have redrawn every display.
 typedef bool (*frame_func)(struct keyframe_animation_t*, visualizer_state_t*);
 
 // Represents a keyframe animation, so fields are internal to the system
@@ -126,6 +155,14 @@ void stop_keyframe_animation(keyframe_animation_t* animation);
 // Useful for crossfades for example
 void run_next_keyframe(keyframe_animation_t* animation, visualizer_state_t* state);
 
+// Reports an area of a display drawn to by a keyframe function
+void visualizer_invalidate(visualizer_state_t* state, GDisplay* display,
+        coord_t x, coord_t y, coord_t cx, coord_t cy);
+// Reports the whole display as drawn to
+void visualizer_invalidate_display(visualizer_state_t* state, GDisplay* display);
+// Reports that the keyframe function has not drawn anything
+void visualizer_invalidate_nothing(visualizer_state_t* state);
+
 // The master can set userdata which will be transferred to the slave
 #ifdef VISUALIZER_USER_DATA_SIZE
 void visualizer_set_user_data(void* user_data);
@@ -18,6 +18,6 @@
 
 bool keyframe_no_operation(keyframe_animation_t* animation, visualizer_state_t* state) {
     (void)animation;
-    (void)state;
+    visualizer_invalidate_nothing(state);
     return false;
 }
@@ -0,0 +1,3 @@
+ws2812_encode_SRC :=\
+	$(QUANTUM_PATH)/ws2812/tests/ws2812_encode_tests.cpp \
+	$(QUANTUM_PATH)/ws2812/ws2812_encode.c
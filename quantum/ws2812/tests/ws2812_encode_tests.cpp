@@ -0,0 +1,72 @@
+#include "gtest/gtest.h"
+extern "C" {
+#include "ws2812/ws2812_encode.h"
+}
+
+class Ws2812Encode : public testing::Test {
+public:
+    // Decodes the wire bits back into pulses, checking that every data bit
+    // is a 3 bit period starting high and ending low
+    std::vector<int> high_times(const uint8_t* encoded, unsigned length) {
+        std::vector<int> result;
+        for (unsigned bit = 0; bit < length * 8; bit += 3) {
+            int pattern = 0;
+            for (unsigned i = 0; i < 3; i++) {
+                unsigned b = bit + i;
+                pattern = (pattern << 1) | ((encoded[b / 8] >> (7 - b % 8)) & 1);
+            }
+            EXPECT_TRUE(pattern == 0b100 || pattern == 0b110);
+            result.push_back(pattern == 0b110 ? 2 : 1);
+        }
+        return result;
+    }
+};
+
+TEST_F(Ws2812Encode, zero_is_short_pulses) {
+    uint8_t out[3];
+    ws2812_encode_byte(0x00, out);
+    EXPECT_EQ(out[0], 0x92);
+    EXPECT_EQ(out[1], 0x49);
+    EXPECT_EQ(out[2], 0x24);
+}
+
+TEST_F(Ws2812Encode, ones_are_long_pulses) {
+    uint8_t out[3];
+    ws2812_encode_byte(0xFF, out);
+    EXPECT_EQ(out[0], 0xDB);
+    EXPECT_EQ(out[1], 0x6D);
+    EXPECT_EQ(out[2], 0xB6);
+}
+
+TEST_F(Ws2812Encode, msb_goes_first) {
+    uint8_t out[3];
+    ws2812_encode_byte(0x80, out);
+    std::vector<int> pulses = high_times(out, 3);
+    std::vector<int> expected = {2, 1, 1, 1, 1, 1, 1, 1};
+    EXPECT_EQ(pulses, expected);
+}
+
+TEST_F(Ws2812Encode, every_byte_round_trips) {
+    for (unsigned value = 0; value < 256; value++) {
+        uint8_t out[3];
+        ws2812_encode_byte(value, out);
+        std::vector<int> pulses = high_times(out, 3);
+        ASSERT_EQ(pulses.size(), 8u);
+        unsigned decoded = 0;
+        for (int pulse : pulses) {
+            decoded = (decoded << 1) | (pulse == 2 ? 1 : 0);
+        }
+        EXPECT_EQ(decoded, value);
+    }
+}
+
+TEST_F(Ws2812Encode, encodes_an_array_in_order) {
+    const uint8_t grb[] = {0x12, 0x34, 0xAB, 0xCD};
+    uint8_t out[WS2812_ENCODED_LENGTH(sizeof(grb))];
+    ws2812_encode(grb, sizeof(grb), out);
+    for (unsigned i = 0; i < sizeof(grb); i++) {
+        uint8_t single[3];
+        ws2812_encode_byte(grb[i], single);
+        EXPECT_EQ(memcmp(out + i * 3, single, 3), 0) << "byte " << i;
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * WS2812 driver for ChibiOS, using an SPI peripheral with DMA
+ *
+ * The LED data is encoded into the bit stream of ws2812_encode.h and sent
+ * with spiStartSend, so the CPU is free while the DMA feeds the SPI. Only
+ * MOSI is used, connect it to the data line of the LEDs.
+ *
+ * The SPI clock has to be about 2.67MHz (anywhere from 2.4MHz to 2.9MHz
+ * works). How that's set up depends on the MCU, so the keyboard provides
+ * the configuration:
+ *
+ *   #define WS2812_SPI SPID1        // in config.h, the default
+ *   const SPIConfig ws2812_spi_config = { ... };
+ */
+
+#include "ch.h"
+#include "hal.h"
+#include "light_ws2812.h"
+#include "ws2812_encode.h"
+
+#ifndef WS2812_SPI
+#define WS2812_SPI SPID1
+#endif
+
+// Low time after the data, long enough for the LEDs to latch (280us, for
+// the newer parts) at 2.67MHz
+#ifndef WS2812_RESET_BYTES
+#define WS2812_RESET_BYTES 94
+#endif
+
+extern const SPIConfig ws2812_spi_config;
+
+// A leading zero byte makes sure the line is low before the first bit
+#define WS2812_BUFFER_SIZE \
+    (1 + WS2812_ENCODED_LENGTH(RGBLED_NUM * sizeof(LED_TYPE)) + WS2812_RESET_BYTES)
+
+static uint8_t buffer[WS2812_BUFFER_SIZE];
+static bool started = false;
+
+static void send_array(const uint8_t* data, uint16_t length) {
+    if (length > RGBLED_NUM * sizeof(LED_TYPE)) {
+        length = RGBLED_NUM * sizeof(LED_TYPE);
+    }
+    if (!started) {
+        spiStart(&WS2812_SPI, &ws2812_spi_config);
+        started = true;
+    }
+    // the previous frame might still be going out of the buffer
+    while (WS2812_SPI.state == SPI_ACTIVE) {
+        chThdSleepMicroseconds(100);
+    }
+    uint16_t encoded = WS2812_ENCODED_LENGTH(length);
+    buffer[0] = 0;
+    ws2812_encode(data, length, buffer + 1);
+    for (uint16_t i = 0; i < WS2812_RESET_BYTES; i++) {
+        buffer[1 + encoded + i] = 0;
+    }
+    spiStartSend(&WS2812_SPI, 1 + encoded + WS2812_RESET_BYTES, buffer);
+}
+
+void ws2812_setleds(LED_TYPE *ledarray, uint16_t leds) {
+    send_array((const uint8_t*)ledarray, leds * sizeof(LED_TYPE));
+}
+
+void ws2812_setleds_rgbw(LED_TYPE *ledarray, uint16_t leds) {
+    send_array((const uint8_t*)ledarray, leds * sizeof(LED_TYPE));
+}
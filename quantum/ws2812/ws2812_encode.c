@@ -0,0 +1,22 @@
+#include "ws2812_encode.h"
+
+// The 12 bit patterns of the 16 possible nibbles
+static const uint16_t nibble_patterns[16] = {
+    0x924, 0x926, 0x934, 0x936, 0x9A4, 0x9A6, 0x9B4, 0x9B6,
+    0xD24, 0xD26, 0xD34, 0xD36, 0xDA4, 0xDA6, 0xDB4, 0xDB6,
+};
+
+void ws2812_encode_byte(uint8_t value, uint8_t* out) {
+    uint16_t high = nibble_patterns[value >> 4];
+    uint16_t low = nibble_patterns[value & 0xF];
+    out[0] = high >> 4;
+    out[1] = (high << 4) | (low >> 8);
+    out[2] = low;
+}
+
+void ws2812_encode(const uint8_t* data, uint16_t length, uint8_t* out) {
+    while (length--) {
+        ws2812_encode_byte(*data++, out);
+        out += 3;
+    }
+}
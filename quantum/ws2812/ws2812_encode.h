@@ -0,0 +1,24 @@
+#ifndef WS2812_ENCODE_H
+#define WS2812_ENCODE_H
+
+#include <stdint.h>
+
+/*
+ * Turns LED data into a bit stream for a serial peripheral (SPI, or a
+ * USART in SPI mode) clocked at about 2.67MHz, so that the peripheral
+ * generates the WS2812 timing instead of the CPU.
+ *
+ * Every data bit becomes three bits on the wire, 100 for a zero and 110
+ * for a one. At 375ns per bit that is a 375ns or 750ns high pulse in a
+ * 1125ns period, inside the WS2812 and SK6812 tolerances. Each data byte
+ * becomes three bytes, sent MSB first.
+ */
+
+#define WS2812_ENCODED_LENGTH(length) ((length) * 3)
+
+// Encodes one byte into out[0..2]
+void ws2812_encode_byte(uint8_t value, uint8_t* out);
+// Encodes length bytes into WS2812_ENCODED_LENGTH(length) bytes of out
+void ws2812_encode(const uint8_t* data, uint16_t length, uint8_t* out);
+
+#endif
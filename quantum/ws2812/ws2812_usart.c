@@ -0,0 +1,80 @@
+/*
+ * WS2812 driver using USART1 of the ATmega32U4 in SPI master mode
+ *
+ * The USART shifts out the encoded bit stream of ws2812_encode.h, so the
+ * timing comes from the hardware. The three bit symbols run across the
+ * bytes on the wire, and a byte written late would hold the line high in
+ * the middle of a symbol, so the three bytes of every data byte are written
+ * with interrupts disabled, for about 9us each. Those three end with a
+ * complete symbol, which ends low, so an interrupt between data bytes only
+ * stretches a low phase, which the LEDs accept as long as it is shorter
+ * than their latch time.
+ *
+ * The data comes out on TXD1 (D3), so RGB_DI_PIN has to be D3. XCK1 (D5) is
+ * driven as the SPI clock and can't be used for anything else.
+ */
+
+#include <stdbool.h>
+#include <avr/io.h>
+#include <util/atomic.h>
+#include <util/delay.h>
+#include "light_ws2812.h"
+#include "ws2812_encode.h"
+
+#if RGB_DI_PIN != D3
+#error "The usart WS2812 driver needs RGB_DI_PIN to be D3 (TXD1)"
+#endif
+
+#if F_CPU != 16000000
+#error "The usart WS2812 driver needs a 16MHz clock"
+#endif
+
+// F_CPU / (2 * (UBRR + 1)) = 2.67MHz
+#define WS2812_USART_UBRR 2
+
+static void usart_init(void) {
+    static bool initialized = false;
+    if (initialized) {
+        return;
+    }
+    initialized = true;
+    // the baud rate register has to be zero while the mode is set up
+    UBRR1 = 0;
+    DDRD |= (1<<5) | (1<<3);
+    PORTD &= ~(1<<3);
+    // master SPI mode, MSB first
+    UCSR1C = (1<<UMSEL11) | (1<<UMSEL10);
+    UCSR1B = (1<<TXEN1);
+    UBRR1 = WS2812_USART_UBRR;
+}
+
+static void usart_send(uint8_t byte) {
+    while (!(UCSR1A & (1<<UDRE1)));
+    UDR1 = byte;
+}
+
+static void send_array(const uint8_t* data, uint16_t length) {
+    usart_init();
+    uint8_t encoded[3];
+    // clear the complete flag, it's set once the last byte is shifted out
+    UCSR1A |= (1<<TXC1);
+    while (length--) {
+        ws2812_encode_byte(*data++, encoded);
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            usart_send(encoded[0]);
+            usart_send(encoded[1]);
+            usart_send(encoded[2]);
+        }
+    }
+    while (!(UCSR1A & (1<<TXC1)));
+}
+
+void ws2812_setleds(LED_TYPE *ledarray, uint16_t leds) {
+    send_array((const uint8_t*)ledarray, leds * sizeof(LED_TYPE));
+    _delay_us(50);
+}
+
+void ws2812_setleds_rgbw(LED_TYPE *ledarray, uint16_t leds) {
+    send_array((const uint8_t*)ledarray, leds * sizeof(LED_TYPE));
+    _delay_us(80);
+}
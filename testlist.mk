@@ -1,4 +1,12 @@
 include $(ROOT_DIR)/quantum/serial_link/tests/testlist.mk
+include $(ROOT_DIR)/quantum/split_common/tests/testlist.mk
+include $(ROOT_DIR)/quantum/ws2812/tests/testlist.mk
+include $(ROOT_DIR)/quantum/color/tests/testlist.mk
+include $(ROOT_DIR)/quantum/rgb_reactive/tests/testlist.mk
+include $(ROOT_DIR)/quantum/audio/tests/testlist.mk
+include $(ROOT_DIR)/quantum/process_keycode/tests/testlist.mk
+include $(ROOT_DIR)/tmk_core/common/tests/testlist.mk
+include $(ROOT_DIR)/tmk_core/protocol/tests/testlist.mk
 
 define VALIDATE_TEST_LIST
     ifneq ($1,)
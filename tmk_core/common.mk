@@ -41,7 +41,8 @@ else
 endif
 
 ifeq ($(strip $(MOUSEKEY_ENABLE)), yes)
-    TMK_COMMON_SRC += $(COMMON_DIR)/mousekey.c
+    TMK_COMMON_SRC += $(COMMON_DIR)/mousekey.c \
+        $(COMMON_DIR)/mousekey_motion.c
     TMK_COMMON_DEFS += -DMOUSEKEY_ENABLE
     TMK_COMMON_DEFS += -DMOUSE_ENABLE
 endif
@@ -61,6 +62,15 @@ else
     TMK_COMMON_DEFS += -DNO_DEBUG
 endif
 
+ifeq ($(strip $(TRACE_ENABLE)), yes)
+    TMK_COMMON_SRC += $(COMMON_DIR)/trace.c
+    TMK_COMMON_DEFS += -DTRACE_ENABLE
+endif
+
+ifeq ($(strip $(TRACE_BINARY)), yes)
+    TMK_COMMON_DEFS += -DTRACE_BINARY
+endif
+
 ifeq ($(strip $(COMMAND_ENABLE)), yes)
     TMK_COMMON_SRC += $(COMMON_DIR)/command.c
     TMK_COMMON_DEFS += -DCOMMAND_ENABLE
@@ -80,6 +90,11 @@ ifeq ($(strip $(SLEEP_LED_ENABLE)), yes)
     TMK_COMMON_DEFS += -DNO_SUSPEND_POWER_DOWN
 endif
 
+ifeq ($(strip $(IDLE_SCAN_ENABLE)), yes)
+    TMK_COMMON_SRC += $(COMMON_DIR)/idle_scan.c
+    TMK_COMMON_DEFS += -DIDLE_SCAN_ENABLE
+endif
+
 ifeq ($(strip $(NO_UART)), yes)
     TMK_COMMON_DEFS += -DNO_UART
 endif
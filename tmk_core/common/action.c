@@ -43,8 +43,7 @@ int tp_buttons;
 void action_exec(keyevent_t event)
 {
     if (!IS_NOEVENT(event)) {
-        dprint("\n---- action_exec: start -----\n");
-        dprint("EVENT: "); debug_event(event); dprintln();
+        dtrace(ACTION_EXEC, TRACE_EVENT_ARGS(event));
     }
 
 #ifdef FAUXCLICKY_ENABLE
@@ -77,7 +76,7 @@ void action_exec(keyevent_t event)
 #else
     process_record(&record);
     if (!IS_NOEVENT(record.event)) {
-        dprint("processed: "); debug_record(record); dprintln();
+        dtrace(PROCESSED_EVENT, TRACE_EVENT_ARGS(record.event));
     }
 #endif
 }
@@ -131,12 +130,13 @@ void process_record(keyrecord_t *record)
         return;
 
     action_t action = store_or_get_action(record->event.pressed, record->event.key);
-    dprint("ACTION: "); debug_action(action);
 #ifndef NO_ACTION_LAYER
-    dprint(" layer_state: "); layer_debug();
-    dprint(" default_layer_state: "); default_layer_debug();
+    dtrace(ACTION, action.kind.id, action.kind.param>>8, action.kind.param&0xff,
+           (uint16_t)(layer_state>>16), (uint16_t)layer_state,
+           (uint16_t)(default_layer_state>>16), (uint16_t)default_layer_state);
+#else
+    dtrace(ACTION_NO_LAYER, action.kind.id, action.kind.param>>8, action.kind.param&0xff);
 #endif
-    dprintln();
 
     process_action(record, action);
 }
@@ -101,6 +101,10 @@ void debug_event(keyevent_t event);
 void debug_record(keyrecord_t record);
 void debug_action(action_t action);
 
+/* arguments of an event "%04X%c(%u)" and a record "%04X%c(%u):%u%c" in dtrace() */
+#define TRACE_EVENT_ARGS(e)     ((e).key.row<<8 | (e).key.col), ((e).pressed ? 'd' : 'u'), (e).time
+#define TRACE_RECORD_ARGS(r)    TRACE_EVENT_ARGS((r).event), (r).tap.count, ((r).tap.interrupted ? '-' : ' ')
+
 #ifdef __cplusplus
 }
 #endif
@@ -40,7 +40,7 @@ void action_tapping_process(keyrecord_t record)
 {
     if (process_tapping(&record)) {
         if (!IS_NOEVENT(record.event)) {
-            debug("processed: "); debug_record(record); debug("\n");
+            dtrace(PROCESSED, TRACE_RECORD_ARGS(record));
         }
     } else {
         if (!waiting_buffer_enq(record)) {
@@ -58,8 +58,7 @@ void action_tapping_process(keyrecord_t record)
     }
     for (; waiting_buffer_tail != waiting_buffer_head; waiting_buffer_tail = (waiting_buffer_tail + 1) % WAITING_BUFFER_SIZE) {
         if (process_tapping(&waiting_buffer[waiting_buffer_tail])) {
-            debug("processed: waiting_buffer["); debug_dec(waiting_buffer_tail); debug("] = ");
-            debug_record(waiting_buffer[waiting_buffer_tail]); debug("\n\n");
+            dtrace(WAITING_PROCESSED, waiting_buffer_tail, TRACE_RECORD_ARGS(waiting_buffer[waiting_buffer_tail]));
         } else {
             break;
         }
@@ -69,6 +68,11 @@ void action_tapping_process(keyrecord_t record)
     }
 }
 
+bool action_tapping_pending(void)
+{
+    return !IS_NOEVENT(tapping_key.event) || waiting_buffer_head != waiting_buffer_tail;
+}
+
 
 /* Tapping
  *
@@ -183,8 +187,7 @@ bool process_tapping(keyrecord_t *keyp)
         // after TAPPING_TERM
         else {
             if (tapping_key.tap.count == 0) {
-                debug("Tapping: End. Timeout. Not tap(0): ");
-                debug_event(event); debug("\n");
+                dtrace(TAPPING_TIMEOUT, TRACE_EVENT_ARGS(event));
                 process_record(&tapping_key);
                 tapping_key = (keyrecord_t){};
                 debug_tapping_key();
@@ -265,8 +268,7 @@ bool process_tapping(keyrecord_t *keyp)
         } else {
             // FIX: process_aciton here?
             // timeout. no sequential tap.
-            debug("Tapping: End(Timeout after releasing last tap): ");
-            debug_event(event); debug("\n");
+            dtrace(TAPPING_RELEASED, TRACE_EVENT_ARGS(event));
             tapping_key = (keyrecord_t){};
             debug_tapping_key();
             return false;
@@ -363,16 +365,16 @@ void waiting_buffer_scan_tap(void)
  */
 static void debug_tapping_key(void)
 {
-    debug("TAPPING_KEY="); debug_record(tapping_key); debug("\n");
+    dtrace(TAPPING_KEY, TRACE_RECORD_ARGS(tapping_key));
 }
 
 static void debug_waiting_buffer(void)
 {
-    debug("{ ");
+    dtrace(WAITING_BEGIN);
     for (uint8_t i = waiting_buffer_tail; i != waiting_buffer_head; i = (i + 1) % WAITING_BUFFER_SIZE) {
-        debug("["); debug_dec(i); debug("]="); debug_record(waiting_buffer[i]); debug(" ");
+        dtrace(WAITING_ENTRY, i, TRACE_RECORD_ARGS(waiting_buffer[i]));
     }
-    debug("}\n");
+    dtrace(WAITING_END);
 }
 
 #endif
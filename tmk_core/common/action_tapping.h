@@ -34,6 +34,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #ifndef NO_ACTION_TAPPING
 void action_tapping_process(keyrecord_t record);
+/* whether a tap is undecided or events wait for one */
+bool action_tapping_pending(void);
 #endif
 
 #endif
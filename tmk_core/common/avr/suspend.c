@@ -10,6 +10,7 @@
 #include "timer.h"
 #include "led.h"
 #include "host.h"
+#include "eeconfig.h"
 
 #ifdef PROTOCOL_LUFA
 	#include "lufa.h"
@@ -105,6 +106,7 @@ static void power_down(uint8_t wdto)
 
 void suspend_power_down(void)
 {
+    eeconfig_commit();
 #ifndef NO_SUSPEND_POWER_DOWN
     power_down(WDTO_15MS);
 #endif
@@ -2,6 +2,7 @@
 #include "hal.h"
 
 #include "eeconfig.h"
+#include "eeprom.h"
 
 /*************************************/
 /*          Hardware backend         */
@@ -367,15 +368,64 @@ static void flash_write(const uint16_t *code, uint32_t addr, uint32_t data)
 	MCM->PLACR |= MCM_PLACR_CFCC;
 }
 
-void eeprom_write_byte(uint8_t *addr, uint8_t data)
+// Erases the work area and writes it back with len bytes at offset
+// replaced, for when the log of writes is full
+static void flash_rewrite(uint32_t offset, const uint8_t *data, uint32_t len)
 {
-	uint32_t offset = (uint32_t)addr;
-	const uint16_t *p, *end = (const uint16_t *)((uint32_t)flashend);
+	const uint16_t *p;
 	uint32_t i, val, flashaddr;
 	uint16_t do_flash_cmd[] = {
 		0x2380, 0x7003, 0x7803, 0xb25b, 0x2b00, 0xdafb, 0x4770};
 	uint8_t buf[EEPROM_SIZE];
 
+	for (i=0; i < EEPROM_SIZE; i++) {
+		buf[i] = 0xFF;
+	}
+	val = 0;
+	for (p = (uint16_t *)SYMVAL(__eeprom_workarea_start__); p < (uint16_t *)SYMVAL(__eeprom_workarea_end__); p++) {
+		val = *p;
+		if ((val & 255) < EEPROM_SIZE) {
+			buf[val & 255] = val >> 8;
+		}
+	}
+	for (i=0; i < len && offset + i < EEPROM_SIZE; i++) {
+		buf[offset + i] = data[i];
+	}
+	for (flashaddr=(uint32_t)(uint16_t *)SYMVAL(__eeprom_workarea_start__); flashaddr < (uint32_t)(uint16_t *)SYMVAL(__eeprom_workarea_end__); flashaddr += 1024) {
+		*(uint32_t *)&(FTFA->FCCOB3) = 0x09000000 | flashaddr;
+		__disable_irq();
+		(*((void (*)(volatile uint8_t *))((uint32_t)do_flash_cmd | 1)))(&(FTFA->FSTAT));
+		__enable_irq();
+		val = FTFA->FSTAT & (FTFA_FSTAT_RDCOLERR|FTFA_FSTAT_ACCERR|FTFA_FSTAT_FPVIOL);;
+		if (val) FTFA->FSTAT = val;
+		MCM->PLACR |= MCM_PLACR_CFCC;
+	}
+	flashaddr=(uint32_t)(uint16_t *)SYMVAL(__eeprom_workarea_start__);
+	for (i=0; i < EEPROM_SIZE; i++) {
+		if (buf[i] == 0xFF) continue;
+		if ((flashaddr & 2) == 0) {
+			val = (buf[i] << 8) | i;
+		} else {
+			val = val | (buf[i] << 24) | (i << 16);
+			flash_write(do_flash_cmd, flashaddr, val);
+		}
+		flashaddr += 2;
+	}
+	flashend = flashaddr;
+	if ((flashaddr & 2)) {
+		val |= 0xFFFF0000;
+		flash_write(do_flash_cmd, flashaddr, val);
+	}
+}
+
+void eeprom_write_byte(uint8_t *addr, uint8_t data)
+{
+	uint32_t offset = (uint32_t)addr;
+	const uint16_t *end = (const uint16_t *)((uint32_t)flashend);
+	uint32_t val, flashaddr;
+	uint16_t do_flash_cmd[] = {
+		0x2380, 0x7003, 0x7803, 0xb25b, 0x2b00, 0xdafb, 0x4770};
+
 	if (offset >= EEPROM_SIZE) return;
 	if (!end) {
 		eeprom_initialize();
@@ -393,42 +443,30 @@ void eeprom_write_byte(uint8_t *addr, uint8_t data)
 		}
 		flash_write(do_flash_cmd, flashaddr, val);
 	} else {
-		for (i=0; i < EEPROM_SIZE; i++) {
-			buf[i] = 0xFF;
-		}
-		val = 0;
-		for (p = (uint16_t *)SYMVAL(__eeprom_workarea_start__); p < (uint16_t *)SYMVAL(__eeprom_workarea_end__); p++) {
-			val = *p;
-			if ((val & 255) < EEPROM_SIZE) {
-				buf[val & 255] = val >> 8;
-			}
-		}
-		buf[offset] = data;
-		for (flashaddr=(uint32_t)(uint16_t *)SYMVAL(__eeprom_workarea_start__); flashaddr < (uint32_t)(uint16_t *)SYMVAL(__eeprom_workarea_end__); flashaddr += 1024) {
-			*(uint32_t *)&(FTFA->FCCOB3) = 0x09000000 | flashaddr;
-			__disable_irq();
-			(*((void (*)(volatile uint8_t *))((uint32_t)do_flash_cmd | 1)))(&(FTFA->FSTAT));
-			__enable_irq();
-			val = FTFA->FSTAT & (FTFA_FSTAT_RDCOLERR|FTFA_FSTAT_ACCERR|FTFA_FSTAT_FPVIOL);;
-			if (val) FTFA->FSTAT = val;
-			MCM->PLACR |= MCM_PLACR_CFCC;
-		}
-		flashaddr=(uint32_t)(uint16_t *)SYMVAL(__eeprom_workarea_start__);
-		for (i=0; i < EEPROM_SIZE; i++) {
-			if (buf[i] == 0xFF) continue;
-			if ((flashaddr & 2) == 0) {
-				val = (buf[i] << 8) | i;
-			} else {
-				val = val | (buf[i] << 24) | (i << 16);
-				flash_write(do_flash_cmd, flashaddr, val);
+		flash_rewrite(offset, &data, 1);
+	}
+}
+
+// Logs the bytes that changed, or rewrites the work area once when they
+// don't all fit instead of filling it up and erasing it halfway through
+static void flash_update_block(uint32_t offset, const uint8_t *src, uint32_t len)
+{
+	uint32_t i, changed = 0;
+
+	if (offset >= EEPROM_SIZE) return;
+	if (offset + len > EEPROM_SIZE) len = EEPROM_SIZE - offset;
+	for (i=0; i < len; i++) {
+		if (eeprom_read_byte((const uint8_t *)(offset + i)) != src[i]) changed++;
+	}
+	if (!changed) return;
+	if ((const uint16_t *)((uint32_t)flashend) + changed < (uint16_t *)SYMVAL(__eeprom_workarea_end__)) {
+		for (i=0; i < len; i++) {
+			if (eeprom_read_byte((const uint8_t *)(offset + i)) != src[i]) {
+				eeprom_write_byte((uint8_t *)(offset + i), src[i]);
 			}
-			flashaddr += 2;
-		}
-		flashend = flashaddr;
-		if ((flashaddr & 2)) {
-			val |= 0xFFFF0000;
-			flash_write(do_flash_cmd, flashaddr, val);
 		}
+	} else {
+		flash_rewrite(offset, src, len);
 	}
 }
 
@@ -559,30 +597,31 @@ void eeprom_write_block(const void *buf, void *addr, uint32_t len) {
 }
 
 #endif /* chip selection */
-// The update functions just calls write for now, but could probably be optimized
+// The update functions only write the bytes that changed, every write wears
+// the flash behind the emulated EEPROMs
 
 void eeprom_update_byte(uint8_t *addr, uint8_t value) {
-	eeprom_write_byte(addr, value);
+	if (eeprom_read_byte(addr) != value) {
+		eeprom_write_byte(addr, value);
+	}
 }
 
 void eeprom_update_word(uint16_t *addr, uint16_t value) {
-	uint8_t *p = (uint8_t *)addr;
-	eeprom_write_byte(p++, value);
-	eeprom_write_byte(p, value >> 8);
+	eeprom_update_block(&value, addr, sizeof(value));
 }
 
 void eeprom_update_dword(uint32_t *addr, uint32_t value) {
-	uint8_t *p = (uint8_t *)addr;
-	eeprom_write_byte(p++, value);
-	eeprom_write_byte(p++, value >> 8);
-	eeprom_write_byte(p++, value >> 16);
-	eeprom_write_byte(p, value >> 24);
+	eeprom_update_block(&value, addr, sizeof(value));
 }
 
 void eeprom_update_block(const void *buf, void *addr, uint32_t len) {
+#if defined(KL2x)
+	flash_update_block((uint32_t)addr, (const uint8_t *)buf, len);
+#else
 	uint8_t *p = (uint8_t *)addr;
 	const uint8_t *src = (const uint8_t *)buf;
 	while (len--) {
-		eeprom_write_byte(p++, *src++);
+		eeprom_update_byte(p++, *src++);
 	}
+#endif
 }
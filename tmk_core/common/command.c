@@ -257,6 +257,13 @@ static void print_status(void)
 #   if USB_COUNT_SOF
     print_val_hex8(usbSofCount);
 #   endif
+#endif
+
+    print_val_dec(eeconfig_writes);
+    print_val_dec(eeconfig_writes_coalesced);
+
+#ifdef RGBLIGHT_ENABLE
+    rgblight_print_stats();
 #endif
 	return;
 }
@@ -583,6 +590,8 @@ static void mousekey_param_print(void)
     print("4: time_to_max: "); pdec(mk_time_to_max); print("\n");
     print("5: wheel_max_speed: "); pdec(mk_wheel_max_speed); print("\n");
     print("6: wheel_time_to_max: "); pdec(mk_wheel_time_to_max); print("\n");
+    print("7: curve: "); pdec(mk_curve); print("\n");
+    print("8: friction: "); pdec(mk_friction); print("\n");
 #endif /* !NO_PRINT */
 
 }
@@ -634,6 +643,20 @@ static void mousekey_param_inc(uint8_t param, uint8_t inc)
                 mk_wheel_time_to_max = UINT8_MAX;
             PRINT_SET_VAL(mk_wheel_time_to_max);
             break;
+        case 7:
+            if (mk_curve + inc < MOUSEKEY_CURVE_TABLE)
+                mk_curve += inc;
+            else
+                mk_curve = MOUSEKEY_CURVE_TABLE;
+            PRINT_SET_VAL(mk_curve);
+            break;
+        case 8:
+            if (mk_friction + inc < UINT8_MAX)
+                mk_friction += inc;
+            else
+                mk_friction = UINT8_MAX;
+            PRINT_SET_VAL(mk_friction);
+            break;
     }
 }
 
@@ -682,6 +705,20 @@ static void mousekey_param_dec(uint8_t param, uint8_t dec)
                 mk_wheel_time_to_max = 0;
             PRINT_SET_VAL(mk_wheel_time_to_max);
             break;
+        case 7:
+            if (mk_curve > dec)
+                mk_curve -= dec;
+            else
+                mk_curve = 0;
+            PRINT_SET_VAL(mk_curve);
+            break;
+        case 8:
+            if (mk_friction > dec)
+                mk_friction -= dec;
+            else
+                mk_friction = 0;
+            PRINT_SET_VAL(mk_friction);
+            break;
     }
 }
 
@@ -695,6 +732,8 @@ static void mousekey_console_help(void)
           "4:	time_to_max\n"
           "5:	wheel_max_speed\n"
           "6:	wheel_time_to_max\n"
+          "7:	curve(0: linear, 1: quadratic, 2: table)\n"
+          "8:	friction(/256 per interval, 0: off)\n"
           "\n"
           "p:	print values\n"
           "d:	set defaults\n"
@@ -703,7 +742,8 @@ static void mousekey_console_help(void)
           "pgup:	+10\n"
           "pgdown:	-10\n"
           "\n"
-          "speed = delta * max_speed * (repeat / time_to_max)\n");
+          "speed = delta + delta * (max_speed - 1) * curve(time / (time_to_max * interval))\n"
+          "in units per interval, with the fractions kept\n");
     xprintf("where delta: cursor=%d, wheel=%d\n"
             "See http://en.wikipedia.org/wiki/Mouse_keys\n", MOUSEKEY_MOVE_DELTA,  MOUSEKEY_WHEEL_DELTA);
 }
@@ -734,6 +774,8 @@ static bool mousekey_console(uint8_t code)
         case KC_4:
         case KC_5:
         case KC_6:
+        case KC_7:
+        case KC_8:
             mousekey_param = numkey2num(code);
             break;
         case KC_UP:
@@ -755,6 +797,8 @@ static bool mousekey_console(uint8_t code)
             mk_time_to_max = MOUSEKEY_TIME_TO_MAX;
             mk_wheel_max_speed = MOUSEKEY_WHEEL_MAX_SPEED;
             mk_wheel_time_to_max = MOUSEKEY_WHEEL_TIME_TO_MAX;
+            mk_curve = MOUSEKEY_CURVE;
+            mk_friction = MOUSEKEY_FRICTION;
             print("set default\n");
             break;
         default:
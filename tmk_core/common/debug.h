@@ -20,6 +20,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <stdbool.h>
 #include "print.h"
+#include "trace_formats.h"
+#ifdef TRACE_ENABLE
+#   include "trace.h"
+#endif
 
 
 #ifdef __cplusplus
@@ -63,6 +67,13 @@ extern debug_config_t debug_config;
 #define dprintf(fmt, ...)           do { if (debug_enable) xprintf(fmt, ##__VA_ARGS__); } while (0)
 #define dmsg(s)                     dprintf("%s at %s: %S\n", __FILE__, __LINE__, PSTR(s))
 
+/* A format from trace_formats.h, stored to be formatted later with TRACE_ENABLE */
+#ifdef TRACE_ENABLE
+#define dtrace(name, ...)           do { if (debug_enable) trace(name, ##__VA_ARGS__); } while (0)
+#else
+#define dtrace(name, ...)           dprintf(TRACE_FORMAT_##name, ##__VA_ARGS__)
+#endif
+
 /* Deprecated. DO NOT USE these anymore, use dprintf instead. */
 #define debug(s)                    do { if (debug_enable) print(s); } while (0)
 #define debugln(s)                  do { if (debug_enable) println(s); } while (0)
@@ -93,6 +104,7 @@ extern debug_config_t debug_config;
 #define dprintln(s)
 #define dprintf(fmt, ...)
 #define dmsg(s)
+#define dtrace(name, ...)
 #define debug(s)
 #define debugln(s)
 #define debug_msg(s)
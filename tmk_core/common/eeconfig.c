@@ -2,9 +2,90 @@
 #include <stdbool.h>
 #include "eeprom.h"
 #include "eeconfig.h"
+#include "timer.h"
+
+#define CACHE_SIZE (EECONFIG_CACHE_END - EECONFIG_CACHE_START)
+
+#if CACHE_SIZE > 16
+#error "The eeconfig cache keeps one bit per byte in a uint16_t, it can't be larger than 16 bytes"
+#endif
+
+static uint8_t cache[CACHE_SIZE];
+// one bit per byte of the cache
+static uint16_t cache_valid;
+static uint16_t cache_dirty;
+static uint16_t last_update;
+
+uint16_t eeconfig_writes;
+uint16_t eeconfig_writes_coalesced;
+
+void eeconfig_read_cached(const void* addr, void* data, uint8_t length)
+{
+    uint8_t offset = (uintptr_t)addr - EECONFIG_CACHE_START;
+    uint8_t* out = data;
+    for (uint8_t i = offset; i < offset + length; i++) {
+        if (!(cache_valid & ((uint16_t)1 << i))) {
+            cache[i] = eeprom_read_byte((const uint8_t*)(uintptr_t)(EECONFIG_CACHE_START + i));
+            cache_valid |= (uint16_t)1 << i;
+        }
+        *out++ = cache[i];
+    }
+}
+
+void eeconfig_update_cached(void* addr, const void* data, uint8_t length)
+{
+    uint8_t offset = (uintptr_t)addr - EECONFIG_CACHE_START;
+    const uint8_t* in = data;
+    bool pending = cache_dirty != 0;
+    bool changed = false;
+    for (uint8_t i = offset; i < offset + length; i++, in++) {
+        uint8_t current;
+        eeconfig_read_cached((const void*)(uintptr_t)(EECONFIG_CACHE_START + i), &current, 1);
+        if (current == *in) {
+            continue;
+        }
+        cache[i] = *in;
+        cache_dirty |= (uint16_t)1 << i;
+        changed = true;
+    }
+    if (changed) {
+        if (pending) {
+            eeconfig_writes_coalesced++;
+        }
+        last_update = timer_read();
+    }
+}
+
+void eeconfig_commit(void)
+{
+    if (!cache_dirty) {
+        return;
+    }
+    uint8_t first = 0;
+    while (!(cache_dirty & ((uint16_t)1 << first))) first++;
+    uint8_t last = CACHE_SIZE - 1;
+    while (!(cache_dirty & ((uint16_t)1 << last))) last--;
+    // the clean bytes in between go along, so it's a single block write
+    uint8_t length = last - first + 1;
+    uint8_t block[CACHE_SIZE];
+    eeconfig_read_cached((const void*)(uintptr_t)(EECONFIG_CACHE_START + first), block, length);
+    eeprom_update_block(block, (void*)(uintptr_t)(EECONFIG_CACHE_START + first), length);
+    cache_dirty = 0;
+    eeconfig_writes++;
+}
+
+void eeconfig_task(void)
+{
+    if (cache_dirty && timer_elapsed(last_update) >= EECONFIG_WRITE_DELAY) {
+        eeconfig_commit();
+    }
+}
 
 void eeconfig_init(void)
 {
+    // everything below is written directly
+    cache_valid = 0;
+    cache_dirty = 0;
     eeprom_update_word(EECONFIG_MAGIC,          EECONFIG_MAGIC_NUMBER);
     eeprom_update_byte(EECONFIG_DEBUG,          0);
     eeprom_update_byte(EECONFIG_DEFAULT_LAYER,  0);
@@ -19,6 +100,9 @@ void eeconfig_init(void)
 #ifdef RGBLIGHT_ENABLE
     eeprom_update_dword(EECONFIG_RGBLIGHT,      0);
 #endif
+#ifdef STENO_ENABLE
+    eeprom_update_byte(EECONFIG_STENOMODE,      0);
+#endif
 }
 
 void eeconfig_enable(void)
@@ -46,11 +130,11 @@ uint8_t eeconfig_read_keymap(void)      { return eeprom_read_byte(EECONFIG_KEYMA
 void eeconfig_update_keymap(uint8_t val) { eeprom_update_byte(EECONFIG_KEYMAP, val); }
 
 #ifdef BACKLIGHT_ENABLE
-uint8_t eeconfig_read_backlight(void)      { return eeprom_read_byte(EECONFIG_BACKLIGHT); }
-void eeconfig_update_backlight(uint8_t val) { eeprom_update_byte(EECONFIG_BACKLIGHT, val); }
+uint8_t eeconfig_read_backlight(void)      { uint8_t val; eeconfig_read_cached(EECONFIG_BACKLIGHT, &val, 1); return val; }
+void eeconfig_update_backlight(uint8_t val) { eeconfig_update_cached(EECONFIG_BACKLIGHT, &val, 1); }
 #endif
 
 #ifdef AUDIO_ENABLE
-uint8_t eeconfig_read_audio(void)      { return eeprom_read_byte(EECONFIG_AUDIO); }
-void eeconfig_update_audio(uint8_t val) { eeprom_update_byte(EECONFIG_AUDIO, val); }
+uint8_t eeconfig_read_audio(void)      { uint8_t val; eeconfig_read_cached(EECONFIG_AUDIO, &val, 1); return val; }
+void eeconfig_update_audio(uint8_t val) { eeconfig_update_cached(EECONFIG_AUDIO, &val, 1); }
 #endif
@@ -34,6 +34,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define EECONFIG_AUDIO                              (uint8_t *)7
 #define EECONFIG_RGBLIGHT                           (uint32_t *)8
 #define EECONFIG_UNICODEMODE                        (uint8_t *)12
+#define EECONFIG_STENOMODE                          (uint8_t *)13
 
 
 /* debug bit */
@@ -80,4 +81,31 @@ uint8_t eeconfig_read_audio(void);
 void eeconfig_update_audio(uint8_t val);
 #endif
 
+/* Write-back cache
+ *
+ * The settings changed by holding down keys (backlight, audio, rgblight,
+ * unicode mode and steno mode) go through a cache in RAM. They are written
+ * to the EEPROM once they haven't changed for EECONFIG_WRITE_DELAY ms, when
+ * the keyboard suspends, or when eeconfig_commit is called, so a row of
+ * quick changes costs one write.
+ */
+#ifndef EECONFIG_WRITE_DELAY
+#define EECONFIG_WRITE_DELAY 1000
+#endif
+
+#define EECONFIG_CACHE_START                        6
+#define EECONFIG_CACHE_END                          14
+
+// Reads and writes any part of the cached area
+void eeconfig_read_cached(const void* addr, void* data, uint8_t length);
+void eeconfig_update_cached(void* addr, const void* data, uint8_t length);
+// Writes the cached changes once EECONFIG_WRITE_DELAY has passed
+void eeconfig_task(void);
+// Writes the cached changes right away
+void eeconfig_commit(void);
+
+// Writes to the EEPROM, and updates that only changed the cache
+extern uint16_t eeconfig_writes;
+extern uint16_t eeconfig_writes_coalesced;
+
 #endif
@@ -0,0 +1,79 @@
+/*
+Copyright 2011 Jun Wako <wakojun@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include "idle_scan.h"
+
+void idle_scan_init(idle_scan_t *scan, uint32_t now)
+{
+    memset(scan, 0, sizeof(*scan));
+    scan->active = now;
+    scan->since = now;
+}
+
+bool idle_scan_should_rest(idle_scan_t *scan, bool idle, uint32_t now)
+{
+    if (!idle) {
+        scan->active = now;
+        return false;
+    }
+    if (now - scan->active < IDLE_SCAN_GRACE * 1000UL) {
+        return false;
+    }
+    // an edge that never made a key: bounce or noise
+    scan->woken = false;
+    return true;
+}
+
+void idle_scan_key(idle_scan_t *scan, uint32_t now)
+{
+    if (scan->woken) {
+        uint32_t latency = now - scan->edge;
+        scan->stats.keys++;
+        scan->stats.latency_sum += latency;
+        if (latency > scan->stats.latency_max) {
+            scan->stats.latency_max = latency;
+        }
+        scan->woken = false;
+    }
+}
+
+void idle_scan_rested(idle_scan_t *scan, uint32_t start, uint32_t end,
+                      bool woken, uint32_t edge)
+{
+    scan->stats.rested += end - start;
+    if (woken) {
+        scan->stats.wakes++;
+        scan->woken = true;
+        scan->edge = edge;
+        // scan flat out while the matrix debounces it
+        scan->active = end;
+    }
+}
+
+bool idle_scan_report(idle_scan_t *scan, uint32_t now, idle_scan_stats_t *stats)
+{
+    uint32_t time = now - scan->since;
+    if (time < IDLE_SCAN_REPORT * 1000UL) {
+        return false;
+    }
+    *stats = scan->stats;
+    stats->time = time;
+    memset(&scan->stats, 0, sizeof(scan->stats));
+    scan->since = now;
+    return true;
+}
@@ -0,0 +1,94 @@
+/*
+Copyright 2011 Jun Wako <wakojun@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef IDLE_SCAN_H
+#define IDLE_SCAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Idle aware scanning
+ *
+ * The main loop asks idle_scan_should_rest() after every keyboard_task(),
+ * and calls idle_scan_key() when that passed a key change on to the
+ * actions. While keyboard_is_idle() is false, and for
+ * IDLE_SCAN_GRACE ms after that, the answer is no and the matrix is
+ * scanned flat out. After that the loop rests between scans: until a key
+ * edge wakes it, if the matrix can raise an interrupt for one, and
+ * IDLE_SCAN_WAKE_TIMEOUT ms at most so slow timers still run, or
+ * IDLE_SCAN_INTERVAL ms otherwise. Times are in microseconds from a clock
+ * that is allowed to wrap.
+ *
+ * Along the way it counts how much of the time was spent resting and how
+ * long after the edge that woke it the first key was processed. The
+ * matrix is debouncing from the edge on, so the keyboard isn't idle any
+ * more well before that key gets through.
+ */
+
+// Full rate scanning after the keyboard last had something to do. Long
+// enough for the tapping term and timers of that order to run out.
+#ifndef IDLE_SCAN_GRACE
+#define IDLE_SCAN_GRACE 250
+#endif
+
+// Between scans when idle and the matrix can't wake the keyboard
+#ifndef IDLE_SCAN_INTERVAL
+#define IDLE_SCAN_INTERVAL 5
+#endif
+
+// Longest rest while waiting for a key edge
+#ifndef IDLE_SCAN_WAKE_TIMEOUT
+#define IDLE_SCAN_WAKE_TIMEOUT 50
+#endif
+
+// How often the statistics are reported, with debug enabled
+#ifndef IDLE_SCAN_REPORT
+#define IDLE_SCAN_REPORT 10000
+#endif
+
+typedef struct {
+    uint32_t time;          // us the statistics cover
+    uint32_t rested;        // us of it spent resting
+    uint16_t wakes;         // rests ended by a key edge
+    uint16_t keys;          // of those, how many turned out to be a key
+    uint32_t latency_sum;   // us from the edge to the first key processed
+    uint32_t latency_max;
+} idle_scan_stats_t;
+
+typedef struct {
+    uint32_t active;        // when the keyboard last had something to do
+    uint32_t edge;          // the edge that ended the last rest
+    bool woken;             // waiting for the key of that edge
+    uint32_t since;         // start of the statistics
+    idle_scan_stats_t stats;
+} idle_scan_t;
+
+void idle_scan_init(idle_scan_t *scan, uint32_t now);
+bool idle_scan_should_rest(idle_scan_t *scan, bool idle, uint32_t now);
+// A key change reached the actions; the first after a wake is timed
+void idle_scan_key(idle_scan_t *scan, uint32_t now);
+// A rest from start to end is over; woken if a key edge at edge ended it
+void idle_scan_rested(idle_scan_t *scan, uint32_t start, uint32_t end,
+                      bool woken, uint32_t edge);
+// Every IDLE_SCAN_REPORT ms, hands over the statistics and starts anew
+bool idle_scan_report(idle_scan_t *scan, uint32_t now, idle_scan_stats_t *stats);
+
+// Called by the matrix wake interrupt, with the system locked
+void idle_scan_wake_i(void);
+
+#endif
@@ -31,6 +31,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "eeconfig.h"
 #include "backlight.h"
 #include "action_layer.h"
+#include "action_tapping.h"
 #ifdef BOOTMAGIC_ENABLE
 #   include "bootmagic.h"
 #else
@@ -60,6 +61,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifdef VISUALIZER_ENABLE
 #   include "visualizer/visualizer.h"
 #endif
+#if defined(UCIS_ENABLE) || defined(UNICODE_ENABLE) || defined(UNICODEMAP_ENABLE)
+#   include "process_unicode_common.h"
+#endif
+#ifdef TRACE_ENABLE
+#   include "trace.h"
+#endif
 
 #ifdef MATRIX_HAS_GHOST
 extern const uint16_t keymaps[][MATRIX_ROWS][MATRIX_COLS];
@@ -112,6 +119,15 @@ __attribute__ ((weak))
 void matrix_setup(void) {
 }
 
+__attribute__ ((weak))
+bool matrix_is_debouncing(void) {
+    return false;
+}
+
+/* matrix state the actions have seen */
+static matrix_row_t matrix_prev[MATRIX_ROWS];
+static bool key_processed;
+
 void keyboard_setup(void) {
     matrix_setup();
 }
@@ -153,7 +169,6 @@ void keyboard_init(void) {
  */
 void keyboard_task(void)
 {
-    static matrix_row_t matrix_prev[MATRIX_ROWS];
 #ifdef MATRIX_HAS_GHOST
   //  static matrix_row_t matrix_ghost[MATRIX_ROWS];
 #endif
@@ -161,7 +176,16 @@ void keyboard_task(void)
     matrix_row_t matrix_row = 0;
     matrix_row_t matrix_change = 0;
 
+    key_processed = false;
     matrix_scan();
+#if defined(UCIS_ENABLE) || defined(UNICODE_ENABLE) || defined(UNICODEMAP_ENABLE)
+    // Keys wait for the character being typed, or they would land in the
+    // middle of its input sequence with its mods held. Their changes stay
+    // in the matrix and are picked up once it's done.
+    if (unicode_stream_busy()) {
+        goto MATRIX_LOOP_END;
+    }
+#endif
     for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
         matrix_row = matrix_get_row(r);
         matrix_change = matrix_row ^ matrix_prev[r];
@@ -190,6 +214,7 @@ void keyboard_task(void)
                     });
                     // record a processed key
                     matrix_prev[r] ^= ((matrix_row_t)1<<c);
+                    key_processed = true;
                     // process a key per task call
                     goto MATRIX_LOOP_END;
                 }
@@ -222,15 +247,54 @@ MATRIX_LOOP_END:
 	serial_link_update();
 #endif
 
+#if defined(UCIS_ENABLE) || defined(UNICODE_ENABLE) || defined(UNICODEMAP_ENABLE)
+    unicode_stream_task();
+#endif
+
 #ifdef VISUALIZER_ENABLE
     visualizer_update(default_layer_state, layer_state, visualizer_get_mods(), host_keyboard_leds());
 #endif
 
+    eeconfig_task();
+
     // update LED
     if (led_status != host_keyboard_leds()) {
         led_status = host_keyboard_leds();
         keyboard_set_leds(led_status);
     }
+
+#ifdef TRACE_ENABLE
+    // format what was traced, now that the event is done with
+    trace_task();
+#endif
+}
+
+/*
+ * Nothing is pressed, about to be or in the middle of a tap. What's left,
+ * like mousekey acceleration or one shot timeouts, can run at a slower
+ * pace; see idle_scan.h.
+ */
+bool keyboard_is_idle(void)
+{
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+        if (matrix_prev[r] || matrix_get_row(r)) {
+            return false;
+        }
+    }
+    if (matrix_is_debouncing()) {
+        return false;
+    }
+#ifndef NO_ACTION_TAPPING
+    if (action_tapping_pending()) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+bool keyboard_key_processed(void)
+{
+    return key_processed;
 }
 
 void keyboard_set_leds(uint8_t leds)
@@ -65,6 +65,10 @@ void keyboard_init(void);
 void keyboard_task(void);
 /* it runs when host LED status is updated */
 void keyboard_set_leds(uint8_t leds);
+/* whether keyboard_task() has nothing to do until a key changes */
+bool keyboard_is_idle(void);
+/* whether the last keyboard_task() passed a key change to the actions */
+bool keyboard_key_processed(void);
 
 #ifdef __cplusplus
 }
@@ -62,6 +62,13 @@ void matrix_print(void);
 void matrix_power_up(void);
 void matrix_power_down(void);
 
+/* whether a change is being debounced (optional) */
+bool matrix_is_debouncing(void);
+/* drive all rows and arm interrupts on the columns, so that a key press
+ * wakes the keyboard; false if the matrix can't (optional) */
+bool matrix_wake_enable(void);
+void matrix_wake_disable(void);
+
 /* executes code for Quantum */
 void matrix_init_quantum(void);
 void matrix_scan_quantum(void);
@@ -22,12 +22,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "print.h"
 #include "debug.h"
 #include "mousekey.h"
+#include "mousekey_motion.h"
 
 
 
 static report_mouse_t mouse_report = {};
-static uint8_t mousekey_repeat =  0;
+static uint8_t mousekey_keys = 0;
 static uint8_t mousekey_accel = 0;
+static mousekey_motion_t move_motion;
+static mousekey_motion_t wheel_motion;
 
 static void mousekey_debug(void);
 
@@ -36,7 +39,8 @@ static void mousekey_debug(void);
  * Mouse keys  acceleration algorithm
  *  http://en.wikipedia.org/wiki/Mouse_keys
  *
- *  speed = delta * max_speed * (repeat / time_to_max)**((1000+curve)/1000)
+ * The parameters below are turned into fixed point speeds by
+ * mousekey_motion.c, which keeps the fractions of units between reports.
  */
 /* milliseconds between the initial key press and first repeated motion event (0-2550) */
 uint8_t mk_delay = MOUSEKEY_DELAY/10;
@@ -46,151 +50,224 @@ uint8_t mk_interval = MOUSEKEY_INTERVAL;
 uint8_t mk_max_speed = MOUSEKEY_MAX_SPEED;
 /* number of events (count) accelerating to steady speed (0-255) */
 uint8_t mk_time_to_max = MOUSEKEY_TIME_TO_MAX;
-/* ramp used to reach maximum pointer speed (NOT SUPPORTED) */
-//int8_t mk_curve = 0;
+/* ramp used to reach maximum pointer speed, see MOUSEKEY_CURVE_* */
+uint8_t mk_curve = MOUSEKEY_CURVE;
+/* speed lost each event after release, out of 256, 0 stops at once */
+uint8_t mk_friction = MOUSEKEY_FRICTION;
 /* wheel params */
 uint8_t mk_wheel_max_speed = MOUSEKEY_WHEEL_MAX_SPEED;
 uint8_t mk_wheel_time_to_max = MOUSEKEY_WHEEL_TIME_TO_MAX;
 
 
+/* Reports go out every mk_interval ms of the USB frame clock when there
+ * is one, so they don't drift with the scan rate. Without it, the timer
+ * is used, also when the frames stop for MOUSEKEY_FRAME_TIMEOUT ms, as
+ * they do while USB is suspended or the reports go over Bluetooth. Time
+ * left over from one report counts towards the next. */
+static volatile uint8_t frame_count = 0;
+static uint8_t last_frame = 0;
+static uint16_t last_frame_timer = 0;
 static uint16_t last_timer = 0;
+static uint16_t pending_time = 0;
 
+void mousekey_frame(void)
+{
+    frame_count++;
+}
 
-static uint8_t move_unit(void)
+static uint16_t elapsed_time(void)
 {
-    uint16_t unit;
-    if (mousekey_accel & (1<<0)) {
-        unit = (MOUSEKEY_MOVE_DELTA * mk_max_speed)/4;
-    } else if (mousekey_accel & (1<<1)) {
-        unit = (MOUSEKEY_MOVE_DELTA * mk_max_speed)/2;
-    } else if (mousekey_accel & (1<<2)) {
-        unit = (MOUSEKEY_MOVE_DELTA * mk_max_speed);
-    } else if (mousekey_repeat == 0) {
-        unit = MOUSEKEY_MOVE_DELTA;
-    } else if (mousekey_repeat >= mk_time_to_max) {
-        unit = MOUSEKEY_MOVE_DELTA * mk_max_speed;
-    } else {
-        unit = (MOUSEKEY_MOVE_DELTA * mk_max_speed * mousekey_repeat) / mk_time_to_max;
+    uint16_t now = timer_read();
+    uint16_t elapsed = TIMER_DIFF_16(now, last_timer);
+    last_timer = now;
+
+    uint8_t frame = frame_count;
+    if (frame != last_frame) {
+        uint8_t frames = frame - last_frame;
+        last_frame = frame;
+        last_frame_timer = now;
+        return frames;
     }
-    return (unit > MOUSEKEY_MOVE_MAX ? MOUSEKEY_MOVE_MAX : (unit == 0 ? 1 : unit));
+    if (TIMER_DIFF_16(now, last_frame_timer) < MOUSEKEY_FRAME_TIMEOUT) {
+        /* the next frame is on its way */
+        return 0;
+    }
+    return elapsed;
 }
 
-static uint8_t wheel_unit(void)
+static void move_config(mousekey_motion_config_t *config)
 {
-    uint16_t unit;
-    if (mousekey_accel & (1<<0)) {
-        unit = (MOUSEKEY_WHEEL_DELTA * mk_wheel_max_speed)/4;
-    } else if (mousekey_accel & (1<<1)) {
-        unit = (MOUSEKEY_WHEEL_DELTA * mk_wheel_max_speed)/2;
-    } else if (mousekey_accel & (1<<2)) {
-        unit = (MOUSEKEY_WHEEL_DELTA * mk_wheel_max_speed);
-    } else if (mousekey_repeat == 0) {
-        unit = MOUSEKEY_WHEEL_DELTA;
-    } else if (mousekey_repeat >= mk_wheel_time_to_max) {
-        unit = MOUSEKEY_WHEEL_DELTA * mk_wheel_max_speed;
-    } else {
-        unit = (MOUSEKEY_WHEEL_DELTA * mk_wheel_max_speed * mousekey_repeat) / mk_wheel_time_to_max;
-    }
-    return (unit > MOUSEKEY_WHEEL_MAX ? MOUSEKEY_WHEEL_MAX : (unit == 0 ? 1 : unit));
+    *config = (mousekey_motion_config_t){
+        .delay = mk_delay * 10,
+        .interval = mk_interval ? mk_interval : 1,
+        .delta = MOUSEKEY_MOVE_DELTA,
+        .max_speed = mk_max_speed,
+        .time_to_max = mk_time_to_max,
+        .limit = MOUSEKEY_MOVE_MAX,
+        .curve = mk_curve,
+        .friction = mk_friction,
+    };
 }
 
-void mousekey_task(void)
+static void wheel_config(mousekey_motion_config_t *config)
 {
-    if (timer_elapsed(last_timer) < (mousekey_repeat ? mk_interval : mk_delay*10))
-        return;
+    move_config(config);
+    config->delta = MOUSEKEY_WHEEL_DELTA;
+    config->max_speed = mk_wheel_max_speed;
+    config->time_to_max = mk_wheel_time_to_max;
+    config->limit = MOUSEKEY_WHEEL_MAX;
+}
 
-    if (mouse_report.x == 0 && mouse_report.y == 0 && mouse_report.v == 0 && mouse_report.h == 0)
-        return;
+#define KEY_UP       (1<<0)
+#define KEY_DOWN     (1<<1)
+#define KEY_LEFT     (1<<2)
+#define KEY_RIGHT    (1<<3)
+#define KEY_WH_UP    (1<<4)
+#define KEY_WH_DOWN  (1<<5)
+#define KEY_WH_LEFT  (1<<6)
+#define KEY_WH_RIGHT (1<<7)
 
-    if (mousekey_repeat != UINT8_MAX)
-        mousekey_repeat++;
+static int8_t direction(uint8_t minus, uint8_t plus)
+{
+    return ((mousekey_keys & plus) ? 1 : 0) - ((mousekey_keys & minus) ? 1 : 0);
+}
 
+static int8_t add_clamped(int8_t a, int8_t b)
+{
+    int16_t sum = a + b;
+    return sum > 127 ? 127 : (sum < -127 ? -127 : sum);
+}
+
+/* Hands the held directions to the motion, which moves at once if it was standing still */
+static void mousekey_directions(void)
+{
+    mousekey_motion_config_t config;
+    int8_t x, y;
 
-    if (mouse_report.x > 0) mouse_report.x = move_unit();
-    if (mouse_report.x < 0) mouse_report.x = move_unit() * -1;
-    if (mouse_report.y > 0) mouse_report.y = move_unit();
-    if (mouse_report.y < 0) mouse_report.y = move_unit() * -1;
+    move_config(&config);
+    mousekey_motion_set(&move_motion, &config, direction(KEY_LEFT, KEY_RIGHT),
+                        direction(KEY_UP, KEY_DOWN), mousekey_accel, &x, &y);
+    mouse_report.x = add_clamped(mouse_report.x, x);
+    mouse_report.y = add_clamped(mouse_report.y, y);
 
-    /* diagonal move [1/sqrt(2) = 0.7] */
-    if (mouse_report.x && mouse_report.y) {
-        mouse_report.x *= 0.7;
-        mouse_report.y *= 0.7;
+    wheel_config(&config);
+    mousekey_motion_set(&wheel_motion, &config, direction(KEY_WH_LEFT, KEY_WH_RIGHT),
+                        direction(KEY_WH_DOWN, KEY_WH_UP), mousekey_accel, &x, &y);
+    mouse_report.h = add_clamped(mouse_report.h, x);
+    mouse_report.v = add_clamped(mouse_report.v, y);
+}
+
+void mousekey_task(void)
+{
+    uint16_t elapsed = elapsed_time();
+    if (!mousekey_motion_active(&move_motion) && !mousekey_motion_active(&wheel_motion)) {
+        pending_time = 0;
+        return;
     }
 
-    if (mouse_report.v > 0) mouse_report.v = wheel_unit();
-    if (mouse_report.v < 0) mouse_report.v = wheel_unit() * -1;
-    if (mouse_report.h > 0) mouse_report.h = wheel_unit();
-    if (mouse_report.h < 0) mouse_report.h = wheel_unit() * -1;
+    uint8_t interval = mk_interval ? mk_interval : 1;
+    pending_time += elapsed;
+    /* a long stall doesn't turn into a jump */
+    if (pending_time > 4 * interval)
+        pending_time = interval;
+
+    bool moved = false;
+    while (pending_time >= interval) {
+        mousekey_motion_config_t config;
+        int8_t x, y;
+        pending_time -= interval;
 
-    mousekey_send();
+        move_config(&config);
+        if (mousekey_motion_step(&move_motion, &config, mousekey_accel, &x, &y)) {
+            mouse_report.x = add_clamped(mouse_report.x, x);
+            mouse_report.y = add_clamped(mouse_report.y, y);
+            moved = true;
+        }
+        wheel_config(&config);
+        if (mousekey_motion_step(&wheel_motion, &config, mousekey_accel, &x, &y)) {
+            mouse_report.h = add_clamped(mouse_report.h, x);
+            mouse_report.v = add_clamped(mouse_report.v, y);
+            moved = true;
+        }
+    }
+    if (moved)
+        mousekey_send();
 }
 
 void mousekey_on(uint8_t code)
 {
-    if      (code == KC_MS_UP)       mouse_report.y = move_unit() * -1;
-    else if (code == KC_MS_DOWN)     mouse_report.y = move_unit();
-    else if (code == KC_MS_LEFT)     mouse_report.x = move_unit() * -1;
-    else if (code == KC_MS_RIGHT)    mouse_report.x = move_unit();
-    else if (code == KC_MS_WH_UP)    mouse_report.v = wheel_unit();
-    else if (code == KC_MS_WH_DOWN)  mouse_report.v = wheel_unit() * -1;
-    else if (code == KC_MS_WH_LEFT)  mouse_report.h = wheel_unit() * -1;
-    else if (code == KC_MS_WH_RIGHT) mouse_report.h = wheel_unit();
+    if      (code == KC_MS_UP)       mousekey_keys |= KEY_UP;
+    else if (code == KC_MS_DOWN)     mousekey_keys |= KEY_DOWN;
+    else if (code == KC_MS_LEFT)     mousekey_keys |= KEY_LEFT;
+    else if (code == KC_MS_RIGHT)    mousekey_keys |= KEY_RIGHT;
+    else if (code == KC_MS_WH_UP)    mousekey_keys |= KEY_WH_UP;
+    else if (code == KC_MS_WH_DOWN)  mousekey_keys |= KEY_WH_DOWN;
+    else if (code == KC_MS_WH_LEFT)  mousekey_keys |= KEY_WH_LEFT;
+    else if (code == KC_MS_WH_RIGHT) mousekey_keys |= KEY_WH_RIGHT;
     else if (code == KC_MS_BTN1)     mouse_report.buttons |= MOUSE_BTN1;
     else if (code == KC_MS_BTN2)     mouse_report.buttons |= MOUSE_BTN2;
     else if (code == KC_MS_BTN3)     mouse_report.buttons |= MOUSE_BTN3;
     else if (code == KC_MS_BTN4)     mouse_report.buttons |= MOUSE_BTN4;
     else if (code == KC_MS_BTN5)     mouse_report.buttons |= MOUSE_BTN5;
-    else if (code == KC_MS_ACCEL0)   mousekey_accel |= (1<<0);
-    else if (code == KC_MS_ACCEL1)   mousekey_accel |= (1<<1);
-    else if (code == KC_MS_ACCEL2)   mousekey_accel |= (1<<2);
+    else if (code == KC_MS_ACCEL0)   mousekey_accel |= MOUSEKEY_ACCEL_0;
+    else if (code == KC_MS_ACCEL1)   mousekey_accel |= MOUSEKEY_ACCEL_1;
+    else if (code == KC_MS_ACCEL2)   mousekey_accel |= MOUSEKEY_ACCEL_2;
+
+    mousekey_directions();
 }
 
 void mousekey_off(uint8_t code)
 {
-    if      (code == KC_MS_UP       && mouse_report.y < 0) mouse_report.y = 0;
-    else if (code == KC_MS_DOWN     && mouse_report.y > 0) mouse_report.y = 0;
-    else if (code == KC_MS_LEFT     && mouse_report.x < 0) mouse_report.x = 0;
-    else if (code == KC_MS_RIGHT    && mouse_report.x > 0) mouse_report.x = 0;
-    else if (code == KC_MS_WH_UP    && mouse_report.v > 0) mouse_report.v = 0;
-    else if (code == KC_MS_WH_DOWN  && mouse_report.v < 0) mouse_report.v = 0;
-    else if (code == KC_MS_WH_LEFT  && mouse_report.h < 0) mouse_report.h = 0;
-    else if (code == KC_MS_WH_RIGHT && mouse_report.h > 0) mouse_report.h = 0;
+    if      (code == KC_MS_UP)       mousekey_keys &= ~KEY_UP;
+    else if (code == KC_MS_DOWN)     mousekey_keys &= ~KEY_DOWN;
+    else if (code == KC_MS_LEFT)     mousekey_keys &= ~KEY_LEFT;
+    else if (code == KC_MS_RIGHT)    mousekey_keys &= ~KEY_RIGHT;
+    else if (code == KC_MS_WH_UP)    mousekey_keys &= ~KEY_WH_UP;
+    else if (code == KC_MS_WH_DOWN)  mousekey_keys &= ~KEY_WH_DOWN;
+    else if (code == KC_MS_WH_LEFT)  mousekey_keys &= ~KEY_WH_LEFT;
+    else if (code == KC_MS_WH_RIGHT) mousekey_keys &= ~KEY_WH_RIGHT;
     else if (code == KC_MS_BTN1) mouse_report.buttons &= ~MOUSE_BTN1;
     else if (code == KC_MS_BTN2) mouse_report.buttons &= ~MOUSE_BTN2;
     else if (code == KC_MS_BTN3) mouse_report.buttons &= ~MOUSE_BTN3;
     else if (code == KC_MS_BTN4) mouse_report.buttons &= ~MOUSE_BTN4;
     else if (code == KC_MS_BTN5) mouse_report.buttons &= ~MOUSE_BTN5;
-    else if (code == KC_MS_ACCEL0) mousekey_accel &= ~(1<<0);
-    else if (code == KC_MS_ACCEL1) mousekey_accel &= ~(1<<1);
-    else if (code == KC_MS_ACCEL2) mousekey_accel &= ~(1<<2);
+    else if (code == KC_MS_ACCEL0) mousekey_accel &= ~MOUSEKEY_ACCEL_0;
+    else if (code == KC_MS_ACCEL1) mousekey_accel &= ~MOUSEKEY_ACCEL_1;
+    else if (code == KC_MS_ACCEL2) mousekey_accel &= ~MOUSEKEY_ACCEL_2;
 
-    if (mouse_report.x == 0 && mouse_report.y == 0 && mouse_report.v == 0 && mouse_report.h == 0)
-        mousekey_repeat = 0;
+    mousekey_directions();
 }
 
+/* Sends the buttons and whatever has moved since the last report */
 void mousekey_send(void)
 {
     mousekey_debug();
     host_mouse_send(&mouse_report);
-    last_timer = timer_read();
+    mouse_report.x = 0;
+    mouse_report.y = 0;
+    mouse_report.v = 0;
+    mouse_report.h = 0;
 }
 
 void mousekey_clear(void)
 {
     mouse_report = (report_mouse_t){};
-    mousekey_repeat = 0;
+    mousekey_keys = 0;
     mousekey_accel = 0;
+    mousekey_motion_stop(&move_motion);
+    mousekey_motion_stop(&wheel_motion);
+    pending_time = 0;
 }
 
 static void mousekey_debug(void)
 {
     if (!debug_mouse) return;
-    print("mousekey [btn|x y v h](rep/acl): [");
+    print("mousekey [btn|x y v h](spd/acl): [");
     phex(mouse_report.buttons); print("|");
     print_decs(mouse_report.x); print(" ");
     print_decs(mouse_report.y); print(" ");
     print_decs(mouse_report.v); print(" ");
     print_decs(mouse_report.h); print("](");
-    print_dec(mousekey_repeat); print("/");
+    print_dec(move_motion.speed >> 8); print("/");
     print_dec(mousekey_accel); print(")\n");
 }
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <stdbool.h>
 #include "host.h"
+#include "mousekey_motion.h"
 
 
 /* max value on report descriptor */
@@ -59,6 +60,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MOUSEKEY_WHEEL_TIME_TO_MAX
 #define MOUSEKEY_WHEEL_TIME_TO_MAX 40
 #endif
+#ifndef MOUSEKEY_CURVE
+#define MOUSEKEY_CURVE MOUSEKEY_CURVE_LINEAR
+#endif
+#ifndef MOUSEKEY_FRICTION
+#define MOUSEKEY_FRICTION 0
+#endif
+/* ms without a USB frame before the timer takes over again */
+#ifndef MOUSEKEY_FRAME_TIMEOUT
+#define MOUSEKEY_FRAME_TIMEOUT 4
+#endif
 
 
 #ifdef __cplusplus
@@ -69,6 +80,8 @@ extern uint8_t mk_delay;
 extern uint8_t mk_interval;
 extern uint8_t mk_max_speed;
 extern uint8_t mk_time_to_max;
+extern uint8_t mk_curve;
+extern uint8_t mk_friction;
 extern uint8_t mk_wheel_max_speed;
 extern uint8_t mk_wheel_time_to_max;
 
@@ -78,6 +91,8 @@ void mousekey_on(uint8_t code);
 void mousekey_off(uint8_t code);
 void mousekey_clear(void);
 void mousekey_send(void);
+/* Call on every USB start of frame, once a millisecond */
+void mousekey_frame(void);
 
 #ifdef __cplusplus
 }
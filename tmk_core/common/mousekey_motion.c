@@ -0,0 +1,160 @@
+/*
+Copyright 2011 Jun Wako <wakojun@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "mousekey_motion.h"
+#include "progmem.h"
+
+// 1/sqrt(2) in 1/256
+#define DIAGONAL 181
+// Coasting stops below 1/8 unit per report
+#define COAST_MIN 32
+
+static const uint8_t curve_table[9] PROGMEM = MOUSEKEY_CURVE_TABLE_POINTS;
+
+// How far along the curve progress out of 255 is, out of 255
+static uint8_t curve(uint8_t type, uint8_t progress)
+{
+    switch (type) {
+        case MOUSEKEY_CURVE_QUADRATIC:
+            return (uint16_t)progress * progress / 255;
+        case MOUSEKEY_CURVE_TABLE: {
+            uint16_t point = (uint16_t)progress * 8;
+            uint8_t i = point / 255;
+            uint8_t from = pgm_read_byte(&curve_table[i]);
+            if (i == 8)
+                return from;
+            uint8_t to = pgm_read_byte(&curve_table[i + 1]);
+            return from + ((int16_t)(to - from) * (point % 255)) / 255;
+        }
+        default:
+            return progress;
+    }
+}
+
+uint16_t mousekey_motion_speed(const mousekey_motion_config_t *config, uint16_t held, uint8_t accel)
+{
+    uint16_t start = config->delta;
+    uint16_t full = config->delta * (config->max_speed ? config->max_speed : 1);
+    uint32_t speed;
+    if (accel & MOUSEKEY_ACCEL_0) {
+        speed = (uint32_t)full << 6;
+    } else if (accel & MOUSEKEY_ACCEL_1) {
+        speed = (uint32_t)full << 7;
+    } else if (accel & MOUSEKEY_ACCEL_2) {
+        speed = (uint32_t)full << 8;
+    } else if (held <= config->delay) {
+        speed = start << 8;
+    } else {
+        uint16_t span = config->time_to_max * config->interval;
+        uint16_t time = held - config->delay;
+        uint8_t progress = (span == 0 || time >= span) ? 255 : (uint32_t)time * 255 / span;
+        speed = ((uint32_t)start << 8) + (((int32_t)(full - start) << 8) * curve(config->curve, progress)) / 255;
+    }
+    if (speed > ((uint16_t)config->limit << 8)) {
+        speed = (uint16_t)config->limit << 8;
+    }
+    return speed;
+}
+
+// Adds one report's worth of dir at speed to rest, and takes the whole units
+static int8_t take(int16_t *rest, int8_t dir, uint16_t speed, uint8_t limit)
+{
+    int32_t total = *rest + (int32_t)dir * speed;
+    int16_t whole = total / 256;
+    if (whole > limit || whole < -limit) {
+        *rest = 0;
+        return whole > 0 ? limit : -limit;
+    }
+    *rest = total - whole * 256;
+    return whole;
+}
+
+static void move(mousekey_motion_t *motion, const mousekey_motion_config_t *config, int8_t *x, int8_t *y)
+{
+    int8_t dx = motion->x, dy = motion->y;
+    if (!dx && !dy) {
+        dx = motion->coast_x;
+        dy = motion->coast_y;
+    }
+    uint16_t speed = motion->speed;
+    if (dx && dy) {
+        speed = (uint32_t)speed * DIAGONAL / 256;
+    }
+    *x = take(&motion->rest_x, dx, speed, config->limit);
+    *y = take(&motion->rest_y, dy, speed, config->limit);
+    motion->coast_x = dx;
+    motion->coast_y = dy;
+}
+
+void mousekey_motion_set(mousekey_motion_t *motion, const mousekey_motion_config_t *config,
+                         int8_t dx, int8_t dy, uint8_t accel, int8_t *x, int8_t *y)
+{
+    bool starting = !motion->x && !motion->y;
+    motion->x = dx;
+    motion->y = dy;
+    *x = 0;
+    *y = 0;
+    if (!dx && !dy) {
+        if (!config->friction) {
+            mousekey_motion_stop(motion);
+        }
+        return;
+    }
+    if (starting) {
+        motion->held = 0;
+        motion->rest_x = 0;
+        motion->rest_y = 0;
+        motion->speed = mousekey_motion_speed(config, 0, accel);
+        move(motion, config, x, y);
+    }
+}
+
+bool mousekey_motion_step(mousekey_motion_t *motion, const mousekey_motion_config_t *config,
+                          uint8_t accel, int8_t *x, int8_t *y)
+{
+    *x = 0;
+    *y = 0;
+    if (motion->x || motion->y) {
+        if (motion->held < UINT16_MAX - config->interval) {
+            motion->held += config->interval;
+        }
+        if (motion->held < config->delay) {
+            return false;
+        }
+        motion->speed = mousekey_motion_speed(config, motion->held, accel);
+    } else if (motion->speed) {
+        motion->speed -= ((uint32_t)motion->speed * config->friction + 255) / 256;
+        if (motion->speed < COAST_MIN) {
+            mousekey_motion_stop(motion);
+            return false;
+        }
+    } else {
+        return false;
+    }
+    move(motion, config, x, y);
+    return *x || *y;
+}
+
+bool mousekey_motion_active(const mousekey_motion_t *motion)
+{
+    return motion->x || motion->y || motion->speed;
+}
+
+void mousekey_motion_stop(mousekey_motion_t *motion)
+{
+    *motion = (mousekey_motion_t){};
+}
@@ -0,0 +1,88 @@
+/*
+Copyright 2011 Jun Wako <wakojun@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MOUSEKEY_MOTION_H
+#define MOUSEKEY_MOTION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Mousekey motion in fixed point
+ *
+ * Speeds are in 1/256 of a unit per report, and what a report can't carry
+ * of a move is kept for the next one, so slow and diagonal moves come out
+ * right on average instead of being rounded down every report. The engine
+ * is stepped once per report interval and knows nothing of time otherwise,
+ * so the reports can go out at a steady rate whatever the scan does.
+ *
+ * From the first key, nothing more moves for delay ms. Then the speed goes
+ * from delta to delta * max_speed over time_to_max reports, following the
+ * curve: linear, quadratic (slow to start, for aiming) or a table of nine
+ * points from MOUSEKEY_CURVE_TABLE. With friction set, the motion is
+ * kinetic: on release it keeps going and loses friction/256 of its speed
+ * every report until it stops.
+ */
+
+#define MOUSEKEY_CURVE_LINEAR    0
+#define MOUSEKEY_CURVE_QUADRATIC 1
+#define MOUSEKEY_CURVE_TABLE     2
+
+// Fraction of the way from delta to full speed, out of 255, at 0/8 to 8/8
+// of time_to_max
+#ifndef MOUSEKEY_CURVE_TABLE_POINTS
+#define MOUSEKEY_CURVE_TABLE_POINTS {0, 4, 16, 40, 80, 140, 200, 240, 255}
+#endif
+
+typedef struct {
+    uint16_t delay;       // ms from the first key before it keeps moving
+    uint8_t interval;     // ms between reports
+    uint8_t delta;        // units per report at the start
+    uint8_t max_speed;    // delta times this at full speed
+    uint8_t time_to_max;  // reports from the delay to full speed
+    uint8_t limit;        // most a report can carry
+    uint8_t curve;
+    uint8_t friction;     // 0 stops on release
+} mousekey_motion_config_t;
+
+// ACCEL keys, fixed speeds of 1/4, 1/2 and all of full speed
+#define MOUSEKEY_ACCEL_0 (1 << 0)
+#define MOUSEKEY_ACCEL_1 (1 << 1)
+#define MOUSEKEY_ACCEL_2 (1 << 2)
+
+typedef struct {
+    int8_t x, y;            // directions held, -1, 0 or 1
+    int8_t coast_x, coast_y;
+    uint16_t held;          // ms the keys have been held
+    uint16_t speed;         // 1/256 units per report
+    int16_t rest_x, rest_y; // 1/256 units not sent yet
+} mousekey_motion_t;
+
+// Speed after holding for held ms
+uint16_t mousekey_motion_speed(const mousekey_motion_config_t *config, uint16_t held, uint8_t accel);
+
+// Sets the directions held. Starting from standstill gives the first move
+// at once, in x and y.
+void mousekey_motion_set(mousekey_motion_t *motion, const mousekey_motion_config_t *config,
+                         int8_t dx, int8_t dy, uint8_t accel, int8_t *x, int8_t *y);
+// Moves by one report interval, returns false if there's nothing to send
+bool mousekey_motion_step(mousekey_motion_t *motion, const mousekey_motion_config_t *config,
+                          uint8_t accel, int8_t *x, int8_t *y);
+bool mousekey_motion_active(const mousekey_motion_t *motion);
+void mousekey_motion_stop(mousekey_motion_t *motion);
+
+#endif
@@ -0,0 +1,116 @@
+#include "gtest/gtest.h"
+#include <cstring>
+extern "C" {
+#include "common/eeconfig.h"
+#include "common/timer.h"
+}
+
+// A fake EEPROM that counts the calls that would write to it
+static uint8_t eeprom[32];
+static unsigned eeprom_write_calls;
+static uint16_t now;
+
+extern "C" {
+uint8_t eeprom_read_byte(const uint8_t* p) { return eeprom[(uintptr_t)p]; }
+uint16_t eeprom_read_word(const uint16_t* p) {
+    return eeprom[(uintptr_t)p] | (eeprom[(uintptr_t)p + 1] << 8);
+}
+void eeprom_update_byte(uint8_t* p, uint8_t value) {
+    eeprom_write_calls++;
+    eeprom[(uintptr_t)p] = value;
+}
+void eeprom_update_word(uint16_t* p, uint16_t value) {
+    eeprom_write_calls++;
+    eeprom[(uintptr_t)p] = value;
+    eeprom[(uintptr_t)p + 1] = value >> 8;
+}
+void eeprom_update_dword(uint32_t* p, uint32_t value) {
+    eeprom_write_calls++;
+    memcpy(&eeprom[(uintptr_t)p], &value, 4);
+}
+void eeprom_update_block(const void* src, void* p, uint32_t n) {
+    eeprom_write_calls++;
+    memcpy(&eeprom[(uintptr_t)p], src, n);
+}
+
+uint16_t timer_read(void) { return now; }
+uint16_t timer_elapsed(uint16_t last) { return TIMER_DIFF_16(now, last); }
+}
+
+class EeconfigCache : public testing::Test {
+public:
+    EeconfigCache() {
+        memset(eeprom, 0, sizeof(eeprom));
+        now = 0;
+        eeconfig_init();
+        eeprom_write_calls = 0;
+        eeconfig_writes = 0;
+        eeconfig_writes_coalesced = 0;
+    }
+};
+
+TEST_F(EeconfigCache, rapid_updates_cause_a_single_write) {
+    for (uint8_t i = 1; i <= 20; i++) {
+        eeconfig_update_backlight(i);
+        now += 50;
+        eeconfig_task();
+    }
+    EXPECT_EQ(eeprom_write_calls, 0);
+    EXPECT_EQ(eeconfig_read_backlight(), 20);
+    now += EECONFIG_WRITE_DELAY;
+    eeconfig_task();
+    EXPECT_EQ(eeprom_write_calls, 1);
+    EXPECT_EQ(eeprom[EECONFIG_CACHE_START], 20);
+    EXPECT_EQ(eeconfig_writes, 1);
+    EXPECT_EQ(eeconfig_writes_coalesced, 19);
+}
+
+TEST_F(EeconfigCache, nothing_is_written_without_changes) {
+    eeconfig_update_backlight(0);
+    now += EECONFIG_WRITE_DELAY;
+    eeconfig_task();
+    eeconfig_commit();
+    EXPECT_EQ(eeprom_write_calls, 0);
+}
+
+TEST_F(EeconfigCache, commit_writes_right_away) {
+    eeconfig_update_audio(0x12);
+    eeconfig_commit();
+    EXPECT_EQ(eeprom_write_calls, 1);
+    EXPECT_EQ(eeprom[(uintptr_t)EECONFIG_AUDIO], 0x12);
+    now += EECONFIG_WRITE_DELAY;
+    eeconfig_task();
+    EXPECT_EQ(eeprom_write_calls, 1);
+}
+
+TEST_F(EeconfigCache, different_settings_share_a_write) {
+    uint32_t rgb = 0x11223344;
+    eeconfig_update_backlight(3);
+    eeconfig_update_cached(EECONFIG_RGBLIGHT, &rgb, sizeof(rgb));
+    eeconfig_commit();
+    EXPECT_EQ(eeprom_write_calls, 1);
+    EXPECT_EQ(eeprom[(uintptr_t)EECONFIG_BACKLIGHT], 3);
+    uint32_t stored;
+    memcpy(&stored, &eeprom[(uintptr_t)EECONFIG_RGBLIGHT], 4);
+    EXPECT_EQ(stored, rgb);
+}
+
+TEST_F(EeconfigCache, reads_come_from_the_eeprom_first) {
+    eeprom[(uintptr_t)EECONFIG_AUDIO] = 0x55;
+    eeconfig_init();
+    eeprom[(uintptr_t)EECONFIG_AUDIO] = 0x55;
+    EXPECT_EQ(eeconfig_read_audio(), 0x55);
+}
+
+TEST_F(EeconfigCache, the_write_delay_restarts_with_every_change) {
+    eeconfig_update_backlight(1);
+    now += EECONFIG_WRITE_DELAY - 1;
+    eeconfig_task();
+    eeconfig_update_backlight(2);
+    now += EECONFIG_WRITE_DELAY - 1;
+    eeconfig_task();
+    EXPECT_EQ(eeprom_write_calls, 0);
+    now += 1;
+    eeconfig_task();
+    EXPECT_EQ(eeprom_write_calls, 1);
+}
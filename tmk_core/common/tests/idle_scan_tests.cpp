@@ -0,0 +1,137 @@
+#include "gtest/gtest.h"
+extern "C" {
+#include "idle_scan.h"
+}
+
+#define MS 1000UL
+
+class IdleScan : public testing::Test {
+public:
+    idle_scan_t scan;
+    uint32_t start;
+
+    IdleScan() : start(0xFFFF0000UL) {
+        // close to wrapping, which it has to survive
+        idle_scan_init(&scan, start);
+    }
+};
+
+TEST_F(IdleScan, scans_flat_out_while_busy_and_for_the_grace_period) {
+    uint32_t now = start;
+    for (; now - start < 100 * MS; now += 500) {
+        EXPECT_FALSE(idle_scan_should_rest(&scan, false, now));
+    }
+    uint32_t last_busy = now - 500;
+    for (; now - last_busy < IDLE_SCAN_GRACE * MS; now += 500) {
+        EXPECT_FALSE(idle_scan_should_rest(&scan, true, now));
+    }
+    EXPECT_TRUE(idle_scan_should_rest(&scan, true, now));
+    EXPECT_FALSE(idle_scan_should_rest(&scan, false, now));
+    EXPECT_FALSE(idle_scan_should_rest(&scan, true, now + 1));
+}
+
+TEST_F(IdleScan, a_wake_scans_flat_out_and_times_the_first_key) {
+    uint32_t now = start + IDLE_SCAN_GRACE * MS;
+    ASSERT_TRUE(idle_scan_should_rest(&scan, true, now));
+
+    // an edge 30ms into the rest, noticed 20us later
+    uint32_t edge = now + 30 * MS;
+    idle_scan_rested(&scan, now, edge + 20, true, edge);
+    now = edge + 20;
+
+    // debouncing, which isn't idle, and the key comes through 5ms later
+    for (; now < edge + 5 * MS; now += 300) {
+        EXPECT_FALSE(idle_scan_should_rest(&scan, false, now));
+    }
+    idle_scan_key(&scan, now);
+    EXPECT_FALSE(idle_scan_should_rest(&scan, false, now));
+    // its release isn't timed
+    idle_scan_key(&scan, now + 80 * MS);
+    EXPECT_FALSE(idle_scan_should_rest(&scan, false, now + 100 * MS));
+
+    idle_scan_stats_t stats;
+    EXPECT_FALSE(idle_scan_report(&scan, now, &stats));
+    ASSERT_TRUE(idle_scan_report(&scan, start + IDLE_SCAN_REPORT * MS, &stats));
+    EXPECT_EQ(stats.time, IDLE_SCAN_REPORT * MS);
+    EXPECT_EQ(stats.rested, 30 * MS + 20);
+    EXPECT_EQ(stats.wakes, 1);
+    EXPECT_EQ(stats.keys, 1);
+    EXPECT_EQ(stats.latency_sum, now - edge);
+    EXPECT_EQ(stats.latency_max, now - edge);
+
+    // and starts anew
+    EXPECT_FALSE(idle_scan_report(&scan, start + IDLE_SCAN_REPORT * MS + 1, &stats));
+}
+
+TEST_F(IdleScan, an_edge_without_a_key_is_not_timed) {
+    uint32_t now = start + IDLE_SCAN_GRACE * MS;
+    ASSERT_TRUE(idle_scan_should_rest(&scan, true, now));
+    idle_scan_rested(&scan, now, now + MS, true, now + MS);
+    now += MS;
+    while (!idle_scan_should_rest(&scan, true, now)) {
+        now += 500;
+    }
+    EXPECT_EQ(now - start, (2 * IDLE_SCAN_GRACE + 1) * MS);
+
+    // a key much later, after a timed out rest
+    idle_scan_rested(&scan, now, now + IDLE_SCAN_WAKE_TIMEOUT * MS, false, 0);
+    idle_scan_key(&scan, now + IDLE_SCAN_WAKE_TIMEOUT * MS);
+    EXPECT_FALSE(idle_scan_should_rest(&scan, false, now + IDLE_SCAN_WAKE_TIMEOUT * MS));
+
+    idle_scan_stats_t stats;
+    ASSERT_TRUE(idle_scan_report(&scan, start + IDLE_SCAN_REPORT * MS, &stats));
+    EXPECT_EQ(stats.wakes, 1);
+    EXPECT_EQ(stats.keys, 0);
+    EXPECT_EQ(stats.latency_max, 0);
+}
+
+// Ten seconds with a key every two seconds, 5ms debounce: how much of the
+// time is spent resting, waking on an edge or polling
+TEST_F(IdleScan, idle_time) {
+    const uint32_t scan_time = 300;
+    for (bool wake : { true, false }) {
+        idle_scan_init(&scan, start);
+        uint32_t now = start;
+        uint32_t next_press = start + 1000 * MS;
+        uint32_t pressed = 0;
+        bool down = false;
+        idle_scan_stats_t stats;
+
+        while (!idle_scan_report(&scan, now, &stats)) {
+            // the matrix is busy from the edge on, debouncing, and the key
+            // is processed once debounced, held for 80ms
+            bool busy = down || now - start >= next_press - start;
+            bool key = false;
+            if (!down && now - start >= next_press - start + 5 * MS) {
+                down = true;
+                key = true;
+                pressed = next_press;
+                next_press += 2000 * MS;
+            } else if (down && now - pressed >= 85 * MS) {
+                down = false;
+                key = true;
+            }
+            now += scan_time;
+            if (key) {
+                idle_scan_key(&scan, now);
+            }
+            if (!idle_scan_should_rest(&scan, !busy, now)) {
+                continue;
+            }
+            uint32_t rest = (wake ? IDLE_SCAN_WAKE_TIMEOUT : IDLE_SCAN_INTERVAL) * MS;
+            if (wake && next_press - now < rest) {
+                idle_scan_rested(&scan, now, next_press + 20, true, next_press);
+                now = next_press + 20;
+            } else {
+                idle_scan_rested(&scan, now, now + rest, false, 0);
+                now += rest;
+            }
+        }
+        EXPECT_GT(stats.rested * 100.0 / stats.time, 75.0);
+        if (wake) {
+            EXPECT_EQ(stats.keys, 5);
+            EXPECT_GE(stats.latency_max, 5 * MS);
+            EXPECT_LE(stats.latency_max, 5 * MS + 2 * scan_time);
+        }
+    }
+}
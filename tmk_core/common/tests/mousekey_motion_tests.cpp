@@ -0,0 +1,300 @@
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+extern "C" {
+#include "common/mousekey_motion.h"
+#include "common/mousekey.h"
+#include "common/keycode.h"
+#include "common/debug.h"
+}
+
+// The host side of mousekey.c, every report it sends and a clock the test
+// moves along
+static std::vector<report_mouse_t> reports;
+static std::vector<uint16_t> report_times;
+static uint16_t now;
+
+extern "C" {
+debug_config_t debug_config;
+void host_mouse_send(report_mouse_t* report) {
+    reports.push_back(*report);
+    report_times.push_back(now);
+}
+uint16_t timer_read(void) { return now; }
+uint16_t timer_elapsed(uint16_t last) { return now - last; }
+}
+
+static mousekey_motion_config_t defaults(uint8_t curve = MOUSEKEY_CURVE_LINEAR, uint8_t friction = 0) {
+    return mousekey_motion_config_t{
+        MOUSEKEY_DELAY, MOUSEKEY_INTERVAL, MOUSEKEY_MOVE_DELTA, MOUSEKEY_MAX_SPEED,
+        MOUSEKEY_TIME_TO_MAX, MOUSEKEY_MOVE_MAX, curve, friction,
+    };
+}
+
+struct sample_t {
+    int time, x, y;
+};
+
+// Holds the direction for held ms, then lets go and runs for as long again,
+// and returns the position after every report
+static std::vector<sample_t> simulate(const mousekey_motion_config_t& config, int8_t dx, int8_t dy,
+                                      int held, uint8_t accel = 0) {
+    mousekey_motion_t motion = {};
+    std::vector<sample_t> path;
+    int8_t x, y;
+    int px = 0, py = 0;
+    mousekey_motion_set(&motion, &config, dx, dy, accel, &x, &y);
+    px += x;
+    py += y;
+    path.push_back({ 0, px, py });
+    for (int time = config.interval; time <= 2 * held; time += config.interval) {
+        if (time == held + config.interval) {
+            mousekey_motion_set(&motion, &config, 0, 0, accel, &x, &y);
+        }
+        mousekey_motion_step(&motion, &config, accel, &x, &y);
+        px += x;
+        py += y;
+        path.push_back({ time, px, py });
+    }
+    return path;
+}
+
+// What mousekey.c did before, an 8 bit unit per report, cut to 0.7 of it
+// on diagonals
+static int old_unit(const mousekey_motion_config_t& config, int repeat) {
+    int unit;
+    if (repeat == 0) {
+        unit = config.delta;
+    } else if (repeat >= config.time_to_max) {
+        unit = config.delta * config.max_speed;
+    } else {
+        unit = config.delta * config.max_speed * repeat / config.time_to_max;
+    }
+    return std::min(std::max(unit, 1), 127);
+}
+
+static std::vector<sample_t> simulate_old(const mousekey_motion_config_t& config, bool diagonal, int held) {
+    std::vector<sample_t> path;
+    int px = 0, repeat = 0;
+    for (int time = 0; time <= held; time += (repeat == 1 ? config.delay : config.interval)) {
+        int unit = old_unit(config, repeat);
+        if (repeat != 255) {
+            repeat++;
+        }
+        px += diagonal ? (int8_t)(unit * 0.7) : unit;
+        path.push_back({ time, px, diagonal ? px : 0 });
+    }
+    return path;
+}
+
+TEST(MousekeyMotion, speed_follows_the_curve) {
+    for (uint8_t curve : { MOUSEKEY_CURVE_LINEAR, MOUSEKEY_CURVE_QUADRATIC, MOUSEKEY_CURVE_TABLE }) {
+        mousekey_motion_config_t config = defaults(curve);
+        uint16_t ramp = config.time_to_max * config.interval;
+        EXPECT_EQ(mousekey_motion_speed(&config, 0, 0), config.delta * 256) << (int)curve;
+        EXPECT_EQ(mousekey_motion_speed(&config, config.delay, 0), config.delta * 256) << (int)curve;
+        EXPECT_EQ(mousekey_motion_speed(&config, config.delay + ramp, 0), config.delta * config.max_speed * 256)
+            << (int)curve;
+        uint16_t last = 0;
+        for (uint16_t held = 0; held < config.delay + ramp + 500; held += 10) {
+            uint16_t speed = mousekey_motion_speed(&config, held, 0);
+            EXPECT_GE(speed, last) << (int)curve << " " << held;
+            last = speed;
+        }
+    }
+    mousekey_motion_config_t linear = defaults(MOUSEKEY_CURVE_LINEAR);
+    mousekey_motion_config_t quadratic = defaults(MOUSEKEY_CURVE_QUADRATIC);
+    uint16_t half = linear.delay + linear.time_to_max * linear.interval / 2;
+    EXPECT_NEAR(mousekey_motion_speed(&linear, half, 0), (5 + 45 / 2.0) * 256, 256);
+    EXPECT_NEAR(mousekey_motion_speed(&quadratic, half, 0), (5 + 45 / 4.0) * 256, 256);
+}
+
+TEST(MousekeyMotion, accel_keys_are_fixed_speeds) {
+    mousekey_motion_config_t config = defaults();
+    EXPECT_EQ(mousekey_motion_speed(&config, 0, MOUSEKEY_ACCEL_0), 50 * 256 / 4);
+    EXPECT_EQ(mousekey_motion_speed(&config, 0, MOUSEKEY_ACCEL_1), 50 * 256 / 2);
+    EXPECT_EQ(mousekey_motion_speed(&config, 5000, MOUSEKEY_ACCEL_2), 50 * 256);
+    config.max_speed = 100;
+    EXPECT_EQ(mousekey_motion_speed(&config, 0, MOUSEKEY_ACCEL_2), 127 * 256);
+}
+
+TEST(MousekeyMotion, moves_at_once_then_waits_for_the_delay) {
+    mousekey_motion_config_t config = defaults();
+    std::vector<sample_t> path = simulate(config, 1, 0, 1000);
+    EXPECT_EQ(path[0].x, config.delta);
+    for (const sample_t& sample : path) {
+        if (sample.time < config.delay) {
+            EXPECT_EQ(sample.x, config.delta) << sample.time;
+        }
+    }
+    EXPECT_EQ(path[config.delay / config.interval].x, 2 * config.delta);
+}
+
+TEST(MousekeyMotion, nothing_is_lost_between_reports) {
+    // a wheel at one and a half notches a report
+    mousekey_motion_config_t config = defaults();
+    config.delta = 1;
+    config.max_speed = 3;
+    config.time_to_max = 2;
+    config.delay = 0;
+    config.limit = 127;
+    std::vector<sample_t> path = simulate(config, 0, 1, 2000);
+    // the ramp, and then 3 per report
+    int reports = 2000 / config.interval;
+    EXPECT_NEAR(path[reports].y, 1 + 2 + 3 * (reports - 1), 1);
+
+    // diagonally at one unit a report, each axis gets 0.7 of a unit, which
+    // used to be cut down to nothing
+    config.max_speed = 1;
+    path = simulate(config, 1, 1, 5000);
+    EXPECT_NEAR(path[100].x, 100 / sqrt(2), 1);
+    EXPECT_NEAR(path[100].y, 100 / sqrt(2), 1);
+}
+
+TEST(MousekeyMotion, diagonals_go_as_fast_as_straight_lines) {
+    mousekey_motion_config_t config = defaults();
+    std::vector<sample_t> straight = simulate(config, 1, 0, 3000);
+    std::vector<sample_t> diagonal = simulate(config, 1, 1, 3000);
+    double along = hypot(diagonal[60].x, diagonal[60].y);
+    EXPECT_NEAR(along / straight[60].x, 1.0, 0.01);
+
+    std::vector<sample_t> old_straight = simulate_old(config, false, 3000);
+    std::vector<sample_t> old_diagonal = simulate_old(config, true, 3000);
+    double old_along = hypot(old_diagonal.back().x, old_diagonal.back().y);
+    // 0.7 of a unit on each axis came to 0.984 of the straight line
+    EXPECT_LT(old_along / old_straight.back().x, 0.99);
+}
+
+TEST(MousekeyMotion, reports_are_clamped) {
+    mousekey_motion_config_t config = defaults();
+    config.max_speed = 255;
+    config.delay = 0;
+    std::vector<sample_t> path = simulate(config, -1, 0, 2000);
+    for (size_t i = 1; i < path.size(); i++) {
+        EXPECT_GE(path[i].x - path[i - 1].x, -127);
+    }
+}
+
+TEST(MousekeyMotion, kinetic_motion_coasts_to_a_stop) {
+    std::vector<sample_t> stops = simulate(defaults(), 1, 0, 1000);
+    std::vector<sample_t> coasts = simulate(defaults(MOUSEKEY_CURVE_LINEAR, 64), 1, 0, 1000);
+    size_t release = 1000 / MOUSEKEY_INTERVAL;
+    EXPECT_EQ(stops[release + 1].x, stops[release].x);
+    EXPECT_EQ(stops.back().x, stops[release].x);
+
+    // slowing down, give or take the fraction carried over
+    int last_step = coasts[release].x - coasts[release - 1].x;
+    for (size_t i = release + 1; i < coasts.size(); i++) {
+        int step = coasts[i].x - coasts[i - 1].x;
+        EXPECT_LE(step, last_step + 1) << i;
+        last_step = std::min(last_step, step);
+    }
+    EXPECT_GT(coasts[release + 1].x, coasts[release].x);
+    EXPECT_EQ(coasts.back().x, coasts[coasts.size() - 2].x);
+
+    mousekey_motion_t motion = {};
+    mousekey_motion_config_t config = defaults(MOUSEKEY_CURVE_LINEAR, 64);
+    int8_t x, y;
+    mousekey_motion_set(&motion, &config, 0, 1, 0, &x, &y);
+    mousekey_motion_set(&motion, &config, 0, 0, 0, &x, &y);
+    EXPECT_TRUE(mousekey_motion_active(&motion));
+    for (int i = 0; i < 100 && mousekey_motion_active(&motion); i++) {
+        mousekey_motion_step(&motion, &config, 0, &x, &y);
+        EXPECT_EQ(x, 0);
+        EXPECT_GE(y, 0);
+    }
+    EXPECT_FALSE(mousekey_motion_active(&motion));
+}
+
+// mousekey.c reports every interval of the clock however uneven the scans
+// are, and with USB frames coming in it goes by those
+class Mousekey : public testing::Test {
+public:
+    Mousekey() {
+        reports.clear();
+        report_times.clear();
+        now = 0;
+        mousekey_clear();
+    }
+    ~Mousekey() { mousekey_clear(); }
+
+    void run(int ms, bool frames) {
+        srand(3);
+        for (int end = now + ms; now < end;) {
+            // scans between 1 and 7 ms apart
+            int scan = 1 + rand() % 7;
+            for (int i = 0; i < scan; i++) {
+                now++;
+                if (frames) {
+                    mousekey_frame();
+                }
+            }
+            mousekey_task();
+        }
+    }
+};
+
+TEST_F(Mousekey, steady_reports_from_uneven_scans) {
+    mk_interval = 16;
+    mk_delay = 0;
+    mousekey_on(KC_MS_RIGHT);
+    mousekey_send();
+    run(2000, false);
+    mousekey_off(KC_MS_RIGHT);
+    mousekey_send();
+    int total = 0;
+    for (auto& report : reports) {
+        total += report.x;
+    }
+    // one report per interval, whatever the scans did
+    EXPECT_NEAR(reports.size(), 2000 / 16 + 2, 2);
+    std::vector<int> gaps;
+    for (size_t i = 2; i + 1 < report_times.size(); i++) {
+        gaps.push_back(report_times[i] - report_times[i - 1]);
+    }
+    double mean = 0;
+    for (int gap : gaps) mean += gap;
+    mean /= gaps.size();
+    EXPECT_NEAR(mean, 16, 0.5);
+    EXPECT_GT(total, 0);
+    mk_interval = MOUSEKEY_INTERVAL;
+    mk_delay = MOUSEKEY_DELAY / 10;
+}
+
+TEST_F(Mousekey, buttons_dont_repeat_the_move) {
+    mousekey_on(KC_MS_UP);
+    mousekey_send();
+    mousekey_on(KC_MS_BTN1);
+    mousekey_send();
+    ASSERT_EQ(reports.size(), 2u);
+    EXPECT_EQ(reports[0].y, -MOUSEKEY_MOVE_DELTA);
+    EXPECT_EQ(reports[1].y, 0);
+    EXPECT_EQ(reports[1].buttons, MOUSE_BTN1);
+}
+
+TEST_F(Mousekey, usb_frames_drive_the_reports) {
+    mk_delay = 0;
+    mousekey_on(KC_MS_WH_DOWN);
+    mousekey_send();
+    run(1000, true);
+    EXPECT_NEAR(reports.size(), 1000 / MOUSEKEY_INTERVAL + 1, 1);
+    for (auto& report : reports) {
+        EXPECT_LE(report.v, 0);
+    }
+    mk_delay = MOUSEKEY_DELAY / 10;
+}
+
+TEST_F(Mousekey, timer_takes_over_when_frames_stop) {
+    mk_delay = 0;
+    mousekey_on(KC_MS_WH_DOWN);
+    mousekey_send();
+    run(1000, true);
+    size_t with_frames = reports.size();
+    // suspended, or unplugged with the reports going over Bluetooth
+    run(1000, false);
+    EXPECT_NEAR(reports.size() - with_frames, 1000 / MOUSEKEY_INTERVAL, 1);
+    run(1000, true);
+    EXPECT_NEAR(reports.size() - with_frames, 2000 / MOUSEKEY_INTERVAL, 2);
+    mk_delay = MOUSEKEY_DELAY / 10;
+}
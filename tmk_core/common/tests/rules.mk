@@ -0,0 +1,19 @@
+tmk_core_eeconfig_DEFS := -DBACKLIGHT_ENABLE -DAUDIO_ENABLE
+tmk_core_eeconfig_SRC :=\
+	$(TMK_PATH)/common/tests/eeconfig_tests.cpp \
+	$(TMK_PATH)/common/eeconfig.c
+
+tmk_core_mousekey_motion_DEFS := -DMOUSEKEY_ENABLE -DNO_PRINT
+tmk_core_mousekey_motion_SRC :=\
+	$(TMK_PATH)/common/tests/mousekey_motion_tests.cpp \
+	$(TMK_PATH)/common/mousekey_motion.c \
+	$(TMK_PATH)/common/mousekey.c
+
+tmk_core_trace_DEFS := -DTRACE_ENABLE -DTRACE_BINARY
+tmk_core_trace_SRC :=\
+	$(TMK_PATH)/common/tests/trace_tests.cpp \
+	$(TMK_PATH)/common/trace.c
+
+tmk_core_idle_scan_SRC :=\
+	$(TMK_PATH)/common/tests/idle_scan_tests.cpp \
+	$(TMK_PATH)/common/idle_scan.c
@@ -0,0 +1,5 @@
+TEST_LIST +=\
+	tmk_core_eeconfig \
+	tmk_core_mousekey_motion \
+	tmk_core_trace \
+	tmk_core_idle_scan
@@ -0,0 +1,105 @@
+#include "gtest/gtest.h"
+#include <string>
+extern "C" {
+#include "trace.h"
+}
+
+static std::string output;
+
+extern "C" int8_t sendchar(uint8_t c) {
+    output += c;
+    return 0;
+}
+
+class Trace : public testing::Test {
+public:
+    Trace() {
+        trace_clear();
+        output.clear();
+    }
+
+    void log(uint8_t id, std::initializer_list<uint16_t> args) {
+        trace_log(id, args.size(), args.begin());
+    }
+};
+
+TEST_F(Trace, entries_come_back_in_order) {
+    trace(PROCESSED, 0x0102, 'd', 1000, 1, ' ');
+    trace(LOST, 7);
+    log(TRACE_ID_ACTION_NO_LAYER, {});
+
+    trace_entry_t entry;
+    ASSERT_TRUE(trace_read(&entry));
+    EXPECT_EQ(entry.id, TRACE_ID_PROCESSED);
+    ASSERT_EQ(entry.count, 5);
+    EXPECT_EQ(entry.args[0], 0x0102);
+    EXPECT_EQ(entry.args[1], 'd');
+    EXPECT_EQ(entry.args[2], 1000);
+    EXPECT_EQ(entry.args[3], 1);
+    EXPECT_EQ(entry.args[4], ' ');
+    EXPECT_EQ(entry.args[5], 0);
+    ASSERT_TRUE(trace_read(&entry));
+    EXPECT_EQ(entry.id, TRACE_ID_LOST);
+    EXPECT_EQ(entry.args[0], 7);
+    ASSERT_TRUE(trace_read(&entry));
+    EXPECT_EQ(entry.id, TRACE_ID_ACTION_NO_LAYER);
+    EXPECT_EQ(entry.count, 0);
+    EXPECT_FALSE(trace_read(&entry));
+}
+
+TEST_F(Trace, wraps_around) {
+    trace_entry_t entry;
+    for (uint16_t n = 0; n < 1000; n++) {
+        log(TRACE_ID_TAPPING_KEY, { n, (uint16_t)(n * 3), 0xFFFF });
+        log(TRACE_ID_LOST, { n });
+        ASSERT_TRUE(trace_read(&entry));
+        EXPECT_EQ(entry.id, TRACE_ID_TAPPING_KEY);
+        EXPECT_EQ(entry.args[0], n);
+        EXPECT_EQ(entry.args[1], (uint16_t)(n * 3));
+        EXPECT_EQ(entry.args[2], 0xFFFF);
+        ASSERT_TRUE(trace_read(&entry));
+        EXPECT_EQ(entry.args[0], n);
+    }
+    EXPECT_FALSE(trace_read(&entry));
+}
+
+TEST_F(Trace, full_ring_counts_what_it_drops) {
+    // 12 bytes each, one byte of the ring is always free
+    const int fit = (TRACE_BUFFER_SIZE - 1) / 12;
+    for (int n = 0; n < fit + 5; n++) {
+        log(TRACE_ID_PROCESSED, { (uint16_t)n, 'd', 0, 0, ' ' });
+    }
+    trace_entry_t entry;
+    for (int n = 0; n < fit; n++) {
+        ASSERT_TRUE(trace_read(&entry));
+        EXPECT_EQ(entry.args[0], n);
+    }
+    EXPECT_FALSE(trace_read(&entry));
+
+    log(TRACE_ID_PROCESSED, { 100, 'u', 0, 0, ' ' });
+    ASSERT_TRUE(trace_read(&entry));
+    EXPECT_EQ(entry.id, TRACE_ID_LOST);
+    EXPECT_EQ(entry.args[0], 5);
+    ASSERT_TRUE(trace_read(&entry));
+    EXPECT_EQ(entry.args[0], 100);
+    EXPECT_FALSE(trace_read(&entry));
+}
+
+TEST_F(Trace, task_sends_lines_of_hex) {
+    trace(ACTION_EXEC, 0x0304, 'u', 0x1234);
+    trace(LOST, 1);
+    trace(WAITING_END);
+    trace_task();
+    EXPECT_EQ(output, "~0103040375003412\n~00010100\n~0C00\n");
+
+    // a few at a time
+    for (int n = 0; n < TRACE_TASK_ENTRIES + 1; n++) {
+        trace(LOST, 1);
+    }
+    output.clear();
+    trace_task();
+    EXPECT_EQ(output.size(), TRACE_TASK_ENTRIES * 10);
+    output.clear();
+    trace_task();
+    EXPECT_EQ(output.size(), 10);
+}
@@ -0,0 +1,167 @@
+/*
+Copyright 2011 Jun Wako <wakojun@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "trace.h"
+#include "progmem.h"
+#ifdef TRACE_BINARY
+#   include "sendchar.h"
+#else
+#   include "print.h"
+#   if !defined(__AVR__) && !defined(PROTOCOL_CHIBIOS)
+#       include <stdio.h>
+#   endif
+#endif
+
+#define MASK (TRACE_BUFFER_SIZE - 1)
+
+#if TRACE_BUFFER_SIZE > 256 || (TRACE_BUFFER_SIZE & MASK)
+#   error "TRACE_BUFFER_SIZE must be a power of two up to 256"
+#endif
+
+/*
+ * An entry is its ID, the number of arguments and the arguments, low byte
+ * first. The writer only moves head, the reader only tail.
+ */
+static uint8_t buffer[TRACE_BUFFER_SIZE];
+static volatile uint8_t head;
+static volatile uint8_t tail;
+static uint8_t lost;
+
+static inline uint8_t put(uint8_t index, uint8_t id, uint8_t count, const uint16_t *args)
+{
+    buffer[index] = id;
+    index = (index + 1) & MASK;
+    buffer[index] = count;
+    index = (index + 1) & MASK;
+    for (uint8_t i = 0; i < count; i++) {
+        buffer[index] = args[i];
+        index = (index + 1) & MASK;
+        buffer[index] = args[i] >> 8;
+        index = (index + 1) & MASK;
+    }
+    return index;
+}
+
+void trace_log(uint8_t id, uint8_t count, const uint16_t *args)
+{
+    if (count > TRACE_ARGS_MAX) {
+        count = TRACE_ARGS_MAX;
+    }
+    uint8_t index = head;
+    uint8_t room = (tail - index - 1) & MASK;
+    uint8_t size = 2 + count * 2;
+    if (room < size + (lost ? 4 : 0)) {
+        if (lost < 255) {
+            lost++;
+        }
+        return;
+    }
+    if (lost) {
+        uint16_t count_lost = lost;
+        index = put(index, TRACE_ID_LOST, 1, &count_lost);
+        lost = 0;
+    }
+    head = put(index, id, count, args);
+}
+
+bool trace_read(trace_entry_t *entry)
+{
+    uint8_t index = tail;
+    if (index == head) {
+        return false;
+    }
+    entry->id = buffer[index];
+    index = (index + 1) & MASK;
+    entry->count = buffer[index];
+    index = (index + 1) & MASK;
+    uint8_t i = 0;
+    for (; i < entry->count; i++) {
+        uint8_t low = buffer[index];
+        index = (index + 1) & MASK;
+        entry->args[i] = low | buffer[index] << 8;
+        index = (index + 1) & MASK;
+    }
+    for (; i < TRACE_ARGS_MAX; i++) {
+        entry->args[i] = 0;
+    }
+    tail = index;
+    return true;
+}
+
+void trace_clear(void)
+{
+    head = tail = 0;
+    lost = 0;
+}
+
+
+#ifdef TRACE_BINARY
+static void send_hex(uint8_t byte)
+{
+    static const char digits[] PROGMEM = "0123456789ABCDEF";
+    sendchar(pgm_read_byte(&digits[byte >> 4]));
+    sendchar(pgm_read_byte(&digits[byte & 0x0F]));
+}
+
+// ~, ID, number of arguments, arguments low byte first, all in hex
+static void send_entry(const trace_entry_t *entry)
+{
+    sendchar('~');
+    send_hex(entry->id);
+    send_hex(entry->count);
+    for (uint8_t i = 0; i < entry->count; i++) {
+        send_hex(entry->args[i]);
+        send_hex(entry->args[i] >> 8);
+    }
+    sendchar('\n');
+}
+
+#elif !defined(NO_PRINT)
+#define TRACE_FORMAT_STRING(name) static const char format_##name[] PROGMEM = TRACE_FORMAT_##name;
+TRACE_FORMATS(TRACE_FORMAT_STRING)
+#define TRACE_FORMAT_POINTER(name) format_##name,
+static const char * const formats[] PROGMEM = {
+    TRACE_FORMATS(TRACE_FORMAT_POINTER)
+};
+
+#if defined(__AVR__)
+#   define trace_printf             __xprintf
+#   define read_format(id)          ((const char *)pgm_read_word(&formats[id]))
+#else
+#   define trace_printf             printf
+#   define read_format(id)          ((char *)formats[id])
+#endif
+
+static void send_entry(const trace_entry_t *entry)
+{
+    if (entry->id >= TRACE_ID_COUNT) {
+        return;
+    }
+    const uint16_t *a = entry->args;
+    trace_printf(read_format(entry->id), a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]);
+}
+#endif
+
+void trace_task(void)
+{
+    trace_entry_t entry;
+    for (uint8_t n = 0; n < TRACE_TASK_ENTRIES && trace_read(&entry); n++) {
+#if defined(TRACE_BINARY) || !defined(NO_PRINT)
+        send_entry(&entry);
+#endif
+    }
+}
@@ -0,0 +1,78 @@
+/*
+Copyright 2011 Jun Wako <wakojun@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "trace_formats.h"
+
+/*
+ * Binary trace log
+ *
+ * Instead of formatting, trace() stores the ID of a format from
+ * trace_formats.h and its arguments in a ring, which costs about as much
+ * as copying them. trace_task() does the formatting later, when the
+ * keyboard has nothing else to do. With TRACE_BINARY it doesn't format at
+ * all: each entry goes out as a line of hex starting with '~', and
+ * util/trace_decode.py formats them on the host with the table the build
+ * writes to .build/<target>_trace.txt.
+ *
+ * The ring has one writer, the main loop, and one reader, trace_task(),
+ * so it needs no locking. When it is full entries are dropped, and a
+ * count of them is logged once there is room again.
+ */
+
+// Power of two, 256 at most
+#ifndef TRACE_BUFFER_SIZE
+#define TRACE_BUFFER_SIZE 128
+#endif
+
+// Entries trace_task() sends per call
+#ifndef TRACE_TASK_ENTRIES
+#define TRACE_TASK_ENTRIES 4
+#endif
+
+#define TRACE_ARGS_MAX 8
+
+#define TRACE_ID_ENUM(name) TRACE_ID_##name,
+enum trace_id {
+    TRACE_FORMATS(TRACE_ID_ENUM)
+    TRACE_ID_COUNT
+};
+#undef TRACE_ID_ENUM
+
+typedef struct {
+    uint8_t id;
+    uint8_t count;
+    uint16_t args[TRACE_ARGS_MAX];
+} trace_entry_t;
+
+#define trace(name, ...)  do {                                              \
+    const uint16_t trace_args_[] = { 0, ##__VA_ARGS__ };                    \
+    trace_log(TRACE_ID_##name, sizeof(trace_args_) / sizeof(uint16_t) - 1,  \
+              trace_args_ + 1);                                             \
+} while (0)
+
+void trace_log(uint8_t id, uint8_t count, const uint16_t *args);
+// Takes the oldest entry
+bool trace_read(trace_entry_t *entry);
+void trace_clear(void);
+void trace_task(void);
+
+#endif
@@ -0,0 +1,64 @@
+/*
+Copyright 2011 Jun Wako <wakojun@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACE_FORMATS_H
+#define TRACE_FORMATS_H
+
+/*
+ * Formats of the trace log, the ID is the place in TRACE_FORMATS
+ *
+ * Arguments are 16 bit, so no %l, %s or %S. An event is "%04X%c(%u)" and
+ * a record adds ":%u%c", see TRACE_EVENT_ARGS and TRACE_RECORD_ARGS.
+ * Add new ones at the end, so logs decode with the tables of older builds.
+ */
+#define TRACE_FORMAT_LOST               "trace: %u lost\n"
+#define TRACE_FORMAT_ACTION_EXEC        "\n---- action_exec: start -----\nEVENT: %04X%c(%u)\n"
+#define TRACE_FORMAT_PROCESSED          "processed: %04X%c(%u):%u%c\n"
+#define TRACE_FORMAT_PROCESSED_EVENT    "processed: %04X%c(%u)\n"
+#define TRACE_FORMAT_ACTION             "ACTION: kind %X[%X:%02X] layer_state: %04X%04X default_layer_state: %04X%04X\n"
+#define TRACE_FORMAT_ACTION_NO_LAYER    "ACTION: kind %X[%X:%02X]\n"
+#define TRACE_FORMAT_WAITING_PROCESSED  "processed: waiting_buffer[%u] = %04X%c(%u):%u%c\n\n"
+#define TRACE_FORMAT_TAPPING_TIMEOUT    "Tapping: End. Timeout. Not tap(0): %04X%c(%u)\n"
+#define TRACE_FORMAT_TAPPING_RELEASED   "Tapping: End(Timeout after releasing last tap): %04X%c(%u)\n"
+#define TRACE_FORMAT_TAPPING_KEY        "TAPPING_KEY=%04X%c(%u):%u%c\n"
+#define TRACE_FORMAT_WAITING_BEGIN      "{ "
+#define TRACE_FORMAT_WAITING_ENTRY      "[%u]=%04X%c(%u):%u%c "
+#define TRACE_FORMAT_WAITING_END        "}\n"
+
+#define TRACE_FORMATS(X)    \
+    X(LOST)                 \
+    X(ACTION_EXEC)          \
+    X(PROCESSED)            \
+    X(PROCESSED_EVENT)      \
+    X(ACTION)               \
+    X(ACTION_NO_LAYER)      \
+    X(WAITING_PROCESSED)    \
+    X(TAPPING_TIMEOUT)      \
+    X(TAPPING_RELEASED)     \
+    X(TAPPING_KEY)          \
+    X(WAITING_BEGIN)        \
+    X(WAITING_ENTRY)        \
+    X(WAITING_END)
+
+/* The table util/trace_decode.py reads, made by the build with
+ * cc -E -P -DTRACE_TABLE */
+#ifdef TRACE_TABLE
+#define TRACE_TABLE_ENTRY(name) name TRACE_FORMAT_##name
+TRACE_FORMATS(TRACE_TABLE_ENTRY)
+#endif
+
+#endif
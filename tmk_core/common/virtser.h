@@ -7,4 +7,7 @@ void virtser_recv(const uint8_t ch);
 /* Call this to send a character over the Virtual Serial Device */
 void virtser_send(const uint8_t byte);
 
+/* Sends length bytes with a single flush, for packets up to the size of the endpoint */
+void virtser_send_packet(const uint8_t *data, uint8_t length);
+
 #endif
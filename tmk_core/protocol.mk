@@ -3,6 +3,7 @@ PROTOCOL_DIR = protocol
 
 ifdef PS2_MOUSE_ENABLE
     SRC += $(PROTOCOL_DIR)/ps2_mouse.c
+    SRC += $(PROTOCOL_DIR)/ps2_mouse_packet.c
     OPT_DEFS += -DPS2_MOUSE_ENABLE
     OPT_DEFS += -DMOUSE_ENABLE
 endif
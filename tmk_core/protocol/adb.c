@@ -37,13 +37,61 @@ POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include <stdbool.h>
-#include <util/delay.h>
 #include <avr/io.h>
 #include <avr/interrupt.h>
 #include "adb.h"
+#include "adb_engine.h"
+#include "timer.h"
+#ifdef ADB_MOUSE_ENABLE
+#   include "host.h"
+#   include "report.h"
+#endif
+
 
+/*
+ * Transactions run in the background from two interrupts: the data pin's
+ * external interrupt for edges and a compare match on a free running
+ * timer at F_CPU/8 for everything else. Edges are timed on that timer,
+ * and each wait is counted from the event before it, so the time the
+ * interrupts take doesn't add up over a transaction.
+ *
+ * The defaults are INT0, with the data line on PD0 as on the converters,
+ * and Timer3. Set all of ADB_INT_* or ADB_TIMER_* in config.h for others.
+ */
+#ifndef ADB_INT_VECT
+#   define ADB_INT_INIT()  do {    \
+    EICRA |= ((0<<ISC01) |      \
+              (1<<ISC00));      \
+} while (0)
+#   define ADB_INT_ON()  do {      \
+    EIFR  |= (1<<INTF0);        \
+    EIMSK |= (1<<INT0);         \
+} while (0)
+#   define ADB_INT_OFF() do {      \
+    EIMSK &= ~(1<<INT0);        \
+} while (0)
+#   define ADB_INT_VECT    INT0_vect
+#endif
+
+#ifndef ADB_TIMER_VECT
+#   define ADB_TIMER_INIT() do {   \
+    TCCR3A = 0;                 \
+    TCCR3B = (1<<CS31);         \
+} while (0)
+#   define ADB_TIMER_ON()  do {    \
+    TIFR3  |= (1<<OCF3A);       \
+    TIMSK3 |= (1<<OCIE3A);      \
+} while (0)
+#   define ADB_TIMER_OFF() do {    \
+    TIMSK3 &= ~(1<<OCIE3A);     \
+} while (0)
+#   define ADB_TCNT        TCNT3
+#   define ADB_OCR         OCR3A
+#   define ADB_TIMER_VECT  TIMER3_COMPA_vect
+#endif
+
+#define TICKS_PER_US    (F_CPU / 8000000)
 
-// GCC doesn't inline functions normally
 #define data_lo() (ADB_DDR |=  (1<<ADB_DATA_BIT))
 #define data_hi() (ADB_DDR &= ~(1<<ADB_DATA_BIT))
 #define data_in() (ADB_PIN &   (1<<ADB_DATA_BIT))
@@ -54,39 +102,6 @@ static inline void psw_hi(void);
 static inline bool psw_in(void);
 #endif
 
-static inline void attention(void);
-static inline void place_bit0(void);
-static inline void place_bit1(void);
-static inline void send_byte(uint8_t data);
-static inline uint16_t wait_data_lo(uint16_t us);
-static inline uint16_t wait_data_hi(uint16_t us);
-static inline uint16_t adb_host_dev_recv(uint8_t device);
-
-
-void adb_host_init(void)
-{
-    ADB_PORT &= ~(1<<ADB_DATA_BIT);
-    data_hi();
-#ifdef ADB_PSW_BIT
-    psw_hi();
-#endif
-}
-
-#ifdef ADB_PSW_BIT
-bool adb_host_psw(void)
-{
-    return psw_in();
-}
-#endif
-
-/*
- * Don't call this in a row without the delay, otherwise it makes some of poor controllers
- * overloaded and misses strokes. Recommended interval is 12ms.
- *
- * Thanks a lot, blargg!
- * <http://geekhack.org/index.php?topic=14290.msg1068919#msg1068919>
- * <http://geekhack.org/index.php?topic=14290.msg1070139#msg1070139>
- */
 
 // ADB Bit Cells
 //
@@ -123,92 +138,189 @@ bool adb_host_psw(void)
 // [from Apple IIgs Hardware Reference Second Edition]
 
 enum {
-    ADDR_KEYB  = 0x20,
-    ADDR_MOUSE = 0x30
+    ADDR_KEYB  = 0x02,
+    ADDR_MOUSE = 0x03
 };
 
-uint16_t adb_host_kbd_recv(void)
+static adb_poll_t poll;
+static uint16_t poll_time;
+static uint16_t kbd_data;
+#ifdef ADB_MOUSE_ENABLE
+static uint16_t mouse_data;
+#endif
+
+// Timer count the current wait started from
+static uint16_t last_event;
+
+static void bus_apply(adb_bus_t bus, uint16_t now)
 {
-    return adb_host_dev_recv(ADDR_KEYB);
+    // listen before letting go, the line rises as soon as it's released
+    if (bus.edges) {
+        ADB_INT_ON();
+    }
+    if (bus.drive) {
+        data_lo();
+    } else {
+        data_hi();
+    }
+    if (!bus.edges) {
+        ADB_INT_OFF();
+    }
+    last_event = now;
+    if (bus.wait) {
+        ADB_OCR = now + bus.wait * TICKS_PER_US;
+        ADB_TIMER_ON();
+    } else {
+        ADB_TIMER_OFF();
+    }
 }
 
-#ifdef ADB_MOUSE_ENABLE
-void adb_mouse_init(void) {
-	    return;
+ISR(ADB_TIMER_VECT)
+{
+    bus_apply(adb_engine_timer(), ADB_OCR);
 }
 
-uint16_t adb_host_mouse_recv(void)
+ISR(ADB_INT_VECT)
 {
-    return adb_host_dev_recv(ADDR_MOUSE);
+    uint16_t now = ADB_TCNT;
+    bool level = data_in();
+    bus_apply(adb_engine_edge(level, (uint16_t)(now - last_event) / TICKS_PER_US), now);
 }
-#endif
 
-static inline uint16_t adb_host_dev_recv(uint8_t device)
+static void bus_start(void)
 {
-    uint16_t data = 0;
+    uint8_t sreg = SREG;
     cli();
-    attention();
-    send_byte(device|0x0C);     // Addr:Keyboard(0010)/Mouse(0011), Cmd:Talk(11), Register0(00)
-    place_bit0();               // Stopbit(0)
-    if (!wait_data_hi(500)) {    // Service Request(310us Adjustable Keyboard): just ignored
-        sei();
-        return -30;             // something wrong
+    adb_bus_t bus = adb_engine_start();
+    if (bus.wait) {
+        bus_apply(bus, ADB_TCNT);
     }
-    if (!wait_data_lo(500)) {   // Tlt/Stop to Start(140-260us)
-        sei();
-        return 0;               // No data to send
-    }
-    
-    uint8_t n = 17; // start bit + 16 data bits
-    do {
-        uint8_t lo = (uint8_t) wait_data_hi(130);
-        if (!lo)
-            goto error;
-        
-        uint8_t hi = (uint8_t) wait_data_lo(lo);
-        if (!hi)
-            goto error;
-        
-        hi = lo - hi;
-        lo = 130 - lo;
-        
-        data <<= 1;
-        if (lo < hi) {
-            data |= 1;
+    SREG = sreg;
+}
+
+
+void adb_host_init(void)
+{
+    ADB_PORT &= ~(1<<ADB_DATA_BIT);
+    data_hi();
+#ifdef ADB_PSW_BIT
+    psw_hi();
+#endif
+    adb_engine_init();
+    adb_poll_init(&poll);
+    adb_poll_add(&poll, ADDR_KEYB);
+#ifdef ADB_MOUSE_ENABLE
+    adb_poll_add(&poll, ADDR_MOUSE);
+#endif
+    ADB_INT_INIT();
+    ADB_TIMER_INIT();
+}
+
+#ifdef ADB_PSW_BIT
+bool adb_host_psw(void)
+{
+    return psw_in();
+}
+#endif
+
+/*
+ * Polls no faster than every ADB_POLL_INTERVAL, otherwise it makes some of
+ * poor controllers overloaded and misses strokes. Recommended interval is 12ms.
+ *
+ * Thanks a lot, blargg!
+ * <http://geekhack.org/index.php?topic=14290.msg1068919#msg1068919>
+ * <http://geekhack.org/index.php?topic=14290.msg1070139#msg1070139>
+ */
+void adb_host_task(void)
+{
+    adb_transaction_t transaction;
+    while (adb_engine_result(&transaction)) {
+        if (!ADB_IS_TALK(transaction.command)) {
+            continue;
+        }
+        uint8_t address = ADB_ADDRESS(transaction.command);
+        adb_poll_done(&poll, address, transaction.srq);
+        if (transaction.status != ADB_OK || (transaction.command & 0x03) || transaction.length < 2) {
+            continue;
         }
-        else if (n == 17) {
-            sei();
-            return -20;
+        uint16_t data = (transaction.data[0] << 8) | transaction.data[1];
+        if (address == ADDR_KEYB) {
+            kbd_data = data;
         }
+#ifdef ADB_MOUSE_ENABLE
+        if (address == ADDR_MOUSE) {
+            mouse_data = data;
+        }
+#endif
     }
-    while ( --n );
 
-    // Stop bit can't be checked normally since it could have service request lenghtening
-    // and its high state never goes low.
-    if (!wait_data_hi(351) || wait_data_lo(91)) {
-        sei();
-        return -21;
+    // a device is polled again once what it sent last has been taken
+    if (!adb_engine_busy() && timer_elapsed(poll_time) >= ADB_POLL_INTERVAL) {
+        uint8_t address = adb_poll_next(&poll);
+        bool taken = !kbd_data;
+#ifdef ADB_MOUSE_ENABLE
+        if (address == ADDR_MOUSE) {
+            taken = !mouse_data;
+        }
+#endif
+        if (taken) {
+            adb_engine_queue(ADB_TALK(address, 0), 0, 0);
+            poll_time = timer_read();
+        }
     }
-    sei();
-    return data;
+    bus_start();
+}
 
-error:
-    sei();
-    return -n;
+static uint16_t take(uint16_t *data)
+{
+    adb_host_task();
+    uint16_t taken = *data;
+    *data = 0;
+    return taken;
+}
+
+uint16_t adb_host_kbd_recv(void)
+{
+    return take(&kbd_data);
 }
 
+#ifdef ADB_MOUSE_ENABLE
+void adb_mouse_init(void) {
+	    return;
+}
+
+uint16_t adb_host_mouse_recv(void)
+{
+    return take(&mouse_data);
+}
+
+// Register 0: button (0 when pressed), 7 bit Y, second button, 7 bit X
+void adb_mouse_task(void)
+{
+    uint16_t data = adb_host_mouse_recv();
+    if (!data) {
+        return;
+    }
+    report_mouse_t report = {};
+    if (!(data & 0x8000)) {
+        report.buttons |= MOUSE_BTN1;
+    }
+    if (!(data & 0x0080)) {
+        report.buttons |= MOUSE_BTN2;
+    }
+    report.y = (int8_t)(data >> 7) >> 1;
+    report.x = (int8_t)(data << 1) >> 1;
+    host_mouse_send(&report);
+}
+#endif
+
 void adb_host_listen(uint8_t cmd, uint8_t data_h, uint8_t data_l)
 {
-    cli();
-    attention();
-    send_byte(cmd);
-    place_bit0();               // Stopbit(0)
-    _delay_us(200);             // Tlt/Stop to Start
-    place_bit1();               // Startbit(1)
-    send_byte(data_h); 
-    send_byte(data_l);
-    place_bit0();               // Stopbit(0);
-    sei();
+    uint8_t data[2] = { data_h, data_l };
+    while (!adb_engine_queue(cmd, data, 2)) {
+        adb_host_task();
+    }
+    bus_start();
 }
 
 // send state of LEDs
@@ -240,63 +352,6 @@ static inline bool psw_in()
 }
 #endif
 
-static inline void attention(void)
-{
-    data_lo();
-    _delay_us(800-35); // bit1 holds lo for 35 more
-    place_bit1();
-}
-
-static inline void place_bit0(void)
-{
-    data_lo();
-    _delay_us(65);
-    data_hi();
-    _delay_us(35);
-}
-
-static inline void place_bit1(void)
-{
-    data_lo();
-    _delay_us(35);
-    data_hi();
-    _delay_us(65);
-}
-
-static inline void send_byte(uint8_t data)
-{
-    for (int i = 0; i < 8; i++) {
-        if (data&(0x80>>i))
-            place_bit1();
-        else
-            place_bit0();
-    }
-}
-
-// These are carefully coded to take 6 cycles of overhead.
-// inline asm approach became too convoluted
-static inline uint16_t wait_data_lo(uint16_t us)
-{
-    do {
-        if ( !data_in() )
-            break;
-        _delay_us(1 - (6 * 1000000.0 / F_CPU));
-    }
-    while ( --us );
-    return us;
-}
-
-static inline uint16_t wait_data_hi(uint16_t us)
-{
-    do {
-        if ( data_in() )
-            break;
-        _delay_us(1 - (6 * 1000000.0 / F_CPU));
-    }
-    while ( --us );
-    return us;
-}
-
 
 /*
 ADB Protocol
@@ -51,9 +51,15 @@ POSSIBILITY OF SUCH DAMAGE.
 #define ADB_POWER       0x7F
 #define ADB_CAPS        0x39
 
+#ifndef ADB_POLL_INTERVAL
+#define ADB_POLL_INTERVAL   12
+#endif
+
 
-// ADB host
+// ADB host, nothing here waits for the bus: talks are queued and their
+// data is returned by a later call, 0 until then
 void     adb_host_init(void);
+void     adb_host_task(void);
 bool     adb_host_psw(void);
 uint16_t adb_host_kbd_recv(void);
 uint16_t adb_host_mouse_recv(void);
@@ -0,0 +1,390 @@
+/*
+Copyright 2011 Jun WAKO <wakojun@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include "adb_engine.h"
+
+/*
+ * Receiving
+ *
+ * After the host lets go of its stop bit the line rises at once, or up to
+ * 300us later when a device holds it for a service request. Then the bus
+ * stays high for 140-260us before the device's start bit, unless it has
+ * nothing to say. Every bit is low then high, a 1 when the low part is
+ * the shorter one. The stop bit has no falling edge after it, so it shows
+ * up as the line staying high.
+ */
+enum {
+    RX_RELEASE,     // host let go, line may be held for a service request
+    RX_IDLE,        // waiting for the start bit
+    RX_LOW,         // low part of a bit
+    RX_HIGH,        // high part of a bit
+    RX_DONE,
+    RX_NO_DATA,
+    RX_ERROR,
+};
+
+void adb_rx_start(adb_rx_t *rx)
+{
+    memset(rx, 0, sizeof(*rx));
+    rx->state = RX_RELEASE;
+}
+
+static void rx_bit(adb_rx_t *rx, bool bit)
+{
+    if (rx->bits == 0) {
+        if (!bit) {
+            rx->state = RX_ERROR;
+        }
+    } else {
+        uint8_t n = rx->bits - 1;
+        if (n >= ADB_MAX_DATA * 8) {
+            rx->state = RX_ERROR;
+            return;
+        }
+        if (bit) {
+            rx->data[n / 8] |= 0x80 >> (n % 8);
+        }
+    }
+    rx->bits++;
+}
+
+void adb_rx_edge(adb_rx_t *rx, bool level, uint16_t us)
+{
+    switch (rx->state) {
+        case RX_RELEASE:
+            if (level) {
+                rx->srq = us >= ADB_SRQ_MIN;
+                rx->state = RX_IDLE;
+            }
+            break;
+        case RX_IDLE:
+            if (!level) {
+                rx->state = RX_LOW;
+            }
+            break;
+        case RX_LOW:
+            if (level) {
+                if (us < ADB_LOW_MIN || us > ADB_LOW_MAX) {
+                    rx->state = RX_ERROR;
+                    break;
+                }
+                rx->low = us;
+                rx->state = RX_HIGH;
+            }
+            break;
+        case RX_HIGH:
+            if (!level) {
+                uint16_t cell = rx->low + us;
+                if (cell < ADB_CELL_MIN || cell > ADB_CELL_MAX) {
+                    rx->state = RX_ERROR;
+                    break;
+                }
+                rx->state = RX_LOW;
+                rx_bit(rx, rx->low < us);
+            }
+            break;
+    }
+}
+
+void adb_rx_timeout(adb_rx_t *rx)
+{
+    switch (rx->state) {
+        case RX_IDLE:
+            rx->state = RX_NO_DATA;
+            break;
+        case RX_HIGH: {
+            // the line stayed up after the stop bit, data is 2 to 8 bytes
+            uint8_t n = rx->bits - 1;
+            if (rx->bits == 0 || n % 8 || n < 16) {
+                rx->state = RX_ERROR;
+            } else {
+                rx->length = n / 8;
+                rx->state = RX_DONE;
+            }
+            break;
+        }
+        case RX_RELEASE:
+        case RX_LOW:
+            rx->state = RX_ERROR;
+            break;
+    }
+}
+
+uint16_t adb_rx_wait(const adb_rx_t *rx)
+{
+    switch (rx->state) {
+        case RX_RELEASE:    return ADB_SRQ_MAX;
+        case RX_IDLE:       return ADB_TLT_MAX;
+        case RX_LOW:        return ADB_LOW_MAX;
+        case RX_HIGH:       return ADB_CELL_MAX - rx->low;
+        default:            return 0;
+    }
+}
+
+uint8_t adb_rx_status(const adb_rx_t *rx)
+{
+    switch (rx->state) {
+        case RX_DONE:       return ADB_OK;
+        case RX_NO_DATA:    return ADB_NO_DATA;
+        case RX_ERROR:      return ADB_ERROR;
+        default:            return ADB_PENDING;
+    }
+}
+
+
+/*
+ * Sending
+ *
+ * Segments alternate low and high: attention with the high half of the
+ * start bit, eight command bits, the stop bit, and for a listen the stop
+ * to start time merged into the high half of that stop bit, the start bit
+ * and the data with another stop bit.
+ */
+void adb_tx_start(adb_tx_t *tx, uint8_t command, const uint8_t *data, uint8_t length)
+{
+    tx->command = command;
+    tx->data = data;
+    tx->length = ADB_IS_LISTEN(command) ? length : 0;
+    tx->segment = 0;
+}
+
+static uint16_t bit_segment(bool bit, bool high)
+{
+    return bit != high ? ADB_BIT_SHORT : ADB_BIT_LONG;
+}
+
+uint16_t adb_tx_next(adb_tx_t *tx)
+{
+    uint8_t segment = tx->segment++;
+    bool high = segment & 1;
+    uint8_t bit = segment / 2;
+
+    // attention and start bit
+    if (bit == 0) {
+        return high ? ADB_BIT_LONG : ADB_ATTENTION;
+    }
+    // command
+    if (bit <= 8) {
+        return bit_segment(tx->command & (0x80 >> (bit - 1)), high);
+    }
+    // stop bit, the end of a talk once the host lets go
+    if (bit == 9) {
+        if (!high) {
+            return ADB_BIT_LONG;
+        }
+        if (!tx->length) {
+            return 0;
+        }
+        return ADB_BIT_SHORT + ADB_STOP_TO_START;
+    }
+    if (!tx->length) {
+        return 0;
+    }
+    // start bit, data, stop bit
+    bit -= 10;
+    if (bit == 0) {
+        return bit_segment(1, high);
+    }
+    bit--;
+    if (bit < tx->length * 8) {
+        return bit_segment(tx->data[bit / 8] & (0x80 >> (bit % 8)), high);
+    }
+    if (bit == tx->length * 8) {
+        return bit_segment(0, high);
+    }
+    return 0;
+}
+
+
+/*
+ * Transaction queue
+ *
+ * One ring: [tail, active) are finished and wait for adb_engine_result(),
+ * [active, head) are queued. The main loop moves head and tail, the
+ * interrupts move active.
+ */
+enum {
+    ENGINE_IDLE,
+    ENGINE_TX,
+    ENGINE_RX,
+    ENGINE_GAP,
+};
+
+static adb_transaction_t transactions[ADB_QUEUE_SIZE];
+static volatile uint8_t head;
+static volatile uint8_t active;
+static volatile uint8_t tail;
+static volatile uint8_t state;
+static adb_tx_t tx;
+static adb_rx_t rx;
+
+static const adb_bus_t bus_idle = { 0, false, false };
+
+static uint8_t next_index(uint8_t index)
+{
+    return (index + 1) % ADB_QUEUE_SIZE;
+}
+
+void adb_engine_init(void)
+{
+    head = active = tail = 0;
+    state = ENGINE_IDLE;
+}
+
+bool adb_engine_queue(uint8_t command, const uint8_t *data, uint8_t length)
+{
+    uint8_t next = next_index(head);
+    if (next == tail || length > ADB_MAX_DATA) {
+        return false;
+    }
+    adb_transaction_t *transaction = &transactions[head];
+    transaction->command = command;
+    transaction->length = length;
+    if (length) {
+        memcpy(transaction->data, data, length);
+    }
+    transaction->status = ADB_PENDING;
+    transaction->srq = false;
+    head = next;
+    return true;
+}
+
+bool adb_engine_busy(void)
+{
+    return state != ENGINE_IDLE || active != head;
+}
+
+bool adb_engine_result(adb_transaction_t *transaction)
+{
+    if (tail == active) {
+        return false;
+    }
+    *transaction = transactions[tail];
+    tail = next_index(tail);
+    return true;
+}
+
+static adb_bus_t bus_segment(void)
+{
+    adb_bus_t bus = { adb_tx_next(&tx), tx.segment & 1, false };
+    return bus;
+}
+
+adb_bus_t adb_engine_start(void)
+{
+    if (state != ENGINE_IDLE || active == head) {
+        return bus_idle;
+    }
+    adb_transaction_t *transaction = &transactions[active];
+    adb_tx_start(&tx, transaction->command, transaction->data, transaction->length);
+    state = ENGINE_TX;
+    return bus_segment();
+}
+
+static adb_bus_t finish(uint8_t status)
+{
+    adb_transaction_t *transaction = &transactions[active];
+    if (ADB_IS_TALK(transaction->command)) {
+        transaction->length = rx.length;
+        memcpy(transaction->data, rx.data, rx.length);
+        transaction->srq = rx.srq;
+    }
+    transaction->status = status;
+    active = next_index(active);
+    state = ENGINE_GAP;
+    adb_bus_t bus = { ADB_GAP, false, false };
+    return bus;
+}
+
+static adb_bus_t receiving(void)
+{
+    uint8_t status = adb_rx_status(&rx);
+    if (status != ADB_PENDING) {
+        return finish(status);
+    }
+    adb_bus_t bus = { adb_rx_wait(&rx), false, true };
+    return bus;
+}
+
+adb_bus_t adb_engine_timer(void)
+{
+    switch (state) {
+        case ENGINE_TX: {
+            adb_bus_t bus = bus_segment();
+            if (bus.wait) {
+                return bus;
+            }
+            if (!ADB_IS_TALK(tx.command)) {
+                return finish(ADB_OK);
+            }
+            adb_rx_start(&rx);
+            state = ENGINE_RX;
+            return receiving();
+        }
+        case ENGINE_RX:
+            adb_rx_timeout(&rx);
+            return receiving();
+        case ENGINE_GAP:
+            state = ENGINE_IDLE;
+            return adb_engine_start();
+    }
+    return bus_idle;
+}
+
+adb_bus_t adb_engine_edge(bool level, uint16_t us)
+{
+    if (state != ENGINE_RX) {
+        return bus_idle;
+    }
+    adb_rx_edge(&rx, level, us);
+    return receiving();
+}
+
+
+/*
+ * Poll scheduler
+ */
+void adb_poll_init(adb_poll_t *poll)
+{
+    poll->count = 0;
+    poll->current = 0;
+}
+
+void adb_poll_add(adb_poll_t *poll, uint8_t address)
+{
+    if (poll->count < ADB_POLL_DEVICES) {
+        poll->devices[poll->count++] = address;
+    }
+}
+
+uint8_t adb_poll_next(const adb_poll_t *poll)
+{
+    return poll->devices[poll->current];
+}
+
+void adb_poll_done(adb_poll_t *poll, uint8_t address, bool srq)
+{
+    if (!poll->count || address != poll->devices[poll->current]) {
+        return;
+    }
+    // the polled device can just answer, so a service request is someone
+    // else's: try the next one until it turns out who
+    if (srq) {
+        poll->current = (poll->current + 1) % poll->count;
+    }
+}
@@ -0,0 +1,169 @@
+/*
+Copyright 2011 Jun WAKO <wakojun@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ADB_ENGINE_H
+#define ADB_ENGINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * ADB host transactions, one bus event at a time
+ *
+ * Nothing in here waits. The driver tells the engine when its timer runs
+ * out and when the data line changes, with the microseconds since the
+ * last of those, and the engine answers with what the bus should do next:
+ * whether to hold the line low, which edges it wants to hear about and
+ * when to call back. That way a whole transaction runs from interrupts,
+ * and the same code runs here on recorded waveforms.
+ *
+ * Transactions are queued by the main loop and come back, with what the
+ * device answered, in the same order. Both queues have one writer and one
+ * reader, so they need no locking.
+ *
+ * The poll scheduler keeps talking to the device that last had data, and
+ * moves on to the next one whenever a service request shows that some
+ * other device is waiting, the way the ADB Manager does it.
+ */
+
+#ifndef ADB_QUEUE_SIZE
+#define ADB_QUEUE_SIZE 4
+#endif
+
+#define ADB_MAX_DATA 8
+
+#ifndef ADB_POLL_DEVICES
+#define ADB_POLL_DEVICES 4
+#endif
+
+// Command byte
+#define ADB_FLUSH(addr)         (((addr) << 4) | 0x01)
+#define ADB_LISTEN(addr, reg)   (((addr) << 4) | 0x08 | (reg))
+#define ADB_TALK(addr, reg)     (((addr) << 4) | 0x0C | (reg))
+#define ADB_IS_TALK(command)    (((command) & 0x0C) == 0x0C)
+#define ADB_IS_LISTEN(command)  (((command) & 0x0C) == 0x08)
+#define ADB_ADDRESS(command)    ((command) >> 4)
+
+// Timing in microseconds
+#define ADB_ATTENTION       800
+#define ADB_BIT_SHORT       35
+#define ADB_BIT_LONG        65
+#define ADB_STOP_TO_START   200
+#define ADB_GAP             300     // idle bus between transactions
+
+// What is accepted from a device
+#define ADB_SRQ_MIN         60      // low after the host's stop bit
+#define ADB_SRQ_MAX         500
+#define ADB_TLT_MAX         300     // stop to start, 140-260
+#define ADB_LOW_MIN         15
+#define ADB_LOW_MAX         100
+#define ADB_CELL_MIN        50
+#define ADB_CELL_MAX        170
+
+enum adb_status {
+    ADB_PENDING,
+    ADB_OK,
+    ADB_NO_DATA,    // device didn't answer a talk
+    ADB_ERROR,      // bad timing, the transaction is lost
+};
+
+typedef struct {
+    uint8_t command;
+    uint8_t length;     // bytes to listen, or bytes the talk got back
+    uint8_t data[ADB_MAX_DATA];
+    uint8_t status;
+    bool srq;           // another device asked for service
+} adb_transaction_t;
+
+// What the bus does until the next event
+typedef struct {
+    uint16_t wait;      // microseconds until adb_engine_timer(), 0 never
+    bool drive;         // hold the line low
+    bool edges;         // call adb_engine_edge() on every change
+} adb_bus_t;
+
+/*
+ * Decoding what a device sends after a talk, from the host releasing the
+ * line at the end of its stop bit
+ */
+typedef struct {
+    uint8_t state;
+    uint8_t bits;       // start bit and data bits so far
+    uint8_t low;
+    uint8_t length;
+    uint8_t data[ADB_MAX_DATA];
+    bool srq;
+} adb_rx_t;
+
+void adb_rx_start(adb_rx_t *rx);
+// The line went to level after us microseconds
+void adb_rx_edge(adb_rx_t *rx, bool level, uint16_t us);
+// Nothing happened within adb_rx_wait()
+void adb_rx_timeout(adb_rx_t *rx);
+uint16_t adb_rx_wait(const adb_rx_t *rx);
+// ADB_PENDING until the transfer is over
+uint8_t adb_rx_status(const adb_rx_t *rx);
+
+/*
+ * The host's side of a transaction, as alternate low and high times
+ * starting with the attention signal. A talk ends at the low half of the
+ * stop bit, where the device may hold the line for a service request.
+ */
+typedef struct {
+    uint8_t command;
+    uint8_t length;
+    const uint8_t *data;
+    uint8_t segment;
+} adb_tx_t;
+
+void adb_tx_start(adb_tx_t *tx, uint8_t command, const uint8_t *data, uint8_t length);
+// How long the next segment lasts, 0 once the host is done
+uint16_t adb_tx_next(adb_tx_t *tx);
+
+/*
+ * Transaction queue
+ */
+void adb_engine_init(void);
+// False if the queue is full
+bool adb_engine_queue(uint8_t command, const uint8_t *data, uint8_t length);
+bool adb_engine_busy(void);
+// Takes the oldest finished transaction
+bool adb_engine_result(adb_transaction_t *transaction);
+
+// Starts the next queued transaction if the bus is idle, wait is 0 when
+// there is nothing to start
+adb_bus_t adb_engine_start(void);
+adb_bus_t adb_engine_timer(void);
+adb_bus_t adb_engine_edge(bool level, uint16_t us);
+
+/*
+ * Poll scheduler
+ */
+typedef struct {
+    uint8_t devices[ADB_POLL_DEVICES];
+    uint8_t count;
+    uint8_t current;
+} adb_poll_t;
+
+void adb_poll_init(adb_poll_t *poll);
+void adb_poll_add(adb_poll_t *poll, uint8_t address);
+// Address to talk to next
+uint8_t adb_poll_next(const adb_poll_t *poll);
+// Whether polling address saw a service request
+void adb_poll_done(adb_poll_t *poll, uint8_t address, bool srq);
+
+#endif
@@ -42,6 +42,10 @@
 #include "visualizer/visualizer.h"
 #endif
 #include "suspend.h"
+#ifdef IDLE_SCAN_ENABLE
+#include "idle_scan.h"
+#include "matrix.h"
+#endif
 
 
 /* -------------------------
@@ -88,6 +92,84 @@ host_driver_t chibios_driver = {
 
 
 
+#ifdef IDLE_SCAN_ENABLE
+/* Idle aware scanning, see idle_scan.h
+ * The main thread rests on an event the matrix wake interrupt signals.
+ */
+#if 1000000 % CH_CFG_ST_FREQUENCY
+#error "IDLE_SCAN_ENABLE needs CH_CFG_ST_FREQUENCY to divide 1MHz"
+#endif
+#define US_PER_TICK (1000000 / CH_CFG_ST_FREQUENCY)
+#define WAKE_EVENT EVENT_MASK(0)
+
+static idle_scan_t idle_scan;
+static thread_t *idle_scan_thread;
+static bool idle_scan_armed;
+static uint32_t idle_scan_edge;
+
+/* Boards whose matrix can't wake the keyboard rest IDLE_SCAN_INTERVAL */
+__attribute__ ((weak)) bool matrix_wake_enable(void) { return false; }
+__attribute__ ((weak)) void matrix_wake_disable(void) {}
+
+/* microseconds; wraps together with the system time */
+static inline uint32_t idle_scan_now(void) {
+  return (uint32_t)chVTGetSystemTimeX() * US_PER_TICK;
+}
+
+void idle_scan_wake_i(void) {
+  if (idle_scan_armed) {
+    idle_scan_armed = false;
+    idle_scan_edge = idle_scan_now();
+    chEvtSignalI(idle_scan_thread, WAKE_EVENT);
+  }
+}
+
+static void idle_scan_init_main(void) {
+  idle_scan_thread = chThdGetSelfX();
+  idle_scan_init(&idle_scan, idle_scan_now());
+}
+
+static void idle_scan_task(void) {
+  uint32_t start = idle_scan_now();
+  idle_scan_stats_t stats;
+
+  if (idle_scan_report(&idle_scan, start, &stats)) {
+    dprintf("idle: %lu%% of %lums, %u wakes, first key %lu us mean %lu us max\n",
+            stats.time ? (uint32_t)((uint64_t)stats.rested * 100 / stats.time) : 0,
+            stats.time / 1000, stats.wakes,
+            stats.keys ? stats.latency_sum / stats.keys : 0, stats.latency_max);
+  }
+  if (keyboard_key_processed()) {
+    idle_scan_key(&idle_scan, start);
+  }
+  if (!idle_scan_should_rest(&idle_scan, keyboard_is_idle(), start)) {
+    return;
+  }
+
+  /* Armed before the interrupts are, so an edge right away isn't lost */
+  chEvtGetAndClearEvents(WAKE_EVENT);
+  chSysLock();
+  idle_scan_armed = true;
+  chSysUnlock();
+#ifdef SERIAL_LINK_ENABLE
+  /* keys on the other half come over the link, not as edges */
+  bool wake = false;
+#else
+  bool wake = matrix_wake_enable();
+#endif
+  uint32_t rest = (wake ? IDLE_SCAN_WAKE_TIMEOUT : IDLE_SCAN_INTERVAL) * 1000UL;
+  eventmask_t events = chEvtWaitAnyTimeout(WAKE_EVENT, rest / US_PER_TICK);
+  if (wake) {
+    matrix_wake_disable();
+  }
+  chSysLock();
+  idle_scan_armed = false;
+  chSysUnlock();
+
+  idle_scan_rested(&idle_scan, start, idle_scan_now(), events != 0, idle_scan_edge);
+}
+#endif
+
 /* Main thread
  */
 int main(void) {
@@ -150,6 +232,10 @@ int main(void) {
 
   print("Keyboard start.\n");
 
+#ifdef IDLE_SCAN_ENABLE
+  idle_scan_init_main();
+#endif
+
   /* Main loop */
   while(true) {
 
@@ -182,5 +268,8 @@ int main(void) {
     }
 
     keyboard_task();
+#ifdef IDLE_SCAN_ENABLE
+    idle_scan_task();
+#endif
   }
 }
@@ -9,6 +9,8 @@
 #include "timer.h"
 #include "action_util.h"
 #include "ringbuffer.hpp"
+#include "sdep.hpp"
+#include "adafruit_ble_queue.hpp"
 #include <string.h>
 
 // These are the pin assignments for the 32u4 boards.
@@ -26,6 +28,23 @@
 #define AdafruitBleIRQPin   E6
 #endif
 
+// How many commands may be sent before the response to the first of them
+// has been read. The default of 1 waits for each OK, as the driver always
+// has; whether the Bluefruit firmware takes a second command before
+// answering the first hasn't been verified on hardware, so deeper
+// pipelining is opt-in from config.h. Going deeper than the module keeps
+// up with only moves reports out of send_buf, where waiting key reports
+// get merged, into the module, where they don't.
+#ifndef AdafruitBlePipelineDepth
+#define AdafruitBlePipelineDepth 1
+#endif
+
+// Define AdafruitBleHidReportCmd to the SDEP command ID under which your
+// module firmware takes HID reports in binary, a report ID followed by
+// the report, to send them that way rather than as AT commands. It is
+// tried once the module is configured; if the firmware answers it with an
+// error the AT commands are used after all.
+
 
 #define SAMPLE_BATTERY
 #define ConnectionUpdateInterval 1000 /* milliseconds */
@@ -44,79 +63,24 @@ static struct {
   uint32_t vbat;
 #endif
   uint16_t last_connection_update;
-} state;
-
-// Commands are encoded using SDEP and sent via SPI
-// https://github.com/adafruit/Adafruit_BluefruitLE_nRF51/blob/master/SDEP.md
-
-#define SdepMaxPayload 16
-struct sdep_msg {
-  uint8_t type;
-  uint8_t cmd_low;
-  uint8_t cmd_high;
-  struct __attribute__((packed)) {
-    uint8_t len:7;
-    uint8_t more:1;
-  };
-  uint8_t payload[SdepMaxPayload];
-} __attribute__((packed));
-
-// The recv latency is relatively high, so when we're hammering keys quickly,
-// we want to avoid waiting for the responses in the matrix loop.  We maintain
-// a short queue for that.  Since there is quite a lot of space overhead for
-// the AT command representation wrapped up in SDEP, we queue the minimal
-// information here.
-
-enum queue_type {
-  QTKeyReport, // 1-byte modifier + 6-byte key report
-  QTConsumer,  // 16-bit key code
-#ifdef MOUSE_ENABLE
-  QTMouseMove, // 4-byte mouse report
-#endif
-};
 
-struct queue_item {
-  enum queue_type queue_type;
-  uint16_t added;
-  union __attribute__((packed)) {
-    struct __attribute__((packed)) {
-      uint8_t modifier;
-      uint8_t keys[6];
-    } key;
-
-    uint16_t consumer;
-    struct __attribute__((packed)) {
-      int8_t x, y, scroll, pan;
-      uint8_t buttons;
-    } mousemove;
-  };
-};
+  // HID reports go out with AdafruitBleHidReportCmd
+  bool binary_reports;
+  // The mouse buttons the module was last told about
+  bool mouse_buttons_sent;
+  uint8_t mouse_buttons;
+} state;
 
 // Items that we wish to send
-static RingBuffer<queue_item, 40> send_buf;
-// Pending response; while pending, we can't send any more requests.
-// This records the time at which we sent the command for which we
+static ReportQueue<40> send_buf;
+// Pending responses, oldest first; up to AdafruitBlePipelineDepth commands
+// can be waiting for theirs before we stop sending.
+// This records the time at which we sent each command for which we
 // are expecting a response.
-static RingBuffer<uint16_t, 2> resp_buf;
+static RingBuffer<uint16_t, AdafruitBlePipelineDepth + 1> resp_buf;
 
 static bool process_queue_item(struct queue_item *item, uint16_t timeout);
 
-enum sdep_type {
-  SdepCommand = 0x10,
-  SdepResponse = 0x20,
-  SdepAlert = 0x40,
-  SdepError = 0x80,
-  SdepSlaveNotReady = 0xfe, // Try again later
-  SdepSlaveOverflow = 0xff, // You read more data than is available
-};
-
-enum ble_cmd {
-  BleInitialize = 0xbeef,
-  BleAtWrapper = 0x0a00,
-  BleUartTx = 0x0a01,
-  BleUartRx = 0x0a02,
-};
-
 enum ble_system_event_bits {
   BleSystemConnected = 0,
   BleSystemDisconnected = 1,
@@ -254,20 +218,6 @@ static bool sdep_send_pkt(const struct sdep_msg *msg, uint16_t timeout) {
   return success;
 }
 
-static inline void sdep_build_pkt(struct sdep_msg *msg, uint16_t command,
-                                  const uint8_t *payload, uint8_t len,
-                                  bool moredata) {
-  msg->type = SdepCommand;
-  msg->cmd_low = command & 0xff;
-  msg->cmd_high = command >> 8;
-  msg->len = len;
-  msg->more = (moredata && len == SdepMaxPayload) ? 1 : 0;
-
-  static_assert(sizeof(*msg) == 20, "msg is correctly packed");
-
-  memcpy(msg->payload, payload, len);
-}
-
 // Read a single SDEP packet
 static bool sdep_recv_pkt(struct sdep_msg *msg, uint16_t timeout) {
   bool success = false;
@@ -345,26 +295,36 @@ again:
   }
 }
 
-static void send_buf_send_one(uint16_t timeout = SdepTimeout) {
+// Sends the oldest queued item, returning whether it did
+static bool send_buf_send_one(uint16_t timeout = SdepTimeout) {
   struct queue_item item;
 
-  // Don't send anything more until we get an ACK
-  if (!resp_buf.empty()) {
-    return;
+  // Don't send anything more until the oldest command gets its ACK
+  if (resp_buf.size() >= AdafruitBlePipelineDepth) {
+    resp_buf_read_one(false);
+    if (resp_buf.size() >= AdafruitBlePipelineDepth) {
+      return false;
+    }
   }
 
   if (!send_buf.peek(item)) {
-    return;
+    return false;
   }
   if (process_queue_item(&item, timeout)) {
     // commit that peek
     send_buf.get(item);
-    dprintf("send_buf_send_one: have %d remaining\n", (int)send_buf.size());
-  } else {
-    dprint("failed to send, will retry\n");
+    dprintf("send_buf_send_one: have %d remaining, %u coalesced\n",
+            (int)send_buf.size(), send_buf.coalesced);
+    return true;
+  }
+
+  dprint("failed to send, will retry\n");
+  // With commands in flight the module is just busy with them
+  if (resp_buf.empty()) {
     _delay_ms(SdepTimeout);
-    resp_buf_read_one(true);
   }
+  resp_buf_read_one(true);
+  return false;
 }
 
 static void resp_buf_wait(const char *cmd) {
@@ -378,6 +338,18 @@ static void resp_buf_wait(const char *cmd) {
   }
 }
 
+// Note that a response is due to the command just sent
+static void resp_buf_push(void) {
+  auto now = timer_read();
+  while (!resp_buf.enqueue(now)) {
+    resp_buf_read_one(false);
+  }
+  auto later = timer_read();
+  if (TIMER_DIFF_16(later, now) > 0) {
+    dprintf("waited %dms for resp_buf\n", TIMER_DIFF_16(later, now));
+  }
+}
+
 static bool ble_init(void) {
   state.initialized = false;
   state.configured = false;
@@ -497,14 +469,7 @@ static bool at_command(const char *cmd, char *resp, uint16_t resplen,
   }
 
   if (resp == NULL) {
-    auto now = timer_read();
-    while (!resp_buf.enqueue(now)) {
-      resp_buf_read_one(false);
-    }
-    auto later = timer_read();
-    if (TIMER_DIFF_16(later, now) > 0) {
-      dprintf("waited %dms for resp_buf\n", TIMER_DIFF_16(later, now));
-    }
+    resp_buf_push();
     return true;
   }
 
@@ -517,6 +482,45 @@ bool at_command_P(const char *cmd, char *resp, uint16_t resplen, bool verbose) {
   return at_command(cmdbuf, resp, resplen, verbose);
 }
 
+#ifdef AdafruitBleHidReportCmd
+// Sends a single packet command, leaving its response to resp_buf
+static bool sdep_send_command(uint16_t command, const uint8_t *payload,
+                              uint8_t len, uint16_t timeout) {
+  struct sdep_msg msg;
+
+  sdep_build_pkt(&msg, command, payload, len, false);
+  if (!sdep_send_pkt(&msg, timeout)) {
+    return false;
+  }
+  resp_buf_push();
+  return true;
+}
+
+// Whether the firmware takes binary reports. The report tried is
+// all keys up, which is harmless whatever state the host is in.
+static bool probe_binary_reports(void) {
+  struct queue_item item = {};
+  uint8_t payload[SdepMaxPayload];
+  struct sdep_msg msg;
+
+  item.queue_type = QTKeyReport;
+  resp_buf_wait("binary reports");
+
+  sdep_build_pkt(&msg, AdafruitBleHidReportCmd, payload,
+                 ble_hid_payload(&item, payload), false);
+  if (!sdep_send_pkt(&msg, SdepTimeout)) {
+    return false;
+  }
+  bool success = sdep_recv_pkt(&msg, 2 * SdepTimeout) &&
+                 msg.type == SdepResponse;
+  while (success && msg.more && sdep_recv_pkt(&msg, SdepTimeout)) {
+    ; // drain the rest of it
+  }
+  dprintf("binary reports: %s\n", success ? "yes" : "no");
+  return success;
+}
+#endif
+
 bool adafruit_ble_is_connected(void) {
   return state.is_connected;
 }
@@ -529,6 +533,8 @@ bool adafruit_ble_enable_keyboard(void) {
   }
 
   state.configured = false;
+  state.binary_reports = false;
+  state.mouse_buttons_sent = false;
 
   // Disable command echo
   static const char kEcho[] PROGMEM = "ATE=0";
@@ -607,7 +613,9 @@ void adafruit_ble_task(void) {
     return;
   }
   resp_buf_read_one(true);
-  send_buf_send_one(SdepShortTimeout);
+  while (send_buf_send_one(SdepShortTimeout)) {
+    ; // keep the pipeline full
+  }
 
   if (resp_buf.empty() && (state.event_flags & UsingEvents) &&
       digitalRead(AdafruitBleIRQPin)) {
@@ -637,6 +645,9 @@ void adafruit_ble_task(void) {
         state.event_flags |= UsingEvents;
       }
       state.event_flags |= ProbedEvents;
+#ifdef AdafruitBleHidReportCmd
+      state.binary_reports = probe_binary_reports();
+#endif
 
       // leave shouldPoll == true so that we check at least once
       // before relying solely on events
@@ -681,6 +692,14 @@ static bool process_queue_item(struct queue_item *item, uint16_t timeout) {
   }
 #endif
 
+#ifdef AdafruitBleHidReportCmd
+  if (state.binary_reports) {
+    uint8_t payload[SdepMaxPayload];
+    return sdep_send_command(AdafruitBleHidReportCmd, payload,
+                             ble_hid_payload(item, payload), timeout);
+  }
+#endif
+
   switch (item->queue_type) {
     case QTKeyReport:
       strcpy_P(fmtbuf,
@@ -703,6 +722,11 @@ static bool process_queue_item(struct queue_item *item, uint16_t timeout) {
       if (!at_command(cmdbuf, NULL, 0, true, timeout)) {
         return false;
       }
+      if (state.mouse_buttons_sent &&
+          item->mousemove.buttons == state.mouse_buttons) {
+        // Only the move; the buttons are as they were
+        return true;
+      }
       strcpy_P(cmdbuf, PSTR("AT+BLEHIDMOUSEBUTTON="));
       if (item->mousemove.buttons & MOUSE_BTN1) {
         strcat(cmdbuf, "L");
@@ -716,7 +740,12 @@ static bool process_queue_item(struct queue_item *item, uint16_t timeout) {
       if (item->mousemove.buttons == 0) {
         strcat(cmdbuf, "0");
       }
-      return at_command(cmdbuf, NULL, 0, true, timeout);
+      if (!at_command(cmdbuf, NULL, 0, true, timeout)) {
+        return false;
+      }
+      state.mouse_buttons = item->mousemove.buttons;
+      state.mouse_buttons_sent = true;
+      return true;
 #endif
     default:
       return true;
@@ -0,0 +1,150 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "ringbuffer.hpp"
+
+// The recv latency is relatively high, so when we're hammering keys quickly,
+// we want to avoid waiting for the responses in the matrix loop.  We maintain
+// a short queue for that.  Since there is quite a lot of space overhead for
+// the AT command representation wrapped up in SDEP, we queue the minimal
+// information here.
+
+enum queue_type {
+  QTKeyReport, // 1-byte modifier + 6-byte key report
+  QTConsumer,  // 16-bit key code
+#ifdef MOUSE_ENABLE
+  QTMouseMove, // 4-byte mouse report
+#endif
+};
+
+struct ble_key_report {
+  uint8_t modifier;
+  uint8_t keys[6];
+} __attribute__((packed));
+
+struct queue_item {
+  enum queue_type queue_type;
+  uint16_t added;
+  union __attribute__((packed)) {
+    struct ble_key_report key;
+
+    uint16_t consumer;
+    struct __attribute__((packed)) {
+      int8_t x, y, scroll, pan;
+      uint8_t buttons;
+    } mousemove;
+  };
+};
+
+static inline bool ble_key_report_has(const struct ble_key_report &report,
+                                      uint8_t code) {
+  for (uint8_t i = 0; i < sizeof(report.keys); i++) {
+    if (report.keys[i] == code) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Whether going from prev to last and on to next changes any key or
+// modifier twice. If it doesn't, last can be replaced by next without the
+// host missing a press or a release: a key tapped between prev and next
+// still has a report with it down and one with it up.
+static inline bool ble_key_report_toggles_twice(
+    const struct ble_key_report &prev, const struct ble_key_report &last,
+    const struct ble_key_report &next) {
+  if ((prev.modifier ^ last.modifier) & (last.modifier ^ next.modifier)) {
+    return true;
+  }
+  const struct ble_key_report *reports[] = { &prev, &last, &next };
+  for (auto report : reports) {
+    for (uint8_t i = 0; i < sizeof(report->keys); i++) {
+      uint8_t code = report->keys[i];
+      if (!code) {
+        continue;
+      }
+      bool in_last = ble_key_report_has(last, code);
+      if (ble_key_report_has(prev, code) != in_last &&
+          ble_key_report_has(next, code) != in_last) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// The send queue. A key report that is still waiting when the next one
+// arrives is overwritten by it, as long as that doesn't lose a press or a
+// release; the merged item keeps the time the older report was added, so
+// the send latency stays honest.
+template <uint8_t Size>
+class ReportQueue : public RingBuffer<queue_item, Size> {
+  // The last key report enqueued, and the one before it
+  struct ble_key_report last_{}, prev_{};
+
+ public:
+  uint16_t coalesced{0};
+
+  inline bool enqueue(const queue_item &item) {
+    if (item.queue_type != QTKeyReport) {
+      return RingBuffer<queue_item, Size>::enqueue(item);
+    }
+    if (!this->empty()) {
+      queue_item &back = this->back();
+      if (back.queue_type == QTKeyReport &&
+          !ble_key_report_toggles_twice(prev_, back.key, item.key)) {
+        back.key = item.key;
+        last_ = item.key;
+        coalesced++;
+        return true;
+      }
+    }
+    if (!RingBuffer<queue_item, Size>::enqueue(item)) {
+      return false;
+    }
+    prev_ = last_;
+    last_ = item.key;
+    return true;
+  }
+};
+
+// Which report the payload of the binary report command carries
+enum ble_hid_report_id {
+  BleHidKeyboard = 1,
+  BleHidMouse = 2,
+  BleHidConsumer = 3,
+};
+
+// The payload of the binary report command for item: the report ID
+// followed by the report. Returns its length.
+static inline uint8_t ble_hid_payload(const struct queue_item *item,
+                                      uint8_t *payload) {
+  switch (item->queue_type) {
+    case QTKeyReport:
+      payload[0] = BleHidKeyboard;
+      payload[1] = item->key.modifier;
+      payload[2] = 0;
+      memcpy(payload + 3, item->key.keys, sizeof(item->key.keys));
+      return 3 + sizeof(item->key.keys);
+
+    case QTConsumer:
+      payload[0] = BleHidConsumer;
+      payload[1] = item->consumer & 0xff;
+      payload[2] = item->consumer >> 8;
+      return 3;
+
+#ifdef MOUSE_ENABLE
+    case QTMouseMove:
+      payload[0] = BleHidMouse;
+      payload[1] = item->mousemove.buttons;
+      payload[2] = item->mousemove.x;
+      payload[3] = item->mousemove.y;
+      payload[4] = item->mousemove.scroll;
+      payload[5] = item->mousemove.pan;
+      return 6;
+#endif
+    default:
+      return 0;
+  }
+}
@@ -78,7 +78,11 @@
     #include "virtser.h"
 #endif
 
-#if (defined(RGB_MIDI) | defined(RGBLIGHT_ANIMATIONS)) & defined(RGBLIGHT_ENABLE)
+#ifdef MOUSEKEY_ENABLE
+    #include "mousekey.h"
+#endif
+
+#ifdef RGBLIGHT_ENABLE
     #include "rgblight.h"
 #endif
 
@@ -388,9 +392,17 @@ static bool console_flush = false;
   } \
 } while (0)
 
+#endif
+
+#if defined(CONSOLE_ENABLE) || defined(MOUSEKEY_ENABLE)
 // called every 1ms
 void EVENT_USB_Device_StartOfFrame(void)
 {
+#ifdef MOUSEKEY_ENABLE
+    mousekey_frame();
+#endif
+
+#ifdef CONSOLE_ENABLE
     static uint8_t count;
     if (++count % 50) return;
     count = 0;
@@ -398,8 +410,8 @@ void EVENT_USB_Device_StartOfFrame(void)
     if (!console_flush) return;
     Console_Task();
     console_flush = false;
+#endif
 }
-
 #endif
 
 /** Event handler for the USB_ConfigurationChanged event.
@@ -1049,6 +1061,11 @@ void virtser_task(void)
   }
 }
 void virtser_send(const uint8_t byte)
+{
+  virtser_send_packet(&byte, 1);
+}
+
+void virtser_send_packet(const uint8_t *data, uint8_t length)
 {
   uint8_t timeout = 255;
   uint8_t ep = Endpoint_GetCurrentEndpoint();
@@ -1065,7 +1082,11 @@ void virtser_send(const uint8_t byte)
 
     while (timeout-- && !Endpoint_IsReadWriteAllowed()) _delay_us(40);
 
-    Endpoint_Write_8(byte);
+    /* the whole packet goes in one USB transfer, as long as it fits the
+     * endpoint, so the host never sees half of it */
+    for (uint8_t i = 0; i < length; i++) {
+      Endpoint_Write_8(data[i]);
+    }
     CDC_Device_Flush(&cdc_device);
 
     if (Endpoint_IsINReady()) {
@@ -1199,7 +1220,7 @@ int main(void)
 #endif
 #endif
 
-#if defined(RGBLIGHT_ANIMATIONS) & defined(RGBLIGHT_ENABLE)
+#ifdef RGBLIGHT_ENABLE
         rgblight_task();
 #endif
 
@@ -60,6 +60,11 @@ class RingBuffer {
     return buf_[tail_];
   }
 
+  // The most recently enqueued item
+  inline T& back() {
+    return buf_[prevPosition(head_)];
+  }
+
   inline bool peek(T &item) {
     return get(item, false);
   }
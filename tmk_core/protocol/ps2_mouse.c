@@ -25,22 +25,46 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "report.h"
 #include "debug.h"
 #include "ps2.h"
+#include "ps2_mouse_packet.h"
 
 /* ============================= MACROS ============================ */
 
-static report_mouse_t mouse_report = {};
+#if defined(PS2_USE_INT) || defined(PS2_USE_USART)
+/* the driver queues what the mouse sends from its interrupt */
+#define PS2_MOUSE_QUEUED
+#endif
+
+#ifdef PS2_MOUSE_ENABLE_SCROLLING
+#define PS2_MOUSE_PACKET_SIZE 4
+#else
+#define PS2_MOUSE_PACKET_SIZE 3
+#endif
+
+static ps2_mouse_parser_t parser;
+static ps2_mouse_accumulator_t accumulator;
+/* a packet that has to wait for the report before it to go out */
+static ps2_mouse_packet_t waiting;
+static bool has_waiting = false;
+static uint16_t last_request = 0;
+static uint16_t last_report = 0;
 
+static inline void ps2_mouse_print_packet(const ps2_mouse_packet_t *packet);
 static inline void ps2_mouse_print_report(report_mouse_t *mouse_report);
-static inline void ps2_mouse_convert_report_to_hid(report_mouse_t *mouse_report);
-static inline void ps2_mouse_clear_report(report_mouse_t *mouse_report);
 static inline void ps2_mouse_enable_scrolling(void);
-static inline void ps2_mouse_scroll_button_task(report_mouse_t *mouse_report);
+static bool ps2_mouse_add_packet(const ps2_mouse_packet_t *packet);
+static void ps2_mouse_request(void);
+static void ps2_mouse_report(void);
+#if PS2_MOUSE_SCROLL_BTN_MASK
+static bool ps2_mouse_scroll_button_task(uint8_t *buttons, int16_t *x, int16_t *y, int16_t *v, int16_t *h);
+#endif
 
 /* ============================= IMPLEMENTATION ============================ */
 
 /* supports only 3 button mouse at this time */
 void ps2_mouse_init(void) {
     ps2_host_init();
+    ps2_mouse_parser_init(&parser, PS2_MOUSE_PACKET_SIZE);
+    ps2_mouse_accumulator_clear(&accumulator);
 
     _delay_ms(PS2_MOUSE_INIT_DELAY);    // wait for powering up
 
@@ -70,45 +94,92 @@ __attribute__((weak))
 void ps2_mouse_init_user(void) {
 }
 
+/* Takes in whatever the mouse has sent, and sends at most one report per
+ * millisecond, the length of a USB frame, with all the movement since the
+ * last one */
 void ps2_mouse_task(void) {
-    static uint8_t buttons_prev = 0;
-    extern int tp_buttons;
+    if (has_waiting && ps2_mouse_add_packet(&waiting)) {
+        has_waiting = false;
+    }
 
-    /* receives packet from mouse */
-    uint8_t rcv;
-    rcv = ps2_host_send(PS2_MOUSE_READ_DATA);
-    if (rcv == PS2_ACK) {
-        mouse_report.buttons = ps2_host_recv_response() | tp_buttons;
-        mouse_report.x = ps2_host_recv_response() * PS2_MOUSE_X_MULTIPLIER;
-        mouse_report.y = ps2_host_recv_response() * PS2_MOUSE_Y_MULTIPLIER;
-#ifdef PS2_MOUSE_ENABLE_SCROLLING
-        mouse_report.v = -(ps2_host_recv_response() & PS2_MOUSE_SCROLL_MASK) * PS2_MOUSE_V_MULTIPLIER;
+#ifdef PS2_MOUSE_QUEUED
+    while (!has_waiting) {
+        ps2_mouse_packet_t packet;
+        uint8_t data = ps2_host_recv();
+        if (ps2_error != PS2_ERR_NONE) break;
+        if (ps2_mouse_parse(&parser, data, &packet) && !ps2_mouse_add_packet(&packet)) {
+            waiting = packet;
+            has_waiting = true;
+        }
+    }
+    if (!has_waiting && ps2_mouse_mode == PS2_MOUSE_REMOTE_MODE) {
+        ps2_mouse_request();
+    }
+#else
+    if (!has_waiting) {
+        ps2_mouse_request();
+    }
 #endif
-    } else {
+
+    ps2_mouse_report();
+}
+
+/* Asks for a packet every PS2_MOUSE_POLL_INTERVAL ms. The interrupt drivers
+ * queue the answer as it comes in; the busywait driver reads it here. */
+static void ps2_mouse_request(void) {
+    if (parser.count || timer_elapsed(last_request) < PS2_MOUSE_POLL_INTERVAL) return;
+    last_request = timer_read();
+
+    if (ps2_host_send(PS2_MOUSE_READ_DATA) != PS2_ACK) {
         if (debug_mouse) print("ps2_mouse: fail to get mouse packet\n");
         return;
     }
+#ifndef PS2_MOUSE_QUEUED
+    ps2_mouse_packet_t packet;
+    for (uint8_t i = 0; i < PS2_MOUSE_PACKET_SIZE; i++) {
+        uint8_t data = ps2_host_recv_response();
+        if (ps2_mouse_parse(&parser, data, &packet) && !ps2_mouse_add_packet(&packet)) {
+            waiting = packet;
+            has_waiting = true;
+        }
+    }
+    ps2_mouse_parser_init(&parser, PS2_MOUSE_PACKET_SIZE);
+#endif
+}
+
+static bool ps2_mouse_add_packet(const ps2_mouse_packet_t *packet) {
+    extern int tp_buttons;
 
-    /* if mouse moves or buttons state changes */
-    if (mouse_report.x || mouse_report.y || mouse_report.v ||
-            ((mouse_report.buttons ^ buttons_prev) & PS2_MOUSE_BTN_MASK)) {
 #ifdef PS2_MOUSE_DEBUG_RAW
-        // Used to debug raw ps2 bytes from mouse
-        ps2_mouse_print_report(&mouse_report);
+    // Used to debug raw ps2 bytes from mouse
+    ps2_mouse_print_packet(packet);
+#endif
+    uint8_t buttons = (packet->buttons | tp_buttons) & PS2_MOUSE_BTN_MASK;
+    // invert coordinate of y to conform to USB HID mouse
+    int16_t x = packet->x * PS2_MOUSE_X_MULTIPLIER;
+    int16_t y = -packet->y * PS2_MOUSE_Y_MULTIPLIER;
+    int16_t v = 0;
+    int16_t h = 0;
+#ifdef PS2_MOUSE_ENABLE_SCROLLING
+    v = -(int8_t)(packet->z & PS2_MOUSE_SCROLL_MASK) * PS2_MOUSE_V_MULTIPLIER;
 #endif
-        buttons_prev = mouse_report.buttons;
-        ps2_mouse_convert_report_to_hid(&mouse_report);
 #if PS2_MOUSE_SCROLL_BTN_MASK
-        ps2_mouse_scroll_button_task(&mouse_report);
+    if (!ps2_mouse_scroll_button_task(&buttons, &x, &y, &v, &h)) return false;
 #endif
+    return ps2_mouse_accumulate(&accumulator, buttons, x, y, v, h);
+}
+
+static void ps2_mouse_report(void) {
+    report_mouse_t mouse_report = {};
+
+    if (timer_read() == last_report) return;
+    if (!ps2_mouse_take_report(&accumulator, &mouse_report)) return;
+    last_report = timer_read();
 #ifdef PS2_MOUSE_DEBUG_HID
-        // Used to debug the bytes sent to the host
-        ps2_mouse_print_report(&mouse_report);
+    // Used to debug the bytes sent to the host
+    ps2_mouse_print_report(&mouse_report);
 #endif
-        host_mouse_send(&mouse_report);
-    }
-
-    ps2_mouse_clear_report(&mouse_report);
+    host_mouse_send(&mouse_report);
 }
 
 void ps2_mouse_disable_data_reporting(void) {
@@ -147,38 +218,13 @@ void ps2_mouse_set_sample_rate(ps2_mouse_sample_rate_t sample_rate) {
 
 /* ============================= HELPERS ============================ */
 
-#define X_IS_NEG  (mouse_report->buttons & (1<<PS2_MOUSE_X_SIGN))
-#define Y_IS_NEG  (mouse_report->buttons & (1<<PS2_MOUSE_Y_SIGN))
-#define X_IS_OVF  (mouse_report->buttons & (1<<PS2_MOUSE_X_OVFLW))
-#define Y_IS_OVF  (mouse_report->buttons & (1<<PS2_MOUSE_Y_OVFLW))
-static inline void ps2_mouse_convert_report_to_hid(report_mouse_t *mouse_report) {
-    // PS/2 mouse data is '9-bit integer'(-256 to 255) which is comprised of sign-bit and 8-bit value.
-    // bit: 8    7 ... 0
-    //      sign \8-bit/
-    //
-    // Meanwhile USB HID mouse indicates 8bit data(-127 to 127), note that -128 is not used.
-    //
-    // This converts PS/2 data into HID value. Use only -127-127 out of PS/2 9-bit.
-    mouse_report->x = X_IS_NEG ?
-        ((!X_IS_OVF && -127 <= mouse_report->x && mouse_report->x <= -1) ?  mouse_report->x : -127) :
-        ((!X_IS_OVF && 0 <= mouse_report->x && mouse_report->x <= 127) ? mouse_report->x : 127);
-    mouse_report->y = Y_IS_NEG ?
-        ((!Y_IS_OVF && -127 <= mouse_report->y && mouse_report->y <= -1) ?  mouse_report->y : -127) :
-        ((!Y_IS_OVF && 0 <= mouse_report->y && mouse_report->y <= 127) ? mouse_report->y : 127);
-
-    // remove sign and overflow flags
-    mouse_report->buttons &= PS2_MOUSE_BTN_MASK;
-
-    // invert coordinate of y to conform to USB HID mouse
-    mouse_report->y = -mouse_report->y;
-}
-
-static inline void ps2_mouse_clear_report(report_mouse_t *mouse_report) {
-    mouse_report->x = 0;
-    mouse_report->y = 0;
-    mouse_report->v = 0;
-    mouse_report->h = 0;
-    mouse_report->buttons = 0;
+static inline void ps2_mouse_print_packet(const ps2_mouse_packet_t *packet) {
+    if (!debug_mouse) return;
+    print("ps2_mouse: packet [");
+    phex(packet->buttons); print("|");
+    print_decs(packet->x); print(" ");
+    print_decs(packet->y); print(" ");
+    print_hex8(packet->z); print("]\n");
 }
 
 static inline void ps2_mouse_print_report(report_mouse_t *mouse_report) {
@@ -202,9 +248,12 @@ static inline void ps2_mouse_enable_scrolling(void) {
     _delay_ms(20);
 }
 
-#define PRESS_SCROLL_BUTTONS    mouse_report->buttons |= (PS2_MOUSE_SCROLL_BTN_MASK)
-#define RELEASE_SCROLL_BUTTONS  mouse_report->buttons &= ~(PS2_MOUSE_SCROLL_BTN_MASK)
-static inline void ps2_mouse_scroll_button_task(report_mouse_t *mouse_report) {
+/* While the scroll buttons are held, movement scrolls instead. Letting go
+ * of them quickly without scrolling clicks them: the press goes out in a
+ * report of its own, and the release in the next. Returns false when the
+ * packet has to wait for a report first. */
+#if PS2_MOUSE_SCROLL_BTN_MASK
+static bool ps2_mouse_scroll_button_task(uint8_t *buttons, int16_t *x, int16_t *y, int16_t *v, int16_t *h) {
     static enum {
         SCROLL_NONE,
         SCROLL_BTN,
@@ -212,7 +261,7 @@ static inline void ps2_mouse_scroll_button_task(report_mouse_t *mouse_report) {
     } scroll_state = SCROLL_NONE;
     static uint16_t scroll_button_time = 0;
 
-    if (PS2_MOUSE_SCROLL_BTN_MASK == (mouse_report->buttons & (PS2_MOUSE_SCROLL_BTN_MASK))) {
+    if (PS2_MOUSE_SCROLL_BTN_MASK == (*buttons & (PS2_MOUSE_SCROLL_BTN_MASK))) {
         // All scroll buttons are pressed
 
         if (scroll_state == SCROLL_NONE) {
@@ -221,27 +270,31 @@ static inline void ps2_mouse_scroll_button_task(report_mouse_t *mouse_report) {
         }
 
         // If the mouse has moved, update the report to scroll instead of move the mouse
-        if (mouse_report->x || mouse_report->y) {
+        if (*x || *y) {
             scroll_state = SCROLL_SENT;
-            mouse_report->v = -mouse_report->y/(PS2_MOUSE_SCROLL_DIVISOR_V);
-            mouse_report->h =  mouse_report->x/(PS2_MOUSE_SCROLL_DIVISOR_H);
-            mouse_report->x = 0;
-            mouse_report->y = 0;
+            *v = -*y/(PS2_MOUSE_SCROLL_DIVISOR_V);
+            *h =  *x/(PS2_MOUSE_SCROLL_DIVISOR_H);
+            *x = 0;
+            *y = 0;
         }
-    } else if (0 == (PS2_MOUSE_SCROLL_BTN_MASK & mouse_report->buttons)) {
+    } else if (0 == (PS2_MOUSE_SCROLL_BTN_MASK & *buttons)) {
         // None of the scroll buttons are pressed
 
 #if PS2_MOUSE_SCROLL_BTN_SEND
         if (scroll_state == SCROLL_BTN
                 && timer_elapsed(scroll_button_time) < PS2_MOUSE_SCROLL_BTN_SEND) {
-            PRESS_SCROLL_BUTTONS;
-            host_mouse_send(mouse_report);
-            _delay_ms(100);
-            RELEASE_SCROLL_BUTTONS;
+            if (!ps2_mouse_accumulate(&accumulator, *buttons | PS2_MOUSE_SCROLL_BTN_MASK, 0, 0, 0, 0)) {
+                return false;
+            }
+            // the release goes in the next report
+            scroll_state = SCROLL_NONE;
+            return false;
         }
 #endif
         scroll_state = SCROLL_NONE;
     }
 
-    RELEASE_SCROLL_BUTTONS;
+    *buttons &= ~(PS2_MOUSE_SCROLL_BTN_MASK);
+    return true;
 }
+#endif
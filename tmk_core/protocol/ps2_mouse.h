@@ -114,6 +114,10 @@ static enum ps2_mouse_mode_e {
 #ifndef PS2_MOUSE_SCROLL_MASK       
 #define PS2_MOUSE_SCROLL_MASK           0xFF 
 #endif
+/* ms between packets asked for in remote mode, or with the busywait driver */
+#ifndef PS2_MOUSE_POLL_INTERVAL
+#define PS2_MOUSE_POLL_INTERVAL         10
+#endif
 #ifndef PS2_MOUSE_INIT_DELAY
 #define PS2_MOUSE_INIT_DELAY            1000
 #endif
@@ -0,0 +1,111 @@
+/*
+Copyright 2011,2013 Jun Wako <wakojun@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "ps2_mouse_packet.h"
+
+#define X_SIGN  (1 << 4)
+#define Y_SIGN  (1 << 5)
+#define X_OVFLW (1 << 6)
+#define Y_OVFLW (1 << 7)
+
+void ps2_mouse_parser_init(ps2_mouse_parser_t *parser, uint8_t size)
+{
+    parser->count = 0;
+    parser->size = size;
+}
+
+// 9 bit movement, the most it can be in its direction on overflow
+static int16_t movement(uint8_t value, bool negative, bool overflow)
+{
+    if (overflow) {
+        return negative ? -256 : 255;
+    }
+    return negative ? (int16_t)value - 256 : value;
+}
+
+bool ps2_mouse_parse(ps2_mouse_parser_t *parser, uint8_t byte, ps2_mouse_packet_t *packet)
+{
+    if (parser->count == 0 && !(byte & PS2_MOUSE_PACKET_ALWAYS_SET)) {
+        return false;
+    }
+    parser->bytes[parser->count++] = byte;
+    if (parser->count < parser->size) {
+        return false;
+    }
+    parser->count = 0;
+
+    uint8_t status = parser->bytes[0];
+    packet->buttons = status & PS2_MOUSE_PACKET_BTN_MASK;
+    packet->x = movement(parser->bytes[1], status & X_SIGN, status & X_OVFLW);
+    packet->y = movement(parser->bytes[2], status & Y_SIGN, status & Y_OVFLW);
+    packet->z = parser->size > 3 ? parser->bytes[3] : 0;
+    return true;
+}
+
+void ps2_mouse_accumulator_clear(ps2_mouse_accumulator_t *accumulator)
+{
+    *accumulator = (ps2_mouse_accumulator_t){};
+}
+
+bool ps2_mouse_pending(const ps2_mouse_accumulator_t *accumulator)
+{
+    return accumulator->x || accumulator->y || accumulator->v || accumulator->h ||
+        accumulator->buttons != accumulator->sent_buttons;
+}
+
+static int16_t add(int16_t total, int16_t delta)
+{
+    int32_t sum = (int32_t)total + delta;
+    return sum > INT16_MAX ? INT16_MAX : (sum < -INT16_MAX ? -INT16_MAX : sum);
+}
+
+bool ps2_mouse_accumulate(ps2_mouse_accumulator_t *accumulator, uint8_t buttons,
+                          int16_t x, int16_t y, int16_t v, int16_t h)
+{
+    if (buttons != accumulator->buttons && ps2_mouse_pending(accumulator)) {
+        return false;
+    }
+    accumulator->buttons = buttons;
+    accumulator->x = add(accumulator->x, x);
+    accumulator->y = add(accumulator->y, y);
+    accumulator->v = add(accumulator->v, v);
+    accumulator->h = add(accumulator->h, h);
+    return true;
+}
+
+// The part of total a report can carry, taken out of it
+static int8_t take(int16_t *total)
+{
+    int16_t value = *total > 127 ? 127 : (*total < -127 ? -127 : *total);
+    *total -= value;
+    return value;
+}
+
+bool ps2_mouse_take_report(ps2_mouse_accumulator_t *accumulator, report_mouse_t *report)
+{
+    if (!ps2_mouse_pending(accumulator)) {
+        return false;
+    }
+    report->buttons = accumulator->buttons;
+    report->x = take(&accumulator->x);
+    report->y = take(&accumulator->y);
+    report->v = take(&accumulator->v);
+    report->h = take(&accumulator->h);
+    accumulator->sent_buttons = accumulator->buttons;
+    return true;
+}
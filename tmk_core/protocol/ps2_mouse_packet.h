@@ -0,0 +1,73 @@
+/*
+Copyright 2011,2013 Jun Wako <wakojun@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PS2_MOUSE_PACKET_H
+#define PS2_MOUSE_PACKET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "report.h"
+
+/*
+ * PS/2 mouse packets, and the motion they add up to between reports
+ *
+ * The parser takes the bytes in whatever pieces the driver hands them
+ * over, and resynchronises on the bit that is always set in the first
+ * byte of a packet. Movement is kept 9 bit, as the mouse sends it.
+ *
+ * The accumulator adds packets up until a report goes out, so a mouse
+ * sending faster than reports are taken loses nothing: what doesn't fit
+ * the -127 to 127 of a report is left for the next one. A change of
+ * buttons is never merged with movement from before it, so the packet
+ * after one has to wait until the report with it has been taken.
+ */
+
+#define PS2_MOUSE_PACKET_ALWAYS_SET (1 << 3)
+#define PS2_MOUSE_PACKET_BTN_MASK   0x07
+
+typedef struct {
+    uint8_t buttons;
+    int16_t x, y;   // -256 to 255, y up
+    uint8_t z;      // fourth byte of a scroll wheel mouse
+} ps2_mouse_packet_t;
+
+typedef struct {
+    uint8_t bytes[4];
+    uint8_t count;
+    uint8_t size;   // 3, or 4 with the scroll wheel on
+} ps2_mouse_parser_t;
+
+typedef struct {
+    int16_t x, y, v, h;   // HID directions, y down
+    uint8_t buttons;
+    uint8_t sent_buttons;
+} ps2_mouse_accumulator_t;
+
+void ps2_mouse_parser_init(ps2_mouse_parser_t *parser, uint8_t size);
+// Returns true once byte completes a packet
+bool ps2_mouse_parse(ps2_mouse_parser_t *parser, uint8_t byte, ps2_mouse_packet_t *packet);
+
+void ps2_mouse_accumulator_clear(ps2_mouse_accumulator_t *accumulator);
+// Adds movement in HID directions with buttons, returns false if the
+// buttons changed while there is still something to send
+bool ps2_mouse_accumulate(ps2_mouse_accumulator_t *accumulator, uint8_t buttons,
+                          int16_t x, int16_t y, int16_t v, int16_t h);
+bool ps2_mouse_pending(const ps2_mouse_accumulator_t *accumulator);
+// Fills report with what there is to send, returns false if nothing
+bool ps2_mouse_take_report(ps2_mouse_accumulator_t *accumulator, report_mouse_t *report);
+
+#endif
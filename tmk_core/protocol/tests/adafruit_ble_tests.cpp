@@ -0,0 +1,394 @@
+#include "gtest/gtest.h"
+#include <stdio.h>
+#include <deque>
+#include <map>
+#include <vector>
+#include "protocol/lufa/sdep.hpp"
+#include "protocol/lufa/adafruit_ble_queue.hpp"
+
+static queue_item key_item(uint16_t added, uint8_t modifier,
+                           std::initializer_list<uint8_t> keys) {
+    queue_item item = {};
+    item.queue_type = QTKeyReport;
+    item.added = added;
+    item.key.modifier = modifier;
+    uint8_t i = 0;
+    for (uint8_t key : keys) {
+        item.key.keys[i++] = key;
+    }
+    return item;
+}
+
+TEST(AdafruitBleQueue, presses_collapse_into_one_report) {
+    ReportQueue<8> queue;
+    queue.enqueue(key_item(1, 0, { 4 }));
+    queue.enqueue(key_item(2, 0x02, { 4 }));
+    queue.enqueue(key_item(3, 0x02, { 4, 5 }));
+    ASSERT_EQ(queue.size(), 1);
+    EXPECT_EQ(queue.coalesced, 2);
+
+    queue_item item;
+    ASSERT_TRUE(queue.get(item));
+    EXPECT_EQ(item.added, 1);
+    EXPECT_EQ(item.key.modifier, 0x02);
+    EXPECT_EQ(item.key.keys[0], 4);
+    EXPECT_EQ(item.key.keys[1], 5);
+}
+
+TEST(AdafruitBleQueue, taps_keep_their_press_and_release) {
+    ReportQueue<8> queue;
+    queue.enqueue(key_item(1, 0, { 4 }));
+    queue.enqueue(key_item(2, 0, {}));
+    queue.enqueue(key_item(3, 0x01, {}));
+    queue.enqueue(key_item(4, 0, {}));
+    // 4 down and up; the release goes with the press of ctrl, which has to
+    // stay apart from its release
+    EXPECT_EQ(queue.size(), 3);
+
+    queue_item item;
+    ASSERT_TRUE(queue.get(item));
+    EXPECT_EQ(item.key.keys[0], 4);
+    ASSERT_TRUE(queue.get(item));
+    EXPECT_EQ(item.key.modifier, 0x01);
+    EXPECT_EQ(item.key.keys[0], 0);
+    ASSERT_TRUE(queue.get(item));
+    EXPECT_EQ(item.key.modifier, 0);
+}
+
+TEST(AdafruitBleQueue, release_and_next_press_collapse) {
+    ReportQueue<8> queue;
+    queue.enqueue(key_item(1, 0, { 4 }));
+    queue.enqueue(key_item(2, 0, {}));
+    queue.enqueue(key_item(3, 0, { 5 }));
+    EXPECT_EQ(queue.size(), 2);
+    EXPECT_EQ(queue.back().key.keys[0], 5);
+    // Moving a key to another slot is not a change
+    queue.enqueue(key_item(4, 0, { 6, 5 }));
+    queue.enqueue(key_item(5, 0, { 5, 6, 7 }));
+    EXPECT_EQ(queue.size(), 2);
+}
+
+TEST(AdafruitBleQueue, only_waiting_key_reports_collapse) {
+    ReportQueue<8> queue;
+    queue_item consumer = {};
+    consumer.queue_type = QTConsumer;
+    consumer.consumer = 0xE9;
+
+    queue.enqueue(key_item(1, 0, { 4 }));
+    queue.enqueue(consumer);
+    queue.enqueue(key_item(2, 0, { 4, 5 }));
+    EXPECT_EQ(queue.size(), 3);
+
+    // Once sent a report stays as it was
+    queue_item item;
+    while (queue.get(item)) {
+    }
+    queue.enqueue(key_item(3, 0, { 4, 5, 6 }));
+    EXPECT_EQ(queue.size(), 1);
+    EXPECT_EQ(queue.coalesced, 0);
+}
+
+TEST(AdafruitBleQueue, binary_payloads) {
+    uint8_t payload[SdepMaxPayload];
+    queue_item item = key_item(0, 0x22, { 4, 5, 6, 7, 8, 9 });
+    ASSERT_EQ(ble_hid_payload(&item, payload), 9);
+    const uint8_t keys[] = { BleHidKeyboard, 0x22, 0, 4, 5, 6, 7, 8, 9 };
+    EXPECT_EQ(memcmp(payload, keys, sizeof(keys)), 0);
+
+    item.queue_type = QTConsumer;
+    item.consumer = 0x01B5;
+    ASSERT_EQ(ble_hid_payload(&item, payload), 3);
+    EXPECT_EQ(payload[0], BleHidConsumer);
+    EXPECT_EQ(payload[1], 0xB5);
+    EXPECT_EQ(payload[2], 0x01);
+
+    item.queue_type = QTMouseMove;
+    item.mousemove.x = -3;
+    item.mousemove.y = 5;
+    item.mousemove.scroll = 1;
+    item.mousemove.pan = 0;
+    item.mousemove.buttons = 0x01;
+    ASSERT_EQ(ble_hid_payload(&item, payload), 6);
+    const uint8_t mouse[] = { BleHidMouse, 0x01, 0xFD, 5, 1, 0 };
+    EXPECT_EQ(memcmp(payload, mouse, sizeof(mouse)), 0);
+}
+
+/*
+ * A stand-in for the module on the other side of SDEP, with the keyboard's
+ * send loop in front of it, to see what the ways of sending reports do to
+ * how many get through and how late. The costs are guesses rather than
+ * measurements of the nRF51 firmware: acting on an AT command takes much
+ * longer than taking a binary report, and the link carries a few
+ * notifications per connection interval.
+ */
+#define TestHidCommand 0x0a20
+
+struct Costs {
+    uint32_t scan = 300;            // us the matrix scan takes
+    uint32_t spi_packet = 60;       // us to move a packet over SPI
+    uint32_t at_command = 5000;     // us the module takes for an AT report
+    uint32_t binary_command = 300;  // us for a binary one
+    uint32_t interval = 15000;      // us between connection events
+    uint8_t per_event = 6;          // notifications per connection event
+    uint8_t link_buffer = 4;        // notifications the module can hold
+};
+
+struct Delivered {
+    ble_key_report report;
+    uint32_t time;      // us
+    uint32_t latency;   // us
+};
+
+class SdepModule {
+    const Costs &costs_;
+    uint32_t time_{0};
+    uint32_t next_event_;
+    std::vector<uint8_t> at_;
+    struct Command {
+        ble_key_report report;
+        uint16_t added;
+        uint32_t cost;
+    };
+    std::deque<Command> commands_;
+    bool busy_{false};
+    uint32_t done_{0};
+    Command current_;
+    std::deque<Command> link_;
+
+public:
+    std::deque<uint32_t> responses;
+    std::vector<Delivered> delivered;
+
+    explicit SdepModule(const Costs &costs)
+        : costs_(costs), next_event_(costs.interval) {}
+
+    bool idle() const { return !busy_ && commands_.empty() && link_.empty(); }
+
+    void receive(const sdep_msg &msg, uint16_t added) {
+        ASSERT_EQ(msg.type, SdepCommand);
+        Command command = {};
+        command.added = added;
+        if (sdep_pkt_command(&msg) == TestHidCommand) {
+            ASSERT_EQ(msg.payload[0], BleHidKeyboard);
+            command.report.modifier = msg.payload[1];
+            memcpy(command.report.keys, msg.payload + 3, 6);
+            command.cost = costs_.binary_command;
+            commands_.push_back(command);
+            return;
+        }
+        ASSERT_EQ(sdep_pkt_command(&msg), BleAtWrapper);
+        at_.insert(at_.end(), msg.payload, msg.payload + msg.len);
+        if (msg.more) {
+            return;
+        }
+        at_.push_back(0);
+        unsigned mod, k[6];
+        ASSERT_EQ(sscanf((const char *)at_.data(),
+                         "AT+BLEKEYBOARDCODE=%x-00-%x-%x-%x-%x-%x-%x",
+                         &mod, &k[0], &k[1], &k[2], &k[3], &k[4], &k[5]), 7);
+        at_.clear();
+        command.report.modifier = mod;
+        for (int i = 0; i < 6; i++) {
+            command.report.keys[i] = k[i];
+        }
+        command.cost = costs_.at_command;
+        commands_.push_back(command);
+    }
+
+    // Runs the module up to now, 10us at a time
+    void advance(uint32_t now) {
+        for (; time_ < now; time_ += 10) {
+            if (time_ >= next_event_) {
+                for (uint8_t n = 0; n < costs_.per_event && !link_.empty(); n++) {
+                    Command &sent = link_.front();
+                    delivered.push_back({ sent.report, time_, time_ - sent.added * 1000u });
+                    link_.pop_front();
+                }
+                next_event_ += costs_.interval;
+            }
+            if (busy_ && time_ >= done_ && link_.size() < costs_.link_buffer) {
+                link_.push_back(current_);
+                responses.push_back(time_);
+                busy_ = false;
+            }
+            if (!busy_ && !commands_.empty()) {
+                current_ = commands_.front();
+                commands_.pop_front();
+                done_ = time_ + current_.cost;
+                busy_ = true;
+            }
+        }
+    }
+};
+
+struct KeyEvent {
+    uint32_t time;  // us
+    uint8_t code;
+    bool pressed;
+};
+
+static std::vector<KeyEvent> keystrokes(uint32_t count, uint32_t every, uint32_t hold) {
+    std::multimap<uint32_t, KeyEvent> events;
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t code = 4 + (i * 7) % 26;
+        uint32_t time = i * every;
+        events.insert({ time, { time, code, true } });
+        events.insert({ time + hold, { time + hold, code, false } });
+    }
+    std::vector<KeyEvent> list;
+    for (auto &event : events) {
+        list.push_back(event.second);
+    }
+    return list;
+}
+
+struct Result {
+    unsigned reports;       // made by the keyboard
+    unsigned sent;          // delivered by the module
+    double per_second;      // reports made per second until the last was sent
+    double mean_latency;    // ms
+    std::map<uint8_t, unsigned> presses_seen;
+    ble_key_report last;
+};
+
+template <typename Queue>
+static Result run(Queue &queue, bool binary, uint8_t depth, const Costs &costs,
+                  const std::vector<KeyEvent> &events) {
+    SdepModule module(costs);
+    Result result = {};
+    ble_key_report keys = {};
+    uint32_t now = 0;
+    uint8_t in_flight = 0;
+    size_t next = 0;
+
+    auto send_packet = [&](const sdep_msg &msg, uint16_t added) {
+        now += costs.spi_packet;
+        module.advance(now);
+        module.receive(msg, added);
+    };
+
+    // adafruit_ble_task(): the responses that are in, then as much as the
+    // pipeline takes
+    auto task = [&]() {
+        module.advance(now);
+        while (in_flight && !module.responses.empty()) {
+            now += costs.spi_packet;
+            module.responses.pop_front();
+            in_flight--;
+            module.advance(now);
+        }
+        queue_item item;
+        while (in_flight < depth && queue.get(item)) {
+            sdep_msg msg;
+            if (binary) {
+                uint8_t payload[SdepMaxPayload];
+                sdep_build_pkt(&msg, TestHidCommand, payload,
+                               ble_hid_payload(&item, payload), false);
+                send_packet(msg, item.added);
+            } else {
+                char cmd[48];
+                snprintf(cmd, sizeof(cmd),
+                         "AT+BLEKEYBOARDCODE=%02x-00-%02x-%02x-%02x-%02x-%02x-%02x",
+                         item.key.modifier, item.key.keys[0], item.key.keys[1],
+                         item.key.keys[2], item.key.keys[3], item.key.keys[4],
+                         item.key.keys[5]);
+                const char *at = cmd, *end = cmd + strlen(cmd);
+                while (end - at > SdepMaxPayload) {
+                    sdep_build_pkt(&msg, BleAtWrapper, (const uint8_t *)at,
+                                   SdepMaxPayload, true);
+                    send_packet(msg, item.added);
+                    at += SdepMaxPayload;
+                }
+                sdep_build_pkt(&msg, BleAtWrapper, (const uint8_t *)at, end - at, false);
+                send_packet(msg, item.added);
+            }
+            in_flight++;
+        }
+    };
+
+    while (next < events.size() || !queue.empty() || in_flight || !module.idle()) {
+        EXPECT_LT(now, 60000000u) << "stuck";
+        if (now >= 60000000u) {
+            break;
+        }
+        now += costs.scan;
+        for (; next < events.size() && events[next].time <= now; next++) {
+            const KeyEvent &event = events[next];
+            for (uint8_t i = 0; i < 6; i++) {
+                if (event.pressed ? keys.keys[i] == 0 : keys.keys[i] == event.code) {
+                    keys.keys[i] = event.pressed ? event.code : 0;
+                    break;
+                }
+            }
+            queue_item item = {};
+            item.queue_type = QTKeyReport;
+            item.added = now / 1000;
+            item.key = keys;
+            // adafruit_ble_send_keys() sends until there is room
+            while (!queue.enqueue(item)) {
+                now += costs.scan;
+                task();
+            }
+            result.reports++;
+        }
+        task();
+    }
+
+    ble_key_report host = {};
+    for (auto &sent : module.delivered) {
+        for (uint8_t code : sent.report.keys) {
+            if (code && !ble_key_report_has(host, code)) {
+                result.presses_seen[code]++;
+            }
+        }
+        host = sent.report;
+        result.mean_latency += sent.latency / 1000.0;
+    }
+    result.last = host;
+    result.sent = module.delivered.size();
+    result.mean_latency /= result.sent;
+    result.per_second = result.reports /
+                        ((module.delivered.back().time - events.front().time) / 1e6);
+    return result;
+}
+
+static void expect_every_press(const Result &result, const std::vector<KeyEvent> &events) {
+    std::map<uint8_t, unsigned> presses;
+    for (auto &event : events) {
+        if (event.pressed) {
+            presses[event.code]++;
+        }
+    }
+    EXPECT_EQ(result.presses_seen, presses);
+    EXPECT_EQ(result.last.keys[0], 0);
+    EXPECT_EQ(result.last.modifier, 0);
+}
+
+// Typing at 40 keys a second, then a macro sending a key every 2ms; the
+// driver as it was against coalesced AT commands, waiting for each OK as
+// the default does and pipelined two deep, and binary reports
+TEST(AdafruitBleQueue, sdep_module_stand_in) {
+    Costs costs;
+
+    for (auto events : { keystrokes(60, 25000, 45000), keystrokes(60, 2000, 1000) }) {
+        RingBuffer<queue_item, 40> plain;
+        Result before = run(plain, false, 1, costs, events);
+        ReportQueue<40> queue_lockstep;
+        Result lockstep = run(queue_lockstep, false, 1, costs, events);
+        ReportQueue<40> queue_at;
+        Result at = run(queue_at, false, 2, costs, events);
+        ReportQueue<40> queue_binary;
+        Result binary = run(queue_binary, true, 2, costs, events);
+
+        expect_every_press(before, events);
+        expect_every_press(lockstep, events);
+        expect_every_press(at, events);
+        expect_every_press(binary, events);
+
+        EXPECT_EQ(before.sent, before.reports);
+        EXPECT_LE(lockstep.mean_latency, before.mean_latency);
+        EXPECT_LE(at.mean_latency, before.mean_latency);
+        EXPECT_LE(binary.mean_latency, at.mean_latency);
+        EXPECT_GE(binary.per_second, before.per_second);
+    }
+}
@@ -0,0 +1,308 @@
+#include "gtest/gtest.h"
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+extern "C" {
+#include "protocol/adb_engine.h"
+}
+
+// A waveform as a logic analyser records it: the level after each edge
+// and the microseconds since the one before, from the host letting go of
+// the line at the end of its stop bit
+struct edge {
+    bool level;
+    uint16_t us;
+};
+typedef std::vector<edge> waveform_t;
+
+// What a device sends: the line held for a service request or not, stop
+// to start, start bit, data, stop bit
+static waveform_t reply(const std::vector<uint8_t>& data, uint16_t cell, uint16_t srq = 0,
+                        int jitter = 0, uint16_t tlt = 180) {
+    waveform_t wave;
+    auto j = [&]() { return jitter ? rand() % (2 * jitter + 1) - jitter : 0; };
+    wave.push_back({ 1, (uint16_t)(srq ? srq : 2) });
+    wave.push_back({ 0, tlt });
+    std::vector<bool> bits;
+    bits.push_back(1);
+    for (uint8_t byte : data) {
+        for (int i = 7; i >= 0; i--) {
+            bits.push_back(byte & (1 << i));
+        }
+    }
+    bits.push_back(0);
+    for (size_t i = 0; i < bits.size(); i++) {
+        uint16_t low = (bits[i] ? cell * 35 : cell * 65) / 100 + j();
+        wave.push_back({ 1, low });
+        if (i + 1 < bits.size()) {
+            wave.push_back({ 0, (uint16_t)(cell - low + j()) });
+        }
+    }
+    return wave;
+}
+
+class AdbEngine : public testing::Test {
+public:
+    AdbEngine() : bus() {
+        adb_engine_init();
+        srand(3);
+    }
+
+    // Runs the next transaction on the bus, with the device answering
+    // wave, keeps what the host drove
+    adb_transaction_t run(const waveform_t& wave) {
+        host.clear();
+        if (!bus.wait) {
+            bus = adb_engine_start();
+        }
+        // the gap after a listen is the only released wait that long
+        while (bus.wait && !bus.edges && !(bus.wait == ADB_GAP && !bus.drive)) {
+            host.push_back({ !bus.drive, bus.wait });
+            bus = adb_engine_timer();
+        }
+        for (const edge& e : wave) {
+            uint16_t us = e.us;
+            while (bus.edges && us > bus.wait) {
+                us -= bus.wait;
+                bus = adb_engine_timer();
+            }
+            if (!bus.edges) {
+                break;
+            }
+            bus = adb_engine_edge(e.level, us);
+        }
+        // the line stays where the waveform left it
+        while (bus.edges) {
+            bus = adb_engine_timer();
+        }
+        EXPECT_EQ(bus.wait, ADB_GAP);
+        EXPECT_FALSE(bus.drive);
+        // which starts whatever is queued next
+        bus = adb_engine_timer();
+        adb_transaction_t transaction;
+        EXPECT_TRUE(adb_engine_result(&transaction));
+        return transaction;
+    }
+
+    adb_transaction_t talk(uint8_t command, const waveform_t& wave) {
+        EXPECT_TRUE(adb_engine_queue(command, 0, 0));
+        return run(wave);
+    }
+
+    // Reads bits back from what the host drove, low first
+    std::vector<bool> host_bits(size_t from, size_t to) {
+        std::vector<bool> bits;
+        for (size_t i = from; i + 1 < to; i += 2) {
+            EXPECT_FALSE(host[i].level);
+            EXPECT_EQ(host[i].us + host[i + 1].us, 100);
+            bits.push_back(host[i].us < host[i + 1].us);
+        }
+        return bits;
+    }
+
+    adb_bus_t bus;
+    waveform_t host;
+};
+
+static uint8_t byte_of(const std::vector<bool>& bits, size_t from) {
+    uint8_t byte = 0;
+    for (size_t i = 0; i < 8; i++) {
+        byte = byte << 1 | bits[from + i];
+    }
+    return byte;
+}
+
+TEST_F(AdbEngine, talk_is_attention_command_and_stop_bit) {
+    talk(ADB_TALK(2, 0), reply({ 0x00, 0xFF }, 100));
+    ASSERT_EQ(host.size(), 2 + 16 + 1);
+    EXPECT_FALSE(host[0].level);
+    EXPECT_EQ(host[0].us, ADB_ATTENTION);
+    EXPECT_EQ(host[1].us, ADB_BIT_LONG);
+    std::vector<bool> bits = host_bits(2, 18);
+    EXPECT_EQ(byte_of(bits, 0), 0x2C);
+    // the host lets go in the low half of the stop bit
+    EXPECT_FALSE(host[18].level);
+    EXPECT_EQ(host[18].us, ADB_BIT_LONG);
+}
+
+TEST_F(AdbEngine, listen_sends_its_data) {
+    uint8_t data[2] = { 0x00, 0x05 };
+    ASSERT_TRUE(adb_engine_queue(ADB_LISTEN(2, 2), data, 2));
+    adb_transaction_t transaction = run({});
+    EXPECT_EQ(transaction.status, ADB_OK);
+    EXPECT_EQ(transaction.command, 0x2A);
+
+    ASSERT_EQ(host.size(), 2 + 16 + 2 + 2 + 32 + 2);
+    EXPECT_EQ(byte_of(host_bits(2, 18), 0), 0x2A);
+    EXPECT_EQ(host[19].us, ADB_BIT_SHORT + ADB_STOP_TO_START);
+    std::vector<bool> bits = host_bits(20, host.size());
+    ASSERT_EQ(bits.size(), 1 + 16 + 1);
+    EXPECT_TRUE(bits[0]);
+    EXPECT_EQ(byte_of(bits, 1), 0x00);
+    EXPECT_EQ(byte_of(bits, 9), 0x05);
+    EXPECT_FALSE(bits[17]);
+}
+
+// What the host sends after its command reads back with the decoder the
+// host uses for devices
+TEST_F(AdbEngine, listen_reads_back_as_a_reply) {
+    uint8_t data[4] = { 0x12, 0x34, 0xA5, 0xFF };
+    ASSERT_TRUE(adb_engine_queue(ADB_LISTEN(3, 1), data, 4));
+    run({});
+    adb_rx_t rx;
+    adb_rx_start(&rx);
+    adb_rx_edge(&rx, 1, 0);
+    // up to the stop bit, after which the line stays high
+    for (size_t i = 19; i + 1 < host.size(); i++) {
+        adb_rx_edge(&rx, !host[i].level, host[i].us);
+    }
+    adb_rx_timeout(&rx);
+    ASSERT_EQ(adb_rx_status(&rx), ADB_OK);
+    ASSERT_EQ(rx.length, 4);
+    EXPECT_EQ(0, memcmp(rx.data, data, 4));
+    EXPECT_FALSE(rx.srq);
+}
+
+TEST_F(AdbEngine, recorded_keyboard_reply) {
+    // A pressed, 00 FF, in cells of 94-106us
+    const waveform_t wave = {
+        { 1, 3 }, { 0, 184 },
+        { 1, 36 }, { 0, 66 },                                            // start
+        { 1, 63 }, { 0, 36 }, { 1, 67 }, { 0, 32 }, { 1, 64 }, { 0, 35 }, // 0 0 0
+        { 1, 65 }, { 0, 37 }, { 1, 66 }, { 0, 33 }, { 1, 62 }, { 0, 38 }, // 0 0 0
+        { 1, 64 }, { 0, 34 }, { 1, 66 }, { 0, 36 },                       // 0 0
+        { 1, 34 }, { 0, 67 }, { 1, 36 }, { 0, 63 }, { 1, 33 }, { 0, 66 }, // 1 1 1
+        { 1, 37 }, { 0, 64 }, { 1, 35 }, { 0, 65 }, { 1, 34 }, { 0, 68 }, // 1 1 1
+        { 1, 36 }, { 0, 62 }, { 1, 35 }, { 0, 66 },                       // 1 1
+        { 1, 65 },                                                        // stop
+    };
+    adb_transaction_t transaction = talk(ADB_TALK(2, 0), wave);
+    EXPECT_EQ(transaction.status, ADB_OK);
+    ASSERT_EQ(transaction.length, 2);
+    EXPECT_EQ(transaction.data[0], 0x00);
+    EXPECT_EQ(transaction.data[1], 0xFF);
+    EXPECT_FALSE(transaction.srq);
+}
+
+TEST_F(AdbEngine, cells_at_the_limits) {
+    for (uint16_t cell : { 70, 100, 130 }) {
+        adb_transaction_t transaction = talk(ADB_TALK(3, 0), reply({ 0x80, 0x7F }, cell));
+        EXPECT_EQ(transaction.status, ADB_OK) << cell;
+        EXPECT_EQ(transaction.data[0], 0x80) << cell;
+        EXPECT_EQ(transaction.data[1], 0x7F) << cell;
+    }
+}
+
+TEST_F(AdbEngine, nothing_to_say) {
+    adb_transaction_t transaction = talk(ADB_TALK(2, 0), { { 1, 2 } });
+    EXPECT_EQ(transaction.status, ADB_NO_DATA);
+    EXPECT_FALSE(transaction.srq);
+    EXPECT_EQ(transaction.length, 0);
+}
+
+TEST_F(AdbEngine, service_request) {
+    // the mouse holds the stop bit while the keyboard has nothing
+    adb_transaction_t transaction = talk(ADB_TALK(2, 0), { { 1, 235 } });
+    EXPECT_EQ(transaction.status, ADB_NO_DATA);
+    EXPECT_TRUE(transaction.srq);
+
+    // and while the keyboard answers
+    transaction = talk(ADB_TALK(2, 0), reply({ 0x0E, 0xFF }, 90, 240));
+    EXPECT_EQ(transaction.status, ADB_OK);
+    EXPECT_EQ(transaction.data[0], 0x0E);
+    EXPECT_TRUE(transaction.srq);
+}
+
+TEST_F(AdbEngine, bad_timing_is_an_error) {
+    // start bit 0
+    waveform_t wave = reply({ 0x00, 0xFF }, 100);
+    std::swap(wave[2].us, wave[3].us);
+    EXPECT_EQ(talk(ADB_TALK(2, 0), wave).status, ADB_ERROR);
+
+    // glitch
+    wave = reply({ 0x00, 0xFF }, 100);
+    wave[6].us = 5;
+    EXPECT_EQ(talk(ADB_TALK(2, 0), wave).status, ADB_ERROR);
+
+    // cell too long
+    wave = reply({ 0x00, 0xFF }, 100);
+    wave[9].us = 150;
+    EXPECT_EQ(talk(ADB_TALK(2, 0), wave).status, ADB_ERROR);
+
+    // a bit short
+    wave = reply({ 0x00, 0xFF }, 100);
+    wave.erase(wave.end() - 3, wave.end() - 1);
+    EXPECT_EQ(talk(ADB_TALK(2, 0), wave).status, ADB_ERROR);
+
+    // line stuck low
+    EXPECT_EQ(talk(ADB_TALK(2, 0), {}).status, ADB_ERROR);
+}
+
+TEST_F(AdbEngine, random_replies_with_jitter) {
+    for (int n = 0; n < 2000; n++) {
+        std::vector<uint8_t> data(2 + rand() % 7);
+        for (uint8_t& byte : data) {
+            byte = rand();
+        }
+        uint16_t cell = 70 + rand() % 61;
+        uint16_t srq = rand() % 2 ? 200 + rand() % 100 : 0;
+        adb_transaction_t transaction =
+            talk(ADB_TALK(3, rand() % 4), reply(data, cell, srq, 4, 140 + rand() % 120));
+        ASSERT_EQ(transaction.status, ADB_OK) << n;
+        ASSERT_EQ(transaction.length, data.size());
+        EXPECT_EQ(0, memcmp(transaction.data, data.data(), data.size())) << n;
+        EXPECT_EQ(transaction.srq, srq != 0);
+    }
+}
+
+TEST_F(AdbEngine, queue_keeps_order) {
+    uint8_t led[2] = { 0, 3 };
+    EXPECT_TRUE(adb_engine_queue(ADB_TALK(2, 0), 0, 0));
+    EXPECT_TRUE(adb_engine_queue(ADB_LISTEN(2, 2), led, 2));
+    EXPECT_TRUE(adb_engine_queue(ADB_TALK(3, 0), 0, 0));
+    EXPECT_FALSE(adb_engine_queue(ADB_TALK(3, 0), 0, 0));
+    EXPECT_TRUE(adb_engine_busy());
+
+    // the engine goes from one to the next by itself
+    adb_transaction_t transaction = run(reply({ 1, 2 }, 100));
+    EXPECT_EQ(transaction.command, 0x2C);
+    EXPECT_EQ(transaction.data[1], 2);
+    EXPECT_TRUE(bus.drive);
+    transaction = run({});
+    EXPECT_EQ(transaction.command, 0x2A);
+    EXPECT_EQ(transaction.status, ADB_OK);
+    transaction = run(reply({ 3, 4 }, 100));
+    EXPECT_EQ(transaction.command, 0x3C);
+    EXPECT_EQ(transaction.data[1], 4);
+    EXPECT_EQ(bus.wait, 0);
+    EXPECT_FALSE(adb_engine_busy());
+
+    EXPECT_FALSE(adb_engine_result(&transaction));
+}
+
+TEST(AdbPoll, follows_service_requests) {
+    adb_poll_t poll;
+    adb_poll_init(&poll);
+    adb_poll_add(&poll, 2);
+    adb_poll_add(&poll, 3);
+    adb_poll_add(&poll, 5);
+
+    EXPECT_EQ(adb_poll_next(&poll), 2);
+    adb_poll_done(&poll, 2, false);
+    EXPECT_EQ(adb_poll_next(&poll), 2);
+    // someone else is waiting
+    adb_poll_done(&poll, 2, true);
+    EXPECT_EQ(adb_poll_next(&poll), 3);
+    // not the mouse either
+    adb_poll_done(&poll, 3, true);
+    EXPECT_EQ(adb_poll_next(&poll), 5);
+    // found it, it stays the one polled
+    adb_poll_done(&poll, 5, false);
+    adb_poll_done(&poll, 5, false);
+    EXPECT_EQ(adb_poll_next(&poll), 5);
+    adb_poll_done(&poll, 5, true);
+    EXPECT_EQ(adb_poll_next(&poll), 2);
+    // stale results change nothing
+    adb_poll_done(&poll, 3, true);
+    EXPECT_EQ(adb_poll_next(&poll), 2);
+}
@@ -0,0 +1,171 @@
+#include "gtest/gtest.h"
+#include <cstdlib>
+#include <vector>
+extern "C" {
+#include "protocol/ps2_mouse_packet.h"
+}
+
+typedef std::vector<uint8_t> bytes_t;
+
+static std::vector<ps2_mouse_packet_t> parse(ps2_mouse_parser_t* parser, const bytes_t& bytes) {
+    std::vector<ps2_mouse_packet_t> packets;
+    for (uint8_t byte : bytes) {
+        ps2_mouse_packet_t packet;
+        if (ps2_mouse_parse(parser, byte, &packet)) {
+            packets.push_back(packet);
+        }
+    }
+    return packets;
+}
+
+// A packet as a mouse sends it, from 9 bit movement
+static bytes_t encode(uint8_t buttons, int x, int y) {
+    uint8_t status = 0x08 | buttons;
+    if (x < 0) status |= 0x10;
+    if (y < 0) status |= 0x20;
+    return { status, (uint8_t)x, (uint8_t)y };
+}
+
+TEST(PS2MousePacket, parses_movement_and_buttons) {
+    ps2_mouse_parser_t parser;
+    ps2_mouse_parser_init(&parser, 3);
+    auto packets = parse(&parser, { 0x09, 0x05, 0xFE, 0x3A, 0x80, 0x01 });
+    // 0x09 is left, with y 0xFE but no sign bit for it, so 254
+    ASSERT_EQ(packets.size(), 2u);
+    EXPECT_EQ(packets[0].buttons, 1);
+    EXPECT_EQ(packets[0].x, 5);
+    EXPECT_EQ(packets[0].y, 254);
+    // 0x3A: right, both signs set
+    EXPECT_EQ(packets[1].buttons, 2);
+    EXPECT_EQ(packets[1].x, -128);
+    EXPECT_EQ(packets[1].y, -255);
+}
+
+TEST(PS2MousePacket, every_movement_round_trips) {
+    ps2_mouse_parser_t parser;
+    ps2_mouse_parser_init(&parser, 3);
+    for (int x = -256; x <= 255; x++) {
+        auto packets = parse(&parser, encode(4, x, -1 - x));
+        ASSERT_EQ(packets.size(), 1u);
+        EXPECT_EQ(packets[0].x, x);
+        EXPECT_EQ(packets[0].y, -1 - x);
+        EXPECT_EQ(packets[0].buttons, 4);
+    }
+}
+
+TEST(PS2MousePacket, overflow_is_as_far_as_it_goes) {
+    ps2_mouse_parser_t parser;
+    ps2_mouse_parser_init(&parser, 3);
+    auto packets = parse(&parser, { 0x08 | 0x40 | 0x80 | 0x20, 0x10, 0x10 });
+    ASSERT_EQ(packets.size(), 1u);
+    EXPECT_EQ(packets[0].x, 255);
+    EXPECT_EQ(packets[0].y, -256);
+}
+
+TEST(PS2MousePacket, scroll_wheel_packets_have_four_bytes) {
+    ps2_mouse_parser_t parser;
+    ps2_mouse_parser_init(&parser, 4);
+    auto packets = parse(&parser, { 0x08, 0x01, 0x02, 0xFF, 0x08, 0x00, 0x00, 0x01 });
+    ASSERT_EQ(packets.size(), 2u);
+    EXPECT_EQ(packets[0].z, 0xFF);
+    EXPECT_EQ(packets[1].z, 0x01);
+}
+
+TEST(PS2MousePacket, resynchronises_after_stray_bytes) {
+    ps2_mouse_parser_t parser;
+    ps2_mouse_parser_init(&parser, 3);
+    // an ack and a stray byte without the always set bit are skipped
+    auto packets = parse(&parser, { 0xFA - 0x08, 0x00, 0x09, 0x01, 0x01 });
+    ASSERT_EQ(packets.size(), 1u);
+    EXPECT_EQ(packets[0].buttons, 1);
+    EXPECT_EQ(packets[0].x, 1);
+}
+
+TEST(PS2MouseAccumulator, adds_packets_up_between_reports) {
+    ps2_mouse_accumulator_t accumulator;
+    ps2_mouse_accumulator_clear(&accumulator);
+    report_mouse_t report;
+    EXPECT_FALSE(ps2_mouse_take_report(&accumulator, &report));
+    for (int i = 0; i < 5; i++) {
+        EXPECT_TRUE(ps2_mouse_accumulate(&accumulator, 0, 3, -2, 0, 0));
+    }
+    ASSERT_TRUE(ps2_mouse_take_report(&accumulator, &report));
+    EXPECT_EQ(report.x, 15);
+    EXPECT_EQ(report.y, -10);
+    EXPECT_FALSE(ps2_mouse_take_report(&accumulator, &report));
+}
+
+TEST(PS2MouseAccumulator, keeps_what_a_report_cant_carry) {
+    ps2_mouse_accumulator_t accumulator;
+    ps2_mouse_accumulator_clear(&accumulator);
+    report_mouse_t report;
+    ps2_mouse_accumulate(&accumulator, 0, 255, -256, 0, 0);
+    ps2_mouse_accumulate(&accumulator, 0, 100, 0, 0, 0);
+    int x = 0, y = 0, reports = 0;
+    while (ps2_mouse_take_report(&accumulator, &report)) {
+        EXPECT_GE(report.x, -127);
+        EXPECT_GE(report.y, -127);
+        x += report.x;
+        y += report.y;
+        reports++;
+    }
+    EXPECT_EQ(x, 355);
+    EXPECT_EQ(y, -256);
+    EXPECT_EQ(reports, 3);
+}
+
+TEST(PS2MouseAccumulator, button_changes_are_never_merged) {
+    ps2_mouse_accumulator_t accumulator;
+    ps2_mouse_accumulator_clear(&accumulator);
+    report_mouse_t report;
+    EXPECT_TRUE(ps2_mouse_accumulate(&accumulator, 0, 4, 0, 0, 0));
+    // the press waits for the move before it
+    EXPECT_FALSE(ps2_mouse_accumulate(&accumulator, 1, 0, 0, 0, 0));
+    ASSERT_TRUE(ps2_mouse_take_report(&accumulator, &report));
+    EXPECT_EQ(report.buttons, 0);
+    EXPECT_EQ(report.x, 4);
+    EXPECT_TRUE(ps2_mouse_accumulate(&accumulator, 1, 0, 0, 0, 0));
+    // the release waits for the press, even with nothing moving
+    EXPECT_FALSE(ps2_mouse_accumulate(&accumulator, 0, 0, 0, 0, 0));
+    ASSERT_TRUE(ps2_mouse_take_report(&accumulator, &report));
+    EXPECT_EQ(report.buttons, 1);
+    EXPECT_TRUE(ps2_mouse_accumulate(&accumulator, 0, 0, 0, 0, 0));
+    ASSERT_TRUE(ps2_mouse_take_report(&accumulator, &report));
+    EXPECT_EQ(report.buttons, 0);
+    EXPECT_FALSE(ps2_mouse_take_report(&accumulator, &report));
+}
+
+// Packets coming in faster than the main loop gets round to sending: each
+// report carries what came in since the last, and nothing is sent twice or
+// goes missing
+TEST(PS2MouseAccumulator, packets_coalesce_into_reports) {
+    ps2_mouse_parser_t parser;
+    ps2_mouse_parser_init(&parser, 3);
+    ps2_mouse_accumulator_t accumulator;
+    ps2_mouse_accumulator_clear(&accumulator);
+    srand(5);
+    int sent_x = 0, sent_y = 0, x = 0, y = 0, reports = 0;
+    const int packets = 1000;
+    for (int i = 0; i < packets || ps2_mouse_pending(&accumulator); i++) {
+        if (i < packets) {
+            int dx = rand() % 81 - 40, dy = rand() % 81 - 40;
+            sent_x += dx;
+            sent_y -= dy;
+            std::vector<ps2_mouse_packet_t> parsed = parse(&parser, encode(0, dx, dy));
+            ASSERT_EQ(parsed.size(), 1u);
+            ASSERT_TRUE(ps2_mouse_accumulate(&accumulator, parsed[0].buttons, parsed[0].x, -parsed[0].y, 0, 0));
+        }
+        // a report every third packet
+        report_mouse_t report;
+        if (i % 3 == 2 && ps2_mouse_take_report(&accumulator, &report)) {
+            x += report.x;
+            y += report.y;
+            reports++;
+        }
+    }
+    EXPECT_EQ(x, sent_x);
+    EXPECT_EQ(y, sent_y);
+    // one report for each three packets, and one more for what's left over
+    EXPECT_GE(reports, packets / 3);
+    EXPECT_LE(reports, packets / 3 + 2);
+}
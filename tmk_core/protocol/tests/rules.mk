@@ -0,0 +1,11 @@
+tmk_core_ps2_mouse_packet_SRC :=\
+	$(TMK_PATH)/protocol/tests/ps2_mouse_packet_tests.cpp \
+	$(TMK_PATH)/protocol/ps2_mouse_packet.c
+
+tmk_core_adb_engine_SRC :=\
+	$(TMK_PATH)/protocol/tests/adb_engine_tests.cpp \
+	$(TMK_PATH)/protocol/adb_engine.c
+
+tmk_core_adafruit_ble_DEFS := -DMOUSE_ENABLE
+tmk_core_adafruit_ble_SRC :=\
+	$(TMK_PATH)/protocol/tests/adafruit_ble_tests.cpp
@@ -0,0 +1,4 @@
+TEST_LIST +=\
+	tmk_core_ps2_mouse_packet \
+	tmk_core_adb_engine \
+	tmk_core_adafruit_ble
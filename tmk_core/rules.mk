@@ -219,6 +219,7 @@ hex: $(BUILD_DIR)/$(TARGET).hex
 eep: $(BUILD_DIR)/$(TARGET).eep
 lss: $(BUILD_DIR)/$(TARGET).lss
 sym: $(BUILD_DIR)/$(TARGET).sym
+trace: $(BUILD_DIR)/$(TARGET)_trace.txt
 LIBNAME=lib$(TARGET).a
 lib: $(LIBNAME)
 
@@ -275,6 +276,12 @@ gccversion :
 	$(eval CMD=$(BIN) $< $@ || exit 0)
 	@$(BUILD_CMD)
 
+# Create the format table for util/trace_decode.py, in the order of the IDs.
+%_trace.txt: $(TMK_PATH)/$(COMMON_DIR)/trace_formats.h %.elf
+	@$(SILENT) || printf "$(MSG_TRACE_TABLE) $@" | $(AWK_CMD)
+	$(eval CMD=$(CC) -E -P -DTRACE_TABLE $< > $@)
+	@$(BUILD_CMD)
+
 BEGIN = gccversion sizebefore
 
 # Link: create ELF output file from object files.
@@ -383,6 +390,6 @@ $(eval $(foreach OUTPUT,$(OUTPUTS),$(shell mkdir -p $(OUTPUT) 2>/dev/null)))
 
 # Listing of phony targets.
 .PHONY : all finish sizebefore sizeafter gccversion \
-build elf hex eep lss sym coff extcoff \
+build elf hex eep lss sym trace coff extcoff \
 clean clean_list debug gdb-config show_path \
 program teensy dfu flip dfu-ee flip-ee dfu-start 
\ No newline at end of file
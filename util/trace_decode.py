@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+"""Formats the binary trace log of a keyboard built with TRACE_BINARY = yes
+
+    util/trace_decode.py .build/<keyboard>_<keymap>_trace.txt [log]
+
+The log is what the console printed, from hid_listen or a file, read from
+standard input without one. Lines of the trace log, starting with '~', are
+formatted with the table the build made; everything else is passed on.
+"""
+
+import re
+import sys
+
+ENTRY = re.compile(r'(\w+)\s+"((?:[^"\\]|\\.)*)"')
+CONVERSION = re.compile(r'%([-0]?)(\d*)(l?)([duxXcbo%])')
+ESCAPES = {'n': '\n', 't': '\t', 'r': '\r', '\\': '\\', '"': '"'}
+
+
+def read_table(path):
+    with open(path) as table:
+        text = table.read()
+    formats = []
+    for name, fmt in ENTRY.findall(text):
+        fmt = re.sub(r'\\(.)', lambda m: ESCAPES.get(m.group(1), m.group(1)), fmt)
+        formats.append((name, fmt))
+    return formats
+
+
+def format_entry(fmt, args):
+    """The subset of xprintf the trace formats can use, arguments are 16 bit"""
+    args = list(args)
+
+    def convert(match):
+        flag, width, _, kind = match.groups()
+        if kind == '%':
+            return '%'
+        value = args.pop(0) if args else 0
+        if kind == 'd' and value & 0x8000:
+            value -= 0x10000
+        if kind == 'c':
+            text = chr(value & 0xFF)
+        elif kind in 'du':
+            text = str(value)
+        elif kind == 'x':
+            text = '%x' % value
+        elif kind == 'X':
+            text = '%X' % value
+        elif kind == 'o':
+            text = '%o' % value
+        else:
+            text = bin(value)[2:]
+        width = int(width or 0)
+        if flag == '-':
+            return text.ljust(width)
+        return text.rjust(width, '0' if flag == '0' else ' ')
+
+    return CONVERSION.sub(convert, fmt)
+
+
+def decode_line(formats, line):
+    data = bytes.fromhex(line[1:].strip())
+    if len(data) < 2 or len(data) != 2 + data[1] * 2:
+        return line
+    entry_id, count = data[0], data[1]
+    args = [data[2 + i * 2] | data[3 + i * 2] << 8 for i in range(count)]
+    if entry_id >= len(formats):
+        return 'trace: unknown %d %s\n' % (entry_id, ' '.join('%04X' % a for a in args))
+    return format_entry(formats[entry_id][1], args)
+
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit(__doc__)
+    formats = read_table(sys.argv[1])
+    log = open(sys.argv[2]) if len(sys.argv) > 2 else sys.stdin
+    for line in log:
+        if line.startswith('~'):
+            try:
+                line = decode_line(formats, line)
+            except ValueError:
+                pass
+        sys.stdout.write(line)
+        sys.stdout.flush()
+
+
+if __name__ == '__main__':
+    main()